@@ -0,0 +1,117 @@
+//
+// Checks the Bloom filters for false negatives and their false positive
+// rate, and wfBloomMap against a std::map.
+//
+// g++ -g -I../ -fsanitize=address,undefined bloomfilter_test.cpp -o bloomfilter_test
+//
+#include "wfTest.h"
+#include "wfBloomFilter.h"
+#include <map>
+#include <vector>
+
+enum { kKeys = 20000 };
+
+// the keys inserted are even, the odd ones measure false positives
+static bool TestFilter(wfTest *store) {
+	wfBloomFilter<u32> filter(kKeys, 0.01);
+	for (u32 i = 0; i < kKeys; i++)
+		filter.Insert(i * 2);
+
+	u32 positives = 0;
+	for (u32 i = 0; i < kKeys; i++) {
+		WF_TEST_FAIL(filter.Contains(i * 2));
+		positives += filter.Contains(i * 2 + 1) ? 1 : 0;
+	}
+	WF_TEST_FAIL(positives < kKeys / 50);
+
+	std::vector<unsigned char> buffer(filter.SerializedSize());
+	filter.Serialize(&buffer[0]);
+	wfBloomFilter<u32> copy(1, 0.5);
+	WF_TEST_FAIL(copy.Deserialize(&buffer[0], buffer.size()) && copy.Bytes() == filter.Bytes());
+	for (u32 i = 0; i < kKeys; i++)
+		WF_TEST_FAIL(copy.Contains(i * 2));
+	WF_TEST_FAIL(!copy.Deserialize(&buffer[0], buffer.size() - 1));
+
+	filter.Clear();
+	WF_TEST_FAIL(!filter.Contains(0));
+	return true;
+}
+
+static bool TestCountingFilter(wfTest *store) {
+	wfCountingBloomFilter<u32> filter(kKeys, 0.01);
+	for (u32 i = 0; i < kKeys; i++)
+		filter.Insert(i * 2);
+	for (u32 i = 0; i < kKeys; i += 2)
+		filter.Erase(i * 2);
+
+	u32 positives = 0;
+	for (u32 i = 1; i < kKeys; i += 2)
+		WF_TEST_FAIL(filter.Contains(i * 2));
+	for (u32 i = 0; i < kKeys; i += 2)
+		positives += filter.Contains(i * 2) ? 1 : 0;
+	WF_TEST_FAIL(positives < kKeys / 50);
+	return true;
+}
+
+// the rate measured at low rates stays within a factor of two of the one
+// the filters were sized for
+template <typename F>
+static bool LowRate(wfTest *store, double rate) {
+	enum { kInserted = 50000, kProbes = 1000000 };
+	F filter(kInserted, rate);
+	for (u32 i = 0; i < kInserted; i++)
+		filter.Insert(i * 2);
+
+	u32 positives = 0;
+	for (u32 i = 0; i < kProbes; i++)
+		positives += filter.Contains(i * 2 + 1) ? 1 : 0;
+	WF_TEST_FAIL(positives <= 2.0 * rate * kProbes);
+	return true;
+}
+
+static bool TestLowRate(wfTest *store) {
+	WF_TEST_FAIL(LowRate<wfBloomFilter<u32> >(store, 1e-3));
+	WF_TEST_FAIL(LowRate<wfBloomFilter<u32> >(store, 1e-4));
+	WF_TEST_FAIL(LowRate<wfCountingBloomFilter<u32> >(store, 1e-3));
+	WF_TEST_FAIL(LowRate<wfCountingBloomFilter<u32> >(store, 1e-4));
+	return true;
+}
+
+static bool TestMap(wfTest *store) {
+	wfBloomMap<u32, u32> map(64);
+	std::map<u32, u32>   reference;
+	u32                  state = 1;
+
+	// starts small so that the filter is rebuilt a few times
+	for (u32 i = 0; i < 50000; i++) {
+		const u32 key = wfTestRandom(state) % 4096;
+		if (wfTestRandom(state) % 3 != 0) {
+			const u32 value = wfTestRandom(state);
+			// a key already present keeps its value, as in wfMap
+			const u32 expect = reference.insert(std::make_pair(key, value)).first->second;
+			WF_TEST_FAIL(map.Insert(key, value) == expect);
+		} else {
+			map.Erase(key);
+			reference.erase(key);
+		}
+		WF_TEST_FAIL(map.Length() == reference.size());
+		WF_TEST_FAIL(map.Count(key) == reference.count(key));
+	}
+
+	for (u32 key = 0; key < 4096; key++) {
+		std::map<u32, u32>::iterator it = reference.find(key);
+		wfBloomMap<u32, u32>::Iterator found = map.Find(key);
+		WF_TEST_FAIL(it == reference.end() ? found == map.End() : (found != map.End() && found->second == it->second));
+	}
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfBloomFilter: Filter",         &TestFilter),
+		WF_TEST("wfCountingBloomFilter: Filter", &TestCountingFilter),
+		WF_TEST("wfBloomFilter: Low Rate",       &TestLowRate),
+		WF_TEST("wfBloomMap: Random",            &TestMap)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
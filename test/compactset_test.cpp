@@ -0,0 +1,134 @@
+//
+// Checks wfCompactSet and wfCompactMap against a std::set and std::map
+// under random insertions and erasures, across pool growth, elements of the
+// set inserted into it again included.
+//
+// g++ -g -I../ -fsanitize=address,undefined compactset_test.cpp -o compactset_test
+//
+#include "wfTest.h"
+#include "wfCompactSet.h"
+#include <map>
+#include <set>
+#include <string>
+
+static bool TestSetRandom(wfTest *store) {
+	wfCompactSet<u32> set;
+	std::set<u32>     reference;
+	u32               state = 1;
+
+	for (u32 i = 0; i < 100000; i++) {
+		const u32 value = wfTestRandom(state) % 2048;
+		if (wfTestRandom(state) % 3 != 0) {
+			// the first insertion into a full pool grows it underneath
+			WF_TEST_FAIL(set.Insert(value) == value);
+			reference.insert(value);
+		} else {
+			set.Erase(value);
+			reference.erase(value);
+		}
+		WF_TEST_FAIL(set.Length() == reference.size());
+		WF_TEST_FAIL(set.Count(value) == reference.count(value));
+	}
+
+	wfCompactSet<u32>::Iterator it = set.Begin();
+	for (std::set<u32>::iterator expect = reference.begin(); expect != reference.end(); ++expect, ++it)
+		WF_TEST_FAIL(it != set.End() && *it == *expect);
+	WF_TEST_FAIL(it == set.End());
+
+	for (u32 key = 0; key < 2049; key++) {
+		std::set<u32>::iterator lower = reference.lower_bound(key);
+		it = set.LowerBound(key);
+		WF_TEST_FAIL(lower == reference.end() ? it == set.End() : (it != set.End() && *it == *lower));
+	}
+	return true;
+}
+
+static bool TestSetEraseKeepsElements(wfTest *store) {
+	wfCompactSet<u32> set;
+	set.Reserve(256);
+	for (u32 i = 0; i < 256; i++)
+		set.Insert(i);
+
+	// erasing an inner node must not move its in-order neighbour
+	const u32 *element = &*set.Find(100u);
+	for (u32 i = 0; i < 256; i++) {
+		if (i != 100)
+			set.Erase(i);
+	}
+	WF_TEST_FAIL(set.Length() == 1 && &*set.Find(100u) == element && *element == 100);
+	return true;
+}
+
+// an element of the set inserted into it again whenever the pool is full,
+// the pool must not be grown out from under it
+static bool TestSetSelfInsert(wfTest *store) {
+	wfCompactSet<std::string> set;
+	char                      buffer[48];
+	for (u32 i = 0; i < 300; i++) {
+		snprintf(buffer, sizeof(buffer), "element %03u, long enough to allocate", i);
+		set.Insert(buffer);
+		WF_TEST_FAIL(set.Insert(*set.Begin()) == *set.Begin());
+		WF_TEST_FAIL(set.Insert(*set.Find(std::string(buffer))) == buffer);
+		WF_TEST_FAIL(set.Length() == i + 1);
+	}
+	return true;
+}
+
+// keys of other types than the key type are converted to it first, an
+// unsigned key finds the elements of a signed set
+static bool TestSetConvertedLookup(wfTest *store) {
+	wfCompactSet<int> set;
+	for (int i = -50; i <= 50; i++)
+		set.Insert(i);
+
+	for (u32 i = 0; i < 50; i++) {
+		WF_TEST_FAIL(set.Find(i) != set.End() && *set.Find(i) == static_cast<int>(i));
+		WF_TEST_FAIL(set.Count(i) == 1 && *set.LowerBound(i) == static_cast<int>(i));
+		WF_TEST_FAIL(*set.UpperBound(i) == static_cast<int>(i) + 1);
+	}
+	set.Erase(7u);
+	WF_TEST_FAIL(set.Count(7) == 0 && set.Count(51u) == 0 && set.Length() == 100);
+	return true;
+}
+
+static bool TestMapRandom(wfTest *store) {
+	wfCompactMap<u32, std::string> map;
+	std::map<u32, std::string>     reference;
+	u32                            state = 5;
+	char                           buffer[32];
+
+	for (u32 i = 0; i < 50000; i++) {
+		const u32 key = wfTestRandom(state) % 1024;
+		if (wfTestRandom(state) % 3 != 0) {
+			snprintf(buffer, sizeof(buffer), "value %u", key * 7);
+			WF_TEST_FAIL(map.Insert(key, buffer) == buffer);
+			reference.insert(std::make_pair(key, std::string(buffer)));
+		} else {
+			map.Erase(key);
+			reference.erase(key);
+		}
+		WF_TEST_FAIL(map.Length() == reference.size());
+	}
+
+	wfCompactMap<u32, std::string>::Iterator it = map.Begin();
+	for (std::map<u32, std::string>::iterator expect = reference.begin(); expect != reference.end(); ++expect, ++it)
+		WF_TEST_FAIL(it != map.End() && it->first == expect->first && it->second == expect->second);
+	WF_TEST_FAIL(it == map.End());
+
+	map[4096] = "default";
+	WF_TEST_FAIL(map.Find(4096u)->second == "default");
+	map.Clear();
+	WF_TEST_FAIL(map.Empty() && map.Begin() == map.End());
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfCompactSet: Random",               &TestSetRandom),
+		WF_TEST("wfCompactSet: Erase Keeps Elements", &TestSetEraseKeepsElements),
+		WF_TEST("wfCompactSet: Self Insert",          &TestSetSelfInsert),
+		WF_TEST("wfCompactSet: Converted Lookup",     &TestSetConvertedLookup),
+		WF_TEST("wfCompactMap: Random",               &TestMapRandom)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
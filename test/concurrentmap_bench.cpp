@@ -0,0 +1,109 @@
+//
+// Contention benchmark for wfConcurrentMap against a wfMap behind a single
+// mutex, which is what wfConcurrentMap replaces.  Every thread performs the
+// same number of operations on a shared, prepopulated map, 90% lookups and
+// 10% upserts, uniformly over the keys.
+//
+// g++ -O2 -I../ concurrentmap_bench.cpp -o concurrentmap_bench -lpthread
+//
+#include <stdio.h>
+#include "wfTest.h"
+#include "wfConcurrentMap.h"
+
+static const u32 kKeys       = 1 << 16;
+static const u32 kOperations = 1 << 20;
+static const u32 kUpsertRate = 10; // percent
+
+struct LockedMap {
+	bool Find(u32 key, u32& value) {
+		wfLockGuard<wfMutex> guard(m_lock);
+		wfMap<u32, u32>::Iterator it = m_map.Find(key);
+		if (it == m_map.End())
+			return false;
+		value = it->second;
+		return true;
+	}
+
+	void Upsert(u32 key, u32 value) {
+		wfLockGuard<wfMutex> guard(m_lock);
+		m_map.Insert(key, value) = value;
+	}
+
+	wfMutex         m_lock;
+	wfMap<u32, u32> m_map;
+};
+
+template <typename M>
+struct Worker {
+	M            *m_map;
+	u32           m_seed;
+	volatile u32  m_found;
+	volatile u32 *m_start;
+
+	static void Run(void *argument) {
+		Worker &self  = *static_cast<Worker*>(argument);
+		u32     state = self.m_seed;
+		u32     found = 0;
+
+		while (!wfAtomicLoad(self.m_start))
+			wfCpuRelax();
+
+		for (u32 i = 0; i < kOperations; i++) {
+			const u32 key = wfTestRandom(state) & (kKeys - 1);
+			if (wfTestRandom(state) % 100 < kUpsertRate) {
+				self.m_map->Upsert(key, i);
+			} else {
+				u32 value;
+				found += self.m_map->Find(key, value) ? 1 : 0;
+			}
+		}
+
+		self.m_found = found;
+	}
+};
+
+template <typename M>
+static double Measure(M& map, u32 threads) {
+	wfThread    *thread  = new wfThread[threads];
+	Worker<M>   *workers = new Worker<M>[threads];
+	volatile u32 start   = 0;
+
+	for (u32 i = 0; i < threads; i++) {
+		workers[i].m_map   = &map;
+		workers[i].m_seed  = 0x9E3779B9u * (i + 1);
+		workers[i].m_start = &start;
+		thread[i].Start(&Worker<M>::Run, &workers[i]);
+	}
+
+	const double begin = wfTestNow();
+	wfAtomicStore(&start, 1u);
+	for (u32 i = 0; i < threads; i++)
+		thread[i].Join();
+	const double end = wfTestNow();
+
+	delete[] workers;
+	delete[] thread;
+
+	// millions of operations per second over all threads
+	return (double)threads * kOperations / (end - begin) / 1e6;
+}
+
+int main()
+{
+	wfConcurrentMap<u32, u32> sharded;
+	LockedMap                 locked;
+
+	for (u32 key = 0; key < kKeys; key++) {
+		sharded.Upsert(key, key);
+		locked.Upsert(key, key);
+	}
+
+	printf("threads   wfMap+wfMutex   wfConcurrentMap   (Mops/s, %u%% upserts)\n", kUpsertRate);
+	for (u32 threads = 1; threads <= 64; threads <<= 1) {
+		const double a = Measure(locked,  threads);
+		const double b = Measure(sharded, threads);
+		printf("%7u   %13.2f   %15.2f\n", threads, a, b);
+	}
+
+	return 0;
+}
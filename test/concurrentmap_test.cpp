@@ -0,0 +1,143 @@
+//
+// Checks wfConcurrentMap against a std::map, with and without the read
+// cache, and from several threads at once.
+//
+// g++ -g -I../ -fsanitize=address,undefined concurrentmap_test.cpp -o concurrentmap_test -lpthread
+//
+#include "wfTest.h"
+#include "wfConcurrentMap.h"
+#include <map>
+
+struct Pair {
+	u32 a;
+	u32 b;
+};
+
+struct CountVisits {
+	CountVisits() : m_count(0), m_sum(0) { }
+	void operator()(const u32& key, const u32& value) { m_count++; m_sum += key ^ value; }
+	size_t m_count;
+	u64    m_sum;
+};
+
+static bool TestRandom(wfTest *store) {
+	wfConcurrentMap<u32, u32> map(8);
+	std::map<u32, u32>        reference;
+	u32                       state = 1;
+
+	for (u32 i = 0; i < 100000; i++) {
+		const u32 key       = wfTestRandom(state) % 512;
+		const u32 operation = wfTestRandom(state) % 4;
+		if (operation == 0) {
+			const u32  value    = wfTestRandom(state);
+			const bool inserted = reference.find(key) == reference.end();
+			reference[key] = value;
+			WF_TEST_FAIL(map.Upsert(key, value) == inserted);
+		} else if (operation == 1) {
+			WF_TEST_FAIL(map.Erase(key) == (reference.erase(key) != 0));
+		} else {
+			u32 value = 0;
+			std::map<u32, u32>::iterator it = reference.find(key);
+			WF_TEST_FAIL(map.Find(key, value) == (it != reference.end()));
+			WF_TEST_FAIL(it == reference.end() || value == it->second);
+		}
+	}
+	WF_TEST_FAIL(map.Length() == reference.size());
+
+	u64 sum = 0;
+	for (std::map<u32, u32>::iterator it = reference.begin(); it != reference.end(); ++it)
+		sum += it->first ^ it->second;
+	CountVisits visits = map.ForEach(CountVisits());
+	WF_TEST_FAIL(visits.m_count == reference.size() && visits.m_sum == sum);
+	return true;
+}
+
+static bool TestUncachedValues(wfTest *store) {
+	wfConcurrentMap<u32, Pair> map(4);
+	for (u32 i = 0; i < 1000; i++) {
+		Pair pair = { i, i * 2 };
+		map.Upsert(i, pair);
+	}
+	for (u32 i = 0; i < 1000; i += 2)
+		map.Erase(i);
+	for (u32 i = 0; i < 1000; i++) {
+		Pair pair = { 0, 0 };
+		const bool found = map.Find(i, pair);
+		WF_TEST_FAIL(found == ((i & 1) != 0));
+		WF_TEST_FAIL(!found || (pair.a == i && pair.b == i * 2));
+	}
+	return true;
+}
+
+static bool TestFloatingPointValues(wfTest *store) {
+	wfConcurrentMap<u32, double> map(4);
+	for (u32 i = 0; i < 100; i++)
+		map.Upsert(i, i * 0.5);
+	for (u32 i = 0; i < 100; i++) {
+		double value = -1.0;
+		// twice, the second find is served by the cache
+		WF_TEST_FAIL(map.Find(i, value) && value == i * 0.5);
+		WF_TEST_FAIL(map.Find(i, value) && value == i * 0.5);
+	}
+	return true;
+}
+
+enum { kThreads = 4, kKeysPerThread = 2000 };
+
+struct Writer {
+	wfConcurrentMap<u32, u32> *m_map;
+	u32                        m_first;
+	u32                        m_errors;
+
+	// every thread owns its keys, reads back its own writes and reads the
+	// keys of the others, which are either missing or hold key * 3
+	static void Run(void *argument) {
+		Writer &self  = *static_cast<Writer*>(argument);
+		u32     state = self.m_first + 1;
+		for (u32 round = 0; round < 4; round++) {
+			for (u32 i = 0; i < kKeysPerThread; i++) {
+				const u32 key = self.m_first + i;
+				self.m_map->Upsert(key, key * 3);
+
+				u32 value = 0;
+				if (!self.m_map->Find(key, value) || value != key * 3)
+					self.m_errors++;
+
+				const u32 other = wfTestRandom(state) % (kThreads * kKeysPerThread);
+				if (self.m_map->Find(other, value) && value != other * 3)
+					self.m_errors++;
+			}
+			for (u32 i = 0; i < kKeysPerThread; i += 2)
+				self.m_map->Erase(self.m_first + i);
+		}
+	}
+};
+
+static bool TestThreads(wfTest *store) {
+	wfConcurrentMap<u32, u32> map(16);
+	wfThread                  threads[kThreads];
+	Writer                    writers[kThreads];
+
+	for (u32 i = 0; i < kThreads; i++) {
+		writers[i].m_map    = &map;
+		writers[i].m_first  = i * kKeysPerThread;
+		writers[i].m_errors = 0;
+		threads[i].Start(&Writer::Run, &writers[i]);
+	}
+	for (u32 i = 0; i < kThreads; i++) {
+		threads[i].Join();
+		WF_TEST_FAIL(writers[i].m_errors == 0);
+	}
+	WF_TEST_FAIL(map.Length() == kThreads * kKeysPerThread / 2);
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfConcurrentMap: Random",          &TestRandom),
+		WF_TEST("wfConcurrentMap: Uncached Values", &TestUncachedValues),
+		WF_TEST("wfConcurrentMap: Floating Point",  &TestFloatingPointValues),
+		WF_TEST("wfConcurrentMap: Threads",         &TestThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Builds and runs every container test under the address and undefined
+# behaviour sanitizers, the logs of failing tests are kept.
+CXX=g++
+FLAGS="-g -O1 -I../ -fsanitize=address,undefined -fno-sanitize-recover=undefined"
+FAILED=0
+
+for SOURCE in *_test.cpp; do
+    NAME=`basename $SOURCE .cpp`
+    case $NAME in
+        math_test|sysinfo_test) continue ;;
+    esac
+
+    if ! $CXX $FLAGS $SOURCE -o $NAME -lpthread; then
+        echo "[$NAME] Build Failed"
+        FAILED=1
+        continue
+    fi
+
+    if ./$NAME > $NAME.log 2>&1; then
+        echo "[$NAME] Tests Passed"
+        rm $NAME.log
+    else
+        echo "[$NAME] Tests Failed: check $NAME.log for details"
+        FAILED=1
+    fi
+    rm $NAME
+done
+
+exit $FAILED
@@ -0,0 +1,113 @@
+//
+// Checks wfDeque against a std::deque under random pushes and pops at both
+// ends, and pushes of its own elements while it grows.
+//
+// g++ -g -I../ -fsanitize=address,undefined deque_test.cpp -o deque_test
+//
+#include "wfTest.h"
+#include "wfDeque.h"
+#include <deque>
+#include <string>
+
+static bool TestRandom(wfTest *store) {
+	wfDeque<u32>    deque;
+	std::deque<u32> reference;
+	u32             state = 1;
+	u32             values[40];
+
+	for (u32 i = 0; i < 100000; i++) {
+		const u32 operation = wfTestRandom(state) % 8;
+		if (operation < 2) {
+			const u32 value = wfTestRandom(state);
+			if (operation == 0) {
+				deque.PushBack(value);
+				reference.push_back(value);
+			} else {
+				deque.PushFront(value);
+				reference.push_front(value);
+			}
+		} else if (operation < 4) {
+			const size_t count = wfTestRandom(state) % WF_ARRAY_SIZE(values);
+			for (size_t j = 0; j < count; j++)
+				values[j] = wfTestRandom(state);
+			if (operation == 2) {
+				deque.PushBack(values, count);
+				reference.insert(reference.end(), values, values + count);
+			} else {
+				deque.PushFront(values, count);
+				reference.insert(reference.begin(), values, values + count);
+			}
+		} else if (operation == 4) {
+			const size_t count = deque.PopFront(values, wfTestRandom(state) % WF_ARRAY_SIZE(values));
+			for (size_t j = 0; j < count; j++) {
+				WF_TEST_FAIL(values[j] == reference.front());
+				reference.pop_front();
+			}
+		} else if (!reference.empty()) {
+			if (operation < 7) {
+				WF_TEST_FAIL(deque.Back() == reference.back());
+				deque.PopBack();
+				reference.pop_back();
+			} else {
+				WF_TEST_FAIL(deque.Front() == reference.front());
+				deque.PopFront();
+				reference.pop_front();
+			}
+		}
+		WF_TEST_FAIL(deque.Length() == reference.size());
+	}
+
+	size_t index = 0;
+	for (wfDeque<u32>::ConstIterator it = deque.Begin(); it != deque.End(); ++it, ++index)
+		WF_TEST_FAIL(*it == reference[index] && deque[index] == reference[index]);
+	WF_TEST_FAIL(deque.End() - deque.Begin() == static_cast<ptrdiff_t>(reference.size()));
+	return true;
+}
+
+static bool TestPushOwnElement(wfTest *store) {
+	wfDeque<std::string> deque;
+	const std::string    front(64, 'f');
+	const std::string    back (64, 'b');
+	deque.PushBack(back);
+	deque.PushFront(front);
+
+	// every push of an end while full reallocates underneath the reference
+	for (u32 i = 0; i < 200; i++) {
+		deque.PushBack(deque.Back());
+		deque.PushFront(deque.Front());
+	}
+	WF_TEST_FAIL(deque.Length() == 402);
+	for (size_t i = 0; i < deque.Length(); i++)
+		WF_TEST_FAIL(deque[i] == (i < deque.Length() / 2 ? front : back));
+	return true;
+}
+
+static bool TestPushOwnRun(wfTest *store) {
+	wfDeque<std::string> deque;
+	char                 buffer[16];
+	for (u32 i = 0; i < 16; i++) {
+		snprintf(buffer, sizeof(buffer), "%u", i);
+		deque.PushBack(std::string(buffer) + std::string(32, '.'));
+	}
+
+	// the queue starts at the front of its buffer and both pushes fill it
+	// over, the first elements are a contiguous run that growing frees
+	deque.PushBack(&deque.Front(), 8);
+	deque.PushFront(&deque.Front(), 9);
+	WF_TEST_FAIL(deque.Length() == 33);
+	for (u32 i = 0; i < 33; i++) {
+		const u32 expect = (i < 9) ? i : (i < 25) ? i - 9 : i - 25;
+		snprintf(buffer, sizeof(buffer), "%u", expect);
+		WF_TEST_FAIL(deque[i] == std::string(buffer) + std::string(32, '.'));
+	}
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfDeque: Random",           &TestRandom),
+		WF_TEST("wfDeque: Push Own Element", &TestPushOwnElement),
+		WF_TEST("wfDeque: Push Own Run",     &TestPushOwnRun)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,132 @@
+//
+// Checks that wfEpochDomain defers destruction while readers are inside
+// and reclaims everything once they have left.
+//
+// g++ -g -I../ -fsanitize=address,undefined epoch_test.cpp -o epoch_test -lpthread
+//
+#include "wfTest.h"
+#include "wfEpoch.h"
+
+struct Object {
+	u32 m_value;
+};
+
+static volatile u32 s_destroyed = 0;
+
+static void DestroyObject(void *object) {
+	delete static_cast<Object*>(object);
+	wfAtomicFetchAdd(&s_destroyed, 1u);
+}
+
+static bool TestDeferred(wfTest *store) {
+	wfEpochDomain       domain;
+	wfEpochParticipant *reader = domain.Join();
+	s_destroyed = 0;
+
+	reader->Enter();
+	for (u32 i = 0; i < 16; i++)
+		domain.Retire(new Object(), &DestroyObject);
+	WF_TEST_FAIL(domain.Collect() == 16 && s_destroyed == 0);
+	reader->Exit();
+
+	// a single call after the readers left reclaims it all
+	WF_TEST_FAIL(domain.Collect() == 0 && s_destroyed == 16);
+
+	domain.Retire(new Object(), &DestroyObject);
+	WF_TEST_FAIL(domain.Collect() == 0 && s_destroyed == 17);
+
+	domain.Leave(reader);
+	WF_TEST_FAIL(domain.Join() == reader);
+	return true;
+}
+
+static bool TestDestructor(wfTest *store) {
+	s_destroyed = 0;
+	{
+		wfEpochDomain       domain;
+		wfEpochParticipant *reader = domain.Join();
+		wfEpochGuard        guard(reader);
+		for (u32 i = 0; i < 8; i++)
+			domain.Retire(new Object(), &DestroyObject);
+		WF_TEST_FAIL(s_destroyed == 0);
+		reader->Exit();
+	}
+	WF_TEST_FAIL(s_destroyed == 8);
+	return true;
+}
+
+enum { kReaders = 3, kSwaps = 20000 };
+
+struct Shared {
+	wfEpochDomain    m_domain;
+	Object *volatile m_current;
+	volatile u32     m_done;
+	u32              m_errors[kReaders];
+};
+
+struct Reader {
+	Shared *m_shared;
+	u32     m_index;
+
+	// a retired object is destroyed with its value cleared, which a reader
+	// would see if it was freed under it (and the sanitizer would too)
+	static void Run(void *argument) {
+		Reader             &self   = *static_cast<Reader*>(argument);
+		Shared             &shared = *self.m_shared;
+		wfEpochParticipant *reader = shared.m_domain.Join();
+		while (!wfAtomicLoad(&shared.m_done)) {
+			wfEpochGuard guard(reader);
+			Object *object = wfAtomicLoad(&shared.m_current);
+			if (object->m_value == 0)
+				shared.m_errors[self.m_index]++;
+		}
+		shared.m_domain.Leave(reader);
+	}
+};
+
+static void ClearObject(void *object) {
+	static_cast<Object*>(object)->m_value = 0;
+	delete static_cast<Object*>(object);
+}
+
+static bool TestThreads(wfTest *store) {
+	Shared   shared;
+	wfThread threads[kReaders];
+	Reader   readers[kReaders];
+
+	Object *first = new Object();
+	first->m_value   = 1;
+	shared.m_current = first;
+	shared.m_done    = 0;
+	for (u32 i = 0; i < kReaders; i++) {
+		shared.m_errors[i] = 0;
+		readers[i].m_shared = &shared;
+		readers[i].m_index  = i;
+		threads[i].Start(&Reader::Run, &readers[i]);
+	}
+
+	for (u32 i = 0; i < kSwaps; i++) {
+		Object *object = new Object();
+		object->m_value = i + 2;
+		Object *old = wfAtomicExchange(&shared.m_current, object);
+		shared.m_domain.Retire(old, &ClearObject);
+	}
+
+	wfAtomicStore(&shared.m_done, 1u);
+	for (u32 i = 0; i < kReaders; i++) {
+		threads[i].Join();
+		WF_TEST_FAIL(shared.m_errors[i] == 0);
+	}
+	WF_TEST_FAIL(shared.m_domain.Collect() == 0);
+	delete shared.m_current;
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfEpoch: Deferred",   &TestDeferred),
+		WF_TEST("wfEpoch: Destructor", &TestDestructor),
+		WF_TEST("wfEpoch: Threads",    &TestThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,92 @@
+//
+// Checks that every key bit reaches the low bits of the integer hashes,
+// and that byte hashes do not depend on alignment.
+//
+// g++ -g -I../ -fsanitize=address,undefined hash_test.cpp -o hash_test
+//
+#include "wfTest.h"
+#include "wfHash.h"
+
+enum { kKeys = 1000, kLowBits = 16 };
+
+// flipping any bit of a key must flip every low bit of its hash, the bits
+// hashed containers index with, about half of the time
+template <typename F>
+static bool Avalanches(F hash) {
+	for (u32 bit = 0; bit < 64; bit++) {
+		u32 flips[kLowBits] = { 0 };
+		u32 state = bit + 1;
+		for (u32 i = 0; i < kKeys; i++) {
+			const u64 key   = (static_cast<u64>(wfTestRandom(state)) << 32) | wfTestRandom(state);
+			const u64 delta = hash(key) ^ hash(key ^ (static_cast<u64>(1) << bit));
+			for (u32 low = 0; low < kLowBits; low++)
+				flips[low] += (delta >> low) & 1;
+		}
+		for (u32 low = 0; low < kLowBits; low++) {
+			if (flips[low] < kKeys * 35 / 100 || flips[low] > kKeys * 65 / 100)
+				return false;
+		}
+	}
+	return true;
+}
+
+struct Seeded {
+	explicit Seeded(u64 seed) : m_seed(seed) { }
+	u64 operator()(u64 key) const { return wfFunctional::wfHash<u64>()(key, m_seed); }
+	u64 m_seed;
+};
+
+struct Unseeded {
+	u64 operator()(u64 key) const { return wfFunctional::wfHash<u64>()(key); }
+};
+
+static bool TestIntegerAvalanche(wfTest *store) {
+	const u64 seeds[] = { 0, 1, 0xDEADBEEF, wfHashRandomSeed() };
+	for (size_t i = 0; i < WF_ARRAY_SIZE(seeds); i++)
+		WF_TEST_FAIL(Avalanches(Seeded(seeds[i])));
+	WF_TEST_FAIL(Avalanches(Unseeded()));
+	return true;
+}
+
+static bool TestSeeds(wfTest *store) {
+	WF_TEST_FAIL(wfHashRandomSeed() == wfHashRandomSeed());
+	WF_TEST_FAIL(wfFunctional::wfHash<u32>()(7, 1) != wfFunctional::wfHash<u32>()(7, 2));
+	WF_TEST_FAIL(wfHashBytes("key", 3, 1) != wfHashBytes("key", 3, 2));
+
+	wfFunctional::wfSeededHash<u32> a;
+	wfFunctional::wfSeededHash<u32> b(wfHashRandomSeed());
+	WF_TEST_FAIL(a(42) == b(42));
+	return true;
+}
+
+static bool TestBytesAlignment(wfTest *store) {
+	unsigned char source[1024 + 8];
+	u32           state = 1;
+	for (size_t i = 0; i < sizeof(source); i++)
+		source[i] = static_cast<unsigned char>(wfTestRandom(state));
+
+	unsigned char moved[1024 + 8];
+	for (size_t length = 0; length <= 1024; length += (length < 64) ? 1 : 37) {
+		const u64 expect = wfHashBytes(source, length, 5);
+		for (size_t offset = 1; offset < 8; offset++) {
+			memcpy(moved + offset, source, length);
+			WF_TEST_FAIL(wfHashBytes(moved + offset, length, 5) == expect);
+		}
+		if (length > 0) {
+			// every length sees a change in its last byte
+			source[length - 1] ^= 1;
+			WF_TEST_FAIL(wfHashBytes(source, length, 5) != expect);
+			source[length - 1] ^= 1;
+		}
+	}
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfHash: Integer Avalanche", &TestIntegerAvalanche),
+		WF_TEST("wfHash: Seeds",             &TestSeeds),
+		WF_TEST("wfHashBytes: Alignment",    &TestBytesAlignment)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,188 @@
+//
+// Checks two wfIntrusiveLists sharing a pool of items against a pair of
+// std::lists under random insertions, removals and splices, walked both
+// ways.
+//
+// g++ -g -I../ -fsanitize=address,undefined intrusivelist_test.cpp -o intrusivelist_test
+//
+#include "wfTest.h"
+#include "wfIntrusiveList.h"
+#include <algorithm>
+#include <list>
+
+enum { kItems = 64 };
+
+struct Item {
+	wfIntrusiveListNode<Item> m_node;
+	u32                       m_id;
+};
+
+typedef wfIntrusiveList<Item> List;
+typedef std::list<u32>        Reference;
+
+static bool Same(List& list, const Reference& reference) {
+	if (list.Count() != reference.size())
+		return false;
+
+	List::Iterator it = list.Begin();
+	for (Reference::const_iterator expect = reference.begin(); expect != reference.end(); ++expect, ++it) {
+		if (it == list.End() || it->m_id != *expect)
+			return false;
+	}
+	if (it != list.End())
+		return false;
+
+	for (Reference::const_reverse_iterator expect = reference.rbegin(); expect != reference.rend(); ++expect) {
+		if ((--it)->m_id != *expect)
+			return false;
+	}
+	return it == list.Begin() && (reference.empty() ? !list.GetFirst() : list.GetFirst()->m_id == reference.front());
+}
+
+template <typename I, typename C>
+static I At(C& container, size_t index) {
+	I it = container.begin();
+	while (index--)
+		++it;
+	return it;
+}
+
+static List::Iterator At(List& list, size_t index) {
+	List::Iterator it = list.Begin();
+	while (index--)
+		++it;
+	return it;
+}
+
+// takes an item out of the reference list it is in, if any
+static void Forget(Reference *references, u32 id) {
+	references[0].remove(id);
+	references[1].remove(id);
+}
+
+static bool TestRandom(wfTest *store) {
+	Item      items[kItems];
+	List      lists[2];
+	Reference references[2];
+	u32       state = 1;
+	for (u32 i = 0; i < kItems; i++) {
+		items[i].m_node.Init(&items[i]);
+		items[i].m_id = i;
+	}
+
+	for (u32 i = 0; i < 50000; i++) {
+		const u32  to        = wfTestRandom(state) % 2;
+		const u32  from      = wfTestRandom(state) % 2;
+		Item      &item      = items[wfTestRandom(state) % kItems];
+		Reference &reference = references[to];
+		const u32  operation = wfTestRandom(state) % 10;
+
+		if (operation < 3) {
+			// insertion takes the node out of whichever list it is in
+			if (operation == 2 && !reference.empty()) {
+				const size_t index    = wfTestRandom(state) % reference.size();
+				Item        *position = &items[*At<Reference::iterator>(reference, index)];
+				if (position != &item) {
+					lists[to].InsertBefore(&position->m_node, &item.m_node);
+					Forget(references, item.m_id);
+					reference.insert(std::find(reference.begin(), reference.end(), position->m_id), item.m_id);
+				}
+			} else if (operation == 0) {
+				lists[to].Append(&item.m_node);
+				Forget(references, item.m_id);
+				reference.push_back(item.m_id);
+			} else {
+				lists[to].Prepend(&item.m_node);
+				Forget(references, item.m_id);
+				reference.push_front(item.m_id);
+			}
+		} else if (operation == 3) {
+			item.m_node.Unlink();
+			Forget(references, item.m_id);
+		} else if (operation == 4) {
+			Item *taken = (i % 2) ? lists[to].TakeFirst() : lists[to].TakeLast();
+			WF_TEST_FAIL(reference.empty() ? !taken : (taken && !taken->m_node.IsLinked()));
+			if (taken)
+				reference.remove(taken->m_id);
+		} else if (operation == 5 && from != to) {
+			const size_t index = reference.empty() ? 0 : wfTestRandom(state) % (reference.size() + 1);
+			lists[to].Splice(At(lists[to], index), lists[from]);
+			reference.splice(At<Reference::iterator>(reference, index), references[from]);
+		} else if (operation == 6 && !references[from].empty()) {
+			// a range of one list before a position outside of it, in any list
+			const size_t size   = references[from].size();
+			const size_t first  = wfTestRandom(state) % size;
+			const size_t end    = first + wfTestRandom(state) % (size - first + 1);
+			size_t       target = wfTestRandom(state) % (reference.size() + 1);
+			if (from == to && target >= first && target < end)
+				target = end;
+			lists[to].Splice(At(lists[to], target), At(lists[from], first), At(lists[from], end));
+			reference.splice(At<Reference::iterator>(reference, target), references[from],
+			                 At<Reference::iterator>(references[from], first), At<Reference::iterator>(references[from], end));
+		} else if (operation == 7 && !reference.empty()) {
+			const size_t        index  = wfTestRandom(state) % reference.size();
+			List::Iterator      next   = lists[to].Remove(At(lists[to], index));
+			Reference::iterator expect = reference.erase(At<Reference::iterator>(reference, index));
+			WF_TEST_FAIL(expect == reference.end() ? next == lists[to].End() : next->m_id == *expect);
+		} else if (operation == 8 && i % 16 == 0) {
+			lists[0].Swap(lists[1]);
+			references[0].swap(references[1]);
+		}
+
+		WF_TEST_FAIL(Same(lists[0], references[0]) && Same(lists[1], references[1]));
+		const size_t listed = std::count(references[0].begin(), references[0].end(), item.m_id)
+		                    + std::count(references[1].begin(), references[1].end(), item.m_id);
+		WF_TEST_FAIL(item.m_node.IsLinked() == (listed == 1));
+	}
+	return true;
+}
+
+struct UnlinkOdd {
+	void operator()(Item& item) const {
+		if (item.m_id % 2)
+			item.m_node.Unlink();
+	}
+};
+
+static bool TestLifetimes(wfTest *store) {
+	Item items[8];
+	for (u32 i = 0; i < 8; i++) {
+		items[i].m_node.Init(&items[i]);
+		items[i].m_id = i;
+	}
+
+	{
+		List list;
+		for (u32 i = 0; i < 8; i++)
+			list.Append(&items[i].m_node);
+
+		// items unlinking themselves while visited, and destroyed while linked
+		list.ForEach(UnlinkOdd());
+		WF_TEST_FAIL(list.Count() == 4 && !items[1].m_node.IsLinked() && items[2].m_node.IsLinked());
+		{
+			Item temporary;
+			temporary.m_node.Init(&temporary);
+			temporary.m_id = 100;
+			list.InsertBefore(&items[4].m_node, &temporary.m_node);
+			WF_TEST_FAIL(list.Count() == 5);
+		}
+		WF_TEST_FAIL(list.Count() == 4 && list.GetLast() == &items[6]);
+
+		// a copy of an item is in no list
+		const Item copy(items[0]);
+		WF_TEST_FAIL(!copy.m_node.IsLinked() && items[0].m_node.IsLinked());
+	}
+
+	// the list unlinked everything left in it when it went
+	for (u32 i = 0; i < 8; i++)
+		WF_TEST_FAIL(!items[i].m_node.IsLinked());
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfIntrusiveList: Random",    &TestRandom),
+		WF_TEST("wfIntrusiveList: Lifetimes", &TestLifetimes)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
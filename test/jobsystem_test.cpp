@@ -0,0 +1,134 @@
+//
+// Checks that wfJobSystem runs every job once, splits ParallelFor ranges
+// exactly, nests waits, and that its record pools stop growing.
+//
+// g++ -g -I../ -fsanitize=address,undefined jobsystem_test.cpp -o jobsystem_test -lpthread
+//
+#include "wfTest.h"
+#include "wfJobSystem.h"
+
+enum { kWorkers = 4, kJobs = 256, kFrames = 400 };
+
+static void Increment(void *data) {
+	wfAtomicFetchAdd(static_cast<volatile u32*>(data), 1u);
+}
+
+static bool TestRun(wfTest *store) {
+	wfJobSystem  system(kWorkers);
+	wfJobCounter counter;
+	volatile u32 runs = 0;
+
+	for (u32 i = 0; i < 10000; i++)
+		system.Run(&Increment, const_cast<u32*>(&runs), counter);
+	system.WaitFor(counter);
+	WF_TEST_FAIL(counter.Done() && runs == 10000);
+	return true;
+}
+
+struct Range {
+	volatile u32 *m_hits;
+	volatile u32  m_calls;
+};
+
+static void Mark(void *data, size_t begin, size_t end) {
+	Range *range = static_cast<Range*>(data);
+	for (size_t i = begin; i < end; i++)
+		wfAtomicFetchAdd(&range->m_hits[i], 1u);
+	wfAtomicFetchAdd(&range->m_calls, 1u);
+}
+
+static bool TestParallelFor(wfTest *store) {
+	wfJobSystem  system(kWorkers);
+	const size_t count = 100003;
+	u32         *hits  = new u32[count];
+	for (size_t i = 0; i < count; i++)
+		hits[i] = 0;
+
+	Range        range = { hits, 0 };
+	wfJobCounter counter;
+	system.ParallelFor(&Mark, &range, count, 1000, counter);
+	system.WaitFor(counter);
+
+	// every index once, in pieces of at most a grain
+	bool once = true;
+	for (size_t i = 0; i < count; i++)
+		once = once && hits[i] == 1;
+	delete[] hits;
+	WF_TEST_FAIL(once);
+	WF_TEST_FAIL(range.m_calls >= count / 1000);
+	return true;
+}
+
+struct Tree {
+	wfJobSystem  *m_system;
+	volatile u32 *m_leaves;
+	u32           m_depth;
+};
+
+// every level starts two children and waits for them inside the job
+static void Branch(void *data) {
+	Tree *tree = static_cast<Tree*>(data);
+	if (tree->m_depth == 0) {
+		wfAtomicFetchAdd(tree->m_leaves, 1u);
+		return;
+	}
+
+	Tree         children[2];
+	wfJobCounter counter;
+	for (u32 i = 0; i < 2; i++) {
+		children[i].m_system = tree->m_system;
+		children[i].m_leaves = tree->m_leaves;
+		children[i].m_depth  = tree->m_depth - 1;
+		tree->m_system->Run(&Branch, &children[i], counter);
+	}
+	tree->m_system->WaitFor(counter);
+}
+
+static bool TestNestedWaits(wfTest *store) {
+	wfJobSystem  system(kWorkers);
+	volatile u32 leaves = 0;
+	Tree         root   = { &system, &leaves, 10 };
+	wfJobCounter counter;
+	system.Run(&Branch, &root, counter);
+	system.WaitFor(counter);
+	WF_TEST_FAIL(leaves == 1u << 10);
+	return true;
+}
+
+static void Work(void *data) {
+	// long enough for the other workers to steal some of the jobs
+	volatile u32 spin = 0;
+	for (u32 i = 0; i < 2000; i++)
+		spin = spin + i;
+	Increment(data);
+}
+
+static bool TestPoolsBounded(wfTest *store) {
+	wfJobSystem  system(kWorkers);
+	volatile u32 runs = 0;
+	size_t       warm = 0;
+
+	// frames of jobs started by this thread and partly finished by others,
+	// whose records must come back to this thread's pool
+	for (u32 frame = 0; frame < kFrames; frame++) {
+		wfJobCounter counter;
+		for (u32 i = 0; i < kJobs; i++)
+			system.Run(&Work, const_cast<u32*>(&runs), counter);
+		system.WaitFor(counter);
+		if (frame == 10)
+			warm = system.GetJobRecordCount();
+	}
+	WF_TEST_FAIL(runs == kJobs * kFrames);
+	WF_TEST_FAIL(system.GetJobRecordCount() <= warm + kWorkers * kJobs);
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfJobSystem: Run",           &TestRun),
+		WF_TEST("wfJobSystem: ParallelFor",   &TestParallelFor),
+		WF_TEST("wfJobSystem: Nested Waits",  &TestNestedWaits),
+		WF_TEST("wfJobSystem: Pools Bounded", &TestPoolsBounded)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
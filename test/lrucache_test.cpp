@@ -0,0 +1,145 @@
+//
+// Checks wfLruCache against a list-and-map model of exact LRU, the clock
+// mode against the capacity, and wfShardedLruCache from several threads.
+//
+// g++ -g -I../ -fsanitize=address,undefined lrucache_test.cpp -o lrucache_test -lpthread
+//
+#include "wfTest.h"
+#include "wfLruCache.h"
+#include <list>
+#include <map>
+#include <string>
+
+struct CountEntries {
+	CountEntries() : m_count(0) { }
+	void operator()(const u32&, const u32&) { m_count++; }
+	size_t m_count;
+};
+
+typedef std::list<std::pair<u32, u32> > Order;
+typedef std::map<u32, Order::iterator>  Index;
+
+static bool TestLruRandom(wfTest *store) {
+	wfLruCache<u32, u32> cache(64);
+	Order                order;
+	Index                index;
+	u32                  state = 1;
+
+	for (u32 i = 0; i < 100000; i++) {
+		const u32 key       = wfTestRandom(state) % 256;
+		const u32 operation = wfTestRandom(state) % 3;
+		Index::iterator it = index.find(key);
+		if (operation == 0) {
+			const u32 value = wfTestRandom(state);
+			WF_TEST_FAIL(cache.Put(key, value) == (it == index.end()));
+			if (it != index.end()) {
+				order.erase(it->second);
+			} else if (order.size() == 64) {
+				index.erase(order.back().first);
+				order.pop_back();
+			}
+			order.push_front(std::make_pair(key, value));
+			index[key] = order.begin();
+		} else if (operation == 1) {
+			const u32 *value = cache.Get(key);
+			WF_TEST_FAIL((value != wfNullPointer) == (it != index.end()));
+			if (value) {
+				WF_TEST_FAIL(*value == it->second->second);
+				order.splice(order.begin(), order, it->second);
+			}
+		} else {
+			WF_TEST_FAIL(cache.Erase(key) == (it != index.end()));
+			if (it != index.end()) {
+				order.erase(it->second);
+				index.erase(it);
+			}
+		}
+		WF_TEST_FAIL(cache.Length() == order.size() && cache.Cost() == order.size());
+	}
+	return true;
+}
+
+static bool TestClockCapacity(wfTest *store) {
+	wfLruCache<u32, u32, kLruCacheMode_Clock> cache(100);
+	u32                                       state = 3;
+
+	for (u32 i = 0; i < 100000; i++) {
+		const u32 key = wfTestRandom(state) % 512;
+		if (wfTestRandom(state) % 2) {
+			cache.Put(key, key * 5, 1 + key % 8);
+			WF_TEST_FAIL(cache.Peek(key) && *cache.Peek(key) == key * 5);
+		} else {
+			const u32 *value = cache.Get(key);
+			WF_TEST_FAIL(!value || *value == key * 5);
+		}
+		WF_TEST_FAIL(cache.Cost() <= cache.Capacity());
+	}
+	WF_TEST_FAIL(cache.ForEach(CountEntries()).m_count == cache.Length());
+	return true;
+}
+
+static bool TestPutEvictedValue(wfTest *store) {
+	wfLruCache<u32, std::string> cache(4);
+	for (u32 i = 0; i < 4; i++)
+		cache.Put(i, std::string(64, static_cast<char>('a' + i)));
+
+	// the value being put belongs to the entry the put evicts
+	for (u32 i = 4; i < 64; i++) {
+		const std::string *oldest = cache.Peek(i - 4);
+		WF_TEST_FAIL(oldest != wfNullPointer);
+		cache.Put(i, *oldest);
+		WF_TEST_FAIL(cache.Length() == 4 && cache.Peek(i - 4) == wfNullPointer);
+		WF_TEST_FAIL(*cache.Peek(i) == std::string(64, static_cast<char>('a' + i % 4)));
+	}
+	return true;
+}
+
+enum { kThreads = 4, kKeys = 4096 };
+
+struct Worker {
+	wfShardedLruCache<u32, u32> *m_cache;
+	u32                          m_seed;
+	u32                          m_errors;
+
+	static void Run(void *argument) {
+		Worker &self  = *static_cast<Worker*>(argument);
+		u32     state = self.m_seed;
+		for (u32 i = 0; i < 50000; i++) {
+			const u32 key   = wfTestRandom(state) % kKeys;
+			u32       value = 0;
+			if (wfTestRandom(state) % 2)
+				self.m_cache->Put(key, key + 1);
+			else if (self.m_cache->Get(key, value) && value != key + 1)
+				self.m_errors++;
+		}
+	}
+};
+
+static bool TestShardedThreads(wfTest *store) {
+	wfShardedLruCache<u32, u32> cache(1024, 8);
+	wfThread                    threads[kThreads];
+	Worker                      workers[kThreads];
+
+	for (u32 i = 0; i < kThreads; i++) {
+		workers[i].m_cache  = &cache;
+		workers[i].m_seed   = i + 1;
+		workers[i].m_errors = 0;
+		threads[i].Start(&Worker::Run, &workers[i]);
+	}
+	for (u32 i = 0; i < kThreads; i++) {
+		threads[i].Join();
+		WF_TEST_FAIL(workers[i].m_errors == 0);
+	}
+	WF_TEST_FAIL(cache.Length() <= 1024 && cache.Cost() == cache.Length());
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfLruCache: Random",            &TestLruRandom),
+		WF_TEST("wfLruCache: Clock Capacity",    &TestClockCapacity),
+		WF_TEST("wfLruCache: Put Evicted Value", &TestPutEvictedValue),
+		WF_TEST("wfShardedLruCache: Threads",    &TestShardedThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,136 @@
+//
+// Hand-off benchmark for wfMpscQueue against an intrusive list behind a
+// mutex, which is what wfMpscQueue replaces.  Every producer pushes the
+// same number of preallocated items, a single consumer pops them in
+// batches until it has seen all of them.
+//
+// g++ -O2 -I../ mpscqueue_bench.cpp -o mpscqueue_bench -lpthread
+//
+#include <stdio.h>
+#include "wfTest.h"
+#include "wfMpscQueue.h"
+#include "wfIntrusiveList.h"
+#include "wfThread.h"
+
+static const u32 kItems = 1 << 20; // per producer
+static const u32 kBatch = 64;
+
+struct Item {
+	Item() :
+		m_queued(this),
+		m_listed(this)
+	{ }
+
+	u32                       m_value;
+	wfMpscQueueNode<Item>     m_queued;
+	wfIntrusiveListNode<Item> m_listed;
+};
+
+struct LockFreeQueue {
+	void Push(Item *item) {
+		m_queue.Push(&item->m_queued);
+	}
+
+	size_t PopBatch(Item **items, size_t count) {
+		return m_queue.PopBatch(items, count);
+	}
+
+	wfMpscQueue<Item> m_queue;
+};
+
+struct LockedQueue {
+	void Push(Item *item) {
+		wfLockGuard<wfMutex> guard(m_lock);
+		m_list.Append(&item->m_listed);
+	}
+
+	size_t PopBatch(Item **items, size_t count) {
+		wfLockGuard<wfMutex> guard(m_lock);
+		size_t popped = 0;
+		while (popped < count && !m_list.Empty())
+			items[popped++] = m_list.TakeFirst();
+		return popped;
+	}
+
+	wfMutex               m_lock;
+	wfIntrusiveList<Item> m_list;
+};
+
+template <typename Q>
+struct Producer {
+	Q            *m_queue;
+	Item         *m_items;
+	volatile u32 *m_start;
+
+	static void Run(void *argument) {
+		Producer &self = *static_cast<Producer*>(argument);
+
+		while (!wfAtomicLoad(self.m_start))
+			wfCpuRelax();
+
+		for (u32 i = 0; i < kItems; i++)
+			self.m_queue->Push(&self.m_items[i]);
+	}
+};
+
+template <typename Q>
+static double Measure(Q& queue, Item *items, u32 producers) {
+	wfThread      *thread  = new wfThread[producers];
+	Producer<Q>   *workers = new Producer<Q>[producers];
+	volatile u32   start   = 0;
+
+	for (u32 i = 0; i < producers; i++) {
+		workers[i].m_queue = &queue;
+		workers[i].m_items = items + i * kItems;
+		workers[i].m_start = &start;
+		thread[i].Start(&Producer<Q>::Run, &workers[i]);
+	}
+
+	const double begin = wfTestNow();
+	wfAtomicStore(&start, 1u);
+
+	Item  *batch[kBatch];
+	u32    sum   = 0;
+	size_t total = 0;
+	while (total < (size_t)producers * kItems) {
+		const size_t popped = queue.PopBatch(batch, kBatch);
+		for (size_t i = 0; i < popped; i++)
+			sum += batch[i]->m_value;
+		total += popped;
+		if (popped == 0)
+			wfCpuRelax();
+	}
+	const double end = wfTestNow();
+
+	for (u32 i = 0; i < producers; i++)
+		thread[i].Join();
+
+	delete[] workers;
+	delete[] thread;
+
+	if (sum == 0xFFFFFFFFu)
+		printf("(unlikely checksum)\n");
+
+	// millions of items handed over per second
+	return (double)producers * kItems / (end - begin) / 1e6;
+}
+
+int main()
+{
+	const u32 maxProducers = 16;
+	Item     *items        = new Item[maxProducers * kItems];
+	for (u32 i = 0; i < maxProducers * kItems; i++)
+		items[i].m_value = i;
+
+	printf("producers   wfMutex+list   wfMpscQueue   (Mitems/s, batches of %u)\n", kBatch);
+	for (u32 producers = 1; producers <= maxProducers; producers <<= 1) {
+		LockedQueue   locked;
+		LockFreeQueue lockFree;
+		const double a = Measure(locked,   items, producers);
+		const double b = Measure(lockFree, items, producers);
+		printf("%9u   %12.2f   %11.2f\n", producers, a, b);
+	}
+
+	delete[] items;
+	return 0;
+}
@@ -0,0 +1,154 @@
+//
+// Checks wfMpscQueue against a std::deque on one thread, and that items
+// pushed by many producers reach the consumer once each, in the order
+// every producer pushed them.
+//
+// g++ -g -I../ -fsanitize=address,undefined mpscqueue_test.cpp -o mpscqueue_test -lpthread
+//
+#include "wfTest.h"
+#include "wfMpscQueue.h"
+#include "wfThread.h"
+#include <deque>
+#include <vector>
+
+struct Item {
+	wfMpscQueueNode<Item> m_node;
+	u32                   m_value;
+};
+
+typedef wfMpscQueue<Item> Queue;
+
+struct Record {
+	std::vector<u32> *m_values;
+	void operator()(Item *item) const { m_values->push_back(item->m_value); }
+};
+
+static bool TestOrder(wfTest *store) {
+	enum { kItems = 256 };
+	Item            *items = new Item[kItems];
+	Queue            queue;
+	std::deque<u32>  reference;
+	std::vector<u32> idle;
+	u32              state = 1;
+	for (u32 i = 0; i < kItems; i++) {
+		items[i].m_node.Init(&items[i]);
+		items[i].m_value = i;
+		idle.push_back(i);
+	}
+
+	WF_TEST_FAIL(queue.Empty() && !queue.Pop());
+	for (u32 i = 0; i < 100000; i++) {
+		const u32 operation = wfTestRandom(state) % 6;
+		if (operation < 2 && !idle.empty()) {
+			queue.Push(&items[idle.back()].m_node);
+			reference.push_back(idle.back());
+			idle.pop_back();
+		} else if (operation == 2 && !idle.empty()) {
+			// a chain of nodes linked in one step
+			wfMpscQueueNode<Item> *nodes[8];
+			size_t count = wfTestRandom(state) % WF_ARRAY_SIZE(nodes);
+			if (count > idle.size())
+				count = idle.size();
+			for (size_t j = 0; j < count; j++) {
+				nodes[j] = &items[idle.back()].m_node;
+				reference.push_back(idle.back());
+				idle.pop_back();
+			}
+			queue.Push(nodes, count);
+		} else if (operation == 3) {
+			Item        *popped[8];
+			const size_t count = queue.PopBatch(popped, wfTestRandom(state) % WF_ARRAY_SIZE(popped));
+			for (size_t j = 0; j < count; j++) {
+				WF_TEST_FAIL(!reference.empty() && popped[j]->m_value == reference.front());
+				idle.push_back(reference.front());
+				reference.pop_front();
+			}
+		} else {
+			Item *item = queue.Pop();
+			WF_TEST_FAIL(reference.empty() ? !item : (item && item->m_value == reference.front()));
+			if (item) {
+				idle.push_back(reference.front());
+				reference.pop_front();
+			}
+		}
+		WF_TEST_FAIL(queue.Empty() == reference.empty());
+	}
+
+	std::vector<u32> drained;
+	Record record = { &drained };
+	WF_TEST_FAIL(queue.Drain(record) == reference.size());
+	WF_TEST_FAIL(drained == std::vector<u32>(reference.begin(), reference.end()));
+	WF_TEST_FAIL(queue.Empty() && !queue.Pop());
+	delete[] items;
+	return true;
+}
+
+enum { kProducers = 4, kPerProducer = 50000 };
+
+struct Producer {
+	Queue *m_queue;
+	Item  *m_items;
+
+	// every fourth step pushes a chain of items at once
+	static void Run(void *argument) {
+		Producer &self = *static_cast<Producer*>(argument);
+		for (u32 i = 0; i < kPerProducer; ) {
+			if (i % 4 == 0 && i + 3 <= kPerProducer) {
+				wfMpscQueueNode<Item> *nodes[3] = { &self.m_items[i].m_node, &self.m_items[i + 1].m_node, &self.m_items[i + 2].m_node };
+				self.m_queue->Push(nodes, 3);
+				i += 3;
+			} else {
+				self.m_queue->Push(&self.m_items[i++].m_node);
+			}
+		}
+	}
+};
+
+static bool TestThreads(wfTest *store) {
+	Queue    queue;
+	Item    *items = new Item[kProducers * kPerProducer];
+	Producer producers[kProducers];
+	wfThread threads[kProducers];
+	for (u32 i = 0; i < kProducers * kPerProducer; i++) {
+		items[i].m_node.Init(&items[i]);
+		items[i].m_value = i;
+	}
+	for (u32 i = 0; i < kProducers; i++) {
+		producers[i].m_queue = &queue;
+		producers[i].m_items = items + i * kPerProducer;
+		threads[i].Start(&Producer::Run, &producers[i]);
+	}
+
+	// the next value expected of every producer
+	u32 next[kProducers];
+	for (u32 i = 0; i < kProducers; i++)
+		next[i] = i * kPerProducer;
+
+	u32 received = 0;
+	u32 errors   = 0;
+	while (received < kProducers * kPerProducer) {
+		Item *item = queue.Pop();
+		if (!item) {
+			wfThreadYield();
+			continue;
+		}
+		const u32 producer = item->m_value / kPerProducer;
+		if (item->m_value != next[producer]++)
+			errors++;
+		received++;
+	}
+
+	for (u32 i = 0; i < kProducers; i++)
+		threads[i].Join();
+	WF_TEST_FAIL(errors == 0 && queue.Empty() && !queue.Pop());
+	delete[] items;
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfMpscQueue: Order",   &TestOrder),
+		WF_TEST("wfMpscQueue: Threads", &TestThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,161 @@
+//
+// Checks that every version of a wfPersistentMap keeps its contents while
+// later versions change, against a std::map per version, and that other
+// threads can walk snapshots while the owner keeps updating.
+//
+// g++ -g -I../ -fsanitize=address,undefined persistentmap_test.cpp -o persistentmap_test -lpthread
+//
+#include "wfTest.h"
+#include "wfPersistentMap.h"
+#include "wfThread.h"
+#include <map>
+#include <string>
+#include <vector>
+
+typedef wfPersistentMap<u32, std::string>         Map;
+typedef std::map<u32, std::string>                Reference;
+typedef std::vector<std::pair<u32, std::string> > Pairs;
+
+struct Collect {
+	Pairs *m_pairs;
+	void operator()(const u32& key, const std::string& value) const { m_pairs->push_back(std::make_pair(key, value)); }
+};
+
+static bool Same(const Map& map, const Reference& reference) {
+	Pairs   pairs;
+	Collect collect = { &pairs };
+	map.ForEach(collect);
+	return map.Length() == reference.size() && pairs == Pairs(reference.begin(), reference.end());
+}
+
+static std::string Value(u32 i) {
+	char buffer[48];
+	snprintf(buffer, sizeof(buffer), "value %u, long enough to allocate", i);
+	return buffer;
+}
+
+static bool TestVersions(wfTest *store) {
+	std::vector<Map>       versions;
+	std::vector<Reference> references;
+	Map                    map;
+	Reference              reference;
+	u32                    state = 1;
+
+	for (u32 i = 0; i < 20000; i++) {
+		const u32 key = wfTestRandom(state) % 1000;
+		if (wfTestRandom(state) % 3 != 0) {
+			map = map.Insert(key, Value(i));
+			reference[key] = Value(i);
+		} else {
+			map = map.Erase(key);
+			reference.erase(key);
+		}
+		WF_TEST_FAIL(map.Length() == reference.size());
+
+		const u32           probe = wfTestRandom(state) % 1000;
+		const std::string  *value = map.Find(probe);
+		Reference::iterator it    = reference.find(probe);
+		WF_TEST_FAIL(it == reference.end() ? !value : (value && *value == it->second));
+		WF_TEST_FAIL(map.Count(probe) == reference.count(probe));
+
+		if (i % 500 == 0) {
+			versions.push_back(map);
+			references.push_back(reference);
+			WF_TEST_FAIL(versions.back().Shares(map));
+		}
+	}
+
+	// every old version is as it was when it was taken
+	for (size_t i = 0; i < versions.size(); i++)
+		WF_TEST_FAIL(Same(versions[i], references[i]));
+	WF_TEST_FAIL(Same(map, reference));
+
+	// an erase of a missing key changes nothing, an insert changes only the result
+	const Map same = map.Erase(1000u);
+	WF_TEST_FAIL(same.Shares(map));
+	const Map next = map.Insert(1000, Value(0));
+	WF_TEST_FAIL(!next.Shares(map) && next.Length() == map.Length() + 1 && map.Count(1000u) == 0);
+
+	versions.clear();
+	map = Map();
+	WF_TEST_FAIL(map.Empty() && !map.Find(0u));
+	return true;
+}
+
+enum { kReaders = 3, kKeys = 512, kUpdates = 20000 };
+
+struct Walker {
+	Map          m_snapshot;
+	Reference    m_reference;
+	volatile u32 m_done;
+	u32          m_errors;
+
+	// copies of the snapshot come and go while the owner frees the nodes
+	// its own version no longer uses
+	static void Run(void *argument) {
+		Walker &self = *static_cast<Walker*>(argument);
+		while (!wfAtomicLoad(&self.m_done)) {
+			const Map copy(self.m_snapshot);
+			if (!Same(copy, self.m_reference))
+				self.m_errors++;
+		}
+	}
+};
+
+// keys of other types than the key type are converted to it first, an
+// unsigned key finds the pairs of a map with signed keys
+static bool TestConvertedLookup(wfTest *store) {
+	wfPersistentMap<int, u32> map;
+	for (int i = -50; i <= 50; i++)
+		map = map.Insert(i, static_cast<u32>(i + 50));
+
+	for (u32 i = 0; i <= 50; i++)
+		WF_TEST_FAIL(map.Find(i) && *map.Find(i) == i + 50 && map.Count(i) == 1);
+	WF_TEST_FAIL(map.Count(51u) == 0 && map.Count(static_cast<short>(-7)) == 1);
+
+	const wfPersistentMap<int, u32> erased = map.Erase(7u);
+	WF_TEST_FAIL(erased.Count(7) == 0 && erased.Length() == 100 && map.Count(7u) == 1);
+	WF_TEST_FAIL(erased.Erase(7u).Shares(erased));
+	return true;
+}
+
+static bool TestThreads(wfTest *store) {
+	Map       map;
+	Reference reference;
+	u32       state = 5;
+	for (u32 key = 0; key < kKeys; key++) {
+		map = map.Insert(key, Value(key));
+		reference[key] = Value(key);
+	}
+
+	Walker   walkers[kReaders];
+	wfThread threads[kReaders];
+	for (u32 i = 0; i < kReaders; i++) {
+		walkers[i].m_snapshot  = map;
+		walkers[i].m_reference = reference;
+		walkers[i].m_done      = 0;
+		walkers[i].m_errors    = 0;
+		threads[i].Start(&Walker::Run, &walkers[i]);
+	}
+
+	for (u32 i = 0; i < kUpdates; i++) {
+		const u32 key = wfTestRandom(state) % kKeys;
+		map = (i % 2) ? map.Erase(key) : map.Insert(key, Value(i));
+	}
+
+	for (u32 i = 0; i < kReaders; i++) {
+		wfAtomicStore(&walkers[i].m_done, 1u);
+		threads[i].Join();
+		WF_TEST_FAIL(walkers[i].m_errors == 0);
+	}
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfPersistentMap: Versions",         &TestVersions),
+		WF_TEST("wfPersistentMap: Converted Lookup", &TestConvertedLookup),
+		WF_TEST("wfPersistentMap: Threads",          &TestThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,135 @@
+//
+// Benchmark of wfPriorityQueue and wfPairingHeap against a list kept sorted
+// by insertion, which is how timers were scheduled before.  Runs the hold
+// model: a queue of a fixed number of pending timers, from which the
+// earliest is popped and rescheduled a random delay later, over and over.
+//
+// The sorted list is an intrusive list with every new timer inserted by
+// walking from the back, which is what an InsertionSort of a sorted list
+// with one new element at the tail does.
+//
+// g++ -O2 -I../ priorityqueue_bench.cpp -o priorityqueue_bench
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include "wfTest.h"
+#include "wfPriorityQueue.h"
+#include "wfIntrusiveList.h"
+
+static const u32 kOperations = 1 << 20;
+
+// same sequence of delays for every contender
+static u32 Delay(u32& state) {
+	state = state * 1664525u + 1013904223u;
+	return (state >> 16) & 0xFFFF;
+}
+
+struct Timer {
+	Timer() :
+		m_listed(this),
+		m_heaped(this)
+	{ }
+
+	bool operator < (const Timer& other) const { return m_deadline < other.m_deadline; }
+
+	u64                        m_deadline;
+	wfIntrusiveListNode<Timer> m_listed;
+	wfPairingHeapNode<Timer>   m_heaped;
+};
+
+static u64 SortedList(Timer *timers, u32 count) {
+	wfIntrusiveList<Timer> list;
+	u32                    state = 1;
+	u64                    now   = 0;
+
+	for (u32 i = 0; i < count + kOperations; i++) {
+		Timer *timer;
+		if (i < count) {
+			timer = &timers[i];
+		} else {
+			timer = list.TakeFirst();
+			now   = timer->m_deadline;
+		}
+		timer->m_deadline = now + Delay(state);
+
+		wfIntrusiveList<Timer>::Iterator position = list.End();
+		while (position != list.Begin()) {
+			wfIntrusiveList<Timer>::Iterator previous = position;
+			--previous;
+			if (!(timer->m_deadline < (*previous).m_deadline))
+				break;
+			position = previous;
+		}
+		list.Insert(position, &timer->m_listed);
+	}
+	return now;
+}
+
+static u64 QuaternaryHeap(Timer *, u32 count) {
+	wfPriorityQueue<u64> queue;
+	u32                  state = 1;
+	u64                  now   = 0;
+
+	queue.Reserve(count);
+	for (u32 i = 0; i < count + kOperations; i++) {
+		if (i >= count) {
+			now = queue.Top();
+			queue.Pop();
+		}
+		queue.Push(now + Delay(state));
+	}
+	return now;
+}
+
+static u64 PairingHeap(Timer *timers, u32 count) {
+	wfPairingHeap<Timer> heap;
+	u32                  state = 1;
+	u64                  now   = 0;
+
+	for (u32 i = 0; i < count + kOperations; i++) {
+		Timer *timer;
+		if (i < count) {
+			timer = &timers[i];
+		} else {
+			timer = heap.Pop();
+			now   = timer->m_deadline;
+		}
+		timer->m_deadline = now + Delay(state);
+		heap.Push(&timer->m_heaped);
+	}
+	return now;
+}
+
+static double Measure(u64 (*run)(Timer *, u32), Timer *timers, u32 count, u64 &result) {
+	const double begin = wfTestNow();
+	result = run(timers, count);
+	const double end = wfTestNow();
+
+	// nanoseconds per pop and push
+	return (end - begin) / (count + kOperations) * 1e9;
+}
+
+int main()
+{
+	const u32 maxCount = 1 << 16;
+	Timer    *timers   = new Timer[maxCount];
+
+	printf("  pending   sorted list   wfPriorityQueue   wfPairingHeap   (ns per reschedule)\n");
+	for (u32 count = 16; count <= maxCount; count <<= 2) {
+		u64 a = 0, b = 0, c = 0;
+		const double list    = count <= 4096 ? Measure(SortedList, timers, count, a) : 0.0;
+		const double heap    = Measure(QuaternaryHeap, timers, count, b);
+		const double pairing = Measure(PairingHeap,    timers, count, c);
+
+		if ((count <= 4096 && a != b) || b != c)
+			printf("mismatch\n");
+
+		if (count <= 4096)
+			printf("%9u   %11.1f   %15.1f   %13.1f\n", count, list, heap, pairing);
+		else
+			printf("%9u   %11s   %15.1f   %13.1f\n", count, "-", heap, pairing);
+	}
+
+	delete[] timers;
+	return 0;
+}
@@ -0,0 +1,148 @@
+//
+// Checks wfPriorityQueue and wfPairingHeap against a std::multiset under
+// random pushes, pops, erasures and key changes.
+//
+// g++ -g -I../ -fsanitize=address,undefined priorityqueue_test.cpp -o priorityqueue_test
+//
+#include "wfTest.h"
+#include "wfPriorityQueue.h"
+#include <set>
+#include <vector>
+
+static bool TestQueueRandom(wfTest *store) {
+	wfPriorityQueue<u32>               queue;
+	std::multiset<u32>                 reference;
+	std::vector<wfPriorityQueueHandle> handles;
+	u32                                state = 1;
+
+	for (u32 i = 0; i < 200000; i++) {
+		const u32 operation = wfTestRandom(state) % 8;
+		if (operation < 4 || handles.empty()) {
+			const u32 value = wfTestRandom(state) % 1000;
+			handles.push_back(queue.Push(value));
+			reference.insert(value);
+		} else if (operation == 4) {
+			const wfPriorityQueueHandle top = queue.TopHandle();
+			WF_TEST_FAIL(queue.Top() == *reference.begin());
+			reference.erase(reference.begin());
+			queue.Pop();
+			for (size_t j = 0; j < handles.size(); j++) {
+				if (handles[j] == top) {
+					handles[j] = handles.back();
+					handles.pop_back();
+					break;
+				}
+			}
+		} else {
+			const size_t                index  = wfTestRandom(state) % handles.size();
+			const wfPriorityQueueHandle handle = handles[index];
+			const u32                   old    = queue.Get(handle);
+			reference.erase(reference.find(old));
+			if (operation == 5) {
+				queue.Erase(handle);
+				handles[index] = handles.back();
+				handles.pop_back();
+			} else if (operation == 6) {
+				const u32 value = wfTestRandom(state) % 1000;
+				queue.Update(handle, value);
+				reference.insert(value);
+			} else {
+				const u32 value = old / 2;
+				queue.DecreaseKey(handle, value);
+				reference.insert(value);
+			}
+		}
+		WF_TEST_FAIL(queue.Length() == reference.size());
+		WF_TEST_FAIL(queue.Empty() || queue.Top() == *reference.begin());
+	}
+	return true;
+}
+
+static bool TestQueuePushOwnElement(wfTest *store) {
+	wfPriorityQueue<u32> queue;
+	queue.Push(7);
+	// pushing the top while full reallocates underneath the reference
+	for (u32 i = 0; i < 100; i++)
+		queue.Push(queue.Top());
+	WF_TEST_FAIL(queue.Length() == 101);
+	while (!queue.Empty()) {
+		WF_TEST_FAIL(queue.Top() == 7);
+		queue.Pop();
+	}
+	return true;
+}
+
+struct Timer {
+	Timer() :
+		m_node(this)
+	{ }
+
+	bool operator < (const Timer& other) const { return m_deadline < other.m_deadline; }
+
+	u32                      m_deadline;
+	wfPairingHeapNode<Timer> m_node;
+};
+
+static bool TestPairingHeapRandom(wfTest *store) {
+	const u32             count  = 2048;
+	Timer                *timers = new Timer[count];
+	wfPairingHeap<Timer>  heap;
+	std::multiset<u32>    reference;
+	u32                   state  = 7;
+
+	for (u32 i = 0; i < 200000; i++) {
+		Timer *timer = &timers[wfTestRandom(state) % count];
+		const u32 operation = wfTestRandom(state) % 4;
+		if (!timer->m_node.IsLinked()) {
+			timer->m_deadline = wfTestRandom(state) % 100000;
+			heap.Push(&timer->m_node);
+			reference.insert(timer->m_deadline);
+		} else if (operation == 0) {
+			Timer *top = heap.Pop();
+			WF_TEST_FAIL(top && top->m_deadline == *reference.begin());
+			reference.erase(reference.begin());
+		} else if (operation == 1) {
+			reference.erase(reference.find(timer->m_deadline));
+			heap.Remove(&timer->m_node);
+			WF_TEST_FAIL(!timer->m_node.IsLinked());
+		} else {
+			reference.erase(reference.find(timer->m_deadline));
+			timer->m_deadline /= 2;
+			heap.DecreaseKey(&timer->m_node);
+			reference.insert(timer->m_deadline);
+		}
+		WF_TEST_FAIL(heap.Length() == reference.size());
+		WF_TEST_FAIL(heap.Empty() || heap.Top()->m_deadline == *reference.begin());
+	}
+
+	heap.Clear();
+	delete[] timers;
+	return true;
+}
+
+static bool TestPairingHeapMerge(wfTest *store) {
+	Timer                timers[64];
+	wfPairingHeap<Timer> a;
+	wfPairingHeap<Timer> b;
+
+	for (u32 i = 0; i < 64; i++) {
+		timers[i].m_deadline = (i * 37) % 64;
+		(i & 1 ? a : b).Push(&timers[i].m_node);
+	}
+	a.Merge(b);
+	WF_TEST_FAIL(b.Empty() && a.Length() == 64);
+	for (u32 i = 0; i < 64; i++)
+		WF_TEST_FAIL(a.Pop()->m_deadline == i);
+	WF_TEST_FAIL(a.Empty());
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfPriorityQueue: Random",           &TestQueueRandom),
+		WF_TEST("wfPriorityQueue: Push Own Element", &TestQueuePushOwnElement),
+		WF_TEST("wfPairingHeap: Random",             &TestPairingHeapRandom),
+		WF_TEST("wfPairingHeap: Merge",              &TestPairingHeapMerge)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -0,0 +1,149 @@
+//
+// Checks wfRadixMap against a std::map of std::string keys under random
+// insertions and erasures, and its ordered and prefix walks.
+//
+// g++ -g -I../ -fsanitize=address,undefined radixmap_test.cpp -o radixmap_test
+//
+#include "wfTest.h"
+#include "wfRadixMap.h"
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, u32>                Reference;
+typedef std::vector<std::pair<std::string, u32> > Keys;
+
+static wfStringRef Ref(const std::string& key) {
+	return wfStringRef(key.data(), key.length());
+}
+
+// keys sharing prefixes longer than a node holds inline, keys with zero
+// bytes and keys that are prefixes of others, over alphabets wide enough
+// to fill every node layout
+static std::string RandomKey(u32& state) {
+	static const char *const prefixes[]  = { "", "a", "metrics.server.requests.", "x\0y" };
+	static const size_t      lengths[]   = { 0,  1,   24,                          3     };
+	static const u32         alphabets[] = { 3, 12, 40, 256 };
+
+	const u32   which    = wfTestRandom(state) % WF_ARRAY_SIZE(prefixes);
+	const u32   alphabet = alphabets[wfTestRandom(state) % WF_ARRAY_SIZE(alphabets)];
+	std::string key(prefixes[which], lengths[which]);
+	for (u32 length = wfTestRandom(state) % 5; length; length--)
+		key += static_cast<char>(wfTestRandom(state) % alphabet);
+	return key;
+}
+
+struct Collect {
+	Keys *m_keys;
+	void operator()(const wfStringRef& key, const u32& value) const {
+		m_keys->push_back(std::make_pair(std::string(key.Data(), key.Length()), value));
+	}
+};
+
+// the keys walked are exactly those of the range, in its order
+static bool Same(const Keys& keys, Reference::iterator begin, Reference::iterator end) {
+	Keys::const_iterator it = keys.begin();
+	for (; begin != end; ++begin, ++it) {
+		if (it == keys.end() || it->first != begin->first || it->second != begin->second)
+			return false;
+	}
+	return it == keys.end();
+}
+
+static bool TestRandom(wfTest *store) {
+	wfRadixMap<u32> map;
+	Reference       reference;
+	u32             state = 1;
+
+	for (u32 i = 0; i < 100000; i++) {
+		const std::string key       = RandomKey(state);
+		const u32         operation = wfTestRandom(state) % 8;
+		if (operation < 3) {
+			// a key already present keeps its value
+			const u32 expect = reference.insert(std::make_pair(key, i)).first->second;
+			WF_TEST_FAIL(map.Insert(Ref(key), i) == expect);
+		} else if (operation == 3) {
+			map[Ref(key)] = i;
+			reference[key] = i;
+		} else {
+			WF_TEST_FAIL(map.Erase(Ref(key)) == (reference.erase(key) == 1));
+		}
+		WF_TEST_FAIL(map.Length() == reference.size());
+
+		const std::string   probe = RandomKey(state);
+		Reference::iterator it    = reference.find(probe);
+		const u32          *value = map.Find(Ref(probe));
+		WF_TEST_FAIL(it == reference.end() ? !value : (value && *value == it->second));
+		WF_TEST_FAIL(map.Count(Ref(probe)) == reference.count(probe));
+	}
+
+	// the walk is in the order of the std::map, memcmp with shorter first
+	Keys    keys;
+	Collect collect = { &keys };
+	static_cast<const wfRadixMap<u32>&>(map).ForEach(collect);
+	WF_TEST_FAIL(keys.size() == reference.size());
+	WF_TEST_FAIL(Same(keys, reference.begin(), reference.end()));
+
+	// erasing everything shrinks every node back down
+	for (Reference::iterator it = reference.begin(); it != reference.end(); ++it)
+		WF_TEST_FAIL(map.Erase(Ref(it->first)));
+	WF_TEST_FAIL(map.Empty());
+	for (Reference::iterator it = reference.begin(); it != reference.end(); ++it)
+		WF_TEST_FAIL(!map.Find(Ref(it->first)));
+	return true;
+}
+
+static bool TestPrefixes(wfTest *store) {
+	wfRadixMap<u32> map;
+	Reference       reference;
+	u32             state = 7;
+	for (u32 i = 0; i < 5000; i++) {
+		const std::string key = RandomKey(state);
+		map.Insert(Ref(key), i);
+		reference.insert(std::make_pair(key, i));
+	}
+
+	for (u32 i = 0; i < 2000; i++) {
+		std::string probe = RandomKey(state);
+		probe += RandomKey(state).substr(0, 3);
+
+		// the keys starting with a prefix of the probe
+		const std::string prefix = probe.substr(0, wfTestRandom(state) % (probe.length() + 1));
+		Keys    keys;
+		Collect collect = { &keys };
+		map.ForEachPrefix(Ref(prefix), collect);
+
+		Reference::iterator begin = reference.lower_bound(prefix);
+		Reference::iterator end   = begin;
+		while (end != reference.end() && end->first.compare(0, prefix.length(), prefix) == 0)
+			++end;
+		WF_TEST_FAIL(Same(keys, begin, end));
+
+		// the longest key the probe starts with
+		size_t longest = std::string::npos;
+		for (size_t length = 0; length <= probe.length(); length++) {
+			if (reference.count(probe.substr(0, length)))
+				longest = length;
+		}
+		wfStringRef match;
+		const u32  *value = map.LongestPrefix(Ref(probe), &match);
+		if (longest == std::string::npos) {
+			WF_TEST_FAIL(!value);
+		} else {
+			WF_TEST_FAIL(value && *value == reference[probe.substr(0, longest)]);
+			WF_TEST_FAIL(std::string(match.Data(), match.Length()) == probe.substr(0, longest));
+		}
+	}
+
+	map.Clear();
+	WF_TEST_FAIL(map.Empty() && !map.Find(Ref(reference.begin()->first)));
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfRadixMap: Random",   &TestRandom),
+		WF_TEST("wfRadixMap: Prefixes", &TestPrefixes)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
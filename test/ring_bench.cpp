@@ -0,0 +1,232 @@
+//
+// Throughput and latency benchmark for wfSpscRing and wfMpmcRing against a
+// wfDeque behind a mutex.  Throughput streams items from producers to
+// consumers in batches; latency bounces a single item between two threads
+// through a pair of rings and reports the round trip.  A sudden drop in
+// either column after a change to the layout of the rings is the sign of
+// indices sharing a cache line.
+//
+// g++ -O2 -I../ ring_bench.cpp -o ring_bench -lpthread
+//
+#include <stdio.h>
+#include "wfTest.h"
+#include "wfRing.h"
+#include "wfDeque.h"
+#include "wfThread.h"
+
+static const u32 kItems  = 1 << 22; // per producer
+static const u32 kRounds = 1 << 18;
+static const u32 kBatch  = 32;
+
+// spins for a while and then yields, so that an oversubscribed machine
+// still makes progress
+struct Backoff {
+	Backoff() : m_spins(0) { }
+
+	void Wait() {
+		if (++m_spins < 64)
+			wfCpuRelax();
+		else
+			wfThreadYield();
+	}
+
+	void Reset() { m_spins = 0; }
+
+	u32 m_spins;
+};
+
+struct LockedQueue {
+	size_t TryPushBatch(const u32 *values, size_t count) {
+		wfLockGuard<wfMutex> guard(m_lock);
+		if (m_queue.Length() + count > 1024)
+			count = m_queue.Length() < 1024 ? 1024 - m_queue.Length() : 0;
+		m_queue.PushBack(values, count);
+		return count;
+	}
+
+	size_t TryPopBatch(u32 *values, size_t count) {
+		wfLockGuard<wfMutex> guard(m_lock);
+		return m_queue.PopFront(values, count);
+	}
+
+	wfMutex      m_lock;
+	wfDeque<u32> m_queue;
+};
+
+struct SpscQueue {
+	size_t TryPushBatch(const u32 *values, size_t count) { return m_ring.TryPushBatch(values, count); }
+	size_t TryPopBatch (u32 *values, size_t count)       { return m_ring.TryPopBatch(values, count); }
+
+	wfSpscRing<u32, 1024> m_ring;
+};
+
+struct MpmcQueue {
+	MpmcQueue() : m_ring(1024) { }
+
+	size_t TryPushBatch(const u32 *values, size_t count) { return m_ring.TryPushBatch(values, count); }
+	size_t TryPopBatch (u32 *values, size_t count)       { return m_ring.TryPopBatch(values, count); }
+
+	wfMpmcRing<u32> m_ring;
+};
+
+template <typename Q>
+struct Worker {
+	Q            *m_queue;
+	u32           m_items;
+	u32           m_sum;
+	volatile u32 *m_start;
+
+	static void Produce(void *argument) {
+		Worker &self = *static_cast<Worker*>(argument);
+		u32     batch[kBatch];
+
+		while (!wfAtomicLoad(self.m_start))
+			wfCpuRelax();
+
+		for (u32 sent = 0; sent < self.m_items; ) {
+			size_t count = self.m_items - sent < kBatch ? self.m_items - sent : kBatch;
+			for (size_t i = 0; i < count; i++)
+				batch[i] = sent + (u32)i;
+
+			const u32 *next = batch;
+			Backoff    backoff;
+			while (count) {
+				const size_t pushed = self.m_queue->TryPushBatch(next, count);
+				if (pushed == 0)
+					backoff.Wait();
+				next  += pushed;
+				count -= pushed;
+				sent  += (u32)pushed;
+			}
+		}
+	}
+
+	static void Consume(void *argument) {
+		Worker &self = *static_cast<Worker*>(argument);
+		u32     batch[kBatch];
+		Backoff backoff;
+
+		while (!wfAtomicLoad(self.m_start))
+			wfCpuRelax();
+
+		for (u32 received = 0; received < self.m_items; ) {
+			const size_t left   = self.m_items - received;
+			const size_t popped = self.m_queue->TryPopBatch(batch, left < kBatch ? left : kBatch);
+			if (popped == 0)
+				backoff.Wait();
+			else
+				backoff.Reset();
+			for (size_t i = 0; i < popped; i++)
+				self.m_sum += batch[i];
+			received += (u32)popped;
+		}
+	}
+};
+
+// pairs producers with as many consumers, every consumer takes as many items
+// as a producer sends
+template <typename Q>
+static double Throughput(u32 pairs) {
+	Q            *queue     = new Q;
+	wfThread     *producers = new wfThread[pairs];
+	wfThread     *consumers = new wfThread[pairs];
+	Worker<Q>    *workers   = new Worker<Q>[pairs * 2];
+	volatile u32  start     = 0;
+
+	for (u32 i = 0; i < pairs * 2; i++) {
+		workers[i].m_queue = queue;
+		workers[i].m_items = kItems;
+		workers[i].m_sum   = 0;
+		workers[i].m_start = &start;
+	}
+	for (u32 i = 0; i < pairs; i++) {
+		producers[i].Start(&Worker<Q>::Produce, &workers[i]);
+		consumers[i].Start(&Worker<Q>::Consume, &workers[pairs + i]);
+	}
+
+	const double begin = wfTestNow();
+	wfAtomicStore(&start, 1u);
+	for (u32 i = 0; i < pairs; i++) {
+		producers[i].Join();
+		consumers[i].Join();
+	}
+	const double end = wfTestNow();
+
+	u32 sum = 0;
+	for (u32 i = 0; i < pairs; i++)
+		sum += workers[pairs + i].m_sum;
+	if (sum == 0xFFFFFFFFu)
+		printf("(unlikely checksum)\n");
+
+	delete[] workers;
+	delete[] consumers;
+	delete[] producers;
+	delete queue;
+
+	// millions of items handed over per second
+	return (double)pairs * kItems / (end - begin) / 1e6;
+}
+
+template <typename Q>
+struct Bouncer {
+	Q *m_ping;
+	Q *m_pong;
+
+	static void Run(void *argument) {
+		Bouncer &self = *static_cast<Bouncer*>(argument);
+		for (u32 i = 0; i < kRounds; i++) {
+			u32     value;
+			Backoff backoff;
+			while (self.m_ping->TryPopBatch(&value, 1) == 0)
+				backoff.Wait();
+			while (self.m_pong->TryPushBatch(&value, 1) == 0)
+				backoff.Wait();
+		}
+	}
+};
+
+// average round trip of one item through two queues, in nanoseconds
+template <typename Q>
+static double Latency() {
+	Q          *ping = new Q;
+	Q          *pong = new Q;
+	Bouncer<Q>  bouncer;
+	wfThread    thread;
+
+	bouncer.m_ping = ping;
+	bouncer.m_pong = pong;
+	thread.Start(&Bouncer<Q>::Run, &bouncer);
+
+	const double begin = wfTestNow();
+	for (u32 i = 0; i < kRounds; i++) {
+		u32     value = i;
+		Backoff backoff;
+		while (ping->TryPushBatch(&value, 1) == 0)
+			backoff.Wait();
+		while (pong->TryPopBatch(&value, 1) == 0)
+			backoff.Wait();
+	}
+	const double end = wfTestNow();
+
+	thread.Join();
+	delete pong;
+	delete ping;
+
+	return (end - begin) / kRounds * 1e9;
+}
+
+int main()
+{
+	printf("throughput (Mitems/s, batches of %u)\n", kBatch);
+	printf("    pairs   wfMutex+wfDeque   wfSpscRing   wfMpmcRing\n");
+	printf("%9u   %15.2f   %10.2f   %10.2f\n", 1u,
+		Throughput<LockedQueue>(1), Throughput<SpscQueue>(1), Throughput<MpmcQueue>(1));
+	for (u32 pairs = 2; pairs <= 8; pairs <<= 1)
+		printf("%9u   %15.2f   %10s   %10.2f\n", pairs,
+			Throughput<LockedQueue>(pairs), "-", Throughput<MpmcQueue>(pairs));
+
+	printf("\nround trip latency (ns)\n");
+	printf("   wfMutex+wfDeque   wfSpscRing   wfMpmcRing\n");
+	printf("   %15.1f   %10.1f   %10.1f\n", Latency<LockedQueue>(), Latency<SpscQueue>(), Latency<MpmcQueue>());
+	return 0;
+}
@@ -0,0 +1,201 @@
+//
+// Checks wfSpscRing and wfMpmcRing against a std::deque on one thread, full
+// and empty included, and that items streamed through wfBlockingRing by
+// several threads arrive once each and in the order each producer pushed
+// them.
+//
+// g++ -g -I../ -fsanitize=address,undefined ring_test.cpp -o ring_test -lpthread
+//
+#include "wfTest.h"
+#include "wfRing.h"
+#include "wfAlgorithm.h"
+#include "wfThread.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+static std::string Value(u32 i) {
+	char buffer[48];
+	snprintf(buffer, sizeof(buffer), "value %u, long enough to allocate", i);
+	return buffer;
+}
+
+// the ring is left holding elements for its destructor
+template <typename R>
+static bool Random(wfTest *store, R& ring) {
+	std::deque<std::string> reference;
+	std::string             values[8];
+	u32                     state = 1;
+	u32                     next  = 0;
+
+	for (u32 i = 0; i < 50000; i++) {
+		// lean towards pushing for a while, then towards popping
+		const u32 operation = wfTestRandom(state) % 8 + ((i / 500) % 2 ? 2 : 0);
+		if (operation < 3) {
+			const bool pushed = ring.TryPush(Value(next));
+			WF_TEST_FAIL(pushed == (reference.size() < ring.Capacity()));
+			if (pushed)
+				reference.push_back(Value(next++));
+		} else if (operation < 5) {
+			const size_t count = wfTestRandom(state) % (WF_ARRAY_SIZE(values) + 1);
+			for (size_t j = 0; j < count; j++)
+				values[j] = Value(next + j);
+			const size_t pushed = ring.TryPushBatch(values, count);
+			WF_TEST_FAIL(pushed == wfMin(count, ring.Capacity() - reference.size()));
+			for (size_t j = 0; j < pushed; j++)
+				reference.push_back(Value(next++));
+		} else if (operation < 7) {
+			std::string value;
+			const bool popped = ring.TryPop(value);
+			WF_TEST_FAIL(popped == !reference.empty());
+			if (popped) {
+				WF_TEST_FAIL(value == reference.front());
+				reference.pop_front();
+			}
+		} else {
+			const size_t count  = wfTestRandom(state) % (WF_ARRAY_SIZE(values) + 1);
+			const size_t popped = ring.TryPopBatch(values, count);
+			WF_TEST_FAIL(popped == wfMin(count, reference.size()));
+			for (size_t j = 0; j < popped; j++) {
+				WF_TEST_FAIL(values[j] == reference.front());
+				reference.pop_front();
+			}
+		}
+	}
+
+	// fill it up and leave it full
+	while (reference.size() < ring.Capacity()) {
+		WF_TEST_FAIL(ring.TryPush(Value(next)));
+		reference.push_back(Value(next++));
+	}
+	WF_TEST_FAIL(!ring.TryPush(Value(next)) && ring.TryPushBatch(values, 1) == 0);
+	return true;
+}
+
+static bool TestSingleThread(wfTest *store) {
+	wfSpscRing<std::string, 32> spsc;
+	wfMpmcRing<std::string>     mpmc(20);
+	WF_TEST_FAIL(spsc.Capacity() == 32 && mpmc.Capacity() == 32);
+	WF_TEST_FAIL(Random(store, spsc));
+	WF_TEST_FAIL(Random(store, mpmc));
+	return true;
+}
+
+enum { kProducers = 2, kConsumers = 2, kPerProducer = 100000, kBatch = 16 };
+
+static const u32 kDone = ~0u;
+
+typedef wfBlockingRing<wfSpscRing<u32, 64> > SpscQueue;
+typedef wfBlockingRing<wfMpmcRing<u32> >     MpmcQueue;
+
+// values are the producer times kPerProducer plus the sequence number
+template <typename Q>
+struct Producer {
+	Q   *m_queue;
+	u32  m_index;
+
+	static void Run(void *argument) {
+		Producer &self = *static_cast<Producer*>(argument);
+		u32       values[kBatch];
+		u32       state = self.m_index + 1;
+		for (u32 i = 0; i < kPerProducer; ) {
+			const u32 count = wfMin<u32>(wfTestRandom(state) % kBatch + 1, kPerProducer - i);
+			for (u32 j = 0; j < count; j++)
+				values[j] = self.m_index * kPerProducer + i + j;
+			if (count == 1)
+				self.m_queue->Push(values[0]);
+			else
+				self.m_queue->PushBatch(values, count);
+			i += count;
+		}
+	}
+};
+
+// pops until it takes a kDone, handing back any more of them it took
+template <typename Q>
+struct Consumer {
+	Q            *m_queue;
+	volatile u32 *m_received;
+	u32           m_errors;
+
+	static void Run(void *argument) {
+		Consumer &self = *static_cast<Consumer*>(argument);
+		u32       values[kBatch];
+		u32       next[kProducers];
+		for (u32 i = 0; i < kProducers; i++)
+			next[i] = 0;
+
+		for (;;) {
+			const size_t count = self.m_queue->PopBatch(values, kBatch);
+			size_t       done  = 0;
+			for (size_t i = 0; i < count; i++) {
+				if (values[i] == kDone) {
+					done++;
+					continue;
+				}
+				const u32 producer = values[i] / kPerProducer;
+				const u32 sequence = values[i] % kPerProducer;
+				if (done || producer >= kProducers || sequence < next[producer])
+					self.m_errors++;
+				else
+					next[producer] = sequence + 1;
+				wfAtomicFetchAdd(&self.m_received[values[i]], 1u);
+			}
+			if (done) {
+				while (--done)
+					self.m_queue->Push(kDone);
+				return;
+			}
+		}
+	}
+};
+
+template <typename Q>
+static bool Stream(wfTest *store, Q& queue, u32 producers, u32 consumers) {
+	std::vector<u32> received(kProducers * kPerProducer);
+	Producer<Q>      producer[kProducers];
+	Consumer<Q>      consumer[kConsumers];
+	wfThread         threads[kProducers + kConsumers];
+	for (u32 i = 0; i < consumers; i++) {
+		consumer[i].m_queue    = &queue;
+		consumer[i].m_received = &received[0];
+		consumer[i].m_errors   = 0;
+		threads[kProducers + i].Start(&Consumer<Q>::Run, &consumer[i]);
+	}
+	for (u32 i = 0; i < producers; i++) {
+		producer[i].m_queue = &queue;
+		producer[i].m_index = i;
+		threads[i].Start(&Producer<Q>::Run, &producer[i]);
+	}
+
+	for (u32 i = 0; i < producers; i++)
+		threads[i].Join();
+	for (u32 i = 0; i < consumers; i++)
+		queue.Push(kDone);
+	for (u32 i = 0; i < consumers; i++) {
+		threads[kProducers + i].Join();
+		WF_TEST_FAIL(consumer[i].m_errors == 0);
+	}
+
+	for (u32 i = 0; i < kProducers * kPerProducer; i++)
+		WF_TEST_FAIL(received[i] == (i < producers * kPerProducer ? 1u : 0u));
+	u32 left = 0;
+	WF_TEST_FAIL(!queue.GetRing().TryPop(left));
+	return true;
+}
+
+static bool TestThreads(wfTest *store) {
+	SpscQueue spsc;
+	MpmcQueue mpmc(64);
+	WF_TEST_FAIL(Stream(store, spsc, 1, 1));
+	WF_TEST_FAIL(Stream(store, mpmc, kProducers, kConsumers));
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfRing: Single Thread", &TestSingleThread),
+		WF_TEST("wfRing: Threads",       &TestThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
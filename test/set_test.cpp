@@ -0,0 +1,270 @@
+//
+// Checks wfSet iteration, range lookups, order statistics and moving nodes
+// between sets against a std::set, and wfMap lookups with keys of another
+// type than the one stored.
+//
+// g++ -g -I../ -fsanitize=address,undefined set_test.cpp -o set_test
+//
+#include "wfTest.h"
+#include "wfMap.h"
+#include <set>
+#include <string>
+#include <vector>
+
+struct Sum {
+	Sum() : m_count(0), m_sum(0) { }
+	void operator()(const u32& value) { m_count++; m_sum += value; }
+	size_t m_count;
+	u64    m_sum;
+};
+
+// a set of every size up to 64 walked both ways, the single element set
+// is the one whose only node is the root
+static bool TestIteration(wfTest *store) {
+	for (u32 size = 0; size <= 64; size++) {
+		wfSet<u32>    set;
+		std::set<u32> reference;
+		u32           state = size + 1;
+		while (reference.size() < size) {
+			const u32 value = wfTestRandom(state) % 1000;
+			set.Insert(value);
+			reference.insert(value);
+		}
+
+		wfSet<u32>::Iterator it = set.Begin();
+		for (std::set<u32>::iterator expect = reference.begin(); expect != reference.end(); ++expect, ++it)
+			WF_TEST_FAIL(it != set.End() && *it == *expect);
+		WF_TEST_FAIL(it == set.End());
+
+		if (size == 0)
+			continue;
+
+		it = set.Find(*reference.rbegin());
+		for (std::set<u32>::reverse_iterator expect = reference.rbegin(); expect != reference.rend(); ++expect) {
+			WF_TEST_FAIL(*it == *expect);
+			--it;
+		}
+		WF_TEST_FAIL(it == set.End());
+	}
+	return true;
+}
+
+static bool TestBounds(wfTest *store) {
+	wfSet<u32>    set;
+	std::set<u32> reference;
+	u32           state = 3;
+	for (u32 i = 0; i < 500; i++) {
+		const u32 value = (wfTestRandom(state) % 1000) * 2;
+		set.Insert(value);
+		reference.insert(value);
+	}
+
+	for (u32 key = 0; key < 2002; key++) {
+		std::set<u32>::iterator lower = reference.lower_bound(key);
+		std::set<u32>::iterator upper = reference.upper_bound(key);
+
+		wfSet<u32>::Iterator it = set.LowerBound(key);
+		WF_TEST_FAIL(lower == reference.end() ? it == set.End() : (it != set.End() && *it == *lower));
+		it = set.UpperBound(key);
+		WF_TEST_FAIL(upper == reference.end() ? it == set.End() : (it != set.End() && *it == *upper));
+
+		wfPair<wfSet<u32>::Iterator, wfSet<u32>::Iterator> range = set.EqualRange(key);
+		size_t count = 0;
+		for (wfSet<u32>::Iterator walk = range.first; walk != range.second; ++walk)
+			count++;
+		WF_TEST_FAIL(count == reference.count(key));
+	}
+
+	Sum sum = set.VisitRange(100u, 900u, Sum());
+	Sum expect;
+	for (std::set<u32>::iterator it = reference.lower_bound(100); it != reference.end() && *it < 900; ++it)
+		expect(*it);
+	WF_TEST_FAIL(sum.m_count == expect.m_count && sum.m_sum == expect.m_sum);
+	return true;
+}
+
+// C string keys searched with views into longer strings, never terminated
+// where the key ends
+static bool TestHeterogeneousLookup(wfTest *store) {
+	std::vector<std::string> names;
+	char                     buffer[16];
+	for (u32 i = 0; i < 200; i++) {
+		snprintf(buffer, sizeof(buffer), "key%u", i * 3);
+		names.push_back(buffer);
+	}
+
+	wfMap<const char*, u32> map;
+	for (u32 i = 0; i < names.size(); i++)
+		WF_TEST_FAIL(map.Insert(names[i].c_str(), i) == i);
+	WF_TEST_FAIL(map.Insert(names[7].c_str(), 1000) == 7);
+	WF_TEST_FAIL(map.Length() == names.size());
+
+	for (u32 i = 0; i < 600; i++) {
+		snprintf(buffer, sizeof(buffer), "key%u-suffix", i);
+		const wfStringRef key(buffer, strlen(buffer) - 7);
+		const bool        present = i % 3 == 0;
+
+		wfMap<const char*, u32>::Iterator it = map.Find(key);
+		WF_TEST_FAIL(present ? (it != map.End() && it->second == i / 3) : it == map.End());
+		WF_TEST_FAIL(map.Count(key) == (present ? 1u : 0u));
+
+		// the lower bound of a missing key is the next key in strcmp order
+		buffer[strlen(buffer) - 7] = '\0';
+		it = map.LowerBound(key);
+		wfMap<const char*, u32>::Iterator expect = map.Begin();
+		while (expect != map.End() && strcmp(expect->first, buffer) < 0)
+			++expect;
+		WF_TEST_FAIL(it == expect);
+	}
+
+	// erasing a missing key does nothing
+	map.Erase(wfStringRef("key1"));
+	map.Erase(wfStringRef("key3x", 4));
+	WF_TEST_FAIL(map.Length() == names.size() - 1 && map.Count("key3") == 0 && map.Count("key6") == 1);
+	return true;
+}
+
+// keys of other types than wfStringRef are converted to the key type
+// first, an unsigned key finds the elements of a signed set
+static bool TestConvertedLookup(wfTest *store) {
+	wfSet<int>      set;
+	wfMap<int, u32> map;
+	for (int i = -50; i <= 50; i++) {
+		set.Insert(i);
+		map.Insert(i, static_cast<u32>(i + 50));
+	}
+
+	for (u32 i = 0; i <= 50; i++) {
+		WF_TEST_FAIL(set.Find(i) != set.End() && *set.Find(i) == static_cast<int>(i));
+		WF_TEST_FAIL(set.Count(i) == 1 && *set.LowerBound(i) == static_cast<int>(i));
+		WF_TEST_FAIL(map.Find(i) != map.End() && map.Find(i)->second == i + 50);
+	}
+	WF_TEST_FAIL(set.Count(static_cast<short>(-7)) == 1 && set.Count(51u) == 0);
+	WF_TEST_FAIL(*set.UpperBound(7u) == 8 && set.EqualRange(7u).first == set.Find(7));
+	WF_TEST_FAIL(set.VisitRange(0u, 10u, Sum()).m_count == 10);
+
+	set.Erase(7u);
+	map.Erase(7u);
+	WF_TEST_FAIL(set.Count(7) == 0 && map.Count(7) == 0 && set.Length() == 100 && map.Length() == 100);
+
+	// a string literal becomes a std::string once, not per visited node
+	wfSet<std::string> strings;
+	strings.Insert("alpha");
+	strings.Insert("beta");
+	WF_TEST_FAIL(strings.Count("beta") == 1 && strings.Find("gamma") == strings.End());
+
+	wfSet<int, kSetAugment_Rank> ranked;
+	for (int i = -50; i <= 50; i++)
+		ranked.Insert(i);
+	WF_TEST_FAIL(ranked.Rank(0u) == 50 && ranked.Rank(50u) == 100 && ranked.Rank(51u) == 101);
+	return true;
+}
+
+// ranks and selections stay exact through the rebalancing of inserts and
+// erases, the walk from every selected element is still in order
+static bool TestRankSelect(wfTest *store) {
+	typedef wfSet<u32, kSetAugment_Rank> RankSet;
+	RankSet          set;
+	std::set<u32>    reference;
+	std::vector<u32> sorted;
+	u32              state = 5;
+
+	for (u32 i = 0; i < 20000; i++) {
+		const u32 value = wfTestRandom(state) % 2000;
+		if (wfTestRandom(state) % 3 != 0) {
+			set.Insert(value);
+			reference.insert(value);
+		} else {
+			set.Erase(value);
+			reference.erase(value);
+		}
+		WF_TEST_FAIL(set.Length() == reference.size());
+
+		if (i % 500 != 0)
+			continue;
+
+		sorted.assign(reference.begin(), reference.end());
+		for (size_t index = 0; index < sorted.size(); index++) {
+			RankSet::Iterator it = set.Select(index);
+			WF_TEST_FAIL(it != set.End() && *it == sorted[index]);
+			WF_TEST_FAIL(set.Rank(sorted[index]) == index);
+			WF_TEST_FAIL(index + 1 == sorted.size() ? ++it == set.End() : *++it == sorted[index + 1]);
+		}
+		WF_TEST_FAIL(set.Select(sorted.size()) == set.End());
+
+		// a missing key ranks where it would be inserted
+		for (u32 key = 0; key < 2001; key += 7)
+			WF_TEST_FAIL(set.Rank(key) == static_cast<size_t>(std::distance(reference.begin(), reference.lower_bound(key))));
+	}
+	return true;
+}
+
+// nodes move between sets without their elements being copied, so the
+// address of an element stays the same
+static bool TestExtractMerge(wfTest *store) {
+	wfSet<std::string>    first;
+	wfSet<std::string>    second;
+	std::set<std::string> expectFirst;
+	std::set<std::string> expectSecond;
+	char                  buffer[48];
+	for (u32 i = 0; i < 300; i++) {
+		snprintf(buffer, sizeof(buffer), "element %03u, long enough to allocate", i);
+		(i % 3 ? first : second).Insert(buffer);
+		(i % 3 ? expectFirst : expectSecond).insert(buffer);
+	}
+
+	for (u32 i = 0; i < 300; i += 5) {
+		snprintf(buffer, sizeof(buffer), "element %03u, long enough to allocate", i);
+		wfSet<std::string>::Iterator it = first.Find(std::string(buffer));
+		if (it == first.End())
+			continue;
+
+		const std::string *address = &*it;
+		wfSetNodeHandle<std::string> handle = first.Extract(it);
+		WF_TEST_FAIL(!handle.Empty() && &*handle == address && first.Count(std::string(buffer)) == 0);
+		WF_TEST_FAIL(&second.Insert(handle) == address && handle.Empty());
+		expectFirst.erase(buffer);
+		expectSecond.insert(buffer);
+	}
+
+	// a handle whose key is already present keeps its node
+	wfSetNodeHandle<std::string> handle = second.Extract(second.Begin());
+	const std::string            key    = *handle;
+	first.Insert(key);
+	WF_TEST_FAIL(first.Insert(handle) == key && !handle.Empty());
+	expectSecond.erase(key);
+	expectFirst.insert(key);
+
+	WF_TEST_FAIL(first.Length() == expectFirst.size() && second.Length() == expectSecond.size());
+	WF_TEST_FAIL(std::equal(expectFirst.begin(), expectFirst.end(), first.Begin()));
+	WF_TEST_FAIL(std::equal(expectSecond.begin(), expectSecond.end(), second.Begin()));
+
+	// elements already present stay behind
+	second.Insert(*first.Begin());
+	first.Merge(second);
+	expectFirst.insert(expectSecond.begin(), expectSecond.end());
+	WF_TEST_FAIL(first.Length() == expectFirst.size() && second.Length() == 1);
+	WF_TEST_FAIL(std::equal(expectFirst.begin(), expectFirst.end(), first.Begin()));
+	WF_TEST_FAIL(*second.Begin() == *first.Begin());
+
+	// into an empty set the whole tree moves
+	wfSet<std::string> empty;
+	empty.Merge(first);
+	WF_TEST_FAIL(first.Empty() && first.Begin() == first.End() && empty.Length() == expectFirst.size());
+	WF_TEST_FAIL(std::equal(expectFirst.begin(), expectFirst.end(), empty.Begin()));
+	first.Insert("reused");
+	WF_TEST_FAIL(first.Length() == 1 && *first.Begin() == "reused");
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfSet: Iteration",            &TestIteration),
+		WF_TEST("wfSet: Bounds",               &TestBounds),
+		WF_TEST("wfMap: Heterogeneous Lookup", &TestHeterogeneousLookup),
+		WF_TEST("wfSet: Converted Lookup",     &TestConvertedLookup),
+		WF_TEST("wfSet: Rank and Select",      &TestRankSelect),
+		WF_TEST("wfSet: Extract and Merge",    &TestExtractMerge)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
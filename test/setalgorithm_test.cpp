@@ -0,0 +1,138 @@
+//
+// Checks the set algorithms against their std:: counterparts over sorted
+// arrays of lengths near and far apart, and over wfSet ranges.
+//
+// g++ -g -I../ -fsanitize=address,undefined setalgorithm_test.cpp -o setalgorithm_test
+//
+#include "wfTest.h"
+#include "wfSetAlgorithm.h"
+#include "wfIterator.h"
+#include "wfSet.h"
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <vector>
+
+// lengths equal, a few apart, and far enough apart to gallop both ways
+static const size_t s_lengths[][2] = {
+	{ 0, 0 }, { 0, 50 }, { 50, 0 }, { 4, 4 }, { 7, 13 }, { 100, 100 },
+	{ 1000, 1000 }, { 20, 5000 }, { 5000, 20 }, { 1, 3000 }, { 3000, 1 }
+};
+
+// what wfBackInserter writes into, in place of a wfVector, which does not
+// compile in this tree
+struct Values {
+	void PushBack(const u32& value) { m_values.push_back(value); }
+	std::vector<u32> m_values;
+};
+
+template <typename T>
+static std::vector<T> Sorted(size_t length, u32& state) {
+	std::set<T> values;
+	while (values.size() < length)
+		values.insert(static_cast<T>(wfTestRandom(state) % (length * 4 + 8)));
+	return std::vector<T>(values.begin(), values.end());
+}
+
+template <typename T>
+static const T *Begin(const std::vector<T>& values) { return values.empty() ? wfNullPointer : &values[0]; }
+template <typename T>
+static const T *End(const std::vector<T>& values) { return Begin(values) + values.size(); }
+
+template <typename T>
+static bool Matches(const std::vector<T>& expect, const std::vector<T>& result, const T *end) {
+	return static_cast<size_t>(end - Begin(result)) == expect.size() && std::equal(expect.begin(), expect.end(), Begin(result));
+}
+
+// every algorithm on pointers into the two arrays, against std::
+template <typename T>
+static bool Same(const std::vector<T>& a, const std::vector<T>& b) {
+	std::vector<T> expect;
+	std::vector<T> result(a.size() + b.size() + 1);
+
+	std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expect));
+	if (!Matches(expect, result, wfSetUnion(Begin(a), End(a), Begin(b), End(b), &result[0])))
+		return false;
+
+	expect.clear();
+	std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expect));
+	if (!Matches(expect, result, wfSetIntersection(Begin(a), End(a), Begin(b), End(b), &result[0])))
+		return false;
+
+	expect.clear();
+	std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expect));
+	if (!Matches(expect, result, wfSetDifference(Begin(a), End(a), Begin(b), End(b), &result[0])))
+		return false;
+
+	expect.clear();
+	std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expect));
+	return Matches(expect, result, wfSetSymmetricDifference(Begin(a), End(a), Begin(b), End(b), &result[0]));
+}
+
+static bool TestArrays(wfTest *store) {
+	u32 state = 1;
+	for (size_t i = 0; i < WF_ARRAY_SIZE(s_lengths); i++) {
+		for (u32 round = 0; round < 20; round++) {
+			// u32 takes the block compare for intersections, u64 the generic merge
+			WF_TEST_FAIL(Same(Sorted<u32>(s_lengths[i][0], state), Sorted<u32>(s_lengths[i][1], state)));
+			WF_TEST_FAIL(Same(Sorted<u64>(s_lengths[i][0], state), Sorted<u64>(s_lengths[i][1], state)));
+		}
+	}
+
+	// identical arrays, and arrays with every element in common but one
+	std::vector<u32> a = Sorted<u32>(1000, state);
+	std::vector<u32> b = a;
+	WF_TEST_FAIL(Same(a, b));
+	b.erase(b.begin() + 500);
+	WF_TEST_FAIL(Same(a, b) && Same(b, a));
+	return true;
+}
+
+struct Descending {
+	int operator()(u32 lhs, u32 rhs) const { return (lhs > rhs) ? -1 : ((lhs < rhs) ? 1 : 0); }
+};
+
+static bool TestSetRanges(wfTest *store) {
+	u32 state = 3;
+	const std::vector<u32> a = Sorted<u32>(300, state);
+	const std::vector<u32> b = Sorted<u32>(200, state);
+
+	wfSet<u32> first;
+	wfSet<u32> second;
+	for (size_t i = 0; i < a.size(); i++)
+		first.Insert(a[i]);
+	for (size_t i = 0; i < b.size(); i++)
+		second.Insert(b[i]);
+
+	// bidirectional iterators in, a set and a container with PushBack out
+	wfSet<u32> both;
+	Values     only;
+	wfSetIntersection(first.Begin(), first.End(), second.Begin(), second.End(), wfInserter(both));
+	wfSetDifference(first.Begin(), first.End(), second.Begin(), second.End(), wfBackInserter(only));
+
+	std::vector<u32> expect;
+	std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expect));
+	WF_TEST_FAIL(both.Length() == expect.size() && std::equal(expect.begin(), expect.end(), both.Begin()));
+	expect.clear();
+	std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expect));
+	WF_TEST_FAIL(only.m_values == expect);
+
+	// a comparison of the caller's, over ranges sorted by it
+	const std::vector<u32> down1(a.rbegin(), a.rend());
+	const std::vector<u32> down2(b.rbegin(), b.rend());
+	std::vector<u32>       result(a.size() + b.size());
+	expect.clear();
+	std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expect));
+	std::reverse(expect.begin(), expect.end());
+	const u32 *end = wfSetUnion(Begin(down1), End(down1), Begin(down2), End(down2), &result[0], Descending());
+	WF_TEST_FAIL(static_cast<size_t>(end - &result[0]) == expect.size() && std::equal(expect.begin(), expect.end(), &result[0]));
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfSetAlgorithm: Arrays",     &TestArrays),
+		WF_TEST("wfSetAlgorithm: Set Ranges", &TestSetRanges)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
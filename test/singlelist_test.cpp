@@ -0,0 +1,151 @@
+//
+// Checks two wfSingleLists against a pair of std::lists under random pushes,
+// pops, range insertions, reversals and splices, and that the nodes of
+// popped elements are reused.
+//
+// g++ -g -I../ -fsanitize=address,undefined singlelist_test.cpp -o singlelist_test
+//
+#include "wfTest.h"
+#include "wfSingleList.h"
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+typedef wfSingleList<std::string> List;
+typedef std::list<std::string>    Reference;
+
+static std::string Value(u32 i) {
+	char buffer[48];
+	snprintf(buffer, sizeof(buffer), "value %u, long enough to allocate", i);
+	return buffer;
+}
+
+static bool Same(const List& list, const Reference& reference) {
+	if (list.Length() != reference.size() || list.Empty() != reference.empty())
+		return false;
+
+	List::ConstIterator it = list.Begin();
+	for (Reference::const_iterator expect = reference.begin(); expect != reference.end(); ++expect, ++it) {
+		if (!(it != list.End()) || *it != *expect)
+			return false;
+	}
+	return !(it != list.End()) && (reference.empty() || list.Front() == reference.front());
+}
+
+static bool TestRandom(wfTest *store) {
+	List      lists[2];
+	Reference references[2];
+	u32       state = 1;
+	u32       next  = 0;
+
+	for (u32 i = 0; i < 30000; i++) {
+		const u32  to        = wfTestRandom(state) % 2;
+		const u32  from      = 1 - to;
+		List      &list      = lists[to];
+		Reference &reference = references[to];
+		const u32  operation = wfTestRandom(state) % 16;
+
+		if (operation < 5) {
+			list.PushFront(Value(next));
+			reference.push_front(Value(next++));
+		} else if (operation < 9) {
+			list.PopFront();
+			if (!reference.empty())
+				reference.pop_front();
+		} else if (operation == 9 || operation == 10) {
+			// a run from a std::vector, in front or in place of everything
+			std::vector<std::string> run(wfTestRandom(state) % 40);
+			for (size_t j = 0; j < run.size(); j++)
+				run[j] = Value(next++);
+			if (operation == 9) {
+				list.PushFront(run.begin(), run.end());
+				reference.insert(reference.begin(), run.begin(), run.end());
+			} else {
+				list.Assign(run.begin(), run.end());
+				reference.assign(run.begin(), run.end());
+			}
+		} else if (operation == 11) {
+			list.Reverse();
+			reference.reverse();
+		} else if (operation == 12 && !reference.empty()) {
+			const size_t index = wfTestRandom(state) % reference.size();
+			List::Iterator      position = list.Begin();
+			Reference::iterator after    = reference.begin();
+			for (size_t j = 0; j < index; j++, ++position, ++after)
+				;
+			list.SpliceAfter(position, lists[from]);
+			reference.splice(++after, references[from]);
+		} else if (operation == 13) {
+			list.SpliceFront(lists[from]);
+			reference.splice(reference.begin(), references[from]);
+		} else if (operation == 14 && i % 8 == 0) {
+			lists[0].Swap(lists[1]);
+			references[0].swap(references[1]);
+		} else if (operation == 15 && i % 64 == 0) {
+			if (i % 128 == 0) {
+				list.Clear();
+				reference.clear();
+			} else {
+				list = lists[from];
+				reference = references[from];
+			}
+		}
+
+		WF_TEST_FAIL(Same(lists[0], references[0]) && Same(lists[1], references[1]));
+	}
+
+	// copies are deep, and a list can be assigned to itself
+	const List copy(lists[0]);
+	WF_TEST_FAIL(Same(copy, references[0]));
+	lists[0] = lists[0];
+	lists[0].PushFront(Value(next));
+	WF_TEST_FAIL(Same(copy, references[0]) && lists[0].Length() == copy.Length() + 1);
+	return true;
+}
+
+static bool TestReuse(wfTest *store) {
+	List                     list;
+	std::vector<std::string> run;
+	std::set<const void*>    nodes;
+	for (u32 i = 0; i < 100; i++)
+		run.push_back(Value(i));
+
+	list.Assign(run.begin(), run.end());
+	for (List::Iterator it = list.Begin(); it != list.End(); ++it)
+		nodes.insert(&*it);
+
+	// refilled one at a time, and as a range, the list lives in the same nodes
+	for (u32 round = 0; round < 3; round++) {
+		list.Clear();
+		WF_TEST_FAIL(list.Empty() && !(list.Begin() != list.End()));
+		if (round % 2) {
+			list.Assign(run.begin(), run.end());
+		} else {
+			for (size_t i = run.size(); i-- > 0; )
+				list.PushFront(run[i]);
+		}
+		for (List::Iterator it = list.Begin(); it != list.End(); ++it)
+			WF_TEST_FAIL(nodes.count(&*it) == 1);
+		WF_TEST_FAIL(list.Length() == run.size() && list.Front() == run.front());
+	}
+
+	// the nodes of a spliced list move along with its elements
+	List other;
+	other.PushFront(Value(1000));
+	other.PushFront(Value(1001));
+	const void *moved = &other.Front();
+	list.SpliceAfter(list.Begin(), other);
+	WF_TEST_FAIL(other.Empty() && list.Length() == run.size() + 2 && &*++list.Begin() == moved);
+	other.PushFront(Value(1002));
+	WF_TEST_FAIL(other.Length() == 1 && other.Front() == Value(1002));
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfSingleList: Random", &TestRandom),
+		WF_TEST("wfSingleList: Reuse",  &TestReuse)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
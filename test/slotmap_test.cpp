@@ -0,0 +1,64 @@
+//
+// Checks wfSlotMap against a std::map of handles under random insertions
+// and erasures, including that stale handles are rejected.
+//
+// g++ -g -I../ -fsanitize=address,undefined slotmap_test.cpp -o slotmap_test
+//
+#include "wfTest.h"
+#include "wfSlotMap.h"
+#include <map>
+#include <string>
+#include <vector>
+
+static bool TestRandom(wfTest *store) {
+	wfSlotMap<u32>                 map;
+	std::map<wfSlotMapHandle, u32> reference;
+	std::vector<wfSlotMapHandle>   stale;
+	u32                            state = 1;
+
+	for (u32 i = 0; i < 100000; i++) {
+		if (reference.empty() || wfTestRandom(state) % 3 != 0) {
+			const u32             value  = wfTestRandom(state);
+			const wfSlotMapHandle handle = map.Insert(value);
+			WF_TEST_FAIL(handle != 0 && reference.count(handle) == 0);
+			reference[handle] = value;
+		} else {
+			// erase the object of a handle taken from the dense array
+			const wfSlotMapHandle handle = map.HandleOf(wfTestRandom(state) % map.Length());
+			WF_TEST_FAIL(reference.count(handle) == 1 && *map.Find(handle) == reference[handle]);
+			WF_TEST_FAIL(map.Erase(handle) && !map.Erase(handle));
+			reference.erase(handle);
+			stale.push_back(handle);
+		}
+		WF_TEST_FAIL(map.Length() == reference.size());
+	}
+
+	for (std::map<wfSlotMapHandle, u32>::iterator it = reference.begin(); it != reference.end(); ++it)
+		WF_TEST_FAIL(map.Find(it->first) && *map.Find(it->first) == it->second);
+	for (size_t i = 0; i < stale.size(); i++)
+		WF_TEST_FAIL(!map.Contains(stale[i]));
+
+	map.Clear();
+	WF_TEST_FAIL(map.Empty() && !map.Contains(reference.begin()->first));
+	return true;
+}
+
+static bool TestInsertOwnObject(wfTest *store) {
+	wfSlotMap<std::string> map;
+	const wfSlotMapHandle  first = map.Insert(std::string(64, 'x'));
+	// inserting an object of the pool while full reallocates underneath it
+	for (u32 i = 1; i < 100; i++)
+		map.Insert(*map.Find(first));
+	for (wfSlotMap<std::string>::Iterator it = map.Begin(); it != map.End(); ++it)
+		WF_TEST_FAIL(*it == std::string(64, 'x'));
+	WF_TEST_FAIL(map.Length() == 100);
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfSlotMap: Random",            &TestRandom),
+		WF_TEST("wfSlotMap: Insert Own Object", &TestInsertOwnObject)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
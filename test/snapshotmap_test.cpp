@@ -0,0 +1,160 @@
+//
+// Checks wfSnapshotMap against a std::map, and that readers on other
+// threads only ever see whole versions while the writer publishes.
+//
+// g++ -g -I../ -fsanitize=address,undefined snapshotmap_test.cpp -o snapshotmap_test -lpthread
+//
+#include "wfTest.h"
+#include "wfSnapshotMap.h"
+#include "wfMap.h"
+#include <map>
+#include <vector>
+
+typedef wfSnapshotMap<u32, u32>            Map;
+typedef std::vector<std::pair<u32, u32> > Pairs;
+
+struct Collect {
+	Pairs *m_pairs;
+	void operator()(const u32& key, const u32& value) const { m_pairs->push_back(std::make_pair(key, value)); }
+};
+
+static bool TestRandom(wfTest *store) {
+	Map                map;
+	Map::Reader        reader(map);
+	std::map<u32, u32> reference;
+	u32                state = 1;
+
+	for (u32 i = 0; i < 5000; i++) {
+		const u32 key = wfTestRandom(state) % 300;
+		if (wfTestRandom(state) % 3 != 0) {
+			const bool inserted = reference.find(key) == reference.end();
+			reference[key] = i;
+			WF_TEST_FAIL(map.Upsert(key, i) == inserted);
+		} else {
+			WF_TEST_FAIL(map.Erase(key) == (reference.erase(key) == 1));
+		}
+		WF_TEST_FAIL(reader.Length() == reference.size());
+
+		const u32 probe = wfTestRandom(state) % 300;
+		u32       value = ~0u;
+		std::map<u32, u32>::iterator it = reference.find(probe);
+		WF_TEST_FAIL(reader.Find(probe, value) == (it != reference.end()));
+		WF_TEST_FAIL(it == reference.end() ? value == ~0u : value == it->second);
+		WF_TEST_FAIL(reader.Count(probe) == reference.count(probe));
+	}
+
+	Pairs   pairs;
+	Collect collect = { &pairs };
+	reader.ForEach(collect);
+	WF_TEST_FAIL(pairs == Pairs(reference.begin(), reference.end()));
+
+	// many changes in a single version
+	wfMap<u32, u32> batch;
+	for (u32 i = 0; i < 1000; i++)
+		batch.Insert(i * 2, i);
+	map.Assign(batch.Begin(), batch.End());
+	WF_TEST_FAIL(reader.Length() == 1000 && reader.Count(1998) == 1 && reader.Count(1) == 0);
+
+	map.Clear();
+	WF_TEST_FAIL(reader.Length() == 0 && map.Collect() == 0);
+	return true;
+}
+
+// keys of other types than the key type are converted to it first, an
+// unsigned key finds the pairs of a map with signed keys
+static bool TestConvertedLookup(wfTest *store) {
+	wfSnapshotMap<int, u32>         map;
+	wfSnapshotMap<int, u32>::Reader reader(map);
+	for (int i = -50; i <= 50; i++)
+		map.Upsert(i, static_cast<u32>(i + 50));
+
+	for (u32 i = 0; i <= 50; i++) {
+		u32 value = 0;
+		WF_TEST_FAIL(reader.Find(i, value) && value == i + 50 && reader.Count(i) == 1);
+	}
+	WF_TEST_FAIL(reader.Count(51u) == 0 && reader.Count(static_cast<short>(-7)) == 1);
+	WF_TEST_FAIL(map.Erase(7u) && !map.Erase(7u) && reader.Count(7) == 0 && reader.Length() == 100);
+	return true;
+}
+
+enum { kReaders = 3, kKeys = 64, kVersions = 3000 };
+
+struct Shared {
+	Map          m_map;
+	volatile u32 m_done;
+	u32          m_errors[kReaders];
+};
+
+// every version holds the keys [0, kKeys) with one and the same value,
+// which only grows, and the generation under key kKeys
+struct Reader {
+	Shared *m_shared;
+	u32     m_index;
+
+	static void Run(void *argument) {
+		Reader      &self   = *static_cast<Reader*>(argument);
+		Shared      &shared = *self.m_shared;
+		Map::Reader  reader(shared.m_map);
+		Pairs        pairs;
+		u32          last   = 0;
+		while (!wfAtomicLoad(&shared.m_done)) {
+			pairs.clear();
+			Collect collect = { &pairs };
+			reader.ForEach(collect);
+
+			bool whole = pairs.size() >= kKeys && pairs[0].second >= last;
+			for (size_t i = 0; whole && i < kKeys; i++)
+				whole = pairs[i].first == i && pairs[i].second == pairs[0].second;
+			if (!whole)
+				shared.m_errors[self.m_index]++;
+			else
+				last = pairs[0].second;
+
+			u32 generation = 0;
+			if (reader.Find(static_cast<u32>(kKeys), generation) && generation < last)
+				shared.m_errors[self.m_index]++;
+		}
+	}
+};
+
+static bool TestThreads(wfTest *store) {
+	Shared   shared;
+	wfThread threads[kReaders];
+	Reader   readers[kReaders];
+
+	wfMap<u32, u32> version;
+	for (u32 key = 0; key < kKeys; key++)
+		version.Insert(key, 0u);
+	shared.m_map.Assign(version.Begin(), version.End());
+	shared.m_done = 0;
+	for (u32 i = 0; i < kReaders; i++) {
+		shared.m_errors[i]  = 0;
+		readers[i].m_shared = &shared;
+		readers[i].m_index  = i;
+		threads[i].Start(&Reader::Run, &readers[i]);
+	}
+
+	for (u32 generation = 1; generation < kVersions; generation++) {
+		for (wfMap<u32, u32>::Iterator it = version.Begin(); it != version.End(); ++it)
+			it->second = generation;
+		shared.m_map.Assign(version.Begin(), version.End());
+		shared.m_map.Upsert(kKeys, generation);
+	}
+
+	wfAtomicStore(&shared.m_done, 1u);
+	for (u32 i = 0; i < kReaders; i++) {
+		threads[i].Join();
+		WF_TEST_FAIL(shared.m_errors[i] == 0);
+	}
+	WF_TEST_FAIL(shared.m_map.Collect() == 0);
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfSnapshotMap: Random",           &TestRandom),
+		WF_TEST("wfSnapshotMap: Converted Lookup", &TestConvertedLookup),
+		WF_TEST("wfSnapshotMap: Threads",          &TestThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
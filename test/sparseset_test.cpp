@@ -0,0 +1,91 @@
+//
+// Checks wfSparseSet and wfDenseMap against a std::set and std::map under
+// random insertions and erasures.
+//
+// g++ -g -I../ -fsanitize=address,undefined sparseset_test.cpp -o sparseset_test
+//
+#include "wfTest.h"
+#include "wfSparseSet.h"
+#include <map>
+#include <set>
+#include <string>
+
+static bool TestSetRandom(wfTest *store) {
+	wfSparseSet   set;
+	std::set<u32> reference;
+	u32           state = 1;
+
+	for (u32 i = 0; i < 100000; i++) {
+		// mostly small identifiers, a few spread over the whole range
+		u32 id = wfTestRandom(state);
+		id = (id & 7) ? id % 5000 : id;
+		if (wfTestRandom(state) % 3 != 0)
+			WF_TEST_FAIL(set.Insert(id) == reference.insert(id).second);
+		else
+			WF_TEST_FAIL(set.Erase(id) == (reference.erase(id) != 0));
+		WF_TEST_FAIL(set.Length() == reference.size());
+	}
+
+	for (wfSparseSet::ConstIterator it = set.Begin(); it != set.End(); ++it) {
+		WF_TEST_FAIL(reference.count(*it) == 1);
+		WF_TEST_FAIL(set[set.Index(*it)] == *it);
+	}
+
+	set.Clear();
+	WF_TEST_FAIL(set.Empty() && !set.Contains(*reference.begin()));
+	return true;
+}
+
+static bool TestSetLargestIdentifier(wfTest *store) {
+	wfSparseSet set;
+	WF_TEST_FAIL(set.Insert(0xFFFFFFFFu) && set.Insert(0));
+	WF_TEST_FAIL(set.Contains(0xFFFFFFFFu) && set.Index(0xFFFFFFFFu) == 0);
+	WF_TEST_FAIL(set.Erase(0xFFFFFFFFu) && !set.Contains(0xFFFFFFFFu) && set.Index(0) == 0);
+	return true;
+}
+
+static bool TestMapRandom(wfTest *store) {
+	wfDenseMap<std::string>    map;
+	std::map<u32, std::string> reference;
+	u32                        state = 9;
+	char                       buffer[32];
+
+	for (u32 i = 0; i < 50000; i++) {
+		const u32 id = wfTestRandom(state) % 2000;
+		if (wfTestRandom(state) % 3 != 0) {
+			snprintf(buffer, sizeof(buffer), "value %u", id);
+			WF_TEST_FAIL(map.Insert(id, buffer) == buffer);
+			reference[id] = buffer;
+		} else {
+			WF_TEST_FAIL(map.Erase(id) == (reference.erase(id) != 0));
+		}
+		WF_TEST_FAIL(map.Length() == reference.size());
+	}
+
+	for (size_t i = 0; i < map.Length(); i++) {
+		std::map<u32, std::string>::iterator it = reference.find(map.Keys()[i]);
+		WF_TEST_FAIL(it != reference.end() && map.Begin()[i] == it->second);
+	}
+	return true;
+}
+
+static bool TestMapInsertOwnValue(wfTest *store) {
+	wfDenseMap<std::string> map;
+	map.Insert(0, std::string(64, 'x'));
+	// inserting a value of the map while full reallocates underneath it
+	for (u32 i = 1; i < 100; i++)
+		map.Insert(i, *map.Find(0));
+	for (u32 i = 0; i < 100; i++)
+		WF_TEST_FAIL(map.Find(i) && *map.Find(i) == std::string(64, 'x'));
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfSparseSet: Random",             &TestSetRandom),
+		WF_TEST("wfSparseSet: Largest Identifier", &TestSetLargestIdentifier),
+		WF_TEST("wfDenseMap: Random",              &TestMapRandom),
+		WF_TEST("wfDenseMap: Insert Own Value",    &TestMapInsertOwnValue)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
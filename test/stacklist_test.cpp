@@ -0,0 +1,147 @@
+//
+// Checks wfStackList against a std::vector across block boundaries, and
+// that threads taking items off a shared wfLockFreeStack and putting them
+// back never hold the same item at once.
+//
+// g++ -g -I../ -fsanitize=address,undefined stacklist_test.cpp -o stacklist_test -lpthread
+//
+#include "wfTest.h"
+#include "wfStackList.h"
+#include "wfThread.h"
+#include <string>
+#include <vector>
+
+static std::string Value(u32 i) {
+	char buffer[48];
+	snprintf(buffer, sizeof(buffer), "value %u, long enough to allocate", i);
+	return buffer;
+}
+
+static bool TestRandom(wfTest *store) {
+	wfStackList<std::string> stack;
+	std::vector<std::string> reference;
+	u32                      state = 1;
+
+	for (u32 i = 0; i < 100000; i++) {
+		// runs of pushes and pops long enough to cross several blocks
+		const bool push = (i / 64) % 3 != 2 ? wfTestRandom(state) % 4 != 0 : wfTestRandom(state) % 4 == 0;
+		if (push || reference.empty()) {
+			stack.PushBack(Value(i));
+			reference.push_back(Value(i));
+		} else {
+			stack.PopBack();
+			reference.pop_back();
+		}
+		WF_TEST_FAIL(stack.Length() == reference.size() && stack.Empty() == reference.empty());
+		WF_TEST_FAIL(reference.empty() || stack.Top() == reference.back());
+	}
+
+	// everything comes off in reverse order
+	while (!reference.empty()) {
+		WF_TEST_FAIL(stack.Top() == reference.back());
+		stack.PopBack();
+		reference.pop_back();
+	}
+	WF_TEST_FAIL(stack.Empty());
+
+	// back and forth across the boundary of a block
+	for (u32 i = 0; i < 1000; i++)
+		stack.PushBack(Value(i));
+	for (u32 i = 0; i < 1000; i++) {
+		stack.PushBack(Value(i));
+		stack.PushBack(Value(i + 1));
+		stack.PopBack();
+		stack.PopBack();
+	}
+	const wfStackList<std::string>& constant = stack;
+	WF_TEST_FAIL(constant.Length() == 1000 && constant.Top() == Value(999));
+
+	stack.Clear();
+	WF_TEST_FAIL(stack.Empty() && stack.Length() == 0);
+	stack.PushBack(Value(1));
+	WF_TEST_FAIL(stack.Length() == 1 && stack.Top() == Value(1));
+	return true;
+}
+
+enum { kThreads = 4, kItems = 64, kRounds = 50000 };
+
+struct Item {
+	wfLockFreeStackNode<Item> m_node;
+	volatile u32              m_owner;
+};
+
+typedef wfLockFreeStack<Item> Stack;
+
+struct Worker {
+	Stack *m_stack;
+	u32    m_index;
+	u32    m_errors;
+
+	// an item popped must not be held by anyone else until pushed back
+	static void Run(void *argument) {
+		Worker &self = *static_cast<Worker*>(argument);
+		Item   *held[4];
+		for (u32 round = 0; round < kRounds; round++) {
+			u32 count = 0;
+			while (count < WF_ARRAY_SIZE(held) && (held[count] = self.m_stack->Pop()) != wfNullPointer) {
+				if (wfAtomicExchange(&held[count]->m_owner, self.m_index + 1) != 0)
+					self.m_errors++;
+				count++;
+			}
+			while (count--) {
+				if (wfAtomicExchange(&held[count]->m_owner, 0u) != self.m_index + 1)
+					self.m_errors++;
+				self.m_stack->Push(&held[count]->m_node);
+			}
+		}
+	}
+};
+
+static bool TestThreads(wfTest *store) {
+	Stack stack;
+	Item  items[kItems];
+	WF_TEST_FAIL(stack.Empty() && !stack.Pop());
+
+	// single threaded the stack is last in, first out
+	for (u32 i = 0; i < kItems; i++) {
+		items[i].m_node.Init(&items[i]);
+		items[i].m_owner = 0;
+		stack.Push(&items[i].m_node);
+	}
+	for (u32 i = kItems; i-- > 0; )
+		WF_TEST_FAIL(stack.Pop() == &items[i]);
+	WF_TEST_FAIL(stack.Empty() && !stack.Pop());
+	for (u32 i = 0; i < kItems; i++)
+		stack.Push(&items[i].m_node);
+
+	Worker   workers[kThreads];
+	wfThread threads[kThreads];
+	for (u32 i = 0; i < kThreads; i++) {
+		workers[i].m_stack  = &stack;
+		workers[i].m_index  = i;
+		workers[i].m_errors = 0;
+		threads[i].Start(&Worker::Run, &workers[i]);
+	}
+	for (u32 i = 0; i < kThreads; i++) {
+		threads[i].Join();
+		WF_TEST_FAIL(workers[i].m_errors == 0);
+	}
+
+	// every item is back, once
+	bool seen[kItems] = { };
+	for (u32 i = 0; i < kItems; i++) {
+		Item *item = stack.Pop();
+		WF_TEST_FAIL(item && !seen[item - items]);
+		seen[item - items] = true;
+	}
+	WF_TEST_FAIL(stack.Empty() && !stack.Pop());
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfStackList: Random",      &TestRandom),
+		WF_TEST("wfLockFreeStack: Threads", &TestThreads)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
@@ -13,6 +13,8 @@ int main()
 	printf("SSE4.1:  %d\n", (int)wfCPUHasSSE41());
 	printf("SSE4.2:  %d\n", (int)wfCPUHasSSE42());
 	printf("NEON:    %d\n", (int)wfCPUHasNEON());
+	printf("AVX:     %d\n", (int)wfCPUHasAVX());
+	printf("AVX2:    %d\n", (int)wfCPUHasAVX2());
 	
 	return 0;
 }
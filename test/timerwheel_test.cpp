@@ -0,0 +1,160 @@
+//
+// Checks that wfTimerWheel fires every timer on its deadline, in order,
+// against a std::set of pending deadlines, and that cancelled timers stay
+// quiet.
+//
+// g++ -g -I../ -fsanitize=address,undefined timerwheel_test.cpp -o timerwheel_test
+//
+#include "wfTest.h"
+#include "wfTimerWheel.h"
+#include <set>
+
+enum { kTimers = 2000 };
+
+struct Timer {
+	wfTimerWheelNode<Timer> m_node;
+	u32                     m_id;
+	u32                     m_fired;
+};
+
+typedef wfTimerWheel<Timer>            Wheel;
+typedef std::set<std::pair<u64, u32> > Pending;
+
+static u64 Distance(u32& state) {
+	// mostly near, some in each of the upper levels
+	switch (wfTestRandom(state) % 4) {
+		case 0:  return wfTestRandom(state) % 256;
+		case 1:  return wfTestRandom(state) % 65536;
+		case 2:  return wfTestRandom(state) % (1 << 20);
+		default: return wfTestRandom(state) % (1 << 25);
+	}
+}
+
+// fires in deadline order, and every third timer schedules itself again
+struct Fire {
+	Wheel   *m_wheel;
+	Pending *m_pending;
+	bool    *m_ordered;
+
+	void operator()(Timer *timer) const {
+		const std::pair<u64, u32> expect(timer->m_node.GetDeadline(), timer->m_id);
+		*m_ordered = *m_ordered && !timer->m_node.IsScheduled()
+		                        && expect.first == m_wheel->Now()
+		                        && m_pending->begin()->first == expect.first
+		                        && m_pending->erase(expect) == 1;
+		if (++timer->m_fired % 3 == 0) {
+			m_wheel->ScheduleAfter(&timer->m_node, 1 + timer->m_id);
+			m_pending->insert(std::make_pair(timer->m_node.GetDeadline(), timer->m_id));
+		}
+	}
+};
+
+static bool TestRandom(wfTest *store) {
+	Wheel   wheel;
+	Pending pending;
+	Timer  *timers  = new Timer[kTimers];
+	bool    ordered = true;
+	u32     state   = 1;
+	for (u32 i = 0; i < kTimers; i++) {
+		timers[i].m_node.Init(&timers[i]);
+		timers[i].m_id    = i;
+		timers[i].m_fired = 0;
+	}
+
+	Fire fire = { &wheel, &pending, &ordered };
+	for (u32 i = 0; i < 20000; i++) {
+		Timer *timer = &timers[wfTestRandom(state) % kTimers];
+		if (timer->m_node.IsScheduled())
+			pending.erase(std::make_pair(timer->m_node.GetDeadline(), timer->m_id));
+
+		if (wfTestRandom(state) % 4 == 0) {
+			wheel.Cancel(&timer->m_node);
+		} else {
+			wheel.Schedule(&timer->m_node, wheel.Now() + Distance(state));
+			pending.insert(std::make_pair(timer->m_node.GetDeadline(), timer->m_id));
+			WF_TEST_FAIL(timer->m_node.GetDeadline() > wheel.Now());
+		}
+
+		const u64 ticks = (i % 5000 == 4999) ? Distance(state) : wfTestRandom(state) % 16;
+		wheel.Advance(ticks, fire);
+		WF_TEST_FAIL(ordered);
+		WF_TEST_FAIL(pending.empty() || pending.begin()->first > wheel.Now());
+	}
+
+	// the timers left run out, some rescheduling themselves on the way
+	while (!pending.empty())
+		wheel.Advance(pending.rbegin()->first - wheel.Now(), fire);
+	WF_TEST_FAIL(ordered);
+	for (u32 i = 0; i < kTimers; i++)
+		WF_TEST_FAIL(!timers[i].m_node.IsScheduled());
+	delete[] timers;
+	return true;
+}
+
+struct Count {
+	u32 *m_count;
+	void operator()(Timer *) const { ++*m_count; }
+};
+
+static bool TestPastDeadlines(wfTest *store) {
+	Wheel wheel;
+	Timer timer;
+	u32   fired = 0;
+	Count count = { &fired };
+	timer.m_node.Init(&timer);
+
+	WF_TEST_FAIL(wheel.Advance(300, count) == 0 && wheel.Now() == 300);
+
+	// deadlines already passed fire on the next tick
+	wheel.Schedule(&timer.m_node, 10);
+	WF_TEST_FAIL(timer.m_node.GetDeadline() == 301);
+	WF_TEST_FAIL(wheel.Advance(1, count) == 1 && fired == 1);
+
+	wheel.ScheduleAfter(&timer.m_node, 0);
+	WF_TEST_FAIL(wheel.Advance(1, count) == 1 && fired == 2);
+	return true;
+}
+
+static bool TestCancel(wfTest *store) {
+	Wheel wheel;
+	Timer kept;
+	Timer cancelled;
+	Timer far;
+	u32   fired = 0;
+	Count count = { &fired };
+	kept.m_node.Init(&kept);
+	cancelled.m_node.Init(&cancelled);
+	far.m_node.Init(&far);
+
+	wheel.ScheduleAfter(&kept.m_node, 70000);
+	wheel.ScheduleAfter(&cancelled.m_node, 70000);
+	cancelled.m_node.Cancel();
+	{
+		// destroyed while pending
+		Timer gone;
+		gone.m_node.Init(&gone);
+		wheel.ScheduleAfter(&gone.m_node, 5);
+	}
+	WF_TEST_FAIL(wheel.Advance(70000, count) == 1 && fired == 1);
+
+	// past the top level, the overflow list
+	wheel.Schedule(&far.m_node, static_cast<u64>(1) << 40);
+	wheel.ScheduleAfter(&kept.m_node, 3);
+	const wfTimerWheelNode<Timer> copy(far.m_node);
+	WF_TEST_FAIL(far.m_node.IsScheduled() && !copy.IsScheduled());
+	WF_TEST_FAIL(far.m_node.GetDeadline() == static_cast<u64>(1) << 40);
+
+	wheel.Clear();
+	WF_TEST_FAIL(!far.m_node.IsScheduled() && !kept.m_node.IsScheduled());
+	WF_TEST_FAIL(wheel.Advance(10, count) == 0 && fired == 1);
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfTimerWheel: Random",         &TestRandom),
+		WF_TEST("wfTimerWheel: Past Deadlines", &TestPastDeadlines),
+		WF_TEST("wfTimerWheel: Cancel",         &TestCancel)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
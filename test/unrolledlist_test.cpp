@@ -0,0 +1,112 @@
+//
+// Checks wfUnrolledList against a std::list under random insertions and
+// erasures, and insertions of its own elements.
+//
+// g++ -g -I../ -fsanitize=address,undefined unrolledlist_test.cpp -o unrolledlist_test
+//
+#include "wfTest.h"
+#include "wfUnrolledList.h"
+#include <list>
+#include <string>
+
+template <typename T>
+static bool Same(const wfUnrolledList<T>& list, const std::list<T>& reference) {
+	if (list.Length() != reference.size())
+		return false;
+
+	typename wfUnrolledList<T>::ConstIterator it = list.Begin();
+	for (typename std::list<T>::const_iterator expect = reference.begin(); expect != reference.end(); ++expect, ++it) {
+		if (it == list.End() || !(*it == *expect))
+			return false;
+	}
+	return it == list.End();
+}
+
+static bool TestRandom(wfTest *store) {
+	wfUnrolledList<u32> list;
+	std::list<u32>      reference;
+	u32                 state = 1;
+
+	for (u32 i = 0; i < 20000; i++) {
+		// walk both to the same random position
+		const size_t position = reference.empty() ? 0 : wfTestRandom(state) % (reference.size() + 1);
+		wfUnrolledList<u32>::Iterator it     = list.Begin();
+		std::list<u32>::iterator      expect = reference.begin();
+		for (size_t j = 0; j < position; j++, ++it, ++expect) { }
+
+		const u32 operation = wfTestRandom(state) % 8;
+		if (operation < 4 || expect == reference.end()) {
+			const u32 value = wfTestRandom(state);
+			WF_TEST_FAIL(*list.Insert(it, value) == value);
+			reference.insert(expect, value);
+		} else if (operation < 7) {
+			it     = list.Erase(it);
+			expect = reference.erase(expect);
+			WF_TEST_FAIL(expect == reference.end() ? it == list.End() : *it == *expect);
+		} else {
+			list.PushFront(i);
+			list.PushBack(i);
+			reference.push_front(i);
+			reference.push_back(i);
+		}
+		WF_TEST_FAIL(list.Length() == reference.size());
+	}
+	WF_TEST_FAIL(Same(list, reference));
+
+	while (!reference.empty()) {
+		WF_TEST_FAIL(list.Front() == reference.front() && list.Back() == reference.back());
+		list.PopBack();
+		reference.pop_back();
+		if (!reference.empty()) {
+			list.PopFront();
+			reference.pop_front();
+		}
+	}
+	WF_TEST_FAIL(list.Empty() && list.Begin() == list.End());
+	return true;
+}
+
+static bool TestInsertOwnElement(wfTest *store) {
+	wfUnrolledList<std::string> list;
+	std::list<std::string>      reference;
+	u32                         state = 3;
+	char                        buffer[48];
+
+	for (u32 i = 0; i < 64; i++) {
+		snprintf(buffer, sizeof(buffer), "element %u, long enough to allocate", i);
+		list.PushBack(buffer);
+		reference.push_back(buffer);
+	}
+
+	// insert copies of elements of the node being shifted or split
+	for (u32 i = 0; i < 2000; i++) {
+		const size_t position = wfTestRandom(state) % list.Length();
+		const size_t source   = (position & ~static_cast<size_t>(3)) + wfTestRandom(state) % 4;
+
+		wfUnrolledList<std::string>::Iterator it         = list.Begin();
+		wfUnrolledList<std::string>::Iterator from       = list.Begin();
+		std::list<std::string>::iterator      expect     = reference.begin();
+		std::list<std::string>::iterator      expectFrom = reference.begin();
+		for (size_t j = 0; j < position; j++, ++it, ++expect) { }
+		for (size_t j = 0; j < source && j + 1 < reference.size(); j++, ++from, ++expectFrom) { }
+
+		list.Insert(it, *from);
+		reference.insert(expect, *expectFrom);
+	}
+	WF_TEST_FAIL(Same(list, reference));
+
+	list.PushFront(list.Front());
+	list.PushBack(list.Back());
+	reference.push_front(reference.front());
+	reference.push_back(reference.back());
+	WF_TEST_FAIL(Same(list, reference));
+	return true;
+}
+
+int main() {
+	wfTest tests[] = {
+		WF_TEST("wfUnrolledList: Random",             &TestRandom),
+		WF_TEST("wfUnrolledList: Insert Own Element", &TestInsertOwnElement)
+	};
+	return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+}
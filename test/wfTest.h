@@ -0,0 +1,110 @@
+#ifndef WF_STDLIB_TEST_HDR
+#define WF_STDLIB_TEST_HDR
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "wfStandard.h"
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#endif
+
+/*
+ * File: wfTest
+ *  What the container tests and benchmarks share: a clock, a random
+ *  number generator and a list of named checks.
+ *
+ *  A test is a function taking its <wfTest> record, which fails with
+ *  <WF_TEST_FAIL>.  The tests of a file go in an array handed to
+ *  <wfTestsRun> from main.
+ *
+ * (start code)
+ * static bool TestEmpty(wfTest *store) {
+ *     wfSet<int> set;
+ *     WF_TEST_FAIL(set.Empty());
+ *     return true;
+ * }
+ *
+ * int main() {
+ *     wfTest tests[] = { WF_TEST("wfSet: Empty", &TestEmpty) };
+ *     return wfTestsRun(tests, WF_ARRAY_SIZE(tests));
+ * }
+ * (end code)
+ */
+
+struct wfTest {
+	const char  *name;
+	bool       (*func)(wfTest *store);
+	const char  *error;
+	int          line;
+};
+
+#define WF_TEST_FAIL(COND)           \
+	do {                             \
+		if (!(COND)) {               \
+			store->error = #COND;    \
+			store->line  = __LINE__; \
+			return false;            \
+		}                            \
+	} while (0)
+
+#define WF_TEST(NAME, FUNC) { NAME, FUNC, NULL, 0 }
+
+/*
+ * Function: wfTestsRun
+ *  Runs every test, printing the outcome of each.
+ *
+ * Returns:
+ *  *EXIT_SUCCESS* if all of them passed; *EXIT_FAILURE* otherwise.
+ */
+inline int wfTestsRun(wfTest *tests, size_t count) {
+	int ret = EXIT_SUCCESS;
+	for (size_t i = 0; i < count; i++) {
+		tests[i].error = NULL;
+		if (!tests[i].func(&tests[i])) {
+			printf("Failure: %s\n"
+			"    Condition:  `%s` failed at line %d\n", tests[i].name, tests[i].error, tests[i].line);
+			ret = EXIT_FAILURE;
+		} else {
+			printf("Success: %s\n", tests[i].name);
+		}
+	}
+	return ret;
+}
+
+/*
+ * Function: wfTestNow
+ *  Returns a monotonic time in seconds, for benchmarks.
+ */
+inline double wfTestNow() {
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/*
+ * Function: wfTestRandom
+ *  Advances a xorshift generator, the state must not be zero.
+ */
+inline u32 wfTestRandom(u32& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+#endif
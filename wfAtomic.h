@@ -0,0 +1,203 @@
+#ifndef WF_STDLIB_ATOMIC_HDR
+#define WF_STDLIB_ATOMIC_HDR
+#include "wfStandard.h"
+
+/*
+ * File: wfAtomic
+ *  Atomic operations on naturally aligned 32-bit, 64-bit and pointer
+ *  sized integers and pointers.
+ *
+ * >#include "wfAtomic.h"
+ *
+ *  Loads are acquire, stores are release, and every read-modify-write
+ *  operation is sequentially consistent.  The *Relaxed* variants impose
+ *  no ordering at all.  Uses the *__atomic* builtins on GCC and GCC-like
+ *  compilers (GCC 4.7 and newer, clang, Intel) and the *Interlocked*
+ *  intrinsics on MSVC.
+ */
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#   define WF_STDLIB_ATOMIC_MSVC
+#elif defined(__GNUC__)
+#   define WF_STDLIB_ATOMIC_GCC
+#else
+#   error "wfAtomic: unsupported compiler"
+#endif
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#   include <emmintrin.h>
+#endif
+
+/*
+ * Function: wfCpuRelax
+ *  Hints to the processor that the calling thread is spinning, to be
+ *  called in the body of busy-wait loops.
+ */
+inline void wfCpuRelax() {
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+	_mm_pause();
+#elif defined(WF_STDLIB_ATOMIC_GCC) && (defined(__arm__) || defined(__aarch64__))
+	__asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+#ifdef WF_STDLIB_ATOMIC_GCC
+
+/*
+ * Function: wfAtomicLoad
+ *  Atomically loads a value with acquire ordering.
+ */
+template <typename T> inline T    wfAtomicLoad          (const volatile T *address)          { return __atomic_load_n(address, __ATOMIC_ACQUIRE); }
+template <typename T> inline T    wfAtomicLoadRelaxed   (const volatile T *address)          { return __atomic_load_n(address, __ATOMIC_RELAXED); }
+
+/*
+ * Function: wfAtomicStore
+ *  Atomically stores a value with release ordering.
+ */
+template <typename T> inline void wfAtomicStore         (volatile T *address, T value)       { __atomic_store_n(address, value, __ATOMIC_RELEASE); }
+template <typename T> inline void wfAtomicStoreRelaxed  (volatile T *address, T value)       { __atomic_store_n(address, value, __ATOMIC_RELAXED); }
+
+/*
+ * Function: wfAtomicExchange
+ *  Atomically replaces a value.
+ *
+ * Returns:
+ *  The value before it was replaced.
+ */
+template <typename T> inline T    wfAtomicExchange      (volatile T *address, T value)       { return __atomic_exchange_n(address, value, __ATOMIC_SEQ_CST); }
+
+/*
+ * Function: wfAtomicFetchAdd
+ *  Atomically adds to an integer.
+ *
+ * Returns:
+ *  The value before the addition.
+ */
+template <typename T> inline T    wfAtomicFetchAdd      (volatile T *address, T value)       { return __atomic_fetch_add(address, value, __ATOMIC_SEQ_CST); }
+
+/*
+ * Function: wfAtomicCompareExchange
+ *  Atomically replaces a value if it equals an expected value.
+ *
+ * Parameters:
+ *  address  - The address of the value.
+ *  expected - The value expected at the address, overwritten with the value
+ *             found there when the exchange fails.
+ *  desired  - The value to store.
+ *
+ * Returns:
+ *  *true* if the value was replaced; *false* otherwise.
+ */
+template <typename T> inline bool wfAtomicCompareExchange(volatile T *address, T& expected, T desired) {
+	return __atomic_compare_exchange_n(address, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Function: wfAtomicFence
+ *  Full memory barrier.  <wfAtomicFenceAcquire> and <wfAtomicFenceRelease>
+ *  are the one-sided barriers.
+ */
+inline void wfAtomicFence       () { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+inline void wfAtomicFenceAcquire() { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+inline void wfAtomicFenceRelease() { __atomic_thread_fence(__ATOMIC_RELEASE); }
+
+#else // WF_STDLIB_ATOMIC_MSVC
+
+namespace wfPrivate {
+	//
+	// Aligned loads and stores are atomic on every target MSVC supports,
+	// x86 and x64 give them acquire and release semantics as long as the
+	// compiler does not reorder around them, ARM needs the barrier.
+	//
+	inline void wfAtomicCompilerBarrier() {
+		_ReadWriteBarrier();
+#if defined(_M_ARM) || defined(_M_ARM64)
+		__dmb(0xB); // inner shareable
+#endif
+	}
+
+	template <size_t>
+	struct wfAtomicInterlocked;
+
+	template <>
+	struct wfAtomicInterlocked<4> {
+		typedef long Type;
+		static Type Exchange       (volatile Type *a, Type v)         { return _InterlockedExchange(a, v); }
+		static Type ExchangeAdd    (volatile Type *a, Type v)         { return _InterlockedExchangeAdd(a, v); }
+		static Type CompareExchange(volatile Type *a, Type v, Type c) { return _InterlockedCompareExchange(a, v, c); }
+	};
+
+	template <>
+	struct wfAtomicInterlocked<8> {
+		typedef __int64 Type;
+		static Type Exchange       (volatile Type *a, Type v)         { return _InterlockedExchange64(a, v); }
+		static Type ExchangeAdd    (volatile Type *a, Type v)         { return _InterlockedExchangeAdd64(a, v); }
+		static Type CompareExchange(volatile Type *a, Type v, Type c) { return _InterlockedCompareExchange64(a, v, c); }
+	};
+
+	//
+	// Pointers and integers both travel through the interlocked integer of
+	// the same size.
+	//
+	template <typename T>
+	struct wfAtomicCast {
+		typedef wfAtomicInterlocked<sizeof(T)> Ops;
+		typedef typename Ops::Type             Type;
+
+		static Type  To  (T value)              { return (Type)value; }
+		static T     From(Type value)           { return (T)value;    }
+		static volatile Type *Address(volatile T *address) { return reinterpret_cast<volatile Type*>(address); }
+	};
+}
+
+template <typename T> inline T wfAtomicLoad(const volatile T *address) {
+	const T value = *address;
+	wfPrivate::wfAtomicCompilerBarrier();
+	return value;
+}
+template <typename T> inline T wfAtomicLoadRelaxed(const volatile T *address) {
+	return *address;
+}
+
+template <typename T> inline void wfAtomicStore(volatile T *address, T value) {
+	wfPrivate::wfAtomicCompilerBarrier();
+	*address = value;
+}
+template <typename T> inline void wfAtomicStoreRelaxed(volatile T *address, T value) {
+	*address = value;
+}
+
+template <typename T> inline T wfAtomicExchange(volatile T *address, T value) {
+	typedef wfPrivate::wfAtomicCast<T> Cast;
+	return Cast::From(Cast::Ops::Exchange(Cast::Address(address), Cast::To(value)));
+}
+
+template <typename T> inline T wfAtomicFetchAdd(volatile T *address, T value) {
+	typedef wfPrivate::wfAtomicCast<T> Cast;
+	return Cast::From(Cast::Ops::ExchangeAdd(Cast::Address(address), Cast::To(value)));
+}
+
+template <typename T> inline bool wfAtomicCompareExchange(volatile T *address, T& expected, T desired) {
+	typedef wfPrivate::wfAtomicCast<T> Cast;
+	const T found = Cast::From(Cast::Ops::CompareExchange(Cast::Address(address), Cast::To(desired), Cast::To(expected)));
+	if (found == expected)
+		return true;
+	expected = found;
+	return false;
+}
+
+inline void wfAtomicFence() {
+	_ReadWriteBarrier();
+#if defined(_M_ARM) || defined(_M_ARM64)
+	__dmb(0xB);
+#else
+	_mm_mfence();
+#endif
+}
+inline void wfAtomicFenceAcquire() { wfPrivate::wfAtomicCompilerBarrier(); }
+inline void wfAtomicFenceRelease() { wfPrivate::wfAtomicCompilerBarrier(); }
+
+#endif
+
+#endif
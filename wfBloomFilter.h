@@ -0,0 +1,675 @@
+#ifndef WF_STDLIB_BLOOMFILTER_HDR
+#define WF_STDLIB_BLOOMFILTER_HDR
+#include "wfMap.h"
+#include "wfHash.h"
+
+/*
+ * File: wfBloomFilter
+ *  Probabilistic set membership to front lookups that mostly miss.
+ *
+ * >#include "wfBloomFilter.h"
+ *
+ *  A Bloom filter answers whether a key may be present: a *false* answer is
+ *  certain, a *true* answer is wrong with a small, chosen probability.  The
+ *  filters here are blocked, every key sets or tests all of its bits inside
+ *  one 64 byte cache line, so a query costs a single cache miss no matter
+ *  how many hash functions the false positive rate asks for.  When SSE2 is
+ *  available the bits of a key are tested against the whole line at once.
+ *
+ *  <wfBloomFilter> keeps one bit per position and cannot forget a key.
+ *  <wfCountingBloomFilter> keeps a four bit counter per position instead,
+ *  costing four times the memory or more, and supports removal.
+ *  <wfBloomMap> puts a counting filter in front of a <wfMap> so that misses
+ *  are answered without descending the tree.
+ *
+ *  Both filters are sized by the number of keys expected and the false
+ *  positive rate wanted, and can be written to and read back from a flat
+ *  buffer, for instance to store them next to the data they describe.  The
+ *  buffer is in host byte order.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define WF_STDLIB_BLOOMFILTER_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace wfPrivate {
+	enum {
+		wfBloomFilterCacheLine = 64,
+		wfBloomFilterMaxHashes = 16,
+		wfBloomFilterMagic     = 0x46424657, // "WFBF"
+		wfCountingFilterMagic  = 0x46434657  // "WFCF"
+	};
+
+	struct wfBloomFilterHeader {
+		u32 m_magic;
+		u32 m_hashes;
+		u64 m_blocks;
+	};
+
+	//
+	// The block is picked with the upper half of the hash, the positions in
+	// the block are the top bits of the whole hash multiplied over and over
+	// by an odd constant.  Every key gets its own sequence of positions, the
+	// same progression from a start and a step would only leave the keys of
+	// a block a few hundred thousand patterns between them, which is enough
+	// to make the low rates unreachable.
+	//
+	struct wfBloomFilterProbe {
+		wfBloomFilterProbe(u64 hash, u64 blocks) :
+			m_block(static_cast<size_t>(((hash >> 32) * blocks) >> 32)),
+			m_state(hash)
+		{ }
+
+		u32 Next(u32 bits) {
+			m_state *= 0x9E3779B97F4A7C15ULL;
+			return static_cast<u32>(m_state >> (64 - bits));
+		}
+
+		size_t m_block;
+		u64    m_state;
+	};
+
+	//
+	// The cache line aligned blocks and the sizing shared by both filters,
+	// a block holds *positions* bits or counters.
+	//
+	struct wfBloomFilterStorage {
+		wfBloomFilterStorage(size_t count, double rate, size_t positions, wfHeap *heap) :
+			m_heap(heap)
+		{
+			if (count == 0)
+				count = 1;
+			if (!(rate > 0.0 && rate < 1.0))
+				rate = 0.01;
+
+			// the classic optimum is only a lower bound, keys share blocks
+			// unevenly and the fuller blocks answer wrong more often, so the
+			// number of blocks is searched for until the rate of the blocked
+			// filter itself is low enough, with the number of hashes that
+			// needs the fewest of them
+			const double ln2    = 0.69314718055994530942;
+			const double perKey = -log(rate) / (ln2 * ln2);
+			const size_t least  = static_cast<size_t>(perKey * static_cast<double>(count) / static_cast<double>(positions)) + 1;
+
+			m_hashes = 1;
+			m_blocks = 0;
+			for (u32 hashes = 1; hashes <= wfBloomFilterMaxHashes; hashes++) {
+				// double up to enough blocks, then narrow down to the fewest
+				size_t hi = least;
+				while (Rate(count, hi, positions, hashes) > rate && (m_blocks == 0 || hi < m_blocks))
+					hi *= 2;
+				if (m_blocks != 0 && hi >= m_blocks)
+					continue;
+
+				size_t lo = (hi / 2 < least) ? least : hi / 2;
+				while (lo < hi) {
+					const size_t mid = lo + ((hi - lo) >> 1);
+					if (Rate(count, mid, positions, hashes) > rate)
+						lo = mid + 1;
+					else
+						hi = mid;
+				}
+				m_hashes = hashes;
+				m_blocks = hi;
+			}
+
+			Allocate();
+			Clear();
+		}
+
+		//
+		// The false positive rate of *count* keys spread over *blocks*
+		// blocks: the keys a block takes are Poisson distributed, and a
+		// block holding *i* keys answers wrong with the classic rate of a
+		// filter of *positions* bits and *i* keys.
+		//
+		static double Rate(size_t count, size_t blocks, size_t positions, u32 hashes) {
+			const double mean  = static_cast<double>(count) / static_cast<double>(blocks);
+			const double empty = 1.0 - 1.0 / static_cast<double>(positions);
+			const size_t last  = static_cast<size_t>(mean + 12.0 * sqrt(mean)) + 16;
+
+			// the weights are kept as logarithms, a mean in the hundreds
+			// would underflow the weight of an empty block
+			double weight = -mean;
+			double rate   = 0.0;
+			for (size_t i = 1; i <= last; i++) {
+				weight += log(mean / static_cast<double>(i));
+				rate   += exp(weight) * pow(1.0 - pow(empty, static_cast<double>(hashes * i)), static_cast<double>(hashes));
+			}
+			return rate;
+		}
+
+		~wfBloomFilterStorage() {
+			m_heap->Free(m_memory);
+		}
+
+		void Allocate() {
+			m_memory = m_heap->Alloc(m_blocks * wfBloomFilterCacheLine + wfBloomFilterCacheLine);
+			m_data   = reinterpret_cast<unsigned char*>(
+				(reinterpret_cast<size_t>(m_memory) + wfBloomFilterCacheLine - 1) &
+				~static_cast<size_t>(wfBloomFilterCacheLine - 1)
+			);
+		}
+
+		void Clear() {
+			memset(m_data, 0, m_blocks * wfBloomFilterCacheLine);
+		}
+
+		unsigned char *Block(size_t index) const {
+			return m_data + index * wfBloomFilterCacheLine;
+		}
+
+		size_t Bytes() const {
+			return m_blocks * wfBloomFilterCacheLine;
+		}
+
+		size_t SerializedSize() const {
+			return sizeof(wfBloomFilterHeader) + Bytes();
+		}
+
+		void Serialize(void *buffer, u32 magic) const {
+			wfBloomFilterHeader header;
+			header.m_magic  = magic;
+			header.m_hashes = m_hashes;
+			header.m_blocks = m_blocks;
+			memcpy(buffer, &header, sizeof(header));
+			memcpy(static_cast<unsigned char*>(buffer) + sizeof(header), m_data, Bytes());
+		}
+
+		bool Deserialize(const void *buffer, size_t length, u32 magic) {
+			wfBloomFilterHeader header;
+			if (length < sizeof(header))
+				return false;
+
+			memcpy(&header, buffer, sizeof(header));
+			if (header.m_magic != magic || header.m_hashes < 1 || header.m_hashes > wfBloomFilterMaxHashes)
+				return false;
+			if (header.m_blocks == 0 || header.m_blocks > (length - sizeof(header)) / wfBloomFilterCacheLine)
+				return false;
+			if (length != sizeof(header) + header.m_blocks * wfBloomFilterCacheLine)
+				return false;
+
+			if (header.m_blocks != m_blocks) {
+				m_heap->Free(m_memory);
+				m_blocks = static_cast<size_t>(header.m_blocks);
+				Allocate();
+			}
+			m_hashes = header.m_hashes;
+			memcpy(m_data, static_cast<const unsigned char*>(buffer) + sizeof(header), Bytes());
+			return true;
+		}
+
+		wfHeap        *m_heap;
+		void          *m_memory;
+		unsigned char *m_data;
+		size_t         m_blocks;
+		u32            m_hashes;
+	};
+}
+
+/*
+ * Class: wfBloomFilter
+ *  A blocked Bloom filter.
+ *
+ * Parameters:
+ *  K - The key data type.
+ *  H - The hash function object, which must mix well into all 64 bits.
+ *
+ * Remarks:
+ *  The filter does not store keys and never grows, inserting more keys
+ *  than it was sized for raises the false positive rate.
+ */
+template <typename K, typename H = wfFunctional::wfHash<K> >
+struct wfBloomFilter {
+	/*
+	 * Constructor: wfBloomFilter
+	 *  Constructs an empty filter.
+	 *
+	 * Parameters:
+	 *  count - The number of keys expected.
+	 *  rate  - The false positive rate wanted with *count* keys inserted.
+	 *  heap  - The heap the bits are allocated from.
+	 */
+	wfBloomFilter(size_t count, double rate, wfHeap *heap = &g_miscHeap) :
+		m_storage(count, rate, 512, heap)
+	{ }
+
+	/*
+	 * Function: Insert
+	 *  Adds a key to the filter.
+	 */
+	void Insert(const K& key) { InsertHash(H()(key)); }
+
+	/*
+	 * Function: Contains
+	 *  Tests if a key may have been inserted.
+	 *
+	 * Returns:
+	 *  *false* if the key was certainly never inserted, *true* otherwise.
+	 */
+	bool Contains(const K& key) const { return ContainsHash(H()(key)); }
+
+	/*
+	 * Function: InsertHash
+	 *  Adds a key by its hash, for callers that already hashed it.
+	 */
+	void InsertHash(u64 hash) {
+		wfPrivate::wfBloomFilterProbe probe(hash, m_storage.m_blocks);
+		u64 *words = reinterpret_cast<u64*>(m_storage.Block(probe.m_block));
+		for (u32 i = 0; i < m_storage.m_hashes; i++) {
+			const u32 position = probe.Next(9);
+			words[position >> 6] |= static_cast<u64>(1) << (position & 63);
+		}
+	}
+
+	/*
+	 * Function: ContainsHash
+	 *  Tests a key by its hash, see <Contains>.
+	 */
+	bool ContainsHash(u64 hash) const {
+		wfPrivate::wfBloomFilterProbe probe(hash, m_storage.m_blocks);
+		const u64 *words = reinterpret_cast<const u64*>(m_storage.Block(probe.m_block));
+
+#ifdef WF_STDLIB_BLOOMFILTER_SSE2
+		// gather the bits of the key into a mask, then test the line in one go
+		union {
+			__m128i m_vector[4];
+			u64     m_words[8];
+		} mask;
+		mask.m_vector[0] = mask.m_vector[1] = mask.m_vector[2] = mask.m_vector[3] = _mm_setzero_si128();
+		for (u32 i = 0; i < m_storage.m_hashes; i++) {
+			const u32 position = probe.Next(9);
+			mask.m_words[position >> 6] |= static_cast<u64>(1) << (position & 63);
+		}
+
+		const __m128i *line = reinterpret_cast<const __m128i*>(words);
+		__m128i        all  = _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(line + 0), mask.m_vector[0]), mask.m_vector[0]);
+		all = _mm_and_si128(all, _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(line + 1), mask.m_vector[1]), mask.m_vector[1]));
+		all = _mm_and_si128(all, _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(line + 2), mask.m_vector[2]), mask.m_vector[2]));
+		all = _mm_and_si128(all, _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(line + 3), mask.m_vector[3]), mask.m_vector[3]));
+		return _mm_movemask_epi8(all) == 0xFFFF;
+#else
+		for (u32 i = 0; i < m_storage.m_hashes; i++) {
+			const u32 position = probe.Next(9);
+			if (!(words[position >> 6] & (static_cast<u64>(1) << (position & 63))))
+				return false;
+		}
+		return true;
+#endif
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every key from the filter.
+	 */
+	void Clear() { m_storage.Clear(); }
+
+	/*
+	 * Function: Bytes
+	 *  Returns the size of the bits of the filter in bytes.
+	 */
+	size_t Bytes () const { return m_storage.Bytes();  }
+
+	/*
+	 * Function: Hashes
+	 *  Returns the number of bits set per key.
+	 */
+	u32    Hashes() const { return m_storage.m_hashes; }
+
+	/*
+	 * Function: SerializedSize
+	 *  Returns the size of the buffer <Serialize> writes.
+	 */
+	size_t SerializedSize() const { return m_storage.SerializedSize(); }
+
+	/*
+	 * Function: Serialize
+	 *  Writes the filter to a buffer of <SerializedSize> bytes.
+	 */
+	void Serialize(void *buffer) const {
+		m_storage.Serialize(buffer, wfPrivate::wfBloomFilterMagic);
+	}
+
+	/*
+	 * Function: Deserialize
+	 *  Replaces the filter with one written by <Serialize>.
+	 *
+	 * Returns:
+	 *  *true* on success; *false* if the buffer does not hold a filter, in
+	 *  which case this filter is left unchanged.
+	 *
+	 * Remarks:
+	 *  The filter takes the size of the one in the buffer.  It must have
+	 *  been written with the same hash function object.
+	 */
+	bool Deserialize(const void *buffer, size_t length) {
+		return m_storage.Deserialize(buffer, length, wfPrivate::wfBloomFilterMagic);
+	}
+
+private:
+	wfPrivate::wfBloomFilterStorage m_storage;
+
+	wfBloomFilter(const wfBloomFilter&);
+	wfBloomFilter& operator=(const wfBloomFilter&);
+};
+
+/*
+ * Class: wfCountingBloomFilter
+ *  A blocked Bloom filter with four bit counters, which supports removal.
+ *
+ * Parameters:
+ *  K - The key data type.
+ *  H - The hash function object, which must mix well into all 64 bits.
+ *
+ * Remarks:
+ *  A counter that reaches 15 sticks there, removal leaves it alone so the
+ *  filter never answers *false* for a key it holds.  Removing a key that
+ *  was never inserted can make the filter forget other keys, callers must
+ *  only <Erase> keys they know were inserted.
+ */
+template <typename K, typename H = wfFunctional::wfHash<K> >
+struct wfCountingBloomFilter {
+	/*
+	 * Constructor: wfCountingBloomFilter
+	 *  Constructs an empty filter, see <wfBloomFilter::wfBloomFilter>.
+	 */
+	wfCountingBloomFilter(size_t count, double rate, wfHeap *heap = &g_miscHeap) :
+		m_storage(count, rate, 128, heap)
+	{ }
+
+	/*
+	 * Function: Insert
+	 *  Adds a key to the filter.
+	 */
+	void Insert(const K& key) { InsertHash(H()(key)); }
+
+	/*
+	 * Function: Erase
+	 *  Removes a key inserted before from the filter.
+	 */
+	void Erase(const K& key) { EraseHash(H()(key)); }
+
+	/*
+	 * Function: Contains
+	 *  Tests if a key may be in the filter, see <wfBloomFilter::Contains>.
+	 */
+	bool Contains(const K& key) const { return ContainsHash(H()(key)); }
+
+	/*
+	 * Function: InsertHash
+	 *  Adds a key by its hash.
+	 */
+	void InsertHash(u64 hash) {
+		wfPrivate::wfBloomFilterProbe probe(hash, m_storage.m_blocks);
+		unsigned char *line = m_storage.Block(probe.m_block);
+		for (u32 i = 0; i < m_storage.m_hashes; i++) {
+			const u32 position = probe.Next(7);
+			const u32 shift    = (position & 1) << 2;
+			if (((line[position >> 1] >> shift) & 15) != 15)
+				line[position >> 1] += static_cast<unsigned char>(1 << shift);
+		}
+	}
+
+	/*
+	 * Function: EraseHash
+	 *  Removes a key by its hash.
+	 */
+	void EraseHash(u64 hash) {
+		wfPrivate::wfBloomFilterProbe probe(hash, m_storage.m_blocks);
+		unsigned char *line = m_storage.Block(probe.m_block);
+		for (u32 i = 0; i < m_storage.m_hashes; i++) {
+			const u32 position = probe.Next(7);
+			const u32 shift    = (position & 1) << 2;
+			const u32 counter  = (line[position >> 1] >> shift) & 15;
+			if (counter != 0 && counter != 15)
+				line[position >> 1] -= static_cast<unsigned char>(1 << shift);
+		}
+	}
+
+	/*
+	 * Function: ContainsHash
+	 *  Tests a key by its hash.
+	 */
+	bool ContainsHash(u64 hash) const {
+		wfPrivate::wfBloomFilterProbe probe(hash, m_storage.m_blocks);
+		const unsigned char *line = m_storage.Block(probe.m_block);
+
+#ifdef WF_STDLIB_BLOOMFILTER_SSE2
+		// one bit per byte of the line for the low and the high counters
+		// the key needs, tested against which of them are zero
+		u64 low  = 0;
+		u64 high = 0;
+		for (u32 i = 0; i < m_storage.m_hashes; i++) {
+			const u32 position = probe.Next(7);
+			if (position & 1)
+				high |= static_cast<u64>(1) << (position >> 1);
+			else
+				low  |= static_cast<u64>(1) << (position >> 1);
+		}
+
+		const __m128i *vectors = reinterpret_cast<const __m128i*>(line);
+		const __m128i  zero    = _mm_setzero_si128();
+		const __m128i  nibble  = _mm_set1_epi8(15);
+		u64 lowZero  = 0;
+		u64 highZero = 0;
+		for (u32 i = 0; i < 4; i++) {
+			const __m128i bytes = _mm_load_si128(vectors + i);
+			lowZero  |= static_cast<u64>(static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(bytes, nibble), zero)))) << (i * 16);
+			highZero |= static_cast<u64>(static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_andnot_si128(nibble, bytes), zero)))) << (i * 16);
+		}
+		return !(low & lowZero) && !(high & highZero);
+#else
+		for (u32 i = 0; i < m_storage.m_hashes; i++) {
+			const u32 position = probe.Next(7);
+			if (!((line[position >> 1] >> ((position & 1) << 2)) & 15))
+				return false;
+		}
+		return true;
+#endif
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every key from the filter.
+	 */
+	void Clear() { m_storage.Clear(); }
+
+	/*
+	 * Function: Bytes
+	 *  Returns the size of the counters of the filter in bytes.
+	 */
+	size_t Bytes () const { return m_storage.Bytes();  }
+
+	/*
+	 * Function: Hashes
+	 *  Returns the number of counters touched per key.
+	 */
+	u32    Hashes() const { return m_storage.m_hashes; }
+
+	/*
+	 * Function: SerializedSize
+	 *  Returns the size of the buffer <Serialize> writes.
+	 */
+	size_t SerializedSize() const { return m_storage.SerializedSize(); }
+
+	/*
+	 * Function: Serialize
+	 *  Writes the filter to a buffer of <SerializedSize> bytes.
+	 */
+	void Serialize(void *buffer) const {
+		m_storage.Serialize(buffer, wfPrivate::wfCountingFilterMagic);
+	}
+
+	/*
+	 * Function: Deserialize
+	 *  Replaces the filter with one written by <Serialize>, see
+	 *  <wfBloomFilter::Deserialize>.
+	 */
+	bool Deserialize(const void *buffer, size_t length) {
+		return m_storage.Deserialize(buffer, length, wfPrivate::wfCountingFilterMagic);
+	}
+
+private:
+	wfPrivate::wfBloomFilterStorage m_storage;
+
+	wfCountingBloomFilter(const wfCountingBloomFilter&);
+	wfCountingBloomFilter& operator=(const wfCountingBloomFilter&);
+};
+
+/*
+ * Class: wfBloomMap
+ *  A <wfMap> fronted by a <wfCountingBloomFilter>.
+ *
+ * Parameters:
+ *  K - The key data type.
+ *  V - The value data type.
+ *  H - The hash function object used by the filter.
+ *
+ * Remarks:
+ *  <Find> and <Count> consult the filter first and only descend the tree
+ *  when it answers *true*.  Once the map holds twice the keys the filter
+ *  was sized for, the filter is rebuilt twice as large from the keys in
+ *  the map, keeping the false positive rate near the one asked for.
+ */
+template <typename K, typename V, typename H = wfFunctional::wfHash<K> >
+struct wfBloomMap {
+	typedef wfMap<K, V>                           Map;
+	typedef typename Map::Iterator                Iterator;
+	typedef typename Map::ConstIterator           ConstIterator;
+	typedef wfCountingBloomFilter<K, H>           Filter;
+
+	/*
+	 * Constructor: wfBloomMap
+	 *  Constructs an empty map.
+	 *
+	 * Parameters:
+	 *  count - The number of keys the filter is first sized for.
+	 *  rate  - The false positive rate of the filter.
+	 */
+	explicit wfBloomMap(size_t count = 1024, double rate = 0.01) :
+		m_filter(new (g_miscHeap.Alloc(sizeof(Filter))) Filter(count, rate)),
+		m_count (count ? count : 1),
+		m_rate  (rate)
+	{ }
+
+	~wfBloomMap() {
+		m_filter->~Filter();
+		g_miscHeap.Free(m_filter);
+	}
+
+	/*
+	 * Function: Insert
+	 *  Inserts a key and value unless the key is already present, see
+	 *  <wfMap::Insert>.
+	 *
+	 * Returns:
+	 *  A reference to the value of the key, which is the value already held
+	 *  if there was one.
+	 */
+	V& Insert(const K& key, const V& value) {
+		const u64 hash = H()(key);
+		if (m_filter->ContainsHash(hash)) {
+			Iterator it = m_map.Find(key);
+			if (it != m_map.End())
+				return it->second;
+		}
+
+		V& inserted = m_map.Insert(key, value);
+		m_filter->InsertHash(hash);
+		if (m_map.Length() > m_count * 2)
+			Rebuild(m_count * 2);
+		return inserted;
+	}
+
+	/*
+	 * Function: Find
+	 *  Returns an iterator to the element with a key, or <End> if there is
+	 *  none.  There exists a const cv-qualified version of this function as
+	 *  well.
+	 */
+	Iterator Find(const K& key) {
+		return m_filter->Contains(key) ? m_map.Find(key) : m_map.End();
+	}
+	ConstIterator Find(const K& key) const {
+		const Map &map = m_map;
+		return m_filter->Contains(key) ? map.Find(key) : map.End();
+	}
+
+	/*
+	 * Function: Count
+	 *  Returns *1* if the map has an element with a key, *0* otherwise.
+	 */
+	size_t Count(const K& key) const {
+		return Find(key) != End() ? 1 : 0;
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes the element with a key, if there is one.
+	 */
+	void Erase(const K& key) {
+		const u64 hash = H()(key);
+		if (!m_filter->ContainsHash(hash))
+			return;
+
+		Iterator it = m_map.Find(key);
+		if (it == m_map.End())
+			return;
+
+		m_map.Erase(key);
+		m_filter->EraseHash(hash);
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every element.
+	 */
+	void Clear() {
+		m_map.Clear();
+		m_filter->Clear();
+	}
+
+	Iterator      Begin()       { return m_map.Begin(); }
+	ConstIterator Begin() const { return m_map.Begin(); }
+	Iterator      End  ()       { return m_map.End();   }
+	ConstIterator End  () const { return m_map.End();   }
+
+	size_t Length() const { return m_map.Length(); }
+	bool   Empty () const { return m_map.Empty();  }
+
+	/*
+	 * Function: GetMap
+	 *  Returns the map behind the filter for reading.
+	 */
+	const Map&    GetMap   () const { return m_map;     }
+
+	/*
+	 * Function: GetFilter
+	 *  Returns the filter, for instance to serialize it.
+	 */
+	const Filter& GetFilter() const { return *m_filter; }
+
+private:
+	void Rebuild(size_t count) {
+		Filter *filter = new (g_miscHeap.Alloc(sizeof(Filter))) Filter(count, m_rate);
+		const Map &map = m_map;
+		for (ConstIterator it = map.Begin(); it != map.End(); ++it)
+			filter->Insert(it->first);
+
+		m_filter->~Filter();
+		g_miscHeap.Free(m_filter);
+		m_filter = filter;
+		m_count  = count;
+	}
+
+	Map     m_map;
+	Filter *m_filter;
+	size_t  m_count;
+	double  m_rate;
+
+	wfBloomMap(const wfBloomMap&);
+	wfBloomMap& operator=(const wfBloomMap&);
+};
+
+#endif
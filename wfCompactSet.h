@@ -0,0 +1,701 @@
+#ifndef WF_STDLIB_COMPACTSET_HDR
+#define WF_STDLIB_COMPACTSET_HDR
+#include "wfSet.h"
+#include "wfTypeTraits.h"
+
+/*
+ * File: wfCompactSet
+ *  Memory compact variants of <wfSet> and <wfMap>.
+ *
+ * >#include "wfCompactSet.h"
+ *
+ *  <wfCompactSet> and <wfCompactMap> are the same AA tree as <wfSet> and
+ *  <wfMap> but all nodes live in a single pooled array owned by the
+ *  container.  Links are 32-bit indices into that array instead of
+ *  pointers, and the node level is packed into the top bits of the
+ *  parent index, so a node costs the element plus 12 bytes instead of
+ *  the element plus 32 bytes on 64-bit targets.  A *wfCompactMap<u32, u32>*
+ *  node is 20 bytes where the <wfMap> node is 40, and since the nodes are
+ *  contiguous a lookup touches far fewer cache lines.
+ *
+ *  The price is that the pool grows by reallocation: pointers and
+ *  references to elements are invalidated by any <Insert> that grows the
+ *  pool (use <Reserve> up front to avoid it).  Iterators are indices and
+ *  stay valid across growth.  Erased nodes are kept on a free list and
+ *  reused by later insertions.
+ *
+ *  A container holds at most 134217727 (2^27 - 1) elements.
+ */
+
+namespace wfPrivate {
+	enum {
+		wfCompactSetIndexBits = 27,
+		wfCompactSetIndexMask = (1u << wfCompactSetIndexBits) - 1,
+		wfCompactSetMaxLength = wfCompactSetIndexMask
+	};
+
+	//
+	// Index 0 is the nil sentinel, it has level 0.  Live nodes have level
+	// 1 or greater, nodes on the free list have level 0 and chain through
+	// m_left.
+	//
+	template <typename T>
+	struct wfCompactSetNode {
+		T   m_data;
+		u32 m_left;
+		u32 m_right;
+		u32 m_link;   // parent index in the low 27 bits, level in the high 5
+
+		u32  Parent() const { return m_link &  wfCompactSetIndexMask; }
+		u32  Level () const { return m_link >> wfCompactSetIndexBits; }
+
+		void SetParent(u32 parent) { m_link = (m_link & ~static_cast<u32>(wfCompactSetIndexMask)) | parent; }
+		void SetLevel (u32 level)  { m_link = (m_link &  static_cast<u32>(wfCompactSetIndexMask)) | (level << wfCompactSetIndexBits); }
+	};
+
+	template <typename T>
+	struct wfCompactSetPool {
+		wfCompactSetNode<T> *m_nodes;
+		u32                  m_root;
+		u32                  m_free;
+		u32                  m_used;      // high water mark, including nil
+		u32                  m_capacity;
+		size_t               m_length;
+	};
+}
+
+/*
+ * Class: wfCompactSetIterator
+ *  Bidirectional iterator, no offsets.
+ */
+template <typename T>
+struct wfCompactSetIterator {
+	typedef ptrdiff_t DifferenceType;
+	typedef T         ValueType;
+	typedef T&        ReferenceType;
+	typedef T*        PointerType;
+
+	wfCompactSetIterator() :
+		m_pool (wfNullPointer),
+		m_index(0)
+	{ };
+
+	wfCompactSetIterator(const wfPrivate::wfCompactSetPool<T> *pool, u32 index) :
+		m_pool (pool),
+		m_index(index)
+	{ };
+
+	ReferenceType operator * () const { return  m_pool->m_nodes[m_index].m_data; }
+	PointerType   operator ->() const { return &m_pool->m_nodes[m_index].m_data; }
+
+	wfCompactSetIterator& operator ++() {
+		const wfPrivate::wfCompactSetNode<T> *nodes = m_pool->m_nodes;
+		if (nodes[m_index].m_right != 0) {
+			m_index = nodes[m_index].m_right;
+			while (nodes[m_index].m_left != 0)
+				m_index = nodes[m_index].m_left;
+		} else {
+			u32 parent = nodes[m_index].Parent();
+			while (parent != 0 && m_index == nodes[parent].m_right) {
+				m_index = parent;
+				parent  = nodes[parent].Parent();
+			}
+			m_index = parent;
+		}
+
+		return *this;
+	}
+
+	wfCompactSetIterator& operator --() {
+		const wfPrivate::wfCompactSetNode<T> *nodes = m_pool->m_nodes;
+		if (m_index == 0) {
+			// from the end to the last element
+			m_index = m_pool->m_root;
+			while (nodes[m_index].m_right != 0)
+				m_index = nodes[m_index].m_right;
+		} else if (nodes[m_index].m_left != 0) {
+			m_index = nodes[m_index].m_left;
+			while (nodes[m_index].m_right != 0)
+				m_index = nodes[m_index].m_right;
+		} else {
+			u32 parent = nodes[m_index].Parent();
+			while (parent != 0 && m_index == nodes[parent].m_left) {
+				m_index = parent;
+				parent  = nodes[parent].Parent();
+			}
+			m_index = parent;
+		}
+
+		return *this;
+	}
+
+	wfCompactSetIterator operator ++(int) {
+		wfCompactSetIterator tmp(*this);
+		operator++();
+		return tmp;
+	}
+
+	wfCompactSetIterator operator --(int) {
+		wfCompactSetIterator tmp(*this);
+		operator--();
+		return tmp;
+	}
+
+	friend bool operator == (
+		const wfCompactSetIterator &a,
+		const wfCompactSetIterator &b
+	) { return a.m_index == b.m_index; }
+
+	friend bool operator != (
+		const wfCompactSetIterator &a,
+		const wfCompactSetIterator &b
+	) { return a.m_index != b.m_index; }
+
+protected:
+	const wfPrivate::wfCompactSetPool<T> *m_pool;
+	u32                                   m_index;
+
+	template <typename U> friend struct wfCompactSetIterator;
+	template <typename U> friend struct wfCompactSetConstIterator;
+	template <typename U> friend struct wfCompactSet;
+};
+
+template <typename T>
+struct wfCompactSetConstIterator : wfCompactSetIterator<T> {
+	typedef ptrdiff_t DifferenceType;
+	typedef T         ValueType;
+	typedef const T*  PointerType;
+	typedef const T&  ReferenceType;
+
+	wfCompactSetConstIterator(const wfCompactSetIterator<T> &it) :
+		wfCompactSetIterator<T>(it)
+	{ }
+
+	ReferenceType operator * () const { return  this->m_pool->m_nodes[this->m_index].m_data; }
+	PointerType   operator ->() const { return &this->m_pool->m_nodes[this->m_index].m_data; }
+};
+
+/*
+ * Class: wfCompactSet
+ *  An associative container using an AA tree stored in a pooled node array
+ *
+ * Parameters:
+ *  T - The element data type to be stored in the <wfCompactSet>.
+ *
+ * Remarks:
+ *  Has the interface and ordering of <wfSet>.  See the file overview above
+ *  for the memory layout and the different invalidation rules.
+ */
+template <typename T>
+struct wfCompactSet {
+	typedef wfCompactSetIterator<T>          Iterator;
+	typedef wfCompactSetConstIterator<T>     ConstIterator;
+	typedef wfReverseIterator<Iterator>      ReverseIterator;
+	typedef wfReverseIterator<ConstIterator> ConstReverseIterator;
+
+	wfCompactSet() {
+		m_pool.m_nodes    = wfNullPointer;
+		m_pool.m_root     = 0;
+		m_pool.m_free     = 0;
+		m_pool.m_used     = 0;
+		m_pool.m_capacity = 0;
+		m_pool.m_length   = 0;
+		Grow(1);
+	}
+
+	~wfCompactSet() {
+		Destroy();
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of elements in the <wfCompactSet>.
+	 */
+	size_t Length() const { return m_pool.m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if a <wfCompactSet> is empty.
+	 */
+	bool   Empty () const { return m_pool.m_length == 0; }
+
+	/*
+	 * Function: Capacity
+	 *  Returns the number of elements the <wfCompactSet> can hold before the
+	 *  node pool is grown.
+	 */
+	size_t Capacity() const { return m_pool.m_capacity - 1; }
+
+	/*
+	 * Function: Reserve
+	 *  Grows the node pool to hold at least a specified number of elements.
+	 *
+	 * Parameters:
+	 *  length - The number of elements to reserve room for.
+	 *
+	 * Remarks:
+	 *  Inserting up to *length* elements after a *Reserve* never moves the
+	 *  elements in memory.
+	 */
+	void Reserve(size_t length) {
+		if (length > wfPrivate::wfCompactSetMaxLength)
+			length = wfPrivate::wfCompactSetMaxLength;
+		if (length + 1 > m_pool.m_capacity)
+			Grow(static_cast<u32>(length + 1));
+	}
+
+	Iterator      Begin()       { return Iterator     (&m_pool, MinNode(m_pool.m_root)); }
+	ConstIterator Begin() const { return ConstIterator(Iterator(&m_pool, MinNode(m_pool.m_root))); }
+
+	Iterator      End  ()       { return Iterator     (&m_pool, 0); }
+	ConstIterator End  () const { return ConstIterator(Iterator(&m_pool, 0)); }
+
+	ReverseIterator      ReverseBegin()       { return ReverseIterator     (End()); }
+	ConstReverseIterator ReverseBegin() const { return ConstReverseIterator(End()); }
+
+	ReverseIterator      ReverseEnd()       { return ReverseIterator     (Begin()); }
+	ConstReverseIterator ReverseEnd() const { return ConstReverseIterator(Begin()); }
+
+	/*
+	 * Function: Insert
+	 *  Inserts an element into a <wfCompactSet>
+	 *
+	 * Parameters:
+	 *  data - The value of an element to be inserted into the set unless the
+	 *         set already contain an element whose key is equivalently ordered.
+	 *
+	 * Returns:
+	 *   A reference to the element added, or element which already exists.
+	 *
+	 * Remarks:
+	 *  The reference is invalidated by the next insertion that grows the pool.
+	 *  Inserting a new element into a set already holding 2^27 - 1 elements is
+	 *  undefined; unless *WF_STDLIB_DEBUG* is defined, in which case an
+	 *  assertion will be invoked.
+	 */
+	T& Insert(const T& data) {
+		// InsertIndex may grow the pool, so index it only after
+		const u32 index = InsertIndex(data);
+		return m_pool.m_nodes[index].m_data;
+	}
+
+	/*
+	 * Function: Clear
+	 *  Erases all the elements of a <wfCompactSet> and releases the node pool.
+	 */
+	void Clear() {
+		Destroy();
+		m_pool.m_nodes    = wfNullPointer;
+		m_pool.m_root     = 0;
+		m_pool.m_free     = 0;
+		m_pool.m_used     = 0;
+		m_pool.m_capacity = 0;
+		m_pool.m_length   = 0;
+		Grow(1);
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes an element in a <wfCompactSet> matching a specified key.
+	 *
+	 * Parameters:
+	 *  key - The key of the element to be removed from the set.
+	 *
+	 * Remarks:
+	 *  Nothing is removed if no element matches the key.  The node is put on the
+	 *  free list of the pool, the pool itself never shrinks until <Clear>.
+	 */
+	template <typename U>
+	void Erase(const U& key) {
+		const u32 index = Erase(m_pool.m_root, Probe(key));
+		if (index == 0)
+			return;
+
+		wfPrivate::wfCompactSetNode<T> &node = m_pool.m_nodes[index];
+		node.m_data.~T();
+		node.m_link  = 0;
+		node.m_right = 0;
+		node.m_left  = m_pool.m_free;
+		m_pool.m_free = index;
+	}
+
+	/*
+	 * Function: Find
+	 *  Returns an iterator addressing the element in a <wfCompactSet> that has a
+	 *  key equivalent to a specified key, or <End> if there is none.
+	 *
+	 * Remarks:
+	 *  A key of another type than the key type is converted to it first, unless
+	 *  <wfFunctional::wfTransparentKey> opts it in, the same holds for every other
+	 *  lookup taking a key.
+	 */
+	template <typename U> Iterator      Find(const U& key)       { return Iterator     (&m_pool, FindIndex(Probe(key))); }
+	template <typename U> ConstIterator Find(const U& key) const { return ConstIterator(Iterator(&m_pool, FindIndex(Probe(key)))); }
+
+	/*
+	 * Function: Count
+	 *  Returns 1 if the <wfCompactSet> contains an element whose key matches a
+	 *  specified key; 0 otherwise.
+	 */
+	template <typename U>
+	size_t Count(const U& key) const {
+		return (FindIndex(Probe(key)) != 0) ? 1 : 0;
+	}
+
+	/*
+	 * Function: LowerBound
+	 *  Returns an iterator to the first element in a <wfCompactSet> with a key that
+	 *  is equal to or greater than a specified key.
+	 */
+	template <typename U> Iterator      LowerBound(const U& key)       { return Iterator     (&m_pool, LowerBoundIndex(Probe(key))); }
+	template <typename U> ConstIterator LowerBound(const U& key) const { return ConstIterator(Iterator(&m_pool, LowerBoundIndex(Probe(key)))); }
+
+	/*
+	 * Function: UpperBound
+	 *  Returns an iterator to the first element in a <wfCompactSet> with a key that
+	 *  is greater than a specified key.
+	 */
+	template <typename U> Iterator      UpperBound(const U& key)       { return Iterator     (&m_pool, UpperBoundIndex(Probe(key))); }
+	template <typename U> ConstIterator UpperBound(const U& key) const { return ConstIterator(Iterator(&m_pool, UpperBoundIndex(Probe(key)))); }
+
+protected:
+	typedef wfPrivate::wfCompactSetNode<T> Node;
+	typedef wfPrivate::wfSetKey<T>         Key;
+	typedef typename Key::Type             KeyType;
+
+	template <typename U>
+	int Compare(const U& key, u32 index) const {
+		return wfFunctional::wfCompare<U, KeyType>()(key, Key::Get(m_pool.m_nodes[index].m_data));
+	}
+
+	// the key a lookup searches the pool with, see wfPrivate::wfLookupKey
+	template <typename U>
+	static typename wfPrivate::wfLookupKey<U, KeyType>::Type Probe(const U& key) {
+		return key;
+	}
+
+	void Destroy() {
+		if (!wfIsPOD<T>::value) {
+			for (u32 index = 1; index < m_pool.m_used; index++) {
+				if (m_pool.m_nodes[index].Level() != 0)
+					m_pool.m_nodes[index].m_data.~T();
+			}
+		}
+		g_miscHeap.Free(m_pool.m_nodes);
+	}
+
+	void Grow(u32 capacity) {
+		Node *nodes = reinterpret_cast<Node*>(g_miscHeap.Alloc(capacity * sizeof(Node)));
+
+		if (m_pool.m_used == 0) {
+			// the nil sentinel, its element is never constructed
+			nodes[0].m_left  = 0;
+			nodes[0].m_right = 0;
+			nodes[0].m_link  = 0;
+			m_pool.m_used    = 1;
+		} else if (wfIsPOD<T>::value) {
+			memcpy(static_cast<void*>(nodes), m_pool.m_nodes, m_pool.m_used * sizeof(Node));
+			g_miscHeap.Free(m_pool.m_nodes);
+		} else {
+			for (u32 index = 0; index < m_pool.m_used; index++) {
+				Node &from = m_pool.m_nodes[index];
+				Node &to   = nodes[index];
+
+				to.m_left  = from.m_left;
+				to.m_right = from.m_right;
+				to.m_link  = from.m_link;
+				if (index != 0 && from.Level() != 0) {
+					new (&to.m_data) T(from.m_data);
+					from.m_data.~T();
+				}
+			}
+			g_miscHeap.Free(m_pool.m_nodes);
+		}
+
+		m_pool.m_nodes    = nodes;
+		m_pool.m_capacity = capacity;
+	}
+
+	//
+	// Makes sure one node can be allocated without growing the pool, so
+	// that the link references held while descending stay valid.
+	//
+	void Prepare() {
+		if (m_pool.m_free != 0 || m_pool.m_used < m_pool.m_capacity)
+			return;
+
+#       ifdef WF_STDLIB_DEBUG
+			WF_STDLIB_ASSERT(m_pool.m_used <= wfPrivate::wfCompactSetMaxLength);
+#       endif
+
+		u32 capacity = (m_pool.m_capacity < 16) ? 16 : m_pool.m_capacity * 2;
+		if (capacity > wfPrivate::wfCompactSetMaxLength + 1)
+			capacity = wfPrivate::wfCompactSetMaxLength + 1;
+
+		Grow(capacity);
+	}
+
+	u32 Allocate(const T& data, u32 parent) {
+		u32 index = m_pool.m_free;
+		if (index != 0)
+			m_pool.m_free = m_pool.m_nodes[index].m_left;
+		else
+			index = m_pool.m_used++;
+
+		Node &node = m_pool.m_nodes[index];
+		new (&node.m_data) T(data);
+		node.m_left  = 0;
+		node.m_right = 0;
+		node.m_link  = parent;
+		node.SetLevel(1);
+		m_pool.m_length ++;
+
+		return index;
+	}
+
+	u32 MinNode(u32 index) const {
+		while (m_pool.m_nodes[index].m_left != 0)
+			index = m_pool.m_nodes[index].m_left;
+		return index;
+	}
+
+	void Skew(u32 &n1) {
+		Node *nodes = m_pool.m_nodes;
+		const u32 level = nodes[n1].Level();
+		if (level && level == nodes[nodes[n1].m_left].Level()) {
+			const u32 n2 = nodes[n1].m_left;
+			nodes[n2].SetParent(nodes[n1].Parent());
+			nodes[n1].m_left = nodes[n2].m_right;
+			nodes[nodes[n1].m_left].SetParent(n1);
+			nodes[n2].m_right = n1;
+			nodes[n1].SetParent(n2);
+			n1 = n2;
+		}
+	}
+
+	void Split(u32 &n1) {
+		Node *nodes = m_pool.m_nodes;
+		const u32 level = nodes[n1].Level();
+		if (level && level == nodes[nodes[nodes[n1].m_right].m_right].Level()) {
+			const u32 n2 = nodes[n1].m_right;
+			nodes[n2].SetParent(nodes[n1].Parent());
+			nodes[n1].m_right = nodes[n2].m_left;
+			nodes[nodes[n1].m_right].SetParent(n1);
+			nodes[n2].m_left = n1;
+			nodes[n1].SetParent(n2);
+			nodes[n2].SetLevel(level + 1);
+			n1 = n2;
+		}
+	}
+
+	void Rebalance(u32 &index) {
+		Node     *nodes = m_pool.m_nodes;
+		const u32 level = wfMin(nodes[nodes[index].m_left].Level(), nodes[nodes[index].m_right].Level()) + 1;
+		if (level < nodes[index].Level()) {
+			nodes[index].SetLevel(level);
+			if (level < nodes[nodes[index].m_right].Level())
+				nodes[nodes[index].m_right].SetLevel(level);
+
+			Skew (index);
+			Skew (nodes[index].m_right);
+			Skew (nodes[nodes[index].m_right].m_right);
+			Split(index);
+			Split(nodes[index].m_right);
+		}
+	}
+
+	u32 InsertIndex(const T& data) {
+		// data may be an element of the set itself, which growing the pool
+		// frees, but then its key is found without having to grow
+		if (m_pool.m_free == 0 && m_pool.m_used >= m_pool.m_capacity) {
+			const u32 index = FindIndex(Key::Get(data));
+			if (index != 0)
+				return index;
+		}
+
+		Prepare();
+		return Insert(m_pool.m_root, data, 0);
+	}
+
+	u32 Insert(u32 &index, const T& data, u32 parent) {
+		if (index == 0) {
+			index = Allocate(data, parent);
+			return index;
+		}
+
+		const int compare = Compare(Key::Get(data), index);
+		if (compare == 0)
+			return index;
+
+		const u32 ret = Insert(((compare > 0)
+			? m_pool.m_nodes[index].m_right
+			: m_pool.m_nodes[index].m_left
+		), data, index);
+
+		Skew (index);
+		Split(index);
+
+		return ret;
+	}
+
+	template <typename U>
+	u32 Erase(u32 &index, const U& key) {
+		if (index == 0)
+			return 0;
+
+		Node     *nodes   = m_pool.m_nodes;
+		u32       ret     = 0;
+		const int compare = Compare(key, index);
+		if (compare == 0) {
+			if (nodes[index].m_left != 0 && nodes[index].m_right != 0) {
+				u32 heir = nodes[index].m_left;
+				while (nodes[heir].m_right != 0)
+					heir = nodes[heir].m_right;
+
+				// unlink the heir and put it in the place of the node, the
+				// elements themselves never move
+				Erase(nodes[index].m_left, Key::Get(nodes[heir].m_data));
+
+				nodes[heir].m_left  = nodes[index].m_left;
+				nodes[heir].m_right = nodes[index].m_right;
+				nodes[heir].m_link  = nodes[index].m_link;
+				if (nodes[heir].m_left != 0)
+					nodes[nodes[heir].m_left].SetParent(heir);
+				if (nodes[heir].m_right != 0)
+					nodes[nodes[heir].m_right].SetParent(heir);
+
+				ret   = index;
+				index = heir;
+			} else {
+				const u32 parent = nodes[index].Parent();
+				ret = index;
+
+				index = (nodes[index].m_left == 0)
+					? nodes[index].m_right
+					: nodes[index].m_left;
+
+				if (index != 0)
+					nodes[index].SetParent(parent);
+				m_pool.m_length --;
+
+				return ret;
+			}
+		} else {
+			ret = Erase(((compare < 0)
+				? nodes[index].m_left
+				: nodes[index].m_right
+			), key);
+		}
+
+		if (ret)
+			Rebalance(index);
+
+		return ret;
+	}
+
+	template <typename U>
+	u32 FindIndex(const U& key) const {
+		u32 index = m_pool.m_root;
+		while (index != 0) {
+			const int compare = Compare(key, index);
+			if (compare == 0)
+				break;
+
+			index = (compare < 0) ? m_pool.m_nodes[index].m_left : m_pool.m_nodes[index].m_right;
+		}
+
+		return index;
+	}
+
+	template <typename U>
+	u32 LowerBoundIndex(const U& key) const {
+		u32 index = m_pool.m_root;
+		u32 bound = 0;
+		while (index != 0) {
+			if (Compare(key, index) <= 0) {
+				bound = index;
+				index = m_pool.m_nodes[index].m_left;
+			} else {
+				index = m_pool.m_nodes[index].m_right;
+			}
+		}
+
+		return bound;
+	}
+
+	template <typename U>
+	u32 UpperBoundIndex(const U& key) const {
+		u32 index = m_pool.m_root;
+		u32 bound = 0;
+		while (index != 0) {
+			if (Compare(key, index) < 0) {
+				bound = index;
+				index = m_pool.m_nodes[index].m_left;
+			} else {
+				index = m_pool.m_nodes[index].m_right;
+			}
+		}
+
+		return bound;
+	}
+
+	wfPrivate::wfCompactSetPool<T> m_pool;
+
+private:
+	// the pool is owned, copying would need a deep copy of every node
+	wfCompactSet(const wfCompactSet&);
+	wfCompactSet& operator=(const wfCompactSet&);
+};
+
+/*
+ * Class: wfCompactMap
+ *  An associative container of key-value pairs using an AA tree stored in a
+ *  pooled node array
+ *
+ * Parameters:
+ *  T - The key data type to be stored in the <wfCompactMap>.
+ *  U - The element data type to be stored in the <wfCompactMap>.
+ *
+ * Remarks:
+ *  Has the interface of <wfMap>.  See the file overview above for the memory
+ *  layout and the different invalidation rules.  Iterators address a <wfPair> whose *first*
+ *  is the key and *second* the value.
+ */
+template <typename T, typename U>
+struct wfCompactMap : wfCompactSet<wfPair<T, U> > {
+	typedef wfCompactSet<wfPair<T, U> >  Base;
+	typedef typename Base::Iterator      Iterator;
+	typedef typename Base::ConstIterator ConstIterator;
+
+	/*
+	 * Function: Insert
+	 *  Inserts a key-value pair into a <wfCompactMap> unless the key is already
+	 *  present.
+	 *
+	 * Returns:
+	 *  A reference to the value associated with the key, invalidated by the next
+	 *  insertion that grows the pool.
+	 */
+	U& Insert(const T& key, const U& data) {
+		return Base::Insert(wfPair<T, U>(key, data)).second;
+	}
+
+	U& Insert(const wfPair<T, U>& pair) {
+		return Base::Insert(pair).second;
+	}
+
+	/*
+	 * Function: operator[]
+	 *  Returns the value associated with a key, inserting a default constructed
+	 *  value if the key is not present.
+	 */
+	U& operator[](const T& key) {
+		const u32 index = Base::FindIndex(key);
+		if (index != 0)
+			return this->m_pool.m_nodes[index].m_data.second;
+
+		return Insert(key, U());
+	}
+};
+
+#endif
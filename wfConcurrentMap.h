@@ -0,0 +1,385 @@
+#ifndef WF_STDLIB_CONCURRENTMAP_HDR
+#define WF_STDLIB_CONCURRENTMAP_HDR
+#include "wfMap.h"
+#include "wfHash.h"
+#include "wfThread.h"
+
+/*
+ * File: wfConcurrentMap
+ *  A map that can be shared between threads without an outer lock.
+ *
+ * >#include "wfConcurrentMap.h"
+ *
+ *  Keys are hashed into a power of two number of shards, every shard is a
+ *  <wfMap> behind its own <wfRWLock>.  Threads touching different shards
+ *  never contend, threads reading the same shard only share the reader
+ *  count of its lock.
+ *
+ *  When both the key and the value are scalars of at most 64 bits
+ *  (integers, floating point or pointers) every shard additionally keeps a
+ *  small direct mapped cache of recently found and written entries guarded
+ *  by a sequence counter.
+ *  A <Find> that hits the cache completes without taking the lock and
+ *  without writing to shared memory at all, it only retries through the
+ *  lock when a writer touched the shard while it was reading.
+ *
+ *  Nothing is handed out by reference, <Find> copies the value out, since
+ *  a reference would outlive the lock that made it safe to use.
+ */
+
+namespace wfPrivate {
+	enum {
+		wfConcurrentMapCacheLine    = 64,
+		wfConcurrentMapCacheEntries = 16
+	};
+
+	template <size_t> struct wfConcurrentMapWord;
+	template <>       struct wfConcurrentMapWord<1> { typedef u8  Type; };
+	template <>       struct wfConcurrentMapWord<2> { typedef u16 Type; };
+	template <>       struct wfConcurrentMapWord<4> { typedef u32 Type; };
+	template <>       struct wfConcurrentMapWord<8> { typedef u64 Type; };
+
+	//
+	// A scalar kept as the integer of the same size, so that readers and
+	// writers racing on it do so through atomic loads and stores, floating
+	// point included.
+	//
+	template <typename T>
+	struct wfConcurrentMapSlot {
+		typedef typename wfConcurrentMapWord<sizeof(T)>::Type Word;
+
+		T Load() const {
+			const Word word = wfAtomicLoadRelaxed(&m_word);
+			T          value;
+			memcpy(&value, &word, sizeof(T));
+			return value;
+		}
+
+		void Store(const T& value) {
+			Word word;
+			memcpy(&word, &value, sizeof(T));
+			wfAtomicStoreRelaxed(&m_word, word);
+		}
+
+		volatile Word m_word;
+	};
+
+	template <typename K, typename V>
+	struct wfConcurrentMapEntry {
+		wfConcurrentMapSlot<K> m_key;
+		wfConcurrentMapSlot<V> m_value;
+		volatile u32           m_used;
+	};
+
+	//
+	// The cache: writers to the map (holding the shard exclusively) and
+	// readers filling the cache (holding it shared) make the sequence odd
+	// with a compare exchange while they write an entry, and even again
+	// once they are done.  Readers without the lock load an entry between
+	// two loads of the sequence and discard what they loaded unless both
+	// loads saw the same even value.
+	//
+	template <typename K, typename V, bool>
+	struct wfConcurrentMapCache {
+		typedef wfConcurrentMapEntry<K, V> Entry;
+
+		wfConcurrentMapCache() :
+			m_sequence(0)
+		{
+			for (size_t i = 0; i < wfConcurrentMapCacheEntries; i++)
+				m_entries[i].m_used = 0;
+		}
+
+		bool Find(const K& key, u64 hash, V& value) const {
+			const u32 begin = wfAtomicLoad(&m_sequence);
+			if (begin & 1)
+				return false;
+
+			const Entry &entry = m_entries[hash & (wfConcurrentMapCacheEntries - 1)];
+			const u32    used  = wfAtomicLoadRelaxed(&entry.m_used);
+			const K      found = entry.m_key.Load();
+			const V      copy  = entry.m_value.Load();
+
+			wfAtomicFenceAcquire();
+			if (wfAtomicLoadRelaxed(&m_sequence) != begin)
+				return false;
+
+			if (!used || wfFunctional::wfCompare<K, K>()(found, key) != 0)
+				return false;
+
+			value = copy;
+			return true;
+		}
+
+		//
+		// Only writes the entry when nobody else is writing one, a reader
+		// filling the cache would rather skip it than wait.
+		//
+		bool TryStore(const K& key, u64 hash, const V& value) {
+			u32 sequence = wfAtomicLoadRelaxed(&m_sequence);
+			if ((sequence & 1) || !wfAtomicCompareExchange(&m_sequence, sequence, sequence + 1))
+				return false;
+
+			wfAtomicFenceRelease();
+			Entry &entry = m_entries[hash & (wfConcurrentMapCacheEntries - 1)];
+			entry.m_key.Store(key);
+			entry.m_value.Store(value);
+			wfAtomicStoreRelaxed(&entry.m_used, 1u);
+			wfAtomicStore(&m_sequence, sequence + 2);
+			return true;
+		}
+
+		void Store(const K& key, u64 hash, const V& value) {
+			while (!TryStore(key, hash, value))
+				wfCpuRelax();
+		}
+
+		void Invalidate(const K& key, u64 hash) {
+			u32 sequence = wfAtomicLoadRelaxed(&m_sequence);
+			while ((sequence & 1) || !wfAtomicCompareExchange(&m_sequence, sequence, sequence + 1)) {
+				wfCpuRelax();
+				sequence = wfAtomicLoadRelaxed(&m_sequence);
+			}
+
+			wfAtomicFenceRelease();
+			Entry &entry = m_entries[hash & (wfConcurrentMapCacheEntries - 1)];
+			if (entry.m_used && wfFunctional::wfCompare<K, K>()(entry.m_key.Load(), key) == 0)
+				wfAtomicStoreRelaxed(&entry.m_used, 0u);
+			wfAtomicStore(&m_sequence, sequence + 2);
+		}
+
+		volatile u32 m_sequence;
+		Entry        m_entries[wfConcurrentMapCacheEntries];
+	};
+
+	// no cache for anything but scalars of at most a word: anything larger
+	// cannot be loaded atomically and would be copied while a writer may be
+	// storing to it
+	template <typename K, typename V>
+	struct wfConcurrentMapCache<K, V, false> {
+		bool Find      (const K&, u64, V&)       const { return false; }
+		bool TryStore  (const K&, u64, const V&)       { return false; }
+		void Store     (const K&, u64, const V&)       { }
+		void Invalidate(const K&, u64)                 { }
+	};
+
+	template <typename K, typename V>
+	struct wfConcurrentMapShard {
+		enum {
+			kCached = wfIsScalar<K>::value && sizeof(K) <= sizeof(u64) &&
+			          wfIsScalar<V>::value && sizeof(V) <= sizeof(u64)
+		};
+
+		wfRWLock                                  m_lock;
+		wfMap<K, V>                               m_map;
+		wfConcurrentMapCache<K, V, kCached != 0>  m_cache;
+	};
+}
+
+/*
+ * Class: wfConcurrentMap
+ *  A sharded associative container of key-value pairs which is safe to use
+ *  from any number of threads at once.
+ *
+ * Parameters:
+ *  K - The key data type to be stored in the <wfConcurrentMap>.
+ *  V - The value data type to be stored in the <wfConcurrentMap>.
+ *  H - The hash function object, called as *H()(key)* returning a *u64*,
+ *      defaults to <wfFunctional::wfHash>.
+ *
+ * Remarks:
+ *  Every operation is atomic with respect to the key it touches.  There is
+ *  no iterator, <ForEach> visits the shards one at a time and so does not
+ *  see a single consistent snapshot of the whole map.
+ */
+template <typename K, typename V, typename H = wfFunctional::wfHash<K> >
+struct wfConcurrentMap {
+	/*
+	 * Constructor: wfConcurrentMap
+	 *  Constructs an empty <wfConcurrentMap>.
+	 *
+	 * Parameters:
+	 *  shards - The number of independently locked shards, rounded up to a
+	 *           power of two.  Defaults to 64, which is plenty for as many
+	 *           threads; fewer shards cost less memory when the map is small.
+	 */
+	explicit wfConcurrentMap(size_t shards = 64) :
+		m_memory(wfNullPointer),
+		m_shards(wfNullPointer),
+		m_count (1)
+	{
+		while (m_count < shards)
+			m_count <<= 1;
+
+		// every shard starts on its own cache line so that two shards never
+		// false-share their lock words
+		m_memory = g_miscHeap.Alloc(m_count * ShardSize + wfPrivate::wfConcurrentMapCacheLine);
+		m_shards = reinterpret_cast<unsigned char*>(
+			(reinterpret_cast<size_t>(m_memory) + wfPrivate::wfConcurrentMapCacheLine - 1) &
+			~static_cast<size_t>(wfPrivate::wfConcurrentMapCacheLine - 1)
+		);
+
+		for (size_t i = 0; i < m_count; i++)
+			new (m_shards + i * ShardSize) Shard;
+	}
+
+	~wfConcurrentMap() {
+		for (size_t i = 0; i < m_count; i++)
+			ShardAt(i).~Shard();
+
+		g_miscHeap.Free(m_memory);
+	}
+
+	/*
+	 * Function: Find
+	 *  Looks up the value associated with a key.
+	 *
+	 * Parameters:
+	 *  key   - The key to look up.
+	 *  value - Receives a copy of the value if the key is present.
+	 *
+	 * Returns:
+	 *  *true* if the key is present; *false* otherwise, in which case *value*
+	 *  is left untouched.
+	 */
+	bool Find(const K& key, V& value) const {
+		const u64 hash  = Hash(key);
+		Shard    &shard = ShardOf(hash);
+		if (shard.m_cache.Find(key, hash, value))
+			return true;
+
+		wfSharedLockGuard<wfRWLock> guard(shard.m_lock);
+		typename wfMap<K, V>::ConstIterator it = static_cast<const wfMap<K, V>&>(shard.m_map).Find(key);
+		if (it == shard.m_map.End())
+			return false;
+
+		value = it->second;
+		shard.m_cache.TryStore(key, hash, value);
+		return true;
+	}
+
+	/*
+	 * Function: Count
+	 *  Returns 1 if the key is present; 0 otherwise.
+	 */
+	size_t Count(const K& key) const {
+		V value;
+		return Find(key, value) ? 1 : 0;
+	}
+
+	/*
+	 * Function: Upsert
+	 *  Associates a value with a key, inserting the key if it is not present
+	 *  and replacing its value otherwise.
+	 *
+	 * Returns:
+	 *  *true* if the key was inserted; *false* if its value was replaced.
+	 */
+	bool Upsert(const K& key, const V& value) {
+		const u64 hash  = Hash(key);
+		Shard    &shard = ShardOf(hash);
+
+		wfLockGuard<wfRWLock> guard(shard.m_lock);
+		const size_t length = shard.m_map.Length();
+		shard.m_map.Insert(key, value) = value;
+		shard.m_cache.Store(key, hash, value);
+
+		return shard.m_map.Length() != length;
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes a key and its value.
+	 *
+	 * Returns:
+	 *  *true* if the key was present; *false* otherwise.
+	 */
+	bool Erase(const K& key) {
+		const u64 hash  = Hash(key);
+		Shard    &shard = ShardOf(hash);
+
+		wfLockGuard<wfRWLock> guard(shard.m_lock);
+		const size_t length = shard.m_map.Length();
+		shard.m_cache.Invalidate(key, hash);
+		shard.m_map.Erase(key);
+
+		return shard.m_map.Length() != length;
+	}
+
+	/*
+	 * Function: ForEach
+	 *  Invokes a function on every key-value pair.
+	 *
+	 * Parameters:
+	 *  function - The function object invoked as *function(key, value)*.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied to the
+	 *  elements.
+	 *
+	 * Remarks:
+	 *  Every shard is held shared while its elements are visited, the
+	 *  function must therefor not modify the map.  Pairs are visited in key
+	 *  order within a shard but in no particular order overall.
+	 */
+	template <typename F>
+	F ForEach(F function) const {
+		for (size_t i = 0; i < m_count; i++) {
+			Shard &shard = ShardAt(i);
+			wfSharedLockGuard<wfRWLock> guard(shard.m_lock);
+
+			const wfMap<K, V> &map = shard.m_map;
+			for (typename wfMap<K, V>::ConstIterator it = map.Begin(); it != map.End(); ++it)
+				function(static_cast<const K&>(it->first), static_cast<const V&>(it->second));
+		}
+		return function;
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of key-value pairs.
+	 *
+	 * Remarks:
+	 *  With other threads modifying the map the result is only a snapshot of
+	 *  a moving target.
+	 */
+	size_t Length() const {
+		size_t length = 0;
+		for (size_t i = 0; i < m_count; i++) {
+			Shard &shard = ShardAt(i);
+			wfSharedLockGuard<wfRWLock> guard(shard.m_lock);
+			length += shard.m_map.Length();
+		}
+		return length;
+	}
+
+	/*
+	 * Function: Shards
+	 *  Returns the number of shards.
+	 */
+	size_t Shards() const { return m_count; }
+
+private:
+	typedef wfPrivate::wfConcurrentMapShard<K, V> Shard;
+
+	enum {
+		ShardSize = (sizeof(Shard) + wfPrivate::wfConcurrentMapCacheLine - 1) & ~(wfPrivate::wfConcurrentMapCacheLine - 1)
+	};
+
+	static u64 Hash(const K& key) {
+		return H()(key);
+	}
+
+	// the low bits of the hash pick the cache entry, the high bits the shard
+	Shard& ShardOf(u64 hash) const { return ShardAt(static_cast<size_t>(hash >> 40) & (m_count - 1)); }
+	Shard& ShardAt(size_t index) const { return *reinterpret_cast<Shard*>(m_shards + index * ShardSize); }
+
+	void          *m_memory;
+	unsigned char *m_shards;
+	size_t         m_count;
+
+	wfConcurrentMap(const wfConcurrentMap&);
+	wfConcurrentMap& operator=(const wfConcurrentMap&);
+};
+
+#endif
@@ -0,0 +1,416 @@
+#ifndef WF_STDLIB_DEQUE_HDR
+#define WF_STDLIB_DEQUE_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+#include "wfIterator.h"
+
+/*
+ * File: wfDeque
+ *  A double-ended queue stored in one ring buffer.
+ *
+ * >#include "wfDeque.h"
+ *
+ *  The elements live in a single array whose capacity is a power of two,
+ *  the queue starts at some position in it and wraps around the end.  An
+ *  index is mapped into the array with a mask, pushing and popping at
+ *  either end is a store and an increment or decrement of the head or the
+ *  length.  The array only grows when it is full, a queue which stays at
+ *  about the same length does not allocate at all.
+ *
+ *  Growing moves every element, addresses of elements are only valid until
+ *  the next push.  Use <wfStackList> or <wfSmallList> where references must
+ *  stay stable.
+ */
+
+template <typename T>
+struct wfDeque;
+
+/*
+ * Class: wfDequeIterator
+ *  A random-access iterator over a <wfDeque>.
+ *
+ * Parameters:
+ *  T - The element data type.
+ *  U - *T* for a mutable iterator, *const T* for a constant one.
+ */
+template <typename T, typename U>
+struct wfDequeIterator {
+	typedef ptrdiff_t                            DifferenceType;
+	typedef T                                    ValueType;
+	typedef U*                                   Pointer;
+	typedef U&                                   Reference;
+	typedef wfPrivate::wfRandomAccessIteratorTag IteratorCategory;
+
+	wfDequeIterator() :
+		m_data    (wfNullPointer),
+		m_mask    (0),
+		m_position(0)
+	{ }
+
+	// mutable iterators convert to constant ones
+	wfDequeIterator(const wfDequeIterator<T, T>& other) :
+		m_data    (other.m_data),
+		m_mask    (other.m_mask),
+		m_position(other.m_position)
+	{ }
+
+	Reference operator *  () const { return  m_data[m_position & m_mask]; }
+	Pointer   operator -> () const { return &m_data[m_position & m_mask]; }
+	Reference operator [] (DifferenceType n) const { return m_data[(m_position + n) & m_mask]; }
+
+	wfDequeIterator& operator ++ ()    { m_position ++; return *this; }
+	wfDequeIterator& operator -- ()    { m_position --; return *this; }
+	wfDequeIterator  operator ++ (int) { wfDequeIterator it(*this); m_position ++; return it; }
+	wfDequeIterator  operator -- (int) { wfDequeIterator it(*this); m_position --; return it; }
+
+	wfDequeIterator& operator += (DifferenceType n) { m_position += n; return *this; }
+	wfDequeIterator& operator -= (DifferenceType n) { m_position -= n; return *this; }
+
+	wfDequeIterator operator + (DifferenceType n) const { wfDequeIterator it(*this); return it += n; }
+	wfDequeIterator operator - (DifferenceType n) const { wfDequeIterator it(*this); return it -= n; }
+
+	DifferenceType operator - (const wfDequeIterator& other) const {
+		return static_cast<DifferenceType>(m_position - other.m_position);
+	}
+
+	bool operator == (const wfDequeIterator& other) const { return m_position == other.m_position; }
+	bool operator != (const wfDequeIterator& other) const { return m_position != other.m_position; }
+	bool operator <  (const wfDequeIterator& other) const { return m_position <  other.m_position; }
+	bool operator >  (const wfDequeIterator& other) const { return m_position >  other.m_position; }
+	bool operator <= (const wfDequeIterator& other) const { return m_position <= other.m_position; }
+	bool operator >= (const wfDequeIterator& other) const { return m_position >= other.m_position; }
+
+private:
+	template <typename> friend struct wfDeque;
+	template <typename, typename> friend struct wfDequeIterator;
+
+	wfDequeIterator(T *data, size_t mask, size_t position) :
+		m_data    (data),
+		m_mask    (mask),
+		m_position(position)
+	{ }
+
+	// the position is the head plus the index, unmasked, so that iterators
+	// on either side of the wrap around compare in queue order
+	T      *m_data;
+	size_t  m_mask;
+	size_t  m_position;
+};
+
+/*
+ * Class: wfDeque
+ *  A double-ended queue with O(1) push and pop at both ends and O(1)
+ *  random access.
+ *
+ * Parameters:
+ *  T - The element data type to be stored in the <wfDeque>.
+ */
+template <typename T>
+struct wfDeque {
+	/*
+	 * Type: Iterator
+	 *  A type that provides a random-access iterator over the elements.
+	 */
+	typedef wfDequeIterator<T, T>       Iterator;
+
+	/*
+	 * Type: ConstIterator
+	 *  A type that provides a random-access iterator over *const* elements.
+	 */
+	typedef wfDequeIterator<T, const T> ConstIterator;
+
+	explicit wfDeque(wfHeap *heap = &g_miscHeap) :
+		m_heap    (heap),
+		m_data    (wfNullPointer),
+		m_capacity(0),
+		m_head    (0),
+		m_length  (0)
+	{ }
+
+	~wfDeque() {
+		Clear();
+		m_heap->Free(m_data);
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of elements in the queue.
+	 */
+	size_t Length  () const { return m_length;      }
+
+	/*
+	 * Function: Capacity
+	 *  Returns the number of elements the queue holds before it grows.
+	 */
+	size_t Capacity() const { return m_capacity;    }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the queue is empty.
+	 */
+	bool   Empty   () const { return m_length == 0; }
+
+	/*
+	 * Function: operator[]
+	 *  Returns the element at an index counted from the front.  There exists
+	 *  a const cv-qualified version of this function as well.
+	 */
+	T&       operator [] (size_t index)       { return m_data[Slot(index)]; }
+	const T& operator [] (size_t index) const { return m_data[Slot(index)]; }
+
+	/*
+	 * Function: Front
+	 *  Returns the first element.  There exists a const cv-qualified version
+	 *  of this function as well.
+	 */
+	T&       Front()       { return m_data[m_head]; }
+	const T& Front() const { return m_data[m_head]; }
+
+	/*
+	 * Function: Back
+	 *  Returns the last element.  There exists a const cv-qualified version
+	 *  of this function as well.
+	 */
+	T&       Back()       { return m_data[Slot(m_length - 1)]; }
+	const T& Back() const { return m_data[Slot(m_length - 1)]; }
+
+	/*
+	 * Function: Begin
+	 *  Returns an iterator to the first element.  There exists a const
+	 *  cv-qualified version of this function as well.
+	 */
+	Iterator      Begin()       { return Iterator     (m_data, Mask(), m_head); }
+	ConstIterator Begin() const { return ConstIterator(m_data, Mask(), m_head); }
+
+	/*
+	 * Function: End
+	 *  Returns an iterator to the location succeeding the last element.
+	 *  There exists a const cv-qualified version of this function as well.
+	 */
+	Iterator      End()       { return Iterator     (m_data, Mask(), m_head + m_length); }
+	ConstIterator End() const { return ConstIterator(m_data, Mask(), m_head + m_length); }
+
+	/*
+	 * Function: PushBack
+	 *  Appends a copy of an element.
+	 */
+	void PushBack(const T& value) {
+		if (m_length == m_capacity) {
+			// the value may be an element of the queue, which growing frees
+			const T copy(value);
+			Grow(m_length + 1);
+			return PushBack(copy);
+		}
+		new (&m_data[Slot(m_length)]) T(value);
+		m_length ++;
+	}
+
+	/*
+	 * Function: PushFront
+	 *  Prepends a copy of an element.
+	 */
+	void PushFront(const T& value) {
+		if (m_length == m_capacity) {
+			const T copy(value);
+			Grow(m_length + 1);
+			return PushFront(copy);
+		}
+		const size_t head = (m_head - 1) & Mask();
+		new (&m_data[head]) T(value);
+		m_head = head;
+		m_length ++;
+	}
+
+	/*
+	 * Function: PopBack
+	 *  Removes the last element.
+	 */
+	void PopBack() {
+		m_length --;
+		m_data[Slot(m_length)].~T();
+	}
+
+	/*
+	 * Function: PopFront
+	 *  Removes the first element.
+	 */
+	void PopFront() {
+		m_data[m_head].~T();
+		m_head = (m_head + 1) & Mask();
+		m_length --;
+	}
+
+	/*
+	 * Function: PushBack
+	 *  Appends copies of a run of elements, in order.
+	 *
+	 * Parameters:
+	 *  values - The elements to copy.
+	 *  count  - The number of elements.
+	 *
+	 * Remarks:
+	 *  The buffer grows at most once and the elements are copied in at most
+	 *  two contiguous runs, one up to the end of the buffer and one from its
+	 *  start.  The elements may be ones of the queue itself.
+	 */
+	void PushBack(const T *values, size_t count) {
+		if (m_length + count > m_capacity)
+			return Grow(m_length + count, values, count, false);
+
+		const size_t start = Slot(m_length);
+		const size_t first = Run(start, count);
+		Construct(m_data + start, values, first);
+		Construct(m_data, values + first, count - first);
+		m_length += count;
+	}
+
+	/*
+	 * Function: PushFront
+	 *  Prepends copies of a run of elements, which end up at the front in
+	 *  the order given.
+	 *
+	 * Parameters:
+	 *  values - The elements to copy.
+	 *  count  - The number of elements.
+	 *
+	 * Remarks:
+	 *  As for <PushBack>, the elements may be ones of the queue itself.
+	 */
+	void PushFront(const T *values, size_t count) {
+		if (m_length + count > m_capacity)
+			return Grow(m_length + count, values, count, true);
+
+		const size_t head  = (m_head - count) & Mask();
+		const size_t first = Run(head, count);
+		Construct(m_data + head, values, first);
+		Construct(m_data, values + first, count - first);
+		m_head    = head;
+		m_length += count;
+	}
+
+	/*
+	 * Function: CopyOut
+	 *  Copies a run of elements out of the queue, the queue is unchanged.
+	 *
+	 * Parameters:
+	 *  index  - The index of the first element to copy, counted from the
+	 *           front.
+	 *  values - Receives the elements, which must already be constructed.
+	 *  count  - The number of elements to copy.
+	 *
+	 * Returns:
+	 *  The number of elements copied, fewer than *count* when the queue
+	 *  ends first.
+	 */
+	size_t CopyOut(size_t index, T *values, size_t count) const {
+		if (index >= m_length)
+			return 0;
+		if (count > m_length - index)
+			count = m_length - index;
+
+		const size_t start = Slot(index);
+		const size_t first = Run(start, count);
+		Assign(values,         m_data + start, first);
+		Assign(values + first, m_data,         count - first);
+		return count;
+	}
+
+	/*
+	 * Function: PopFront
+	 *  Moves a run of elements from the front of the queue out.
+	 *
+	 * Parameters:
+	 *  values - Receives the elements, which must already be constructed.
+	 *  count  - The most elements to remove.
+	 *
+	 * Returns:
+	 *  The number of elements removed.
+	 */
+	size_t PopFront(T *values, size_t count) {
+		count = CopyOut(0, values, count);
+		for (size_t i = 0; i < count; i++)
+			PopFront();
+		return count;
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every element, the buffer is kept.
+	 */
+	void Clear() {
+		while (m_length)
+			PopBack();
+		m_head = 0;
+	}
+
+	/*
+	 * Function: Reserve
+	 *  Makes room for at least a number of elements.
+	 */
+	void Reserve(size_t capacity) {
+		if (capacity > m_capacity)
+			Grow(capacity);
+	}
+
+private:
+	enum { kMinimumCapacity = 16 };
+
+	size_t Mask() const { return m_capacity - 1; }
+
+	size_t Slot(size_t index) const { return (m_head + index) & Mask(); }
+
+	// how many of count elements starting at slot fit before the wrap
+	size_t Run(size_t slot, size_t count) const {
+		return count < m_capacity - slot ? count : m_capacity - slot;
+	}
+
+	static void Construct(T *to, const T *from, size_t count) {
+		for (size_t i = 0; i < count; i++)
+			new (&to[i]) T(from[i]);
+	}
+
+	static void Assign(T *to, const T *from, size_t count) {
+		for (size_t i = 0; i < count; i++)
+			to[i] = from[i];
+	}
+
+	// reallocates to the next power of two holding at least count elements,
+	// unwrapping the queue to start at the beginning of the new buffer
+	void Grow(size_t count) {
+		Grow(count, wfNullPointer, 0, false);
+	}
+
+	// as above, pushing a run of values to the front or the back on the way,
+	// they are copied before the old buffer is freed so they may be elements
+	// of the queue
+	void Grow(size_t count, const T *values, size_t pushed, bool front) {
+		size_t capacity = m_capacity ? m_capacity : static_cast<size_t>(kMinimumCapacity);
+		while (capacity < count)
+			capacity *= 2;
+
+		T *data = static_cast<T*>(m_heap->Alloc(capacity * sizeof(T)));
+		Construct(data + (front ? 0 : m_length), values, pushed);
+		for (size_t i = 0; i < m_length; i++) {
+			T& value = m_data[Slot(i)];
+			new (&data[(front ? pushed : 0) + i]) T(value);
+			value.~T();
+		}
+		m_heap->Free(m_data);
+
+		m_data     = data;
+		m_capacity = capacity;
+		m_head     = 0;
+		m_length  += pushed;
+	}
+
+	wfHeap *m_heap;
+	T      *m_data;
+	size_t  m_capacity; // zero or a power of two
+	size_t  m_head;
+	size_t  m_length;
+
+	wfDeque(const wfDeque&);
+	wfDeque& operator=(const wfDeque&);
+};
+
+#endif
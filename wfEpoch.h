@@ -0,0 +1,297 @@
+#ifndef WF_STDLIB_EPOCH_HDR
+#define WF_STDLIB_EPOCH_HDR
+#include <new>
+#include "wfThread.h"
+
+/*
+ * File: wfEpoch
+ *  Epoch-based reclamation: deferred freeing of objects that concurrent
+ *  readers may still be looking at.
+ *
+ * >#include "wfEpoch.h"
+ *
+ *  A <wfEpochDomain> keeps a global epoch counter.  Every reading thread
+ *  joins the domain once to get a <wfEpochParticipant>, and brackets each
+ *  access to shared objects with <wfEpochParticipant::Enter> and
+ *  <wfEpochParticipant::Exit> (or a <wfEpochGuard>).  A writer that
+ *  unlinks an object hands it to <wfEpochDomain::Retire> instead of
+ *  freeing it, the object is destroyed once every reader that could have
+ *  seen it has exited, which is known to be the case two epochs later.
+ *
+ *  Entering and exiting are a store to a record private to the thread and
+ *  a fence, readers never perform a read-modify-write on shared memory and
+ *  never wait for writers.  The epoch only advances when every thread that
+ *  is inside has observed the current one, a reader that stays inside
+ *  forever therefor delays reclamation forever (but never blocks writers).
+ */
+
+namespace wfPrivate {
+	struct wfEpochRetired {
+		void           *m_object;
+		void          (*m_destroy)(void *object);
+		u64             m_epoch;
+		wfEpochRetired *m_next;
+	};
+}
+
+struct wfEpochDomain;
+
+/*
+ * Class: wfEpochParticipant
+ *  The record of one reading thread in a <wfEpochDomain>.
+ *
+ * Remarks:
+ *  Obtained with <wfEpochDomain::Join> and given back with
+ *  <wfEpochDomain::Leave>.  A participant must only be used by one thread
+ *  at a time.  Records are padded to a cache line so that readers do not
+ *  false-share them.
+ */
+struct wfEpochParticipant {
+	/*
+	 * Function: Enter
+	 *  Marks the start of an access to objects protected by the domain.
+	 *
+	 * Remarks:
+	 *  Objects reached after *Enter* stay valid until <Exit>.  Calls do not
+	 *  nest, use a single *Enter* and *Exit* around the outermost access.
+	 */
+	inline void Enter();
+
+	/*
+	 * Function: Exit
+	 *  Marks the end of an access started with <Enter>.
+	 */
+	void Exit() {
+		wfAtomicStore(&m_state, static_cast<u64>(0));
+	}
+
+private:
+	friend struct wfEpochDomain;
+
+	wfEpochParticipant(wfEpochDomain *domain) :
+		m_state (0),
+		m_inUse (1),
+		m_next  (wfNullPointer),
+		m_domain(domain)
+	{ }
+
+	// the epoch observed on entry shifted up by one, the low bit set while inside
+	volatile u64        m_state;
+	volatile u32        m_inUse;
+	wfEpochParticipant *m_next;
+	wfEpochDomain      *m_domain;
+	unsigned char       m_padding[64];
+};
+
+/*
+ * Class: wfEpochDomain
+ *  A set of participants sharing one epoch and one list of retired objects.
+ */
+struct wfEpochDomain {
+	wfEpochDomain() :
+		m_epoch       (0),
+		m_participants(wfNullPointer),
+		m_retired     (wfNullPointer),
+		m_pending     (0)
+	{ }
+
+	/*
+	 * Destructor: wfEpochDomain
+	 *  Destroys every retired object and frees the participant records.
+	 *
+	 * Remarks:
+	 *  No thread may be inside the domain any more.
+	 */
+	~wfEpochDomain() {
+		Reclaim(~static_cast<u64>(0));
+
+		wfEpochParticipant *participant = m_participants;
+		while (participant) {
+			wfEpochParticipant *next = participant->m_next;
+			participant->~wfEpochParticipant();
+			g_miscHeap.Free(participant);
+			participant = next;
+		}
+	}
+
+	/*
+	 * Function: Join
+	 *  Adds the calling thread to the domain.
+	 *
+	 * Returns:
+	 *  The participant record to <wfEpochParticipant::Enter> and
+	 *  <wfEpochParticipant::Exit> with, records given back with <Leave> are
+	 *  reused.
+	 */
+	wfEpochParticipant *Join() {
+		for (wfEpochParticipant *participant = wfAtomicLoad(&m_participants); participant; participant = participant->m_next) {
+			u32 unused = 0;
+			if (wfAtomicLoadRelaxed(&participant->m_inUse) == 0 && wfAtomicCompareExchange(&participant->m_inUse, unused, 1u))
+				return participant;
+		}
+
+		wfEpochParticipant *participant = new (g_miscHeap.Alloc(sizeof(wfEpochParticipant))) wfEpochParticipant(this);
+		wfEpochParticipant *head        = wfAtomicLoadRelaxed(&m_participants);
+		do {
+			participant->m_next = head;
+		} while (!wfAtomicCompareExchange(&m_participants, head, participant));
+
+		return participant;
+	}
+
+	/*
+	 * Function: Leave
+	 *  Removes a thread from the domain, the record may be reused by another
+	 *  thread afterwards.
+	 */
+	void Leave(wfEpochParticipant *participant) {
+		participant->Exit();
+		wfAtomicStore(&participant->m_inUse, 0u);
+	}
+
+	/*
+	 * Function: Retire
+	 *  Schedules an object to be destroyed once no reader can reach it.
+	 *
+	 * Parameters:
+	 *  object  - The object, already unreachable for readers entering from
+	 *            now on.
+	 *  destroy - The function that destroys the object, called with *object*
+	 *            from whichever thread reclaims it.
+	 *
+	 * Remarks:
+	 *  Every call also attempts to advance the epoch once and reclaim what can
+	 *  be reclaimed.
+	 */
+	void Retire(void *object, void (*destroy)(void *object)) {
+		wfPrivate::wfEpochRetired *retired = reinterpret_cast<wfPrivate::wfEpochRetired*>(
+			g_miscHeap.Alloc(sizeof(wfPrivate::wfEpochRetired))
+		);
+
+		retired->m_object  = object;
+		retired->m_destroy = destroy;
+		{
+			wfLockGuard<wfSpinLock> guard(m_lock);
+			retired->m_epoch = wfAtomicLoad(&m_epoch);
+			retired->m_next  = m_retired;
+			m_retired        = retired;
+			m_pending ++;
+		}
+
+		TryAdvance();
+		Reclaim(wfAtomicLoad(&m_epoch));
+	}
+
+	/*
+	 * Function: Collect
+	 *  Advances the epoch as far as the threads inside the domain allow, up to
+	 *  two epochs, then destroys every retired object that is two or more
+	 *  epochs old.
+	 *
+	 * Returns:
+	 *  The number of objects still waiting to be destroyed.
+	 *
+	 * Remarks:
+	 *  Once no thread is inside the domain a single call destroys every object
+	 *  retired so far.
+	 */
+	size_t Collect() {
+		if (TryAdvance())
+			TryAdvance();
+		return Reclaim(wfAtomicLoad(&m_epoch));
+	}
+
+	/*
+	 * Function: Epoch
+	 *  Returns the current global epoch.
+	 */
+	u64 Epoch() const { return wfAtomicLoad(&m_epoch); }
+
+private:
+	friend struct wfEpochParticipant;
+
+	bool TryAdvance() {
+		u64 epoch = wfAtomicLoad(&m_epoch);
+
+		// pairs with the fence in Enter: either the participant sees this
+		// epoch (or a later one) or this sees the participant inside
+		wfAtomicFence();
+		for (wfEpochParticipant *participant = wfAtomicLoad(&m_participants); participant; participant = participant->m_next) {
+			const u64 state = wfAtomicLoad(&participant->m_state);
+			if ((state & 1) && (state >> 1) != epoch)
+				return false;
+		}
+
+		return wfAtomicCompareExchange(&m_epoch, epoch, epoch + 1);
+	}
+
+	size_t Reclaim(u64 epoch) {
+		wfPrivate::wfEpochRetired *reclaim = wfNullPointer;
+		size_t                     pending = 0;
+		{
+			wfLockGuard<wfSpinLock> guard(m_lock);
+			wfPrivate::wfEpochRetired **link = &m_retired;
+			while (*link) {
+				wfPrivate::wfEpochRetired *retired = *link;
+				if (epoch == ~static_cast<u64>(0) || retired->m_epoch + 2 <= epoch) {
+					*link            = retired->m_next;
+					retired->m_next  = reclaim;
+					reclaim          = retired;
+					m_pending --;
+				} else {
+					link = &retired->m_next;
+				}
+			}
+			pending = m_pending;
+		}
+
+		// destroyed outside of the lock, destroy functions may retire more
+		while (reclaim) {
+			wfPrivate::wfEpochRetired *next = reclaim->m_next;
+			reclaim->m_destroy(reclaim->m_object);
+			g_miscHeap.Free(reclaim);
+			reclaim = next;
+		}
+
+		return pending;
+	}
+
+	volatile u64                m_epoch;
+	wfEpochParticipant *volatile m_participants;
+	wfSpinLock                  m_lock;
+	wfPrivate::wfEpochRetired  *m_retired;
+	size_t                      m_pending;
+
+	wfEpochDomain(const wfEpochDomain&);
+	wfEpochDomain& operator=(const wfEpochDomain&);
+};
+
+inline void wfEpochParticipant::Enter() {
+	const u64 epoch = wfAtomicLoad(&m_domain->m_epoch);
+	wfAtomicStoreRelaxed(&m_state, (epoch << 1) | 1);
+	wfAtomicFence();
+}
+
+/*
+ * Class: wfEpochGuard
+ *  Enters a <wfEpochParticipant> for the lifetime of the guard.
+ */
+struct wfEpochGuard {
+	explicit wfEpochGuard(wfEpochParticipant *participant) :
+		m_participant(participant)
+	{
+		m_participant->Enter();
+	}
+
+	~wfEpochGuard() {
+		m_participant->Exit();
+	}
+
+private:
+	wfEpochParticipant *m_participant;
+
+	wfEpochGuard(const wfEpochGuard&);
+	wfEpochGuard& operator=(const wfEpochGuard&);
+};
+
+#endif
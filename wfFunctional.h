@@ -101,6 +101,22 @@ namespace wfPrivate {
 		static bool Execute(const T& lhs, const U& rhs) { return (lhs <= rhs); }
 	};
 
+	// <=> Functor (three-way, one comparison for C strings)
+	template <bool>
+	struct wfFunctionalCompare {
+		template <typename U, typename V>
+		static int Execute(U lhs, V rhs) {
+			return (lhs < rhs) ? -1 : ((rhs < lhs) ? 1 : 0);
+		}
+		static int Execute(const char *lhs, const char *rhs) {
+			return (!lhs || !rhs) ? ((lhs < rhs) ? -1 : ((rhs < lhs) ? 1 : 0)) : strcmp(lhs, rhs);
+		}
+	};
+	template <> struct wfFunctionalCompare<true> {
+		template <typename T, typename U>
+		static int Execute(const T& lhs, const U& rhs) { return (lhs < rhs) ? -1 : ((rhs < lhs) ? 1 : 0); }
+	};
+
 
 	template <typename T, typename U, typename V>
 	struct wfBinaryFunction {
@@ -252,5 +268,187 @@ namespace wfFunctional {
 			>::Execute(lhs, rhs);
 		}
 	};
+
+	/*
+	 * Struct: wfCompare
+	 *  A three-way comparison between a value of a specified type and
+	 *  another value of another type.
+	 *
+	 * Parameters:
+	 *  lhs - The left operand of type *T* in the comparison.
+	 *  rhs - The right operand of type *U* in the comparison.
+	 *
+	 * Returns:
+	 *  A negative value if *lhs < rhs*, a positive value if *rhs < lhs*
+	 *  and zero if neither is ordered before the other.
+	 *
+	 * Remarks:
+	 *  The ordered containers (<wfSet>, <wfMap>) use <wfCompare> once per
+	 *  tree level instead of an equality test followed by a less-than
+	 *  test; for C strings this is a single *strcmp*.
+	 *
+	 *  *T* and *U* need not be the same type, this is what allows the
+	 *  containers to be searched with a key of a different type than the
+	 *  one stored (for instance a <wfStringRef> against *const char**
+	 *  keys) without constructing a temporary key.  Any pair of types
+	 *  for which *operator <* is defined both ways works, otherwise
+	 *  <wfCompare> may be specialized for the pair of types.
+	 */
+	template <typename T, typename U> struct wfCompare;
+	template <typename T, typename U>
+	struct wfCompare : wfPrivate::wfBinaryFunction<T, U, int> {
+		int operator()(const T& lhs, const U& rhs) const {
+			return wfPrivate::wfFunctionalCompare <
+				!wfIsPOD<T>::value &&
+				!wfIsPOD<U>::value
+			>::Execute(lhs, rhs);
+		}
+	};
+
+	/*
+	 * Struct: wfTransparentKey
+	 *  Opts a type in as a key the ordered containers search with as it
+	 *  is, ordered against the stored keys with <wfCompare>.
+	 *
+	 * Parameters:
+	 *  T - The type of the key searched with.
+	 *
+	 * Remarks:
+	 *  A key of any other type is converted to the key type of the
+	 *  container once per lookup, like an argument declared with the key
+	 *  type would be, so that for instance an unsigned key finds the
+	 *  elements of a set of *int*.  <wfStringRef> is opted in, other
+	 *  borrowed key types may specialize <wfTransparentKey> as a
+	 *  *wfPrivate::wfCompileTrue*.
+	 */
+	template <typename T>
+	struct wfTransparentKey : wfPrivate::wfCompileFalse { };
+}
+
+namespace wfPrivate {
+	//
+	// How a lookup hands a key of type U to the comparisons of a container
+	// keyed by K: as it is when it already is a K or is opted in with
+	// wfFunctional::wfTransparentKey, otherwise converted to K once, just
+	// like an argument declared as K would have been.
+	//
+	template <typename U, typename K, bool = wfIsSameType<U, K>::value || wfFunctional::wfTransparentKey<U>::value>
+	struct wfLookupKey {
+		typedef K Type;
+	};
+
+	template <typename U, typename K>
+	struct wfLookupKey<U, K, true> {
+		typedef const U& Type;
+	};
+}
+
+/*
+ * Class: wfStringRef
+ *  A borrowed, non-owning view of a sequence of characters given as a
+ *  pointer and a length.
+ *
+ * Remarks:
+ *  The characters need not be null terminated.  <wfStringRef> is ordered
+ *  against other <wfStringRef>s and against *const char** exactly like
+ *  *strcmp* orders C strings, which makes it usable as a lookup key for
+ *  containers whose keys are C strings (or any string type providing
+ *  the same ordering) without copying the characters into a temporary
+ *  key first.
+ */
+struct wfStringRef {
+	wfStringRef() :
+		m_data  (""),
+		m_length(0)
+	{ }
+
+	wfStringRef(const char *data) :
+		m_data  (data),
+		m_length(data ? strlen(data) : 0)
+	{ }
+
+	wfStringRef(const char *data, size_t length) :
+		m_data  (data),
+		m_length(length)
+	{ }
+
+	/*
+	 * Function: Data
+	 *  Returns the address of the first character of the view.
+	 */
+	const char *Data()   const { return m_data;   }
+
+	/*
+	 * Function: Length
+	 *  Returns the number of characters in the view.
+	 */
+	size_t      Length() const { return m_length; }
+
+	/*
+	 * Function: Compare
+	 *  Three-way comparison against another range of characters.
+	 *
+	 * Returns:
+	 *  A negative value, zero or a positive value if this view orders
+	 *  before, equal to or after *data*.
+	 */
+	int Compare(const char *data, size_t length) const {
+		const int result = memcmp(m_data, data, (m_length < length) ? m_length : length);
+		if (result)
+			return result;
+		return (m_length < length) ? -1 : ((length < m_length) ? 1 : 0);
+	}
+
+	int Compare(const wfStringRef& ref) const {
+		return Compare(ref.m_data, ref.m_length);
+	}
+
+	//
+	// comparing against a C string stops at whichever runs out first, which
+	// avoids a strlen of the (possibly very long) stored key.
+	//
+	int Compare(const char *string) const {
+		size_t i = 0;
+		for (; i < m_length; i++) {
+			const unsigned char a = static_cast<unsigned char>(m_data[i]);
+			const unsigned char b = static_cast<unsigned char>(string[i]);
+			if (a != b)
+				return (int)a - (int)b;
+			if (!b)
+				return 1;
+		}
+		return string[i] ? -1 : 0;
+	}
+
+	friend bool operator <  (const wfStringRef& lhs, const wfStringRef& rhs) { return lhs.Compare(rhs)   <  0; }
+	friend bool operator == (const wfStringRef& lhs, const wfStringRef& rhs) { return lhs.Compare(rhs)   == 0; }
+	friend bool operator <  (const wfStringRef& lhs, const char        *rhs) { return lhs.Compare(rhs)   <  0; }
+	friend bool operator <  (const char        *lhs, const wfStringRef& rhs) { return rhs.Compare(lhs)   >  0; }
+	friend bool operator == (const wfStringRef& lhs, const char        *rhs) { return lhs.Compare(rhs)   == 0; }
+	friend bool operator == (const char        *lhs, const wfStringRef& rhs) { return rhs.Compare(lhs)   == 0; }
+
+private:
+	const char *m_data;
+	size_t      m_length;
+};
+
+//
+// A single pass for every mixed C string comparison instead of the two
+// operator < the generic three-way functor would evaluate.
+//
+namespace wfFunctional {
+	template <> struct wfCompare<wfStringRef, wfStringRef> : wfPrivate::wfBinaryFunction<wfStringRef, wfStringRef, int> {
+		int operator()(const wfStringRef& lhs, const wfStringRef& rhs) const { return  lhs.Compare(rhs); }
+	};
+	template <> struct wfCompare<wfStringRef, const char*> : wfPrivate::wfBinaryFunction<wfStringRef, const char*, int> {
+		int operator()(const wfStringRef& lhs, const char *rhs)        const { return  lhs.Compare(rhs); }
+	};
+	template <> struct wfCompare<const char*, wfStringRef> : wfPrivate::wfBinaryFunction<const char*, wfStringRef, int> {
+		int operator()(const char *lhs, const wfStringRef& rhs)        const { return -rhs.Compare(lhs); }
+	};
+
+	// searched with as it is, without copying the characters into a key
+	template <> struct wfTransparentKey<wfStringRef> : wfPrivate::wfCompileTrue { };
 }
+
 #endif
@@ -0,0 +1,544 @@
+#ifndef WF_STDLIB_HASH_HDR
+#define WF_STDLIB_HASH_HDR
+#include "wfFunctional.h"
+#include "wfPair.h"
+#include "wfSystemInfo.h"
+
+/*
+ * File: wfHash
+ *  Fast non-cryptographic hashing and the <wfFunctional::wfHash> trait.
+ *
+ * >#include "wfHash.h"
+ *
+ *  <wfHashBytes> hashes a run of bytes into 64 bits.  Up to 256 bytes it
+ *  folds 128-bit products of the input with constants the way wyhash
+ *  does, longer inputs are striped over eight 64-bit accumulators the way
+ *  XXH3 does, which maps directly onto SIMD multiplies.  The long path uses
+ *  AVX2 when <wfCPUHasAVX2> reports it at runtime, SSE2 when the target
+ *  has it and plain C otherwise, all three produce the same value.
+ *
+ *  <wfFunctional::wfHash> is the hash function object the hashed
+ *  containers default to.  It has specializations for the integral,
+ *  floating point and pointer types, C strings, <wfStringRef> and
+ *  <wfPair>; specialize it for other key types.
+ *
+ *  Every hash takes an optional seed.  Hashed containers exposed to keys
+ *  an attacker chooses (network input, file names and the like) should use
+ *  <wfFunctional::wfSeededHash>, which seeds with a value picked at random
+ *  per process, so that colliding keys cannot be computed ahead of time.
+ *
+ *  Hash values are not stable across byte orders or between versions of
+ *  this file, do not store them.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define WF_STDLIB_HASH_SSE2
+#   include <emmintrin.h>
+#   if defined(_MSC_VER) && _MSC_VER >= 1700
+#       define WF_STDLIB_HASH_AVX2
+#       define WF_STDLIB_HASH_TARGET_AVX2
+#       include <immintrin.h>
+#   elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+        // compiled for AVX2 on its own, called only when the CPU has it
+#       define WF_STDLIB_HASH_AVX2
+#       define WF_STDLIB_HASH_TARGET_AVX2 __attribute__((target("avx2")))
+#       include <immintrin.h>
+#   endif
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#   include <intrin.h>
+#   pragma intrinsic(_umul128)
+#endif
+
+#include <time.h>
+#if defined(_WIN32)
+#   include <ntsecapi.h> // RtlGenRandom, windows.h comes with wfSystemInfo.h
+#   if defined(_MSC_VER)
+#       pragma comment(lib, "advapi32.lib")
+#   endif
+#endif
+
+namespace wfPrivate {
+	enum {
+		wfHashShortLength = 16,
+		wfHashLongLength  = 256,
+		wfHashStripe      = 64,
+		wfHashBlock       = 8   // stripes between scrambles
+	};
+
+	static const u64 wfHashP0 = 0xA0761D6478BD642FULL;
+	static const u64 wfHashP1 = 0xE7037ED1A0B428DBULL;
+	static const u64 wfHashP2 = 0x8EBC6AF09C88C6E3ULL;
+	static const u64 wfHashP3 = 0x589965CC75374CC3ULL;
+	static const u32 wfHashScramblePrime = 0x9E3779B1u;
+
+	//
+	// Sixteen words of key material for the long path: stripe *n* of a
+	// block is keyed by words *n* to *n + 7*, the scramble by words 8 to 15.
+	//
+	inline const u64 *wfHashSecret() {
+		static const u64 secret[16] = {
+			0xB300F6B4DFB933B5ULL, 0x06B4008749DF1597ULL, 0xECDB5766C406A143ULL, 0x98A5C4F943D61CDAULL,
+			0xB9B143F8D1E75F31ULL, 0x57D49702A60662D6ULL, 0x949C305AA91B8434ULL, 0x13DEE080EC42286BULL,
+			0x7E7E5FD7EC7F585CULL, 0x735FCD5A7AF91923ULL, 0x0417F693011761B6ULL, 0xBE54928886DFD246ULL,
+			0xC530E7CBCBA12070ULL, 0xFC4212BE6EE912C5ULL, 0x42D12AE9E06F17E9ULL, 0x1F04B2375301CFE0ULL
+		};
+		return secret;
+	}
+
+	inline u64 wfHashRead64(const unsigned char *data) { u64 value; memcpy(&value, data, sizeof(value)); return value; }
+	inline u64 wfHashRead32(const unsigned char *data) { u32 value; memcpy(&value, data, sizeof(value)); return value; }
+
+	// replaces *a* and *b* with the low and high halves of their product
+	inline void wfHashMultiply(u64 &a, u64 &b) {
+#if defined(__SIZEOF_INT128__)
+		const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		a = static_cast<u64>(product);
+		b = static_cast<u64>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		a = _umul128(a, b, &b);
+#else
+		const u64 aLow  = a & 0xFFFFFFFFu, aHigh = a >> 32;
+		const u64 bLow  = b & 0xFFFFFFFFu, bHigh = b >> 32;
+		const u64 ll    = aLow  * bLow;
+		const u64 lh    = aLow  * bHigh;
+		const u64 hl    = aHigh * bLow;
+		const u64 hh    = aHigh * bHigh;
+		const u64 cross = (ll >> 32) + (lh & 0xFFFFFFFFu) + hl;
+		const u64 low   = (cross << 32) | (ll & 0xFFFFFFFFu);
+		const u64 high  = hh + (lh >> 32) + (cross >> 32);
+		a = low;
+		b = high;
+#endif
+	}
+
+	// the two halves of the product folded together
+	inline u64 wfHashFold(u64 a, u64 b) {
+		wfHashMultiply(a, b);
+		return a ^ b;
+	}
+
+	// the 64-bit murmur3 finalizer, a bijection
+	inline u64 wfHashMix(u64 hash) {
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	//
+	// The long path.  Every 64 byte stripe adds, per 64-bit lane, the
+	// product of the low and high halves of the keyed input to its own
+	// accumulator and the plain input to its neighbour; every block the
+	// accumulators are scrambled so that the products keep their high
+	// bits.  The last stripe is read from the end of the input, overlapping
+	// the one before it.
+	//
+	inline void wfHashLongScalar(u64 *acc, const unsigned char *data, size_t length, const u64 *secret) {
+		const size_t blocks  = (length - 1) / (wfHashStripe * wfHashBlock);
+		const size_t stripes = ((length - 1) - blocks * wfHashStripe * wfHashBlock) / wfHashStripe;
+
+		for (size_t block = 0; block <= blocks; block++) {
+			const size_t count = block == blocks ? stripes : static_cast<size_t>(wfHashBlock);
+			for (size_t n = 0; n < count; n++, data += wfHashStripe) {
+				for (size_t i = 0; i < 8; i++) {
+					const u64 value = wfHashRead64(data + i * 8);
+					const u64 keyed = value ^ secret[n + i];
+					acc[i ^ 1] += value;
+					acc[i]     += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+				}
+			}
+			if (block == blocks)
+				break;
+			for (size_t i = 0; i < 8; i++) {
+				u64 value = acc[i];
+				value ^= value >> 47;
+				value ^= secret[8 + i];
+				acc[i] = value * wfHashScramblePrime;
+			}
+		}
+
+		data = data + (length - 1) % wfHashStripe + 1 - wfHashStripe;
+		for (size_t i = 0; i < 8; i++) {
+			const u64 value = wfHashRead64(data + i * 8);
+			const u64 keyed = value ^ secret[7 + i];
+			acc[i ^ 1] += value;
+			acc[i]     += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+		}
+	}
+
+#ifdef WF_STDLIB_HASH_SSE2
+	inline __m128i wfHashStripeSSE2(__m128i acc, __m128i value, __m128i key) {
+		const __m128i keyed   = _mm_xor_si128(value, key);
+		const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+		const __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+		return _mm_add_epi64(acc, _mm_add_epi64(product, swapped));
+	}
+
+	inline __m128i wfHashScrambleSSE2(__m128i acc, __m128i key) {
+		const __m128i prime = _mm_set1_epi32(static_cast<int>(wfHashScramblePrime));
+		acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+		acc = _mm_xor_si128(acc, key);
+		const __m128i low  = _mm_mul_epu32(acc, prime);
+		const __m128i high = _mm_mul_epu32(_mm_srli_epi64(acc, 32), prime);
+		return _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+	}
+
+	inline void wfHashLongSSE2(u64 *acc, const unsigned char *data, size_t length, const u64 *secret) {
+		const size_t blocks  = (length - 1) / (wfHashStripe * wfHashBlock);
+		const size_t stripes = ((length - 1) - blocks * wfHashStripe * wfHashBlock) / wfHashStripe;
+
+		__m128i lanes[4];
+		for (size_t i = 0; i < 4; i++)
+			lanes[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+
+		for (size_t block = 0; block <= blocks; block++) {
+			const size_t count = block == blocks ? stripes : static_cast<size_t>(wfHashBlock);
+			for (size_t n = 0; n < count; n++, data += wfHashStripe) {
+				const __m128i *values = reinterpret_cast<const __m128i*>(data);
+				const __m128i *keys   = reinterpret_cast<const __m128i*>(secret + n);
+				for (size_t i = 0; i < 4; i++)
+					lanes[i] = wfHashStripeSSE2(lanes[i], _mm_loadu_si128(values + i), _mm_loadu_si128(keys + i));
+			}
+			if (block == blocks)
+				break;
+			const __m128i *keys = reinterpret_cast<const __m128i*>(secret + 8);
+			for (size_t i = 0; i < 4; i++)
+				lanes[i] = wfHashScrambleSSE2(lanes[i], _mm_loadu_si128(keys + i));
+		}
+
+		data = data + (length - 1) % wfHashStripe + 1 - wfHashStripe;
+		const __m128i *values = reinterpret_cast<const __m128i*>(data);
+		const __m128i *keys   = reinterpret_cast<const __m128i*>(secret + 7);
+		for (size_t i = 0; i < 4; i++) {
+			lanes[i] = wfHashStripeSSE2(lanes[i], _mm_loadu_si128(values + i), _mm_loadu_si128(keys + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, lanes[i]);
+		}
+	}
+#endif
+
+#ifdef WF_STDLIB_HASH_AVX2
+	WF_STDLIB_HASH_TARGET_AVX2
+	inline __m256i wfHashStripeAVX2(__m256i acc, __m256i value, __m256i key) {
+		const __m256i keyed   = _mm256_xor_si256(value, key);
+		const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+		const __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+		return _mm256_add_epi64(acc, _mm256_add_epi64(product, swapped));
+	}
+
+	WF_STDLIB_HASH_TARGET_AVX2
+	inline __m256i wfHashScrambleAVX2(__m256i acc, __m256i key) {
+		const __m256i prime = _mm256_set1_epi32(static_cast<int>(wfHashScramblePrime));
+		acc = _mm256_xor_si256(acc, _mm256_srli_epi64(acc, 47));
+		acc = _mm256_xor_si256(acc, key);
+		const __m256i low  = _mm256_mul_epu32(acc, prime);
+		const __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(acc, 32), prime);
+		return _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+	}
+
+	WF_STDLIB_HASH_TARGET_AVX2
+	inline void wfHashLongAVX2(u64 *acc, const unsigned char *data, size_t length, const u64 *secret) {
+		const size_t blocks  = (length - 1) / (wfHashStripe * wfHashBlock);
+		const size_t stripes = ((length - 1) - blocks * wfHashStripe * wfHashBlock) / wfHashStripe;
+
+		__m256i lanes[2];
+		for (size_t i = 0; i < 2; i++)
+			lanes[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + i);
+
+		for (size_t block = 0; block <= blocks; block++) {
+			const size_t count = block == blocks ? stripes : static_cast<size_t>(wfHashBlock);
+			for (size_t n = 0; n < count; n++, data += wfHashStripe) {
+				const __m256i *values = reinterpret_cast<const __m256i*>(data);
+				const __m256i *keys   = reinterpret_cast<const __m256i*>(secret + n);
+				for (size_t i = 0; i < 2; i++)
+					lanes[i] = wfHashStripeAVX2(lanes[i], _mm256_loadu_si256(values + i), _mm256_loadu_si256(keys + i));
+			}
+			if (block == blocks)
+				break;
+			const __m256i *keys = reinterpret_cast<const __m256i*>(secret + 8);
+			for (size_t i = 0; i < 2; i++)
+				lanes[i] = wfHashScrambleAVX2(lanes[i], _mm256_loadu_si256(keys + i));
+		}
+
+		data = data + (length - 1) % wfHashStripe + 1 - wfHashStripe;
+		const __m256i *values = reinterpret_cast<const __m256i*>(data);
+		const __m256i *keys   = reinterpret_cast<const __m256i*>(secret + 7);
+		for (size_t i = 0; i < 2; i++) {
+			lanes[i] = wfHashStripeAVX2(lanes[i], _mm256_loadu_si256(values + i), _mm256_loadu_si256(keys + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + i, lanes[i]);
+		}
+	}
+#endif
+
+	inline u64 wfHashLong(const unsigned char *data, size_t length, u64 seed) {
+		const u64 *base = wfHashSecret();
+		u64        secret[16];
+		u64        acc[8];
+		for (size_t i = 0; i < 16; i += 2) {
+			secret[i]     = base[i]     + seed;
+			secret[i + 1] = base[i + 1] - seed;
+		}
+		for (size_t i = 0; i < 8; i++)
+			acc[i] = base[15 - i];
+
+#if defined(WF_STDLIB_HASH_AVX2)
+		if (wfCPUHasAVX2())
+			wfHashLongAVX2(acc, data, length, secret);
+		else
+			wfHashLongSSE2(acc, data, length, secret);
+#elif defined(WF_STDLIB_HASH_SSE2)
+		wfHashLongSSE2(acc, data, length, secret);
+#else
+		wfHashLongScalar(acc, data, length, secret);
+#endif
+
+		u64 hash = static_cast<u64>(length) * wfHashP0;
+		for (size_t i = 0; i < 8; i += 2)
+			hash += wfHashFold(acc[i] ^ secret[i + 1], acc[i + 1] ^ secret[i + 2]);
+		return wfHashMix(hash);
+	}
+
+	// eight bytes from the random source of the operating system
+	inline bool wfHashSystemRandom(u64 &value) {
+#if defined(_WIN32)
+		return RtlGenRandom(&value, sizeof(value)) != FALSE;
+#else
+		FILE *file = fopen("/dev/urandom", "rb");
+		if (!file)
+			return false;
+
+		const bool read = fread(&value, sizeof(value), 1, file) == 1;
+		fclose(file);
+		return read;
+#endif
+	}
+
+	//
+	// The system random source, with the time and the load address mixed
+	// in so that there is still something to guess when it is missing.
+	//
+	inline u64 wfHashMakeSeed() {
+		static int  local;
+		const  u64  address = static_cast<u64>(reinterpret_cast<size_t>(&local));
+		const  u64  now     = static_cast<u64>(time(wfNullPointer));
+		const  u64  ticks   = static_cast<u64>(clock());
+		u64         random  = 0;
+		wfHashSystemRandom(random);
+		return wfHashMix(random ^ address ^ wfHashFold(now ^ wfHashP1, ticks ^ wfHashP2));
+	}
+
+	template <typename T> struct wfHashIsScalar : wfIntegralConstant<bool, wfIsIntegral<T>::value> { };
+#if defined(WF_STDLIB_CPP11) || defined(__GNUC__) || defined(_MSC_VER)
+	template <> struct wfHashIsScalar<long long>          : wfCompileTrue { };
+	template <> struct wfHashIsScalar<unsigned long long> : wfCompileTrue { };
+#endif
+
+	// anything not specialized: the bytes of its object representation
+	template <typename T, bool = wfHashIsScalar<T>::value, bool = wfIsFloating<T>::value>
+	struct wfHashDefault;
+}
+
+/*
+ * Function: wfHashBytes
+ *  Hashes a run of bytes.
+ *
+ * Parameters:
+ *  data   - The bytes to hash.
+ *  length - The number of bytes.
+ *  seed   - An optional seed, different seeds give unrelated hashes.
+ *
+ * Returns:
+ *  The 64-bit hash of the bytes.
+ */
+inline u64 wfHashBytes(const void *data, size_t length, u64 seed = 0) {
+	using namespace wfPrivate;
+	const unsigned char *bytes = static_cast<const unsigned char*>(data);
+
+	if (length > wfHashLongLength)
+		return wfHashLong(bytes, length, seed);
+
+	seed ^= wfHashFold(seed ^ wfHashP0, wfHashP1);
+
+	u64 a = 0;
+	u64 b = 0;
+	if (length <= wfHashShortLength) {
+		if (length >= 4) {
+			const size_t middle = (length >> 3) << 2;
+			a = (wfHashRead32(bytes) << 32) | wfHashRead32(bytes + middle);
+			b = (wfHashRead32(bytes + length - 4) << 32) | wfHashRead32(bytes + length - 4 - middle);
+		} else if (length > 0) {
+			a = (static_cast<u64>(bytes[0]) << 16) | (static_cast<u64>(bytes[length >> 1]) << 8) | bytes[length - 1];
+		}
+	} else {
+		size_t remaining = length;
+		if (remaining > 48) {
+			u64 see1 = seed;
+			u64 see2 = seed;
+			do {
+				seed = wfHashFold(wfHashRead64(bytes)      ^ wfHashP1, wfHashRead64(bytes + 8)  ^ seed);
+				see1 = wfHashFold(wfHashRead64(bytes + 16) ^ wfHashP2, wfHashRead64(bytes + 24) ^ see1);
+				see2 = wfHashFold(wfHashRead64(bytes + 32) ^ wfHashP3, wfHashRead64(bytes + 40) ^ see2);
+				bytes     += 48;
+				remaining -= 48;
+			} while (remaining > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (remaining > 16) {
+			seed = wfHashFold(wfHashRead64(bytes) ^ wfHashP1, wfHashRead64(bytes + 8) ^ seed);
+			bytes     += 16;
+			remaining -= 16;
+		}
+		a = wfHashRead64(bytes + remaining - 16);
+		b = wfHashRead64(bytes + remaining - 8);
+	}
+
+	a ^= wfHashP1;
+	b ^= seed;
+	wfHashMultiply(a, b);
+	return wfHashFold(a ^ wfHashP0 ^ static_cast<u64>(length), b ^ wfHashP1);
+}
+
+/*
+ * Function: wfHashCombine
+ *  Combines two hashes into one, for hashing aggregates member by member.
+ *  The result depends on the order of the arguments.
+ */
+inline u64 wfHashCombine(u64 hash, u64 value) {
+	return wfPrivate::wfHashFold(hash ^ wfPrivate::wfHashP0, value ^ wfPrivate::wfHashP1);
+}
+
+/*
+ * Function: wfHashRandomSeed
+ *  Returns a seed picked once per process, for <wfFunctional::wfSeededHash>.
+ *
+ * Remarks:
+ *  The seed comes from *RtlGenRandom* on Windows and from /dev/urandom
+ *  elsewhere.  Where neither is available it falls back to the time and
+ *  the address the library was loaded at, which is good enough to stop
+ *  keys from being chosen to collide ahead of time but guessable by
+ *  anyone who can observe the process.  Not a source of randomness for
+ *  anything else.
+ */
+inline u64 wfHashRandomSeed() {
+	static const u64 seed = wfPrivate::wfHashMakeSeed();
+	return seed;
+}
+
+namespace wfPrivate {
+	template <typename T>
+	struct wfHashDefault<T, false, false> {
+		u64 operator()(const T& key, u64 seed = 0) const {
+			return wfHashBytes(&key, sizeof(T), seed);
+		}
+	};
+
+	// integers; a bijection when unseeded so distinct keys never collide.
+	// Seeded, the fold is finalized: the low half of its product never
+	// sees the high bits of the key
+	template <typename T>
+	struct wfHashDefault<T, true, false> {
+		u64 operator()(const T& key) const {
+			return wfHashMix(static_cast<u64>(key));
+		}
+		u64 operator()(const T& key, u64 seed) const {
+			return wfHashMix(wfHashFold(static_cast<u64>(key) ^ wfHashP0, seed ^ wfHashP1));
+		}
+	};
+
+	// floating point: by value, so that 0.0 and -0.0 hash alike
+	template <typename T>
+	struct wfHashDefault<T, false, true> {
+		u64 operator()(const T& key, u64 seed = 0) const {
+			const double value = key == 0 ? 0.0 : static_cast<double>(key);
+			u64          bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return wfHashDefault<u64, true, false>()(bits, seed);
+		}
+	};
+}
+
+namespace wfFunctional {
+	/*
+	 * Class: wfHash
+	 *  The hash function object of the hashed containers.
+	 *
+	 * Parameters:
+	 *  T - The key data type.
+	 *
+	 * Remarks:
+	 *  Called as *wfHash<T>()(key)*, or *wfHash<T>()(key, seed)* for a
+	 *  seeded hash, returning a *u64*.  Keys that compare equal must hash
+	 *  equal.  Types without a specialization are hashed by the bytes of
+	 *  their object representation, which is only correct for types
+	 *  without pointers or padding; specialize it for anything else.
+	 */
+	template <typename T>
+	struct wfHash : wfPrivate::wfHashDefault<T> { };
+
+	template <typename T>
+	struct wfHash<T*> {
+		u64 operator()(T *key) const {
+			return wfPrivate::wfHashMix(static_cast<u64>(reinterpret_cast<size_t>(key)));
+		}
+		u64 operator()(T *key, u64 seed) const {
+			return wfPrivate::wfHashDefault<u64, true, false>()(static_cast<u64>(reinterpret_cast<size_t>(key)), seed);
+		}
+	};
+
+	template <>
+	struct wfHash<const char*> {
+		u64 operator()(const char *key, u64 seed = 0) const {
+			return wfHashBytes(key, key ? strlen(key) : 0, seed);
+		}
+	};
+
+	template <>
+	struct wfHash<char*> : wfHash<const char*> { };
+
+	template <>
+	struct wfHash<wfStringRef> {
+		u64 operator()(const wfStringRef& key, u64 seed = 0) const {
+			return wfHashBytes(key.Data(), key.Length(), seed);
+		}
+	};
+
+	template <typename T, typename U>
+	struct wfHash<wfPair<T, U> > {
+		u64 operator()(const wfPair<T, U>& key) const {
+			return wfHashCombine(wfHash<T>()(key.first), wfHash<U>()(key.second));
+		}
+		u64 operator()(const wfPair<T, U>& key, u64 seed) const {
+			return wfHashCombine(wfHash<T>()(key.first, seed), wfHash<U>()(key.second, seed));
+		}
+	};
+
+	/*
+	 * Class: wfSeededHash
+	 *  A <wfHash> seeded with <wfHashRandomSeed>, for hashed containers
+	 *  keyed by input from outside the program.
+	 *
+	 * Parameters:
+	 *  T - The key data type.
+	 */
+	template <typename T>
+	struct wfSeededHash {
+		wfSeededHash() :
+			m_seed(wfHashRandomSeed())
+		{ }
+
+		explicit wfSeededHash(u64 seed) :
+			m_seed(seed)
+		{ }
+
+		u64 operator()(const T& key) const {
+			return wfHash<T>()(key, m_seed);
+		}
+
+	private:
+		u64 m_seed;
+	};
+}
+#endif
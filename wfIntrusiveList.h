@@ -0,0 +1,412 @@
+#ifndef WF_STDLIB_INTRUSIVELIST_HDR
+#define WF_STDLIB_INTRUSIVELIST_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+
+/*
+ * File: wfIntrusiveList
+ *  A doubly linked intrusive list whose nodes do not know their list.
+ *
+ * >#include "wfIntrusiveList.h"
+ *
+ *  Like <wfList> every item embeds a node which is passed the pointer to
+ *  the item.  Unlike <wfList> the node has no pointer back to its list:
+ *  the list is circular through a sentinel node owned by the list, so a
+ *  node can unlink itself from its neighbours alone, and moving nodes from
+ *  one list to another never touches the nodes in between.  Appending a
+ *  whole list or splicing a range of nodes is O(1) regardless of length.
+ *
+ *  The price is that the list keeps no count, <Count> walks the list, and
+ *  a node cannot tell which list it is in, only whether it is in one.
+ */
+
+namespace wfPrivate {
+	struct wfIntrusiveLink {
+		wfIntrusiveLink *m_prev;
+		wfIntrusiveLink *m_next;
+	};
+
+	// links the range [first, last] in between prev and next
+	inline void wfIntrusiveLinkRange(wfIntrusiveLink *prev, wfIntrusiveLink *first, wfIntrusiveLink *last, wfIntrusiveLink *next) {
+		first->m_prev = prev;
+		last->m_next  = next;
+		prev->m_next  = first;
+		next->m_prev  = last;
+	}
+}
+
+/*
+ * Class: wfIntrusiveListNode
+ *  The node every item in a <wfIntrusiveList> has as a member.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  A node removes itself from whatever list it is in when destroyed.
+ *  Copying an item does not copy its membership, the copy of a node is
+ *  never linked and assigning to a node leaves it where it is.
+ */
+template <typename T>
+struct wfIntrusiveListNode : private wfPrivate::wfIntrusiveLink {
+	wfIntrusiveListNode() :
+		m_item(wfNullPointer)
+	{
+		m_prev = m_next = wfNullPointer;
+	}
+
+	explicit wfIntrusiveListNode(T *item) :
+		m_item(item)
+	{
+		m_prev = m_next = wfNullPointer;
+	}
+
+	wfIntrusiveListNode(const wfIntrusiveListNode&) :
+		m_item(wfNullPointer)
+	{
+		m_prev = m_next = wfNullPointer;
+	}
+
+	wfIntrusiveListNode& operator=(const wfIntrusiveListNode&) {
+		return *this;
+	}
+
+	~wfIntrusiveListNode() {
+		Unlink();
+	}
+
+	/*
+	 * Function: Init
+	 *  Sets the item of a node constructed without one.
+	 */
+	void Init(T *item) { m_item = item; }
+
+	/*
+	 * Function: GetItem
+	 *  Returns the item of the node.
+	 */
+	T *GetItem() const { return m_item; }
+
+	/*
+	 * Function: IsLinked
+	 *  Tests if the node is in a list.
+	 */
+	bool IsLinked() const { return m_next != wfNullPointer; }
+
+	/*
+	 * Function: Unlink
+	 *  Removes the node from the list it is in, if any, in O(1).
+	 */
+	void Unlink() {
+		if (!m_next)
+			return;
+		m_prev->m_next = m_next;
+		m_next->m_prev = m_prev;
+		m_prev = m_next = wfNullPointer;
+	}
+
+private:
+	template <typename> friend struct wfIntrusiveList;
+	template <typename> friend struct wfIntrusiveListIterator;
+
+	T *m_item;
+};
+
+/*
+ * Class: wfIntrusiveListIterator
+ *  A bidirectional iterator over the items of a <wfIntrusiveList>.
+ *
+ * Remarks:
+ *  Removing the node an iterator is at invalidates the iterator, advance
+ *  it first.
+ */
+template <typename T>
+struct wfIntrusiveListIterator {
+	typedef ptrdiff_t                DifferenceType;
+	typedef T                        ValueType;
+	typedef T*                       PointerType;
+	typedef T&                       ReferenceType;
+	typedef wfIntrusiveListNode<T>   Node;
+
+	wfIntrusiveListIterator() :
+		m_link(wfNullPointer)
+	{ }
+
+	ReferenceType operator *  () const { return *GetNode()->m_item; }
+	PointerType   operator -> () const { return  GetNode()->m_item; }
+
+	/*
+	 * Function: GetNode
+	 *  Returns the node the iterator is at.
+	 */
+	Node *GetNode() const { return static_cast<Node*>(m_link); }
+
+	wfIntrusiveListIterator& operator++() { m_link = m_link->m_next; return *this; }
+	wfIntrusiveListIterator& operator--() { m_link = m_link->m_prev; return *this; }
+
+	wfIntrusiveListIterator operator++(int) {
+		wfIntrusiveListIterator copy = *this;
+		m_link = m_link->m_next;
+		return copy;
+	}
+
+	wfIntrusiveListIterator operator--(int) {
+		wfIntrusiveListIterator copy = *this;
+		m_link = m_link->m_prev;
+		return copy;
+	}
+
+	bool operator == (const wfIntrusiveListIterator& other) const { return m_link == other.m_link; }
+	bool operator != (const wfIntrusiveListIterator& other) const { return m_link != other.m_link; }
+
+private:
+	template <typename> friend struct wfIntrusiveList;
+
+	explicit wfIntrusiveListIterator(wfPrivate::wfIntrusiveLink *link) :
+		m_link(link)
+	{ }
+
+	wfPrivate::wfIntrusiveLink *m_link;
+};
+
+/*
+ * Class: wfIntrusiveList
+ *  A doubly linked list of items that embed a <wfIntrusiveListNode>.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  The list owns none of its items.  A node can be in only one list at a
+ *  time; insertion into a list first takes the node out of any list it
+ *  is in.  Destroying or clearing the list unlinks every node left in it.
+ */
+template <typename T>
+struct wfIntrusiveList {
+	typedef wfIntrusiveListNode<T>     Node;
+	typedef wfIntrusiveListIterator<T> Iterator;
+
+	wfIntrusiveList() {
+		m_sentinel.m_prev = m_sentinel.m_next = &m_sentinel;
+	}
+
+	~wfIntrusiveList() {
+		Clear();
+	}
+
+	/*
+	 * Function: Empty
+	 *  Tests if the list is empty.
+	 */
+	bool Empty() const { return m_sentinel.m_next == &m_sentinel; }
+
+	/*
+	 * Function: Count
+	 *  Returns the number of items in the list, in O(n).
+	 */
+	size_t Count() const {
+		size_t count = 0;
+		for (const wfPrivate::wfIntrusiveLink *link = m_sentinel.m_next; link != &m_sentinel; link = link->m_next)
+			count++;
+		return count;
+	}
+
+	/*
+	 * Function: Begin
+	 *  Returns an iterator to the first item.
+	 */
+	Iterator Begin() { return Iterator(m_sentinel.m_next); }
+
+	/*
+	 * Function: End
+	 *  Returns an iterator to the location succeeding the last item.  Unlike
+	 *  <wfList::End> this does not point at the last item.
+	 */
+	Iterator End() { return Iterator(&m_sentinel); }
+
+	/*
+	 * Function: GetFirst
+	 *  Returns the first item, or *wfNullPointer* if the list is empty.
+	 */
+	T *GetFirst() const { return Empty() ? wfNullPointer : static_cast<Node*>(m_sentinel.m_next)->m_item; }
+
+	/*
+	 * Function: GetLast
+	 *  Returns the last item, or *wfNullPointer* if the list is empty.
+	 */
+	T *GetLast () const { return Empty() ? wfNullPointer : static_cast<Node*>(m_sentinel.m_prev)->m_item; }
+
+	/*
+	 * Function: Prepend
+	 *  Inserts a node at the front of the list.
+	 */
+	void Prepend(Node *node) { InsertBefore(m_sentinel.m_next, node); }
+
+	/*
+	 * Function: Append
+	 *  Inserts a node at the back of the list.
+	 */
+	void Append (Node *node) { InsertBefore(&m_sentinel, node); }
+
+	/*
+	 * Function: InsertBefore
+	 *  Inserts a node before a node already in the list.
+	 */
+	void InsertBefore(Node *position, Node *node) { InsertBefore(static_cast<wfPrivate::wfIntrusiveLink*>(position), node); }
+
+	/*
+	 * Function: Insert
+	 *  Inserts a node before an iterator, which may be <End>.
+	 */
+	void Insert(Iterator position, Node *node) { InsertBefore(position.m_link, node); }
+
+	/*
+	 * Function: Prepend
+	 *  Moves every node of another list to the front of this list in O(1).
+	 */
+	void Prepend(wfIntrusiveList& list) { Splice(Begin(), list); }
+
+	/*
+	 * Function: Append
+	 *  Moves every node of another list to the back of this list in O(1).
+	 */
+	void Append (wfIntrusiveList& list) { Splice(End(),   list); }
+
+	/*
+	 * Function: Splice
+	 *  Moves every node of another list before an iterator in O(1).
+	 */
+	void Splice(Iterator position, wfIntrusiveList& list) {
+		if (list.Empty() || &list == this)
+			return;
+		wfPrivate::wfIntrusiveLink *first = list.m_sentinel.m_next;
+		wfPrivate::wfIntrusiveLink *last  = list.m_sentinel.m_prev;
+		list.m_sentinel.m_prev = list.m_sentinel.m_next = &list.m_sentinel;
+		wfPrivate::wfIntrusiveLinkRange(position.m_link->m_prev, first, last, position.m_link);
+	}
+
+	/*
+	 * Function: Splice
+	 *  Moves the nodes in the range [first, end) before an iterator in O(1).
+	 *
+	 * Parameters:
+	 *  position - Where to move the nodes to, in this list.
+	 *  first    - The first node to move.
+	 *  end      - The node succeeding the last one to move, in the same list
+	 *             as *first*, which may be any list including this one.
+	 *
+	 * Remarks:
+	 *  *position* must not be within the range.  The list the range comes
+	 *  from is not needed since the nodes do not refer to it.
+	 */
+	void Splice(Iterator position, Iterator first, Iterator end) {
+		if (first == end || position == first || position == end)
+			return;
+		wfPrivate::wfIntrusiveLink *last = end.m_link->m_prev;
+		first.m_link->m_prev->m_next = end.m_link;
+		end.m_link->m_prev           = first.m_link->m_prev;
+		wfPrivate::wfIntrusiveLinkRange(position.m_link->m_prev, first.m_link, last, position.m_link);
+	}
+
+	/*
+	 * Function: Remove
+	 *  Removes a node from the list, the same as <wfIntrusiveListNode::Unlink>.
+	 */
+	void Remove(Node *node) { node->Unlink(); }
+
+	/*
+	 * Function: Remove
+	 *  Removes the node at an iterator.
+	 *
+	 * Returns:
+	 *  An iterator to the item succeeding the one removed.
+	 */
+	Iterator Remove(Iterator position) {
+		Iterator next(position.m_link->m_next);
+		position.GetNode()->Unlink();
+		return next;
+	}
+
+	/*
+	 * Function: TakeFirst
+	 *  Removes the first node and returns its item, or *wfNullPointer* if
+	 *  the list is empty.
+	 */
+	T *TakeFirst() { return Take(m_sentinel.m_next); }
+
+	/*
+	 * Function: TakeLast
+	 *  Removes the last node and returns its item, or *wfNullPointer* if
+	 *  the list is empty.
+	 */
+	T *TakeLast () { return Take(m_sentinel.m_prev); }
+
+	/*
+	 * Function: Clear
+	 *  Unlinks every node, in O(n).
+	 */
+	void Clear() {
+		wfPrivate::wfIntrusiveLink *link = m_sentinel.m_next;
+		while (link != &m_sentinel) {
+			wfPrivate::wfIntrusiveLink *next = link->m_next;
+			link->m_prev = link->m_next = wfNullPointer;
+			link = next;
+		}
+		m_sentinel.m_prev = m_sentinel.m_next = &m_sentinel;
+	}
+
+	/*
+	 * Function: Swap
+	 *  Exchanges the nodes of two lists in O(1).
+	 */
+	void Swap(wfIntrusiveList& list) {
+		wfIntrusiveList temp;
+		temp.Splice(temp.End(), list);
+		list.Splice(list.End(), *this);
+		Splice(End(), temp);
+	}
+
+	/*
+	 * Function: ForEach
+	 *  Invokes a function on every item in order, as *function(item)* with
+	 *  a reference to the item.  The function may unlink the node of the
+	 *  item it is given.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied.
+	 */
+	template <typename F>
+	F ForEach(F function) {
+		wfPrivate::wfIntrusiveLink *link = m_sentinel.m_next;
+		while (link != &m_sentinel) {
+			wfPrivate::wfIntrusiveLink *next = link->m_next;
+			function(*static_cast<Node*>(link)->m_item);
+			link = next;
+		}
+		return function;
+	}
+
+private:
+	void InsertBefore(wfPrivate::wfIntrusiveLink *position, Node *node) {
+		// already in place, and unlinking would lose the position
+		if (position == node)
+			return;
+		node->Unlink();
+		wfPrivate::wfIntrusiveLinkRange(position->m_prev, node, node, position);
+	}
+
+	T *Take(wfPrivate::wfIntrusiveLink *link) {
+		if (link == &m_sentinel)
+			return wfNullPointer;
+		Node *node = static_cast<Node*>(link);
+		node->Unlink();
+		return node->m_item;
+	}
+
+	wfPrivate::wfIntrusiveLink m_sentinel;
+
+	wfIntrusiveList(const wfIntrusiveList&);
+	wfIntrusiveList& operator=(const wfIntrusiveList&);
+};
+
+#endif
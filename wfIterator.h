@@ -452,4 +452,86 @@ protected:
 	) { return lhs.Base() != rhs.Base(); }
 #endif // !WF_STDLIB_CPP11
 
+/*
+ * Class: wfBackInsertIterator
+ *  Output iterator adaptor that appends every value assigned through it
+ *  to a container with *PushBack*.
+ *
+ * Parameters:
+ *  C - The container type, for instance a <wfVector>.
+ *
+ * Remarks:
+ *  Used to let algorithms which write through an output iterator grow a
+ *  container instead of writing to preallocated storage.  Use
+ *  <wfBackInserter> to create one.
+ */
+template <typename C>
+struct wfBackInsertIterator {
+	explicit wfBackInsertIterator(C& container) :
+		m_container(&container)
+	{ }
+
+	template <typename T>
+	wfBackInsertIterator& operator =(const T& value) {
+		m_container->PushBack(value);
+		return *this;
+	}
+
+	wfBackInsertIterator& operator * ()    { return *this; }
+	wfBackInsertIterator& operator ++()    { return *this; }
+	wfBackInsertIterator  operator ++(int) { return *this; }
+
+protected:
+	C *m_container;
+};
+
+/*
+ * Class: wfInsertIterator
+ *  Output iterator adaptor that inserts every value assigned through it
+ *  into an associative container with *Insert*.
+ *
+ * Parameters:
+ *  C - The container type, for instance a <wfSet>.
+ *
+ * Remarks:
+ *  Use <wfInserter> to create one.
+ */
+template <typename C>
+struct wfInsertIterator {
+	explicit wfInsertIterator(C& container) :
+		m_container(&container)
+	{ }
+
+	template <typename T>
+	wfInsertIterator& operator =(const T& value) {
+		m_container->Insert(value);
+		return *this;
+	}
+
+	wfInsertIterator& operator * ()    { return *this; }
+	wfInsertIterator& operator ++()    { return *this; }
+	wfInsertIterator  operator ++(int) { return *this; }
+
+protected:
+	C *m_container;
+};
+
+/*
+ * Function: wfBackInserter
+ *  Creates a <wfBackInsertIterator> for a container.
+ */
+template <typename C>
+inline wfBackInsertIterator<C> wfBackInserter(C& container) {
+	return wfBackInsertIterator<C>(container);
+}
+
+/*
+ * Function: wfInserter
+ *  Creates a <wfInsertIterator> for a container.
+ */
+template <typename C>
+inline wfInsertIterator<C> wfInserter(C& container) {
+	return wfInsertIterator<C>(container);
+}
+
 #endif
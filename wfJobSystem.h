@@ -0,0 +1,536 @@
+#ifndef WF_STDLIB_JOBSYSTEM_HDR
+#define WF_STDLIB_JOBSYSTEM_HDR
+#include <new>
+#include "wfThread.h"
+#include "wfSystemInfo.h"
+#include "wfNullPointer.h"
+
+/*
+ * File: wfJobSystem
+ *  A pool of worker threads that run small jobs, balanced by stealing.
+ *
+ * >#include "wfJobSystem.h"
+ *
+ *  Every worker has a Chase-Lev deque of jobs: the worker pushes and pops
+ *  jobs at the bottom of its own deque, like a stack, while idle workers
+ *  steal from the top of the deques of others.  Jobs spawned by a job stay
+ *  with the worker that spawned them, hot in its cache, until another
+ *  worker runs dry, and what gets stolen is the oldest job, usually the
+ *  biggest piece of the remaining work.
+ *
+ *  Jobs are counted on a <wfJobCounter>.  Starting a job increments its
+ *  counter and finishing it decrements the counter, a job that depends on
+ *  others waits for their counter with <wfJobSystem::WaitFor>, which runs
+ *  other jobs in the meantime rather than blocking the worker.  The thread
+ *  that creates the system is one of the workers, the rest are threads of
+ *  their own, as many as the hardware has threads unless told otherwise.
+ *
+ *  Job records come from a pool private to each worker, the worker that
+ *  starts a job takes its record without a lock.  A worker that finishes a
+ *  job started by another pushes the record onto a list of returns of the
+ *  owner, which the owner takes back in a single exchange once its pool
+ *  runs dry.  A thread that keeps starting jobs others finish therefor
+ *  reuses its records instead of allocating more.
+ */
+
+/*
+ * Class: wfJobCounter
+ *  The number of unfinished jobs started against it.
+ *
+ * Remarks:
+ *  A counter can be reused once it is <Done>, and must not be destroyed
+ *  before then.
+ */
+struct wfJobCounter {
+	wfJobCounter() :
+		m_pending(0)
+	{ }
+
+	/*
+	 * Function: Done
+	 *  Tests if every job started against the counter has finished.
+	 *
+	 * Remarks:
+	 *  Everything the jobs did is visible to the caller once it returns
+	 *  *true*.
+	 */
+	bool Done() const { return wfAtomicLoad(&m_pending) == 0; }
+
+private:
+	friend struct wfJobSystem;
+
+	volatile u32 m_pending;
+
+	wfJobCounter(const wfJobCounter&);
+	wfJobCounter& operator=(const wfJobCounter&);
+};
+
+struct wfJobSystem;
+
+namespace wfPrivate {
+	enum { wfJobCacheLine = 64 };
+
+	struct wfJob {
+		void        (*m_function)(void *data);
+		void        (*m_range)(void *data, size_t begin, size_t end);
+		void         *m_data;
+		size_t        m_begin;
+		size_t        m_end;
+		size_t        m_grain;
+		wfJobCounter *m_counter;
+		wfJob        *m_next;
+		u32           m_owner;   // the worker whose pool the record is from
+	};
+
+	struct wfJobBlock {
+		enum { kJobs = 64 };
+
+		wfJobBlock *m_next;
+		wfJob       m_jobs[kJobs];
+	};
+
+	// the owner pushes and pops at the bottom, thieves take from the top;
+	// the fixed capacity lets the owner run a job itself when full instead
+	// of growing a buffer thieves may still be reading
+	struct wfJobDeque {
+		enum { kCapacity = 4096 };
+
+		wfJobDeque() :
+			m_top   (0),
+			m_bottom(0)
+		{ }
+
+		bool Push(wfJob *job) {
+			const s64 bottom = wfAtomicLoadRelaxed(&m_bottom);
+			const s64 top    = wfAtomicLoad(&m_top);
+			if (bottom - top >= kCapacity)
+				return false;
+			wfAtomicStoreRelaxed(&m_jobs[bottom & (kCapacity - 1)], job);
+			wfAtomicStore(&m_bottom, bottom + 1);
+			return true;
+		}
+
+		wfJob *Pop() {
+			const s64 bottom = wfAtomicLoadRelaxed(&m_bottom) - 1;
+			wfAtomicStoreRelaxed(&m_bottom, bottom);
+			wfAtomicFence();
+			s64 top = wfAtomicLoadRelaxed(&m_top);
+			if (top > bottom) {
+				wfAtomicStoreRelaxed(&m_bottom, bottom + 1);
+				return wfNullPointer;
+			}
+
+			wfJob *job = wfAtomicLoadRelaxed(&m_jobs[bottom & (kCapacity - 1)]);
+			if (top == bottom) {
+				// the last job, race the thieves for it
+				if (!wfAtomicCompareExchange(&m_top, top, top + 1))
+					job = wfNullPointer;
+				wfAtomicStoreRelaxed(&m_bottom, bottom + 1);
+			}
+			return job;
+		}
+
+		wfJob *Steal() {
+			s64 top = wfAtomicLoad(&m_top);
+			wfAtomicFence();
+			const s64 bottom = wfAtomicLoad(&m_bottom);
+			if (top >= bottom)
+				return wfNullPointer;
+
+			wfJob *job = wfAtomicLoadRelaxed(&m_jobs[top & (kCapacity - 1)]);
+			if (!wfAtomicCompareExchange(&m_top, top, top + 1))
+				return wfNullPointer;
+			return job;
+		}
+
+		bool Empty() const {
+			const s64 top = wfAtomicLoad(&m_top);
+			return wfAtomicLoad(&m_bottom) <= top;
+		}
+
+		volatile s64   m_top;
+		char           m_topPad[wfJobCacheLine - sizeof(s64)];
+		volatile s64   m_bottom;
+		char           m_bottomPad[wfJobCacheLine - sizeof(s64)];
+		wfJob *volatile m_jobs[kCapacity];
+	};
+
+	struct wfJobWorker {
+		wfJobDeque      m_deque;
+		wfJob *volatile m_returned; // records finished by other workers
+		char            m_returnedPad[wfJobCacheLine - sizeof(void*)];
+		wfJob          *m_free;
+		wfJobBlock     *m_blocks;
+		wfJobSystem    *m_system;
+		u32             m_index;
+		u32             m_seed;
+		wfThread        m_thread;
+	};
+
+	// a template so that every translation unit shares the one variable
+	template <typename T>
+	struct wfJobCurrent {
+		static WF_THREADLOCAL T *s_worker;
+	};
+
+	// zero rather than wfNullPointer, a thread local needs a constant
+	template <typename T>
+	WF_THREADLOCAL T *wfJobCurrent<T>::s_worker = 0;
+}
+
+/*
+ * Class: wfJobSystem
+ *  A set of workers running jobs.
+ *
+ * Remarks:
+ *  Jobs are started and waited for from the thread that created the
+ *  system and from within jobs.  Any other thread may call the same
+ *  functions, but the jobs it starts run on the spot and its waits do
+ *  not help.  Every job must have finished before the system is
+ *  destroyed.
+ */
+struct wfJobSystem {
+	/*
+	 * Type: Function
+	 *  The function of a job, invoked with the data the job was started
+	 *  with.
+	 */
+	typedef void (*Function)(void *data);
+
+	/*
+	 * Type: RangeFunction
+	 *  The function of a <ParallelFor>, invoked with the data it was
+	 *  started with and a range of indices [begin, end).
+	 */
+	typedef void (*RangeFunction)(void *data, size_t begin, size_t end);
+
+	/*
+	 * Function: wfJobSystem
+	 *  Creates a system and starts its worker threads.
+	 *
+	 * Parameters:
+	 *  workers - The number of workers, including the calling thread, or
+	 *            zero for one per hardware thread.
+	 *  heap    - The heap the workers and job records are allocated from.
+	 */
+	explicit wfJobSystem(u32 workers = 0, wfHeap *heap = &g_miscHeap) :
+		m_heap    (heap),
+		m_count   (workers ? workers : wfCPUThreadCount()),
+		m_sleepers(0),
+		m_stop    (0)
+	{
+		m_workers = static_cast<Worker*>(m_heap->Alloc(m_count * sizeof(Worker)));
+		for (u32 i = 0; i < m_count; i++) {
+			Worker *worker = new (&m_workers[i]) Worker;
+			worker->m_returned = wfNullPointer;
+			worker->m_free     = wfNullPointer;
+			worker->m_blocks   = wfNullPointer;
+			worker->m_system   = this;
+			worker->m_index    = i;
+			worker->m_seed     = (i + 1) * 2654435761u;
+		}
+
+		m_previous = Current::s_worker;
+		Current::s_worker = &m_workers[0];
+		for (u32 i = 1; i < m_count; i++)
+			m_workers[i].m_thread.Start(&wfJobSystem::Main, &m_workers[i]);
+	}
+
+	~wfJobSystem() {
+		wfAtomicStore(&m_stop, 1u);
+		{
+			wfLockGuard<wfMutex> guard(m_lock);
+			m_wake.NotifyAll();
+		}
+		for (u32 i = 1; i < m_count; i++)
+			m_workers[i].m_thread.Join();
+		Current::s_worker = m_previous;
+
+		for (u32 i = 0; i < m_count; i++) {
+			for (wfPrivate::wfJobBlock *block = m_workers[i].m_blocks; block; ) {
+				wfPrivate::wfJobBlock *next = block->m_next;
+				m_heap->Free(block);
+				block = next;
+			}
+			m_workers[i].~Worker();
+		}
+		m_heap->Free(m_workers);
+	}
+
+	/*
+	 * Function: GetWorkerCount
+	 *  Returns the number of workers, the creating thread included.
+	 */
+	u32 GetWorkerCount() const { return m_count; }
+
+	/*
+	 * Function: GetJobRecordCount
+	 *  Returns the number of job records the workers have allocated, the
+	 *  pools only ever grow.
+	 *
+	 * Remarks:
+	 *  For diagnostics, call it while no job runs.
+	 */
+	size_t GetJobRecordCount() const {
+		size_t count = 0;
+		for (u32 i = 0; i < m_count; i++) {
+			for (const wfPrivate::wfJobBlock *block = m_workers[i].m_blocks; block; block = block->m_next)
+				count += wfPrivate::wfJobBlock::kJobs;
+		}
+		return count;
+	}
+
+	/*
+	 * Function: Run
+	 *  Starts a job.
+	 *
+	 * Parameters:
+	 *  function - The function of the job.
+	 *  data     - The data passed to the function.
+	 *  counter  - The counter the job is counted on.
+	 *
+	 * Remarks:
+	 *  The job goes on the deque of the calling worker.  If the deque is
+	 *  full the job runs before *Run* returns.
+	 */
+	void Run(Function function, void *data, wfJobCounter& counter) {
+		Worker *worker = GetWorker();
+		if (!worker) {
+			function(data);
+			return;
+		}
+
+		wfPrivate::wfJob *job = Allocate(*worker);
+		job->m_function = function;
+		job->m_range    = wfNullPointer;
+		job->m_data     = data;
+		job->m_counter  = &counter;
+		Spawn(*worker, job);
+	}
+
+	/*
+	 * Function: ParallelFor
+	 *  Starts a job over a range of indices that splits in halves until
+	 *  the pieces are no larger than a grain.
+	 *
+	 * Parameters:
+	 *  function - The function invoked on every piece.
+	 *  data     - The data passed to the function.
+	 *  count    - The number of indices, the range is [0, count).
+	 *  grain    - The largest piece the function is invoked on.
+	 *  counter  - The counter the pieces are counted on.
+	 *
+	 * Remarks:
+	 *  A piece is split only when a worker gets round to it, so a range no
+	 *  worker steals from is run by one worker a grain at a time, and only
+	 *  stolen halves spread the work.  The grain is a trade between the
+	 *  cost of a job and the balance between workers, a few thousand
+	 *  simple elements per grain is a good start.
+	 */
+	void ParallelFor(RangeFunction function, void *data, size_t count, size_t grain, wfJobCounter& counter) {
+		if (count == 0)
+			return;
+
+		Worker *worker = GetWorker();
+		if (!worker) {
+			function(data, 0, count);
+			return;
+		}
+
+		wfPrivate::wfJob *job = Allocate(*worker);
+		job->m_function = wfNullPointer;
+		job->m_range    = function;
+		job->m_data     = data;
+		job->m_begin    = 0;
+		job->m_end      = count;
+		job->m_grain    = grain ? grain : 1;
+		job->m_counter  = &counter;
+		Spawn(*worker, job);
+	}
+
+	/*
+	 * Function: WaitFor
+	 *  Waits for every job counted on a counter to finish, running jobs in
+	 *  the meantime.
+	 *
+	 * Parameters:
+	 *  counter - The counter to wait for.
+	 *
+	 * Remarks:
+	 *  The worker runs its own jobs first and steals once it has none, the
+	 *  jobs it runs need not be those waited for.  A job that waits inside
+	 *  a job therefor nests the jobs it runs on its stack.
+	 */
+	void WaitFor(wfJobCounter& counter) {
+		Worker *worker = GetWorker();
+		u32     spins  = 0;
+		while (!counter.Done()) {
+			wfPrivate::wfJob *job = worker ? Find(*worker) : wfNullPointer;
+			if (job) {
+				Execute(*worker, job);
+				spins = 0;
+			} else if (++spins < kSpins) {
+				wfCpuRelax();
+			} else {
+				wfThreadYield();
+			}
+		}
+	}
+
+private:
+	typedef wfPrivate::wfJobWorker            Worker;
+	typedef wfPrivate::wfJobCurrent<Worker>   Current;
+
+	enum { kSpins = 1024 };
+
+	wfJobSystem(const wfJobSystem&);
+	wfJobSystem& operator=(const wfJobSystem&);
+
+	Worker *GetWorker() const {
+		Worker *worker = Current::s_worker;
+		return worker && worker->m_system == this ? worker : wfNullPointer;
+	}
+
+	wfPrivate::wfJob *Allocate(Worker& worker) {
+		if (!worker.m_free)
+			worker.m_free = wfAtomicExchange(&worker.m_returned, static_cast<wfPrivate::wfJob*>(wfNullPointer));
+
+		if (!worker.m_free) {
+			wfPrivate::wfJobBlock *block = static_cast<wfPrivate::wfJobBlock*>(m_heap->Alloc(sizeof(wfPrivate::wfJobBlock)));
+			block->m_next  = worker.m_blocks;
+			worker.m_blocks = block;
+			for (size_t i = 0; i < wfPrivate::wfJobBlock::kJobs; i++) {
+				block->m_jobs[i].m_next  = worker.m_free;
+				block->m_jobs[i].m_owner = worker.m_index;
+				worker.m_free = &block->m_jobs[i];
+			}
+		}
+		wfPrivate::wfJob *job = worker.m_free;
+		worker.m_free = job->m_next;
+		return job;
+	}
+
+	// back to the pool of the worker the record is from, a stolen job's
+	// record onto the returns of its owner
+	void Release(Worker& worker, wfPrivate::wfJob *job) {
+		if (job->m_owner == worker.m_index) {
+			job->m_next   = worker.m_free;
+			worker.m_free = job;
+			return;
+		}
+
+		Worker           &owner = m_workers[job->m_owner];
+		wfPrivate::wfJob *head  = wfAtomicLoadRelaxed(&owner.m_returned);
+		do {
+			job->m_next = head;
+		} while (!wfAtomicCompareExchange(&owner.m_returned, head, job));
+	}
+
+	void Spawn(Worker& worker, wfPrivate::wfJob *job) {
+		wfAtomicFetchAdd(&job->m_counter->m_pending, 1u);
+		if (!worker.m_deque.Push(job)) {
+			Execute(worker, job);
+			return;
+		}
+		Wake();
+	}
+
+	void Execute(Worker& worker, wfPrivate::wfJob *job) {
+		if (job->m_range) {
+			// hand the upper half to the deque until the rest is a grain
+			while (job->m_end - job->m_begin > job->m_grain) {
+				const size_t middle = job->m_begin + (job->m_end - job->m_begin) / 2;
+				wfPrivate::wfJob *half = Allocate(worker);
+				*half = *job;
+				half->m_owner = worker.m_index;
+				half->m_begin = middle;
+				job->m_end    = middle;
+				Spawn(worker, half);
+			}
+			job->m_range(job->m_data, job->m_begin, job->m_end);
+		} else {
+			job->m_function(job->m_data);
+		}
+
+		wfJobCounter *counter = job->m_counter;
+		Release(worker, job);
+		wfAtomicFetchAdd(&counter->m_pending, ~0u);
+	}
+
+	// the worker's own newest job, or the oldest job of another worker,
+	// starting from a random one so thieves spread over the victims
+	wfPrivate::wfJob *Find(Worker& worker) {
+		wfPrivate::wfJob *job = worker.m_deque.Pop();
+		if (job || m_count == 1)
+			return job;
+
+		worker.m_seed ^= worker.m_seed << 13;
+		worker.m_seed ^= worker.m_seed >> 17;
+		worker.m_seed ^= worker.m_seed << 5;
+		const u32 start = worker.m_seed % m_count;
+		for (u32 i = 0; i < m_count; i++) {
+			const u32 victim = (start + i) % m_count;
+			if (victim != worker.m_index && (job = m_workers[victim].m_deque.Steal()) != wfNullPointer)
+				return job;
+		}
+		return wfNullPointer;
+	}
+
+	bool HasWork() const {
+		for (u32 i = 0; i < m_count; i++)
+			if (!m_workers[i].m_deque.Empty())
+				return true;
+		return false;
+	}
+
+	// the fence orders the push before the load of the sleepers: a worker
+	// going to sleep either sees the job when it looks under the lock, or
+	// has registered before and is woken here
+	void Wake() {
+		wfAtomicFence();
+		if (wfAtomicLoadRelaxed(&m_sleepers) == 0)
+			return;
+		wfLockGuard<wfMutex> guard(m_lock);
+		m_wake.NotifyOne();
+	}
+
+	void Sleep() {
+		wfLockGuard<wfMutex> guard(m_lock);
+		wfAtomicFetchAdd(&m_sleepers, 1u);
+		while (!wfAtomicLoad(&m_stop) && !HasWork())
+			m_wake.Wait(m_lock);
+		wfAtomicFetchAdd(&m_sleepers, ~0u);
+	}
+
+	static void Main(void *argument) {
+		Worker      *worker = static_cast<Worker*>(argument);
+		wfJobSystem *system = worker->m_system;
+		u32          spins  = 0;
+
+		Current::s_worker = worker;
+		while (!wfAtomicLoad(&system->m_stop)) {
+			wfPrivate::wfJob *job = system->Find(*worker);
+			if (job) {
+				system->Execute(*worker, job);
+				spins = 0;
+			} else if (++spins < kSpins) {
+				wfCpuRelax();
+			} else {
+				system->Sleep();
+				spins = 0;
+			}
+		}
+		Current::s_worker = wfNullPointer;
+	}
+
+	wfHeap             *m_heap;
+	Worker             *m_workers;
+	u32                 m_count;
+	Worker             *m_previous;
+	wfMutex             m_lock;
+	wfConditionVariable m_wake;
+	volatile u32        m_sleepers;
+	volatile u32        m_stop;
+};
+
+#endif
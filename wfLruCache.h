@@ -0,0 +1,614 @@
+#ifndef WF_STDLIB_LRUCACHE_HDR
+#define WF_STDLIB_LRUCACHE_HDR
+#include "wfHash.h"
+#include "wfNullPointer.h"
+#include "wfThread.h"
+
+/*
+ * File: wfLruCache
+ *  Bounded key-value caches that evict the least recently used entry.
+ *
+ * >#include "wfLruCache.h"
+ *
+ *  Every entry is a single allocation holding the key, the value, the link
+ *  of its hash bucket and the previous and next links of the recency list,
+ *  the same shape as a <wfList> node but embedded rather than pointing
+ *  back at the entry.  Lookups hash into the buckets, the recency list is
+ *  ordered from the most to the least recently used entry, so <Get>,
+ *  <Put> and eviction are all O(1).  The memory of the last evicted entry
+ *  is kept for the next insertion, a full cache therefor stops allocating
+ *  altogether.
+ *
+ *  The capacity is a budget rather than an entry count: every <Put> is
+ *  given the cost of its entry, which is 1 by default (the capacity is
+ *  then the number of entries) or for instance the size of the value in
+ *  bytes.
+ *
+ *  <wfShardedLruCache> spreads the keys over independently locked caches
+ *  for use from many threads.
+ */
+
+/*
+ * Type: wfLruCacheMode
+ *  Selects how a <wfLruCache> keeps track of recency, given as a template
+ *  argument of the cache.
+ *
+ * Values:
+ *   kLruCacheMode_Lru   -- Every hit moves the entry to the front of the
+ *                          recency list, eviction is exact LRU (the default)
+ *   kLruCacheMode_Clock -- A hit only sets a referenced flag in the entry.
+ *                          Eviction takes the entry at the back and gives
+ *                          any entry with the flag set a second chance by
+ *                          clearing it and moving it to the front instead.
+ *                          Hits never write the list, which keeps hot
+ *                          lookups from bouncing list pointers around
+ */
+enum wfLruCacheMode {
+	kLruCacheMode_Lru,
+	kLruCacheMode_Clock
+};
+
+namespace wfPrivate {
+	template <typename K, typename V>
+	struct wfLruCacheEntry {
+		wfLruCacheEntry(const K& key, const V& value, u64 hash, size_t cost) :
+			m_key       (key),
+			m_value     (value),
+			m_hash      (hash),
+			m_cost      (cost),
+			m_chain     (wfNullPointer),
+			m_prev      (wfNullPointer),
+			m_next      (wfNullPointer),
+			m_referenced(false)
+		{ }
+
+		K                m_key;
+		V                m_value;
+		u64              m_hash;
+		size_t           m_cost;
+		wfLruCacheEntry *m_chain;
+		wfLruCacheEntry *m_prev;
+		wfLruCacheEntry *m_next;
+		bool             m_referenced;
+	};
+}
+
+template <typename K, typename V, wfLruCacheMode M, typename H>
+struct wfShardedLruCache;
+
+/*
+ * Class: wfLruCache
+ *  A bounded hashed cache of key-value pairs.
+ *
+ * Parameters:
+ *  K - The key data type to be stored in the <wfLruCache>.
+ *  V - The value data type to be stored in the <wfLruCache>.
+ *  M - The <wfLruCacheMode>, defaults to *kLruCacheMode_Lru*.
+ *  H - The hash function object, called as *H()(key)* returning a *u64*,
+ *      defaults to <wfFunctional::wfHash>.
+ *
+ * Remarks:
+ *  Not safe to use from several threads at once, not even for <Get> which
+ *  updates the recency of the entry; see <wfShardedLruCache>.
+ */
+template <typename K, typename V, wfLruCacheMode M = kLruCacheMode_Lru, typename H = wfFunctional::wfHash<K> >
+struct wfLruCache {
+	/*
+	 * Constructor: wfLruCache
+	 *  Constructs an empty <wfLruCache>.
+	 *
+	 * Parameters:
+	 *  capacity - The budget the costs of all entries must fit in.
+	 */
+	explicit wfLruCache(size_t capacity) :
+		m_buckets (wfNullPointer),
+		m_mask    (0),
+		m_head    (wfNullPointer),
+		m_tail    (wfNullPointer),
+		m_length  (0),
+		m_cost    (0),
+		m_capacity(capacity),
+		m_spare   (wfNullPointer)
+	{
+		Rehash(16);
+	}
+
+	~wfLruCache() {
+		Clear();
+		g_miscHeap.Free(m_buckets);
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of entries in the cache.
+	 */
+	size_t Length  () const { return m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the cache is empty.
+	 */
+	bool   Empty   () const { return m_length == 0; }
+
+	/*
+	 * Function: Cost
+	 *  Returns the sum of the costs of all entries in the cache.
+	 */
+	size_t Cost    () const { return m_cost;        }
+
+	/*
+	 * Function: Capacity
+	 *  Returns the budget the costs of all entries must fit in.
+	 */
+	size_t Capacity() const { return m_capacity;    }
+
+	/*
+	 * Function: Get
+	 *  Looks up the value associated with a key and marks the entry as the
+	 *  most recently used one.
+	 *
+	 * Returns:
+	 *  The address of the value, which is valid until the next <Put>,
+	 *  <Erase> or <Clear>; *wfNullPointer* if the key is not present.
+	 */
+	V *Get(const K& key) {
+		Entry *entry = Find(key, H()(key));
+		if (!entry)
+			return wfNullPointer;
+
+		Touch(entry);
+		return &entry->m_value;
+	}
+
+	/*
+	 * Function: Peek
+	 *  Looks up the value associated with a key without changing its
+	 *  recency.
+	 */
+	const V *Peek(const K& key) const {
+		const Entry *entry = Find(key, H()(key));
+		return entry ? &entry->m_value : wfNullPointer;
+	}
+
+	/*
+	 * Function: Put
+	 *  Associates a value with a key and marks the entry as the most
+	 *  recently used one, evicting the least recently used entries until the
+	 *  costs fit in the capacity.
+	 *
+	 * Parameters:
+	 *  key   - The key to insert, or whose value to replace.
+	 *  value - The value to associate with the key.
+	 *  cost  - The share of the capacity the entry takes, 1 by default.
+	 *
+	 * Returns:
+	 *  *true* if the key was inserted; *false* if its value was replaced.
+	 *
+	 * Remarks:
+	 *  The entry being put is never evicted by its own <Put>, an entry that
+	 *  costs more than the whole capacity therefor stays in the cache alone
+	 *  until the next <Put>.
+	 */
+	bool Put(const K& key, const V& value, size_t cost = 1) {
+		return Put(key, value, cost, H()(key));
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes a key and its value.
+	 *
+	 * Returns:
+	 *  *true* if the key was present; *false* otherwise.
+	 */
+	bool Erase(const K& key) {
+		return Erase(key, H()(key));
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every entry.
+	 */
+	void Clear() {
+		while (m_head) {
+			Entry *next = m_head->m_next;
+			Destroy(m_head);
+			m_head = next;
+		}
+
+		for (size_t i = 0; i <= m_mask; i++)
+			m_buckets[i] = wfNullPointer;
+
+		g_miscHeap.Free(m_spare);
+
+		m_tail   = wfNullPointer;
+		m_length = 0;
+		m_cost   = 0;
+		m_spare  = wfNullPointer;
+	}
+
+	/*
+	 * Function: ForEach
+	 *  Invokes a function on every entry from the most to the least recently
+	 *  used one, as *function(key, value)*.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied.
+	 *
+	 * Remarks:
+	 *  In *kLruCacheMode_Clock* the order is the order of insertion and second
+	 *  chances, hits since are not reflected.
+	 */
+	template <typename F>
+	F ForEach(F function) const {
+		for (const Entry *entry = m_head; entry; entry = entry->m_next)
+			function(static_cast<const K&>(entry->m_key), static_cast<const V&>(entry->m_value));
+		return function;
+	}
+
+private:
+	template <typename, typename, wfLruCacheMode, typename> friend struct wfShardedLruCache;
+
+	typedef wfPrivate::wfLruCacheEntry<K, V> Entry;
+
+	Entry *Find(const K& key, u64 hash) const {
+		for (Entry *entry = m_buckets[hash & m_mask]; entry; entry = entry->m_chain) {
+			if (entry->m_hash == hash && wfFunctional::wfCompare<K, K>()(entry->m_key, key) == 0)
+				return entry;
+		}
+		return wfNullPointer;
+	}
+
+	bool Put(const K& key, const V& value, size_t cost, u64 hash) {
+		Entry *entry = Find(key, hash);
+		if (entry) {
+			entry->m_value = value;
+			m_cost        += cost - entry->m_cost;
+			entry->m_cost  = cost;
+			Touch(entry);
+			Trim(entry);
+			return false;
+		}
+
+		// the key or value may belong to an entry about to be evicted, so
+		// the new entry is built before evicting; it goes into the memory
+		// the previous eviction left behind
+		void *memory = m_spare;
+		if (memory)
+			m_spare = wfNullPointer;
+		else
+			memory = g_miscHeap.Alloc(sizeof(Entry));
+
+		entry = new (memory) Entry(key, value, hash, cost);
+		Link(entry);
+		Trim(entry);
+
+		if (m_length > m_mask + 1)
+			Rehash((m_mask + 1) * 2);
+
+		return true;
+	}
+
+	bool Erase(const K& key, u64 hash) {
+		Entry *entry = Find(key, hash);
+		if (!entry)
+			return false;
+
+		Unlink(entry);
+		Destroy(entry);
+		return true;
+	}
+
+	void Touch(Entry *entry) {
+		if (M == kLruCacheMode_Clock) {
+			entry->m_referenced = true;
+		} else if (entry != m_head) {
+			Detach(entry);
+			Attach(entry);
+		}
+	}
+
+	//
+	// The back of the recency list is the victim; in clock mode entries
+	// referenced since they got there are passed over once instead.
+	//
+	Entry *Victim() {
+		if (M == kLruCacheMode_Clock) {
+			while (m_tail->m_referenced) {
+				Entry *entry = m_tail;
+				entry->m_referenced = false;
+				Detach(entry);
+				Attach(entry);
+			}
+		}
+		return m_tail;
+	}
+
+	void Trim(Entry *keep) {
+		while (m_cost > m_capacity && m_length > 1) {
+			Entry *victim = Victim();
+			if (victim == keep) {
+				// the entry just touched is never the victim, skip over it
+				Detach(keep);
+				Attach(keep);
+				victim = Victim();
+			}
+
+			Unlink(victim);
+			Recycle(victim);
+		}
+	}
+
+	// recency list only
+	void Attach(Entry *entry) {
+		entry->m_prev = wfNullPointer;
+		entry->m_next = m_head;
+		if (m_head)
+			m_head->m_prev = entry;
+		else
+			m_tail = entry;
+		m_head = entry;
+	}
+
+	void Detach(Entry *entry) {
+		if (entry->m_prev)
+			entry->m_prev->m_next = entry->m_next;
+		else
+			m_head = entry->m_next;
+
+		if (entry->m_next)
+			entry->m_next->m_prev = entry->m_prev;
+		else
+			m_tail = entry->m_prev;
+	}
+
+	// recency list, bucket and accounting
+	void Link(Entry *entry) {
+		Entry **bucket  = &m_buckets[entry->m_hash & m_mask];
+		entry->m_chain  = *bucket;
+		*bucket         = entry;
+		Attach(entry);
+		m_length ++;
+		m_cost  += entry->m_cost;
+	}
+
+	void Unlink(Entry *entry) {
+		Entry **link = &m_buckets[entry->m_hash & m_mask];
+		while (*link != entry)
+			link = &(*link)->m_chain;
+
+		*link = entry->m_chain;
+		Detach(entry);
+		m_length --;
+		m_cost  -= entry->m_cost;
+	}
+
+	static void Destroy(Entry *entry) {
+		entry->~Entry();
+		g_miscHeap.Free(entry);
+	}
+
+	// destroys an evicted entry, keeping its memory for the next insertion
+	void Recycle(Entry *entry) {
+		entry->~Entry();
+		if (m_spare)
+			g_miscHeap.Free(entry);
+		else
+			m_spare = entry;
+	}
+
+	void Rehash(size_t count) {
+		Entry **buckets = static_cast<Entry**>(g_miscHeap.Alloc(count * sizeof(Entry*)));
+		for (size_t i = 0; i < count; i++)
+			buckets[i] = wfNullPointer;
+
+		for (Entry *entry = m_head; entry; entry = entry->m_next) {
+			Entry **bucket = &buckets[entry->m_hash & (count - 1)];
+			entry->m_chain = *bucket;
+			*bucket        = entry;
+		}
+
+		g_miscHeap.Free(m_buckets);
+		m_buckets = buckets;
+		m_mask    = count - 1;
+	}
+
+	Entry **m_buckets;
+	size_t  m_mask;
+	Entry  *m_head;
+	Entry  *m_tail;
+	size_t  m_length;
+	size_t  m_cost;
+	size_t  m_capacity;
+	Entry  *m_spare;
+
+	wfLruCache(const wfLruCache&);
+	wfLruCache& operator=(const wfLruCache&);
+};
+
+/*
+ * Class: wfShardedLruCache
+ *  A bounded hashed cache of key-value pairs which is safe to use from any
+ *  number of threads at once.
+ *
+ * Parameters:
+ *  K - The key data type to be stored in the <wfShardedLruCache>.
+ *  V - The value data type to be stored in the <wfShardedLruCache>.
+ *  M - The <wfLruCacheMode>, defaults to *kLruCacheMode_Lru*.
+ *  H - The hash function object, as for <wfLruCache>.
+ *
+ * Remarks:
+ *  Keys are hashed into a power of two number of shards, every shard is a
+ *  <wfLruCache> behind its own <wfMutex> with an equal share of the
+ *  capacity.  Recency and eviction are therefor per shard, which is close
+ *  to global LRU as long as the keys spread evenly.  Values are copied out
+ *  since a pointer into a shard would outlive its lock.
+ */
+template <typename K, typename V, wfLruCacheMode M = kLruCacheMode_Lru, typename H = wfFunctional::wfHash<K> >
+struct wfShardedLruCache {
+	/*
+	 * Constructor: wfShardedLruCache
+	 *  Constructs an empty <wfShardedLruCache>.
+	 *
+	 * Parameters:
+	 *  capacity - The budget the costs of all entries must fit in, divided
+	 *             evenly between the shards.
+	 *  shards   - The number of independently locked shards, rounded up to a
+	 *             power of two.  Defaults to 16.
+	 */
+	explicit wfShardedLruCache(size_t capacity, size_t shards = 16) :
+		m_memory(wfNullPointer),
+		m_shards(wfNullPointer),
+		m_count (1)
+	{
+		while (m_count < shards)
+			m_count <<= 1;
+
+		// every shard starts on its own cache line, as in wfConcurrentMap
+		m_memory = g_miscHeap.Alloc(m_count * ShardSize + CacheLine);
+		m_shards = reinterpret_cast<unsigned char*>(
+			(reinterpret_cast<size_t>(m_memory) + CacheLine - 1) & ~static_cast<size_t>(CacheLine - 1)
+		);
+
+		const size_t share = (capacity + m_count - 1) / m_count;
+		for (size_t i = 0; i < m_count; i++)
+			new (m_shards + i * ShardSize) Shard(share);
+	}
+
+	~wfShardedLruCache() {
+		for (size_t i = 0; i < m_count; i++)
+			ShardAt(i).~Shard();
+
+		g_miscHeap.Free(m_memory);
+	}
+
+	/*
+	 * Function: Get
+	 *  Looks up the value associated with a key and marks the entry as the
+	 *  most recently used one of its shard.
+	 *
+	 * Parameters:
+	 *  key   - The key to look up.
+	 *  value - Receives a copy of the value if the key is present.
+	 *
+	 * Returns:
+	 *  *true* if the key is present; *false* otherwise.
+	 */
+	bool Get(const K& key, V& value) {
+		const u64 hash  = H()(key);
+		Shard    &shard = ShardOf(hash);
+
+		wfLockGuard<wfMutex> guard(shard.m_lock);
+		typename Cache::Entry *entry = shard.m_cache.Find(key, hash);
+		if (!entry)
+			return false;
+
+		shard.m_cache.Touch(entry);
+		value = entry->m_value;
+		return true;
+	}
+
+	/*
+	 * Function: Put
+	 *  Associates a value with a key, see <wfLruCache::Put>.
+	 */
+	bool Put(const K& key, const V& value, size_t cost = 1) {
+		const u64 hash  = H()(key);
+		Shard    &shard = ShardOf(hash);
+
+		wfLockGuard<wfMutex> guard(shard.m_lock);
+		return shard.m_cache.Put(key, value, cost, hash);
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes a key and its value.
+	 *
+	 * Returns:
+	 *  *true* if the key was present; *false* otherwise.
+	 */
+	bool Erase(const K& key) {
+		const u64 hash  = H()(key);
+		Shard    &shard = ShardOf(hash);
+
+		wfLockGuard<wfMutex> guard(shard.m_lock);
+		return shard.m_cache.Erase(key, hash);
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every entry, one shard at a time.
+	 */
+	void Clear() {
+		for (size_t i = 0; i < m_count; i++) {
+			Shard &shard = ShardAt(i);
+			wfLockGuard<wfMutex> guard(shard.m_lock);
+			shard.m_cache.Clear();
+		}
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of entries, a snapshot of a moving target while
+	 *  other threads use the cache.
+	 */
+	size_t Length() const {
+		size_t length = 0;
+		for (size_t i = 0; i < m_count; i++) {
+			Shard &shard = ShardAt(i);
+			wfLockGuard<wfMutex> guard(shard.m_lock);
+			length += shard.m_cache.Length();
+		}
+		return length;
+	}
+
+	/*
+	 * Function: Cost
+	 *  Returns the sum of the costs of all entries, a snapshot of a moving
+	 *  target while other threads use the cache.
+	 */
+	size_t Cost() const {
+		size_t cost = 0;
+		for (size_t i = 0; i < m_count; i++) {
+			Shard &shard = ShardAt(i);
+			wfLockGuard<wfMutex> guard(shard.m_lock);
+			cost += shard.m_cache.Cost();
+		}
+		return cost;
+	}
+
+	/*
+	 * Function: Shards
+	 *  Returns the number of shards.
+	 */
+	size_t Shards() const { return m_count; }
+
+private:
+	typedef wfLruCache<K, V, M, H> Cache;
+
+	struct Shard {
+		explicit Shard(size_t capacity) :
+			m_cache(capacity)
+		{ }
+
+		wfMutex m_lock;
+		Cache   m_cache;
+	};
+
+	enum {
+		CacheLine = 64,
+		ShardSize = (sizeof(Shard) + CacheLine - 1) & ~(CacheLine - 1)
+	};
+
+	// the low bits of the hash pick the bucket, the high bits the shard
+	Shard& ShardOf(u64 hash) const { return ShardAt(static_cast<size_t>(hash >> 40) & (m_count - 1)); }
+	Shard& ShardAt(size_t index) const { return *reinterpret_cast<Shard*>(m_shards + index * ShardSize); }
+
+	void          *m_memory;
+	unsigned char *m_shards;
+	size_t         m_count;
+
+	wfShardedLruCache(const wfShardedLruCache&);
+	wfShardedLruCache& operator=(const wfShardedLruCache&);
+};
+
+#endif
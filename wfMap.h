@@ -5,11 +5,11 @@
 #include "wfPair.h"
 #include "wfFunctional.h"
 
-template <typename T, typename U>
-struct wfMap : wfSet<wfPair<T, U> > {
+template <typename T, typename U, wfSetAugment A = kSetAugment_None>
+struct wfMap : wfSet<wfPair<T, U>, A> {
 private:
-	typedef wfSet<wfPair<T, U> >                Base;
-	typedef wfPrivate::wfSetNode<wfPair<T, U> > Node;
+	typedef wfSet<wfPair<T, U>, A>                 Base;
+	typedef wfPrivate::wfSetNode<wfPair<T, U>, A > Node;
 public:
 
     /*
@@ -19,18 +19,18 @@ public:
      *
      * Remarks:
      *  The *Iterator* defined by *wfMap* points to elements that are
-     *  objects of *wfPair<T, U>*, whos *First* member is the key to the
-     *  element and whose *Second* member is the mapped datum held by the
+     *  objects of *wfPair<T, U>*, whos *first* member is the key to the
+     *  element and whose *second* member is the mapped datum held by the
      *  element.
      *
      *  To dereference an *Iterator* pointing to an element in a *wfMap*,
      *  use the *->* operator.
      *
-     *  To access the value of the key for the element use *Iter->First*,
+     *  To access the value of the key for the element use *Iter->first*,
      *  to access the value of the mapped datum for the element use
-     *  *Iter->Second*.
+     *  *Iter->second*.
      */   
-	typedef wfSetIterator<wfPair<T, U> >        Iterator;
+	typedef wfSetIterator<wfPair<T, U>, A>      Iterator;
 
     /*
      * Type: ConstIterator
@@ -42,18 +42,18 @@ public:
      *  element.
      *  
      *  The *ConstIterator* defined by *wfMap* points to elements that are
-     *  objects of *wfPair<T, U>*, whos *First* member is the key to the
-     *  element and whose *Second* member is the mapped datum held by the
+     *  objects of *wfPair<T, U>*, whos *first* member is the key to the
+     *  element and whose *second* member is the mapped datum held by the
      *  element.
      *
      *  To dereference an *ConstIterator* pointing to an element in a *wfMap*,
      *  use the *->* operator.
      *
-     *  To access the value of the key for the element use *Iter->First*,
+     *  To access the value of the key for the element use *Iter->first*,
      *  to access the value of the mapped datum for the element use
-     *  *Iter->Second*.
+     *  *Iter->second*.
      */  
-	typedef wfSetConstIterator<wfPair<T, U> >   ConstIterator;
+	typedef wfSetConstIterator<wfPair<T, U>, A> ConstIterator;
 
     /*
      * Type: ReverseIterator
@@ -62,16 +62,37 @@ public:
      */    
 	typedef wfReverseIterator<Iterator>         ReverseIterator;
 	typedef wfReverseIterator<ConstIterator>    ConstReverseIterator;
-	
+
+    /*
+     * Type: NodeHandle
+     *  A type that owns a key-value pair removed from a map with
+     *  <wfSet::Extract>, along with the memory of its node.
+     */
+	typedef wfSetNodeHandle<wfPair<T, U>, A>    NodeHandle;
+
 	U& Insert(const T& key, const U& data) {
 		return Base::Insert(
 			Base::m_root,
 			wfPair<T, U>(key, data)
-		)->m_data.Second;
+		)->m_data.second;
 	}
 	
 	U& Insert(const wfPair<T, U>& data) {
-		return Base::Insert(Base::m_root, data)->m_data.Second;
+		return Base::Insert(Base::m_root, data)->m_data.second;
+	}
+
+    /*
+     * Function: Insert
+     *  Links the node owned by a <NodeHandle> into the map, see
+     *  <wfSet::Insert>.
+     *
+     * Returns:
+     *  A reference to the mapped datum of the pair linked, or of the pair
+     *  already in the map under the same key, in which case the handle
+     *  keeps its node.
+     */
+	U& Insert(NodeHandle& handle) {
+		return Base::Insert(handle).second;
 	}
 
     /*
@@ -95,6 +116,12 @@ public:
      *  the return value is assigned to a *Iterator*, the map object
      *  can be modified.
      *
+     *  A key of a type opted in with <wfFunctional::wfTransparentKey>
+     *  is ordered against *T* as it is, which allows for instance a map
+     *  keyed by C strings to be searched with a <wfStringRef> without
+     *  making a temporary key.  A key of any other type is converted to
+     *  *T* first.  The same holds for <Erase>, <Count> and <LowerBound>.
+     *
      * Complexity:
      *   wfMap is implemented with a wfSet, which in turn utilizes
      *   an AA-tree, as such the time complexity for *Find* is:
@@ -102,43 +129,28 @@ public:
      *   Average Case - O(log n)
      *   Worst Cast   - O(n) 
      */       
-	Iterator      Find(const T& key)       { return Iterator     (m_find(Base::m_root, key)); }
-	ConstIterator Find(const T& key) const { return ConstIterator(m_find(Base::m_root, key)); }
-
-    void Erase(const T& key) {
-
-		Iterator findResultIter	= Find( key );
-
-		if( findResultIter == Base::End() )
-		{
-			return;
-		}		 
+	template <typename K> Iterator      Find(const K& key)       { return Iterator     (Base::FindNode(Base::Probe(key))); }
+	template <typename K> ConstIterator Find(const K& key) const { return ConstIterator(Base::FindNode(Base::Probe(key))); }
 
-		wfPair<T, U>  pairToErase(findResultIter->First, findResultIter->Second);
-
-		Base::Erase( pairToErase );
-    }
+    /*
+     * Function: Erase
+     *  Removes the element with the specified key from the map, if
+     *  there is one.
+     *
+     * Parameters:
+     *  key - The key of the element to be removed from the map.
+     */
+	template <typename K>
+	void Erase(const K& key) {
+		Base::Erase(key);
+	}
     
 	U& operator[](const T& key) {
-		return m_find(Base::m_root, key, true)->m_data.Second;
-	}
-protected:
-	Node *m_find(Node *node, const T& key, bool insert=false) {
-        if (node == Base::m_nil) {
-            if (insert)
-                return Base::Insert(Base::m_root, wfPair<T, U>(key, U()));
-            else
-                return Base::m_nil;
-        }
+		Node *node = Base::FindNode(key);
+		if (node == Base::m_nil)
+			node = Base::Insert(Base::m_root, wfPair<T, U>(key, U()));
 
-        if (!wfFunctional::wfEqual<T, T>()(key, node->m_data.First)) {
-            return m_find((
-                (wfFunctional::wfLess<T, T>()(key, node->m_data.First))
-                    ? node->m_left
-                    : node->m_right
-                ), key, insert);
-        }
-        return node;
+		return node->m_data.second;
 	}
 };
 #endif
@@ -0,0 +1,244 @@
+#ifndef WF_STDLIB_MPSCQUEUE_HDR
+#define WF_STDLIB_MPSCQUEUE_HDR
+#include "wfAtomic.h"
+#include "wfNullPointer.h"
+
+/*
+ * File: wfMpscQueue
+ *  A lock-free intrusive queue for many producers and a single consumer.
+ *
+ * >#include "wfMpscQueue.h"
+ *
+ *  Dmitry Vyukov's intrusive MPSC queue.  Like <wfIntrusiveList> every item
+ *  embeds a node which is passed the pointer to the item, so pushing needs
+ *  no allocation.  A push is a single atomic exchange of the head followed
+ *  by a store, it never waits and never retries however many threads push
+ *  at once.  Popping is done by one thread at a time only and takes no
+ *  atomic read-modify-write at all.
+ *
+ *  Between the exchange and the store of a push the node is not reachable
+ *  from the tail yet; a pop that runs into such a node reports the queue
+ *  as empty even though it is not, the item appears once the producer
+ *  completes its push a few instructions later.
+ */
+
+namespace wfPrivate {
+	enum {
+		wfMpscQueueCacheLine = 64
+	};
+
+	struct wfMpscLink {
+		wfMpscLink *volatile m_next;
+	};
+}
+
+/*
+ * Class: wfMpscQueueNode
+ *  The node every item in a <wfMpscQueue> has as a member.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  A node can be in one queue at a time, and must not be pushed again or
+ *  destroyed until it has been popped.
+ */
+template <typename T>
+struct wfMpscQueueNode : private wfPrivate::wfMpscLink {
+	wfMpscQueueNode() :
+		m_item(wfNullPointer)
+	{
+		m_next = wfNullPointer;
+	}
+
+	explicit wfMpscQueueNode(T *item) :
+		m_item(item)
+	{
+		m_next = wfNullPointer;
+	}
+
+	/*
+	 * Function: Init
+	 *  Sets the item of a node constructed without one.
+	 */
+	void Init(T *item) { m_item = item; }
+
+	/*
+	 * Function: GetItem
+	 *  Returns the item of the node.
+	 */
+	T *GetItem() const { return m_item; }
+
+private:
+	template <typename> friend struct wfMpscQueue;
+
+	T *m_item;
+
+	wfMpscQueueNode(const wfMpscQueueNode&);
+	wfMpscQueueNode& operator=(const wfMpscQueueNode&);
+};
+
+/*
+ * Class: wfMpscQueue
+ *  An unbounded first-in first-out queue of items that embed a
+ *  <wfMpscQueueNode>.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  <Push> is safe from any number of threads at once.  <Pop>, <PopBatch>,
+ *  <Drain> and <Empty> must only be called from one thread at a time, the
+ *  consumer.  The queue owns none of its items.
+ */
+template <typename T>
+struct wfMpscQueue {
+	typedef wfMpscQueueNode<T> Node;
+
+	wfMpscQueue() :
+		m_head(&m_stub),
+		m_tail(&m_stub)
+	{
+		m_stub.m_next = wfNullPointer;
+	}
+
+	/*
+	 * Function: Push
+	 *  Adds a node at the back of the queue, wait-free.
+	 */
+	void Push(Node *node) {
+		wfPrivate::wfMpscLink *link = node;
+		wfAtomicStoreRelaxed(&link->m_next, static_cast<wfPrivate::wfMpscLink*>(wfNullPointer));
+		Link(link, link);
+	}
+
+	/*
+	 * Function: Push
+	 *  Adds a run of nodes at the back of the queue with a single exchange,
+	 *  they are popped in the order given.
+	 *
+	 * Parameters:
+	 *  nodes - The nodes to push.
+	 *  count - The number of nodes.
+	 */
+	void Push(Node *const *nodes, size_t count) {
+		if (count == 0)
+			return;
+		for (size_t i = 0; i + 1 < count; i++)
+			static_cast<wfPrivate::wfMpscLink*>(nodes[i])->m_next = nodes[i + 1];
+		wfPrivate::wfMpscLink *last = nodes[count - 1];
+		wfAtomicStoreRelaxed(&last->m_next, static_cast<wfPrivate::wfMpscLink*>(wfNullPointer));
+		Link(nodes[0], last);
+	}
+
+	/*
+	 * Function: Pop
+	 *  Removes the node at the front of the queue.
+	 *
+	 * Returns:
+	 *  The item of the node, or *wfNullPointer* if the queue is empty or the
+	 *  node at the front is still being pushed.
+	 */
+	T *Pop() {
+		wfPrivate::wfMpscLink *tail = m_tail;
+		wfPrivate::wfMpscLink *next = wfAtomicLoad(&tail->m_next);
+
+		// step over the stub, it only keeps the queue from running empty
+		if (tail == &m_stub) {
+			if (!next)
+				return wfNullPointer;
+			m_tail = tail = next;
+			next   = wfAtomicLoad(&tail->m_next);
+		}
+
+		if (next) {
+			m_tail = next;
+			return static_cast<Node*>(tail)->m_item;
+		}
+
+		// the tail is the last node pushed, or a push is in progress
+		if (tail != wfAtomicLoad(&m_head))
+			return wfNullPointer;
+
+		// put the stub back behind the tail so that it can be taken
+		m_stub.m_next = wfNullPointer;
+		Link(&m_stub, &m_stub);
+
+		next = wfAtomicLoad(&tail->m_next);
+		if (next) {
+			m_tail = next;
+			return static_cast<Node*>(tail)->m_item;
+		}
+		return wfNullPointer;
+	}
+
+	/*
+	 * Function: PopBatch
+	 *  Removes up to a number of nodes from the front of the queue.
+	 *
+	 * Parameters:
+	 *  items - Receives the items of the nodes removed, in order.
+	 *  count - The most nodes to remove.
+	 *
+	 * Returns:
+	 *  The number of nodes removed.
+	 */
+	size_t PopBatch(T **items, size_t count) {
+		size_t popped = 0;
+		while (popped < count) {
+			T *item = Pop();
+			if (!item)
+				break;
+			items[popped++] = item;
+		}
+		return popped;
+	}
+
+	/*
+	 * Function: Drain
+	 *  Removes every node that can be removed, invoking a function on the
+	 *  item of each as *function(item)* with a pointer to the item.
+	 *
+	 * Returns:
+	 *  The number of nodes removed.
+	 *
+	 * Remarks:
+	 *  The node of an item is out of the queue by the time the function is
+	 *  invoked on it, the function may push it again or destroy it.
+	 */
+	template <typename F>
+	size_t Drain(F function) {
+		size_t popped = 0;
+		for (T *item; (item = Pop()) != wfNullPointer; popped++)
+			function(item);
+		return popped;
+	}
+
+	/*
+	 * Function: Empty
+	 *  Tests if the queue is empty, as seen by the consumer.
+	 */
+	bool Empty() const {
+		return m_tail == &m_stub && wfAtomicLoad(&m_stub.m_next) == wfNullPointer;
+	}
+
+private:
+	// appends the already chained nodes [first, last]
+	void Link(wfPrivate::wfMpscLink *first, wfPrivate::wfMpscLink *last) {
+		wfPrivate::wfMpscLink *prev = wfAtomicExchange(&m_head, last);
+		wfAtomicStore(&prev->m_next, first);
+	}
+
+	// producers hammer the head, the consumer owns the tail: keep them on
+	// separate cache lines
+	wfPrivate::wfMpscLink *volatile m_head;
+	char                            m_padHead[wfPrivate::wfMpscQueueCacheLine - sizeof(void*)];
+	wfPrivate::wfMpscLink          *m_tail;
+	wfPrivate::wfMpscLink           m_stub;
+	char                            m_padTail[wfPrivate::wfMpscQueueCacheLine - 2 * sizeof(void*)];
+
+	wfMpscQueue(const wfMpscQueue&);
+	wfMpscQueue& operator=(const wfMpscQueue&);
+};
+
+#endif
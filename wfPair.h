@@ -40,6 +40,9 @@ struct wfPair {
         second(p.second)
     { }
 
-    wfPair(const 
+    wfPair(const wfPair& p) :
+        first(p.first),
+        second(p.second)
+    { }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,376 @@
+#ifndef WF_STDLIB_PERSISTENTMAP_HDR
+#define WF_STDLIB_PERSISTENTMAP_HDR
+#include "wfAlgorithm.h"
+#include "wfAtomic.h"
+#include "wfFunctional.h"
+#include "wfNullPointer.h"
+#include "wfPair.h"
+
+/*
+ * File: wfPersistentMap
+ *  An immutable ordered map whose versions share structure.
+ *
+ * >#include "wfPersistentMap.h"
+ *
+ *  <wfPersistentMap> is an AA tree, like <wfMap>, whose nodes are never
+ *  modified once another version can see them.  <wfPersistentMap::Insert>
+ *  and <wfPersistentMap::Erase> leave the map they are called on alone and
+ *  return a new version, which copies only the O(log n) nodes on the path
+ *  to the change and shares every other node with the original.  Copying a
+ *  map is O(1), it just takes another reference to the root.
+ *
+ *  Nodes are reference counted with atomic counts and allocated from the
+ *  library heap, a node is freed when the last version containing it is
+ *  destroyed.  Versions can therefor be handed to other threads freely: a
+ *  snapshot taken on one thread can be serialized on another while the
+ *  first keeps updating its own version.  A single <wfPersistentMap>
+ *  object is not itself safe to modify from two threads at once.
+ */
+
+namespace wfPrivate {
+	template <typename K, typename V>
+	struct wfPersistentMapNode {
+		wfPersistentMapNode(const wfPair<K, V>& data, size_t level, wfPersistentMapNode *left, wfPersistentMapNode *right) :
+			m_data (data),
+			m_left (left),
+			m_right(right),
+			m_level(level),
+			m_refs (1)
+		{ }
+
+		wfPair<K, V>         m_data;
+		wfPersistentMapNode *m_left;
+		wfPersistentMapNode *m_right;
+		size_t               m_level;
+		volatile u32         m_refs;
+	};
+}
+
+/*
+ * Class: wfPersistentMap
+ *  An immutable ordered map of key-value pairs with O(1) snapshots.
+ *
+ * Parameters:
+ *  K - The key data type to be stored in the <wfPersistentMap>.
+ *  V - The value data type to be stored in the <wfPersistentMap>.
+ */
+template <typename K, typename V>
+struct wfPersistentMap {
+	wfPersistentMap() :
+		m_root  (wfNullPointer),
+		m_length(0)
+	{ }
+
+	/*
+	 * Constructor: wfPersistentMap
+	 *  Takes a snapshot of another map in O(1).
+	 */
+	wfPersistentMap(const wfPersistentMap& map) :
+		m_root  (Retain(map.m_root)),
+		m_length(map.m_length)
+	{ }
+
+	~wfPersistentMap() {
+		Release(m_root);
+	}
+
+	wfPersistentMap& operator=(const wfPersistentMap& map) {
+		Node *root = Retain(map.m_root);
+		Release(m_root);
+		m_root   = root;
+		m_length = map.m_length;
+		return *this;
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of pairs in the map.
+	 */
+	size_t Length() const { return m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the map is empty.
+	 */
+	bool   Empty () const { return m_length == 0; }
+
+	/*
+	 * Function: Insert
+	 *  Returns a version of the map with a key associated with a value.
+	 *
+	 * Parameters:
+	 *  key   - The key to insert, or whose value to replace.
+	 *  value - The value to associate with the key.
+	 *
+	 * Returns:
+	 *  The new version.  The map the function is called on is unchanged.
+	 *
+	 * Remarks:
+	 *  Allocates O(log n) nodes.  To update a map in place assign the result
+	 *  back, *map = map.Insert(key, value)*, the nodes only the old version
+	 *  used are freed by the assignment.
+	 */
+	wfPersistentMap Insert(const K& key, const V& value) const {
+		bool inserted = false;
+		Node *root = Insert(Retain(m_root), wfPair<K, V>(key, value), inserted);
+		return wfPersistentMap(root, m_length + (inserted ? 1 : 0));
+	}
+
+	/*
+	 * Function: Erase
+	 *  Returns a version of the map without a key.
+	 *
+	 * Returns:
+	 *  The new version, which shares the root of this one if the key is not
+	 *  present.  The map the function is called on is unchanged.
+	 */
+	template <typename U>
+	wfPersistentMap Erase(const U& key) const {
+		typename wfPrivate::wfLookupKey<U, K>::Type probe = Probe(key);
+		if (!FindNode(probe))
+			return *this;
+
+		return wfPersistentMap(Erase(Retain(m_root), probe), m_length - 1);
+	}
+
+	/*
+	 * Function: Find
+	 *  Returns the address of the value associated with a key, or
+	 *  *wfNullPointer* when the key is not present.
+	 *
+	 * Remarks:
+	 *  The value is valid for as long as any version containing it is.  A key
+	 *  of another type than *K* is converted to it first, unless
+	 *  <wfFunctional::wfTransparentKey> opts it in, the same holds for <Count>
+	 *  and <Erase>.
+	 */
+	template <typename U>
+	const V *Find(const U& key) const {
+		const Node *node = FindNode(Probe(key));
+		return node ? &node->m_data.second : wfNullPointer;
+	}
+
+	/*
+	 * Function: Count
+	 *  Returns 1 if the key is present; 0 otherwise.
+	 */
+	template <typename U>
+	size_t Count(const U& key) const {
+		return FindNode(Probe(key)) ? 1 : 0;
+	}
+
+	/*
+	 * Function: ForEach
+	 *  Invokes a function on every pair in key order, as
+	 *  *function(key, value)*.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied.
+	 */
+	template <typename F>
+	F ForEach(F function) const {
+		ForEach(m_root, function);
+		return function;
+	}
+
+	/*
+	 * Function: Shares
+	 *  Tests if two versions share their root, which is the case for a
+	 *  snapshot that neither side has changed since.
+	 */
+	bool Shares(const wfPersistentMap& map) const { return m_root == map.m_root; }
+
+private:
+	typedef wfPrivate::wfPersistentMapNode<K, V> Node;
+
+	wfPersistentMap(Node *root, size_t length) :
+		m_root  (root),
+		m_length(length)
+	{ }
+
+	template <typename U>
+	static int Compare(const U& key, const Node *node) {
+		return wfFunctional::wfCompare<U, K>()(key, node->m_data.first);
+	}
+
+	// the key a lookup searches the tree with, see wfPrivate::wfLookupKey
+	template <typename U>
+	static typename wfPrivate::wfLookupKey<U, K>::Type Probe(const U& key) {
+		return key;
+	}
+
+	static size_t Level(const Node *node) { return node ? node->m_level : 0; }
+
+	static Node *Retain(Node *node) {
+		if (node)
+			wfAtomicFetchAdd(&node->m_refs, 1u);
+		return node;
+	}
+
+	static void Release(Node *node) {
+		while (node && wfAtomicFetchAdd(&node->m_refs, ~0u) == 1) {
+			Node *right = node->m_right;
+			Release(node->m_left);
+			node->~Node();
+			g_miscHeap.Free(node);
+
+			// right spine is a loop rather than recursion
+			node = right;
+		}
+	}
+
+	static Node *Create(const wfPair<K, V>& data, size_t level, Node *left, Node *right) {
+		return new (g_miscHeap.Alloc(sizeof(Node))) Node(data, level, left, right);
+	}
+
+	//
+	// Every function below takes a node reference it owns and returns an
+	// owned reference.  A node only this version references is modified in
+	// place, a shared one is copied first (taking references to its
+	// children) and the reference to the original is dropped.
+	//
+	static Node *Mutable(Node *node) {
+		if (wfAtomicLoad(&node->m_refs) == 1)
+			return node;
+
+		Node *copy = Create(node->m_data, node->m_level, Retain(node->m_left), Retain(node->m_right));
+		Release(node);
+		return copy;
+	}
+
+	static bool NeedsSkew(const Node *node) {
+		return node && node->m_left && node->m_left->m_level == node->m_level;
+	}
+
+	static bool NeedsSplit(const Node *node) {
+		return node && node->m_right && node->m_right->m_right && node->m_right->m_right->m_level == node->m_level;
+	}
+
+	static Node *Skew(Node *node) {
+		if (!NeedsSkew(node))
+			return node;
+
+		node = Mutable(node);
+		Node *left    = Mutable(node->m_left);
+		node->m_left  = left->m_right;
+		left->m_right = node;
+		return left;
+	}
+
+	static Node *Split(Node *node) {
+		if (!NeedsSplit(node))
+			return node;
+
+		node = Mutable(node);
+		Node *right    = Mutable(node->m_right);
+		node->m_right  = right->m_left;
+		right->m_left  = node;
+		right->m_level = right->m_level + 1;
+		return right;
+	}
+
+	static Node *Insert(Node *node, const wfPair<K, V>& data, bool& inserted) {
+		if (!node) {
+			inserted = true;
+			return Create(data, 1, wfNullPointer, wfNullPointer);
+		}
+
+		const int compare = Compare(data.first, node);
+		node = Mutable(node);
+		if (compare == 0) {
+			node->m_data.second = data.second;
+			return node;
+		}
+
+		if (compare < 0)
+			node->m_left  = Insert(node->m_left,  data, inserted);
+		else
+			node->m_right = Insert(node->m_right, data, inserted);
+
+		return Split(Skew(node));
+	}
+
+	//
+	// The key is known to be present, every node on the path is therefor
+	// going to change and is made mutable on the way down.
+	//
+	template <typename U>
+	static Node *Erase(Node *node, const U& key) {
+		const int compare = Compare(key, node);
+		if (compare == 0 && (!node->m_left || !node->m_right)) {
+			Node *child = Retain(node->m_left ? node->m_left : node->m_right);
+			Release(node);
+			return child;
+		}
+
+		node = Mutable(node);
+		if (compare == 0) {
+			const Node *heir = node->m_left;
+			while (heir->m_right)
+				heir = heir->m_right;
+
+			node->m_data = heir->m_data;
+			node->m_left = Erase(node->m_left, node->m_data.first);
+		} else if (compare < 0) {
+			node->m_left  = Erase(node->m_left,  key);
+		} else {
+			node->m_right = Erase(node->m_right, key);
+		}
+
+		return Rebalance(node);
+	}
+
+	static Node *Rebalance(Node *node) {
+		const size_t level = wfMin(Level(node->m_left), Level(node->m_right)) + 1;
+		if (level >= node->m_level)
+			return node;
+
+		node->m_level = level;
+		if (Level(node->m_right) > level) {
+			node->m_right = Mutable(node->m_right);
+			node->m_right->m_level = level;
+		}
+
+		node = Skew(node);
+		if (NeedsSkew(node->m_right))
+			node->m_right = Skew(node->m_right);
+		if (node->m_right && NeedsSkew(node->m_right->m_right)) {
+			node->m_right = Mutable(node->m_right);
+			node->m_right->m_right = Skew(node->m_right->m_right);
+		}
+
+		node = Split(node);
+		if (NeedsSplit(node->m_right)) {
+			node = Mutable(node);
+			node->m_right = Split(node->m_right);
+		}
+
+		return node;
+	}
+
+	template <typename U>
+	const Node *FindNode(const U& key) const {
+		const Node *node = m_root;
+		while (node) {
+			const int compare = Compare(key, node);
+			if (compare == 0)
+				break;
+			node = (compare < 0) ? node->m_left : node->m_right;
+		}
+		return node;
+	}
+
+	template <typename F>
+	static void ForEach(const Node *node, F& function) {
+		while (node) {
+			ForEach(node->m_left, function);
+			function(static_cast<const K&>(node->m_data.first), static_cast<const V&>(node->m_data.second));
+			node = node->m_right;
+		}
+	}
+
+	Node  *m_root;
+	size_t m_length;
+};
+
+#endif
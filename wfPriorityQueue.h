@@ -0,0 +1,600 @@
+#ifndef WF_STDLIB_PRIORITYQUEUE_HDR
+#define WF_STDLIB_PRIORITYQUEUE_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+#include "wfFunctional.h"
+
+/*
+ * File: wfPriorityQueue
+ *  Priority queues.
+ *
+ * >#include "wfPriorityQueue.h"
+ *
+ *  <wfPriorityQueue> is an array-backed 4-ary heap of copies of elements,
+ *  every element pushed is given a handle through which its key can later
+ *  be changed or the element removed.  A 4-ary heap is half as deep as a
+ *  binary heap and the four children of a node are next to each other in
+ *  memory, a pop compares more but misses the cache less.
+ *
+ *  <wfPairingHeap> is an intrusive pairing heap over items that embed a
+ *  <wfPairingHeapNode>, like <wfIntrusiveList>.  Pushing and merging two
+ *  heaps are O(1), popping is O(log n) amortized, and it never allocates.
+ *
+ *  Both order elements by a comparison *C* which returns *true* when its
+ *  first argument is to be popped before its second, by default the
+ *  smallest element comes first.
+ */
+
+/*
+ * Type: wfPriorityQueueHandle
+ *  The handle of an element in a <wfPriorityQueue>.
+ */
+typedef u32 wfPriorityQueueHandle;
+
+namespace wfPrivate {
+	template <typename T>
+	struct wfPriorityQueueEntry {
+		wfPriorityQueueEntry(const T& value, u32 handle) :
+			m_value (value),
+			m_handle(handle)
+		{ }
+
+		T   m_value;
+		u32 m_handle;
+	};
+}
+
+/*
+ * Class: wfPriorityQueue
+ *  A 4-ary heap with O(log n) pop and O(1) push on average, with handles
+ *  for changing the key of an element.
+ *
+ * Parameters:
+ *  T - The element data type.
+ *  C - The comparison, *true* when the first element comes first.
+ *
+ * Remarks:
+ *  A handle is valid from the <Push> that returns it until its element is
+ *  popped or erased, after which it is handed out again.  Pushing elements
+ *  in random order moves each up by a constant number of levels on
+ *  average; pushing in the order they are popped is the worst case, each
+ *  climbs to the root.
+ */
+template <typename T, typename C = wfFunctional::wfLess<T, T> >
+struct wfPriorityQueue {
+	explicit wfPriorityQueue(const C& compare = C(), wfHeap *heap = &g_miscHeap) :
+		m_compare  (compare),
+		m_heap     (heap),
+		m_entries  (wfNullPointer),
+		m_length   (0),
+		m_capacity (0),
+		m_positions(wfNullPointer),
+		m_free     (kNoHandle)
+	{ }
+
+	~wfPriorityQueue() {
+		for (size_t i = 0; i < m_length; i++)
+			m_entries[i].~Entry();
+
+		m_heap->Free(m_entries);
+		m_heap->Free(m_positions);
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of elements in the queue.
+	 */
+	size_t Length() const { return m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the queue is empty.
+	 */
+	bool   Empty () const { return m_length == 0; }
+
+	/*
+	 * Function: Top
+	 *  Returns the element that comes first, the queue must not be empty.
+	 */
+	const T& Top() const { return m_entries[0].m_value; }
+
+	/*
+	 * Function: TopHandle
+	 *  Returns the handle of the element that comes first.
+	 */
+	wfPriorityQueueHandle TopHandle() const { return m_entries[0].m_handle; }
+
+	/*
+	 * Function: Get
+	 *  Returns the element of a handle.
+	 */
+	const T& Get(wfPriorityQueueHandle handle) const { return m_entries[m_positions[handle]].m_value; }
+
+	/*
+	 * Function: Push
+	 *  Adds a copy of an element.
+	 *
+	 * Returns:
+	 *  The handle of the element.
+	 */
+	wfPriorityQueueHandle Push(const T& value) {
+		if (m_length == m_capacity) {
+			// the value may be an element of the queue, which growing frees
+			const T copy(value);
+			Reserve(m_capacity ? m_capacity * 2 : 16);
+			return Push(copy);
+		}
+
+		const u32 handle = m_free;
+		m_free = m_positions[handle];
+
+		new (&m_entries[m_length]) Entry(value, handle);
+		m_positions[handle] = static_cast<u32>(m_length);
+		SiftUp(m_length++);
+		return handle;
+	}
+
+	/*
+	 * Function: Pop
+	 *  Removes the element that comes first, the queue must not be empty.
+	 */
+	void Pop() {
+		EraseAt(0);
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes the element of a handle.
+	 */
+	void Erase(wfPriorityQueueHandle handle) {
+		EraseAt(m_positions[handle]);
+	}
+
+	/*
+	 * Function: Update
+	 *  Replaces the element of a handle with one that may come earlier or
+	 *  later, and moves it to its new place.
+	 */
+	void Update(wfPriorityQueueHandle handle, const T& value) {
+		const size_t position = m_positions[handle];
+		const bool   earlier  = m_compare(value, m_entries[position].m_value);
+		m_entries[position].m_value = value;
+		if (earlier)
+			SiftUp(position);
+		else
+			SiftDown(position);
+	}
+
+	/*
+	 * Function: DecreaseKey
+	 *  Replaces the element of a handle with one that comes no later, which
+	 *  only ever moves it towards the top.
+	 */
+	void DecreaseKey(wfPriorityQueueHandle handle, const T& value) {
+		const size_t position = m_positions[handle];
+		m_entries[position].m_value = value;
+		SiftUp(position);
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every element, every handle becomes invalid.
+	 */
+	void Clear() {
+		while (m_length) {
+			m_length --;
+			Release(m_entries[m_length].m_handle);
+			m_entries[m_length].~Entry();
+		}
+	}
+
+	/*
+	 * Function: Reserve
+	 *  Makes room for a number of elements.
+	 */
+	void Reserve(size_t capacity) {
+		if (capacity <= m_capacity)
+			return;
+
+		Entry *entries   = static_cast<Entry*>(m_heap->Alloc(capacity * sizeof(Entry)));
+		u32   *positions = static_cast<u32*>(m_heap->Alloc(capacity * sizeof(u32)));
+
+		for (size_t i = 0; i < m_length; i++) {
+			new (&entries[i]) Entry(m_entries[i]);
+			m_entries[i].~Entry();
+		}
+		if (m_capacity)
+			memcpy(positions, m_positions, m_capacity * sizeof(u32));
+
+		// the new handles go on the free list in order
+		for (size_t i = capacity; i-- > m_capacity; ) {
+			positions[i] = m_free;
+			m_free       = static_cast<u32>(i);
+		}
+
+		m_heap->Free(m_entries);
+		m_heap->Free(m_positions);
+
+		m_entries   = entries;
+		m_positions = positions;
+		m_capacity  = capacity;
+	}
+
+private:
+	typedef wfPrivate::wfPriorityQueueEntry<T> Entry;
+
+	enum {
+		kArity    = 4,
+		kNoHandle = 0xFFFFFFFFu
+	};
+
+	void Release(u32 handle) {
+		m_positions[handle] = m_free;
+		m_free              = handle;
+	}
+
+	void EraseAt(size_t position) {
+		Release(m_entries[position].m_handle);
+
+		const size_t last = --m_length;
+		if (position != last) {
+			m_entries[position] = m_entries[last];
+			m_positions[m_entries[position].m_handle] = static_cast<u32>(position);
+		}
+		m_entries[last].~Entry();
+
+		if (position != last) {
+			// the element moved in from the bottom can belong above or below
+			if (position > 0 && m_compare(m_entries[position].m_value, m_entries[(position - 1) / kArity].m_value))
+				SiftUp(position);
+			else
+				SiftDown(position);
+		}
+	}
+
+	// the element at a position is moved up past every parent it comes
+	// before, the parents move down into the hole on the way
+	void SiftUp(size_t position) {
+		if (position == 0)
+			return;
+
+		Entry entry(m_entries[position]);
+		while (position > 0) {
+			const size_t parent = (position - 1) / kArity;
+			if (!m_compare(entry.m_value, m_entries[parent].m_value))
+				break;
+			Place(position, m_entries[parent]);
+			position = parent;
+		}
+		Place(position, entry);
+	}
+
+	void SiftDown(size_t position) {
+		Entry entry(m_entries[position]);
+		for (;;) {
+			const size_t first = position * kArity + 1;
+			if (first >= m_length)
+				break;
+
+			const size_t end  = first + kArity < m_length ? first + kArity : m_length;
+			size_t       best = first;
+			for (size_t child = first + 1; child < end; child++)
+				if (m_compare(m_entries[child].m_value, m_entries[best].m_value))
+					best = child;
+
+			if (!m_compare(m_entries[best].m_value, entry.m_value))
+				break;
+			Place(position, m_entries[best]);
+			position = best;
+		}
+		Place(position, entry);
+	}
+
+	void Place(size_t position, const Entry& entry) {
+		m_entries[position] = entry;
+		m_positions[entry.m_handle] = static_cast<u32>(position);
+	}
+
+	C       m_compare;
+	wfHeap *m_heap;
+	Entry  *m_entries;
+	size_t  m_length;
+	size_t  m_capacity;
+	u32    *m_positions; // position of the element of a handle, or the next free handle
+	u32     m_free;
+
+	wfPriorityQueue(const wfPriorityQueue&);
+	wfPriorityQueue& operator=(const wfPriorityQueue&);
+};
+
+namespace wfPrivate {
+	struct wfPairingHeapLink {
+		wfPairingHeapLink *m_child;
+		wfPairingHeapLink *m_sibling;
+		wfPairingHeapLink *m_prev;    // the parent of a first child, else the previous sibling
+	};
+}
+
+/*
+ * Class: wfPairingHeapNode
+ *  The node every item in a <wfPairingHeap> has as a member.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  A node can be in one heap at a time.
+ */
+template <typename T>
+struct wfPairingHeapNode : private wfPrivate::wfPairingHeapLink {
+	wfPairingHeapNode() :
+		m_item(wfNullPointer)
+	{
+		Reset();
+	}
+
+	explicit wfPairingHeapNode(T *item) :
+		m_item(item)
+	{
+		Reset();
+	}
+
+	/*
+	 * Function: Init
+	 *  Sets the item of a node constructed without one.
+	 */
+	void Init(T *item) { m_item = item; }
+
+	/*
+	 * Function: GetItem
+	 *  Returns the item of the node.
+	 */
+	T *GetItem() const { return m_item; }
+
+	/*
+	 * Function: IsLinked
+	 *  Tests if the node is in a heap.
+	 */
+	bool IsLinked() const { return m_prev != wfNullPointer; }
+
+private:
+	template <typename, typename> friend struct wfPairingHeap;
+
+	void Reset() {
+		m_child   = wfNullPointer;
+		m_sibling = wfNullPointer;
+		m_prev    = wfNullPointer;
+	}
+
+	T *m_item;
+
+	wfPairingHeapNode(const wfPairingHeapNode&);
+	wfPairingHeapNode& operator=(const wfPairingHeapNode&);
+};
+
+/*
+ * Class: wfPairingHeap
+ *  An intrusive pairing heap of items that embed a <wfPairingHeapNode>.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *  C - The comparison of two items, *true* when the first comes first.
+ *
+ * Remarks:
+ *  The heap owns none of its items.  The key of an item in the heap may
+ *  only change through <DecreaseKey>, or by removing the item, changing it
+ *  and pushing it again.
+ */
+template <typename T, typename C = wfFunctional::wfLess<T, T> >
+struct wfPairingHeap {
+	typedef wfPairingHeapNode<T> Node;
+
+	explicit wfPairingHeap(const C& compare = C()) :
+		m_compare(compare),
+		m_root   (wfNullPointer),
+		m_length (0)
+	{
+		m_anchor.m_child   = wfNullPointer;
+		m_anchor.m_sibling = wfNullPointer;
+		m_anchor.m_prev    = wfNullPointer;
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of items in the heap.
+	 */
+	size_t Length() const { return m_length;             }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the heap is empty.
+	 */
+	bool   Empty () const { return m_root == wfNullPointer; }
+
+	/*
+	 * Function: Top
+	 *  Returns the item that comes first, or *wfNullPointer* if the heap is
+	 *  empty.
+	 */
+	T *Top() const { return m_root ? Item(m_root) : wfNullPointer; }
+
+	/*
+	 * Function: Push
+	 *  Adds a node, in O(1).
+	 */
+	void Push(Node *node) {
+		wfPrivate::wfPairingHeapLink *link = node;
+		link->m_child   = wfNullPointer;
+		link->m_sibling = wfNullPointer;
+		SetRoot(m_root ? Meld(m_root, link) : link);
+		m_length ++;
+	}
+
+	/*
+	 * Function: Pop
+	 *  Removes the node that comes first.
+	 *
+	 * Returns:
+	 *  The item of the node, or *wfNullPointer* if the heap is empty.
+	 */
+	T *Pop() {
+		if (!m_root)
+			return wfNullPointer;
+
+		wfPrivate::wfPairingHeapLink *root = m_root;
+		SetRoot(MergePairs(root->m_child));
+		Detach(root);
+		m_length --;
+		return Item(root);
+	}
+
+	/*
+	 * Function: DecreaseKey
+	 *  Moves a node towards the top after the key of its item was changed
+	 *  to come no later than before, in O(1).
+	 */
+	void DecreaseKey(Node *node) {
+		wfPrivate::wfPairingHeapLink *link = node;
+		if (link == m_root)
+			return;
+		Cut(link);
+		SetRoot(Meld(m_root, link));
+	}
+
+	/*
+	 * Function: Remove
+	 *  Removes any node in the heap.
+	 */
+	void Remove(Node *node) {
+		wfPrivate::wfPairingHeapLink *link = node;
+		if (link == m_root) {
+			Pop();
+			return;
+		}
+
+		Cut(link);
+		wfPrivate::wfPairingHeapLink *children = MergePairs(link->m_child);
+		if (children)
+			SetRoot(Meld(m_root, children));
+		Detach(link);
+		m_length --;
+	}
+
+	/*
+	 * Function: Merge
+	 *  Moves every node of another heap into this one, in O(1).
+	 */
+	void Merge(wfPairingHeap& heap) {
+		if (&heap == this || !heap.m_root)
+			return;
+
+		wfPrivate::wfPairingHeapLink *root = heap.m_root;
+		heap.SetRoot(wfNullPointer);
+		SetRoot(m_root ? Meld(m_root, root) : root);
+		m_length     += heap.m_length;
+		heap.m_length = 0;
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every node, in O(n).
+	 */
+	void Clear() {
+		while (Pop())
+			;
+	}
+
+private:
+	static T *Item(wfPrivate::wfPairingHeapLink *link) {
+		return static_cast<Node*>(link)->m_item;
+	}
+
+	// the root hangs off an anchor, so that every linked node has m_prev set
+	void SetRoot(wfPrivate::wfPairingHeapLink *root) {
+		m_root = root;
+		if (root) {
+			root->m_prev    = &m_anchor;
+			root->m_sibling = wfNullPointer;
+		}
+	}
+
+	static void Detach(wfPrivate::wfPairingHeapLink *link) {
+		link->m_child   = wfNullPointer;
+		link->m_sibling = wfNullPointer;
+		link->m_prev    = wfNullPointer;
+	}
+
+	// unlinks a node that is not the root, with its subtree, from its parent
+	static void Cut(wfPrivate::wfPairingHeapLink *link) {
+		if (link->m_prev->m_child == link)
+			link->m_prev->m_child = link->m_sibling;
+		else
+			link->m_prev->m_sibling = link->m_sibling;
+		if (link->m_sibling)
+			link->m_sibling->m_prev = link->m_prev;
+		link->m_sibling = wfNullPointer;
+	}
+
+	// links two roots, the one that comes later becomes the first child of
+	// the other
+	wfPrivate::wfPairingHeapLink *Meld(wfPrivate::wfPairingHeapLink *a, wfPrivate::wfPairingHeapLink *b) {
+		if (m_compare(*Item(b), *Item(a))) {
+			wfPrivate::wfPairingHeapLink *t = a;
+			a = b;
+			b = t;
+		}
+
+		b->m_sibling = a->m_child;
+		if (a->m_child)
+			a->m_child->m_prev = b;
+		b->m_prev  = a;
+		a->m_child = b;
+		return a;
+	}
+
+	// the two-pass merge of a list of siblings: meld them in pairs from the
+	// left, then meld the pairs from the right into one tree
+	wfPrivate::wfPairingHeapLink *MergePairs(wfPrivate::wfPairingHeapLink *first) {
+		if (!first)
+			return wfNullPointer;
+
+		wfPrivate::wfPairingHeapLink *pairs = wfNullPointer; // chained through m_prev
+		while (first) {
+			wfPrivate::wfPairingHeapLink *a = first;
+			wfPrivate::wfPairingHeapLink *b = a->m_sibling;
+			if (!b) {
+				a->m_prev = pairs;
+				pairs     = a;
+				break;
+			}
+			first = b->m_sibling;
+			a->m_sibling = wfNullPointer;
+			b->m_sibling = wfNullPointer;
+
+			wfPrivate::wfPairingHeapLink *tree = Meld(a, b);
+			tree->m_prev = pairs;
+			pairs        = tree;
+		}
+
+		wfPrivate::wfPairingHeapLink *tree = pairs;
+		pairs = pairs->m_prev;
+		tree->m_sibling = wfNullPointer;
+		while (pairs) {
+			wfPrivate::wfPairingHeapLink *next = pairs->m_prev;
+			pairs->m_sibling = wfNullPointer;
+			tree  = Meld(tree, pairs);
+			pairs = next;
+		}
+		return tree;
+	}
+
+	C                             m_compare;
+	wfPrivate::wfPairingHeapLink  m_anchor;
+	wfPrivate::wfPairingHeapLink *m_root;
+	size_t                        m_length;
+
+	wfPairingHeap(const wfPairingHeap&);
+	wfPairingHeap& operator=(const wfPairingHeap&);
+};
+
+#endif
@@ -0,0 +1,1008 @@
+#ifndef WF_STDLIB_RADIXMAP_HDR
+#define WF_STDLIB_RADIXMAP_HDR
+#include "wfAlgorithm.h"
+#include "wfFunctional.h"
+#include "wfNullPointer.h"
+
+/*
+ * File: wfRadixMap
+ *  A map from byte strings to values using an adaptive radix tree.
+ *
+ * >#include "wfRadixMap.h"
+ *
+ *  Every inner node consumes one byte of the key and picks the child for
+ *  it; there are four node layouts, for up to 4, 16, 48 and 256 children,
+ *  and a node is replaced by the next layout as it fills up and by the
+ *  previous one as it empties.  Runs of bytes shared by every key below a
+ *  node are stored once in that node (path compression) and a key with no
+ *  other key below it is stored as a single leaf as high up as possible
+ *  (lazy expansion).  A lookup therefor costs O(key length) however many
+ *  keys there are, and a set of keys sharing long prefixes (URLs, metric
+ *  names) is stored with little more than the distinct parts of the keys.
+ *
+ *  Keys are any sequence of bytes given as a <wfStringRef>, they need not
+ *  be null terminated and may contain zero bytes.  A key that is a prefix
+ *  of another key is fine.  Keys are ordered as by *memcmp*, with a
+ *  shorter key before every key it is a prefix of, which is the order of
+ *  <wfRadixMap::ForEach>.
+ *
+ *  Searching a 16 child node compares the byte against all keys of the
+ *  node at once with SSE2 when available.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define WF_STDLIB_RADIXMAP_SSE2
+#   include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace wfPrivate {
+	enum {
+		wfRadixMapType4   = 0,
+		wfRadixMapType16  = 1,
+		wfRadixMapType48  = 2,
+		wfRadixMapType256 = 3,
+
+		// prefix bytes stored in the node itself, the rest is read from a leaf
+		wfRadixMapPrefix  = 8
+	};
+
+	struct wfRadixMapLeaf {
+		size_t               m_length;
+		const unsigned char *m_key;
+	};
+
+	template <typename V>
+	struct wfRadixMapValueLeaf : wfRadixMapLeaf {
+		V m_value;
+	};
+
+	//
+	// Child pointers and the terminal (the leaf of the key ending at the
+	// node) are tagged: leaves have the low bit set.
+	//
+	struct wfRadixMapNode {
+		unsigned char m_type;
+		u16           m_count;
+		u32           m_prefixLength;
+		unsigned char m_prefix[wfRadixMapPrefix];
+		void         *m_terminal;
+	};
+
+	struct wfRadixMapNode4 : wfRadixMapNode {
+		unsigned char m_keys[4];
+		void         *m_children[4];
+	};
+
+	struct wfRadixMapNode16 : wfRadixMapNode {
+		unsigned char m_keys[16];
+		void         *m_children[16];
+	};
+
+	struct wfRadixMapNode48 : wfRadixMapNode {
+		unsigned char m_index[256]; // slot + 1, 0 for no child
+		void         *m_children[48];
+	};
+
+	struct wfRadixMapNode256 : wfRadixMapNode {
+		void         *m_children[256];
+	};
+
+	inline bool            wfRadixMapIsLeaf(const void *pointer)  { return (reinterpret_cast<size_t>(pointer) & 1) != 0; }
+	inline wfRadixMapLeaf *wfRadixMapAsLeaf(const void *pointer)  { return reinterpret_cast<wfRadixMapLeaf*>(reinterpret_cast<size_t>(pointer) & ~static_cast<size_t>(1)); }
+	inline void           *wfRadixMapTag   (wfRadixMapLeaf *leaf) { return reinterpret_cast<void*>(reinterpret_cast<size_t>(leaf) | 1); }
+
+	inline u32 wfRadixMapFirstBit(u32 mask) {
+#if defined(__GNUC__)
+		return static_cast<u32>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<u32>(index);
+#else
+		u32 index = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			index ++;
+		}
+		return index;
+#endif
+	}
+
+	inline size_t wfRadixMapNodeSize(unsigned char type) {
+		static const size_t sizes[] = {
+			sizeof(wfRadixMapNode4),
+			sizeof(wfRadixMapNode16),
+			sizeof(wfRadixMapNode48),
+			sizeof(wfRadixMapNode256)
+		};
+		return sizes[type];
+	}
+
+	inline wfRadixMapNode *wfRadixMapCreate(unsigned char type) {
+		const size_t    size = wfRadixMapNodeSize(type);
+		wfRadixMapNode *node = static_cast<wfRadixMapNode*>(g_miscHeap.Alloc(size));
+		memset(static_cast<void*>(node), 0, size);
+		node->m_type = type;
+		return node;
+	}
+
+	// a node replacing another keeps its prefix and terminal
+	inline wfRadixMapNode *wfRadixMapCreate(unsigned char type, const wfRadixMapNode *from) {
+		wfRadixMapNode *node = wfRadixMapCreate(type);
+		node->m_count        = from->m_count;
+		node->m_prefixLength = from->m_prefixLength;
+		node->m_terminal     = from->m_terminal;
+		memcpy(node->m_prefix, from->m_prefix, wfRadixMapPrefix);
+		return node;
+	}
+
+	inline void wfRadixMapFree(wfRadixMapNode *node) {
+		g_miscHeap.Free(node);
+	}
+
+	inline void **wfRadixMapFindChild(wfRadixMapNode *node, unsigned char byte) {
+		switch (node->m_type) {
+			case wfRadixMapType4: {
+				wfRadixMapNode4 *n = static_cast<wfRadixMapNode4*>(node);
+				for (u32 i = 0; i < n->m_count; i++) {
+					if (n->m_keys[i] == byte)
+						return &n->m_children[i];
+				}
+				return wfNullPointer;
+			}
+
+			case wfRadixMapType16: {
+				wfRadixMapNode16 *n = static_cast<wfRadixMapNode16*>(node);
+#ifdef WF_STDLIB_RADIXMAP_SSE2
+				const __m128i keys  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->m_keys));
+				const __m128i match = _mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(byte)));
+				const u32     mask  = static_cast<u32>(_mm_movemask_epi8(match)) & ((1u << n->m_count) - 1);
+				return mask ? &n->m_children[wfRadixMapFirstBit(mask)] : wfNullPointer;
+#else
+				for (u32 i = 0; i < n->m_count; i++) {
+					if (n->m_keys[i] == byte)
+						return &n->m_children[i];
+				}
+				return wfNullPointer;
+#endif
+			}
+
+			case wfRadixMapType48: {
+				wfRadixMapNode48 *n = static_cast<wfRadixMapNode48*>(node);
+				return n->m_index[byte] ? &n->m_children[n->m_index[byte] - 1] : wfNullPointer;
+			}
+
+			default: {
+				wfRadixMapNode256 *n = static_cast<wfRadixMapNode256*>(node);
+				return n->m_children[byte] ? &n->m_children[byte] : wfNullPointer;
+			}
+		}
+	}
+
+	// index of the first key of a sorted node greater than byte
+	inline u32 wfRadixMapInsertPosition(const unsigned char *keys, u32 count, unsigned char byte) {
+#ifdef WF_STDLIB_RADIXMAP_SSE2
+		if (count > 4) {
+			// bytes compare signed, flipping the top bit orders them unsigned
+			const __m128i bias    = _mm_set1_epi8(static_cast<char>(0x80));
+			const __m128i entries = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)), bias);
+			const __m128i value   = _mm_xor_si128(_mm_set1_epi8(static_cast<char>(byte)), bias);
+			const u32     mask    = static_cast<u32>(_mm_movemask_epi8(_mm_cmplt_epi8(value, entries))) & ((1u << count) - 1);
+			return mask ? wfRadixMapFirstBit(mask) : count;
+		}
+#endif
+		u32 position = 0;
+		while (position < count && keys[position] < byte)
+			position++;
+		return position;
+	}
+
+	//
+	// Adds a child for a byte the node has no child for yet, growing the
+	// node into the next layout (and updating the reference to it) when it
+	// is full.
+	//
+	inline void wfRadixMapAddChild(void **ref, wfRadixMapNode *node, unsigned char byte, void *child) {
+		switch (node->m_type) {
+			case wfRadixMapType4: {
+				wfRadixMapNode4 *n = static_cast<wfRadixMapNode4*>(node);
+				if (n->m_count < 4) {
+					const u32 position = wfRadixMapInsertPosition(n->m_keys, n->m_count, byte);
+					memmove(n->m_keys     + position + 1, n->m_keys     + position, (n->m_count - position));
+					memmove(n->m_children + position + 1, n->m_children + position, (n->m_count - position) * sizeof(void*));
+					n->m_keys[position]     = byte;
+					n->m_children[position] = child;
+					n->m_count ++;
+					return;
+				}
+
+				wfRadixMapNode16 *grown = static_cast<wfRadixMapNode16*>(wfRadixMapCreate(wfRadixMapType16, n));
+				memcpy(grown->m_keys,     n->m_keys,     4);
+				memcpy(grown->m_children, n->m_children, 4 * sizeof(void*));
+				wfRadixMapFree(n);
+				*ref = grown;
+				wfRadixMapAddChild(ref, grown, byte, child);
+				return;
+			}
+
+			case wfRadixMapType16: {
+				wfRadixMapNode16 *n = static_cast<wfRadixMapNode16*>(node);
+				if (n->m_count < 16) {
+					const u32 position = wfRadixMapInsertPosition(n->m_keys, n->m_count, byte);
+					memmove(n->m_keys     + position + 1, n->m_keys     + position, (n->m_count - position));
+					memmove(n->m_children + position + 1, n->m_children + position, (n->m_count - position) * sizeof(void*));
+					n->m_keys[position]     = byte;
+					n->m_children[position] = child;
+					n->m_count ++;
+					return;
+				}
+
+				wfRadixMapNode48 *grown = static_cast<wfRadixMapNode48*>(wfRadixMapCreate(wfRadixMapType48, n));
+				for (u32 i = 0; i < 16; i++) {
+					grown->m_index[n->m_keys[i]] = static_cast<unsigned char>(i + 1);
+					grown->m_children[i]         = n->m_children[i];
+				}
+				wfRadixMapFree(n);
+				*ref = grown;
+				wfRadixMapAddChild(ref, grown, byte, child);
+				return;
+			}
+
+			case wfRadixMapType48: {
+				wfRadixMapNode48 *n = static_cast<wfRadixMapNode48*>(node);
+				if (n->m_count < 48) {
+					// erasing leaves holes, take the first free slot
+					u32 slot = 0;
+					while (n->m_children[slot])
+						slot++;
+					n->m_index[byte]    = static_cast<unsigned char>(slot + 1);
+					n->m_children[slot] = child;
+					n->m_count ++;
+					return;
+				}
+
+				wfRadixMapNode256 *grown = static_cast<wfRadixMapNode256*>(wfRadixMapCreate(wfRadixMapType256, n));
+				for (u32 i = 0; i < 256; i++) {
+					if (n->m_index[i])
+						grown->m_children[i] = n->m_children[n->m_index[i] - 1];
+				}
+				wfRadixMapFree(n);
+				*ref = grown;
+				wfRadixMapAddChild(ref, grown, byte, child);
+				return;
+			}
+
+			default: {
+				wfRadixMapNode256 *n = static_cast<wfRadixMapNode256*>(node);
+				n->m_children[byte] = child;
+				n->m_count ++;
+				return;
+			}
+		}
+	}
+
+	//
+	// A 4 child node left with a single entry is replaced by it: by the
+	// terminal if that is all that is left, by the only child otherwise,
+	// which for an inner child means prepending this node's prefix and the
+	// byte leading to it to the child's prefix.
+	//
+	inline void wfRadixMapCollapse(void **ref, wfRadixMapNode4 *node) {
+		if (node->m_count == 0) {
+			*ref = node->m_terminal;
+			wfRadixMapFree(node);
+			return;
+		}
+
+		if (node->m_count != 1 || node->m_terminal)
+			return;
+
+		void *child = node->m_children[0];
+		if (!wfRadixMapIsLeaf(child)) {
+			wfRadixMapNode *inner = static_cast<wfRadixMapNode*>(child);
+
+			unsigned char prefix[wfRadixMapPrefix];
+			u32           length = 0;
+			for (u32 i = 0; i < node->m_prefixLength && length < wfRadixMapPrefix; i++)
+				prefix[length++] = node->m_prefix[i];
+			if (length < wfRadixMapPrefix)
+				prefix[length++] = node->m_keys[0];
+			for (u32 i = 0; i < inner->m_prefixLength && length < wfRadixMapPrefix; i++)
+				prefix[length++] = inner->m_prefix[i];
+
+			memcpy(inner->m_prefix, prefix, length);
+			inner->m_prefixLength += node->m_prefixLength + 1;
+		}
+
+		*ref = child;
+		wfRadixMapFree(node);
+	}
+
+	//
+	// Removes the child for a byte, shrinking the node into the previous
+	// layout (and updating the reference to it) when it has emptied enough.
+	// The thresholds are below the capacity of the smaller layout so that a
+	// node at the boundary does not flip on every insert and erase.
+	//
+	inline void wfRadixMapRemoveChild(void **ref, wfRadixMapNode *node, unsigned char byte) {
+		switch (node->m_type) {
+			case wfRadixMapType4: {
+				wfRadixMapNode4 *n        = static_cast<wfRadixMapNode4*>(node);
+				const u32        position = static_cast<u32>(wfRadixMapFindChild(n, byte) - n->m_children);
+				memmove(n->m_keys     + position, n->m_keys     + position + 1, (n->m_count - position - 1));
+				memmove(n->m_children + position, n->m_children + position + 1, (n->m_count - position - 1) * sizeof(void*));
+				n->m_count --;
+				wfRadixMapCollapse(ref, n);
+				return;
+			}
+
+			case wfRadixMapType16: {
+				wfRadixMapNode16 *n        = static_cast<wfRadixMapNode16*>(node);
+				const u32         position = static_cast<u32>(wfRadixMapFindChild(n, byte) - n->m_children);
+				memmove(n->m_keys     + position, n->m_keys     + position + 1, (n->m_count - position - 1));
+				memmove(n->m_children + position, n->m_children + position + 1, (n->m_count - position - 1) * sizeof(void*));
+				n->m_count --;
+				if (n->m_count > 3)
+					return;
+
+				wfRadixMapNode4 *shrunk = static_cast<wfRadixMapNode4*>(wfRadixMapCreate(wfRadixMapType4, n));
+				memcpy(shrunk->m_keys,     n->m_keys,     n->m_count);
+				memcpy(shrunk->m_children, n->m_children, n->m_count * sizeof(void*));
+				wfRadixMapFree(n);
+				*ref = shrunk;
+				return;
+			}
+
+			case wfRadixMapType48: {
+				wfRadixMapNode48 *n = static_cast<wfRadixMapNode48*>(node);
+				n->m_children[n->m_index[byte] - 1] = wfNullPointer;
+				n->m_index[byte]                    = 0;
+				n->m_count --;
+				if (n->m_count > 12)
+					return;
+
+				wfRadixMapNode16 *shrunk = static_cast<wfRadixMapNode16*>(wfRadixMapCreate(wfRadixMapType16, n));
+				u32               count  = 0;
+				for (u32 i = 0; i < 256; i++) {
+					if (n->m_index[i]) {
+						shrunk->m_keys[count]     = static_cast<unsigned char>(i);
+						shrunk->m_children[count] = n->m_children[n->m_index[i] - 1];
+						count++;
+					}
+				}
+				wfRadixMapFree(n);
+				*ref = shrunk;
+				return;
+			}
+
+			default: {
+				wfRadixMapNode256 *n = static_cast<wfRadixMapNode256*>(node);
+				n->m_children[byte] = wfNullPointer;
+				n->m_count --;
+				if (n->m_count > 37)
+					return;
+
+				wfRadixMapNode48 *shrunk = static_cast<wfRadixMapNode48*>(wfRadixMapCreate(wfRadixMapType48, n));
+				u32               count  = 0;
+				for (u32 i = 0; i < 256; i++) {
+					if (n->m_children[i]) {
+						shrunk->m_index[i]        = static_cast<unsigned char>(count + 1);
+						shrunk->m_children[count] = n->m_children[i];
+						count++;
+					}
+				}
+				wfRadixMapFree(n);
+				*ref = shrunk;
+				return;
+			}
+		}
+	}
+
+	// the leaf with the smallest key below a node, any leaf shares its prefix
+	inline wfRadixMapLeaf *wfRadixMapMinimum(const void *pointer) {
+		while (!wfRadixMapIsLeaf(pointer)) {
+			const wfRadixMapNode *node = static_cast<const wfRadixMapNode*>(pointer);
+			if (node->m_terminal)
+				return wfRadixMapAsLeaf(node->m_terminal);
+
+			switch (node->m_type) {
+				case wfRadixMapType4:
+					pointer = static_cast<const wfRadixMapNode4*>(node)->m_children[0];
+					break;
+				case wfRadixMapType16:
+					pointer = static_cast<const wfRadixMapNode16*>(node)->m_children[0];
+					break;
+				case wfRadixMapType48: {
+					const wfRadixMapNode48 *n = static_cast<const wfRadixMapNode48*>(node);
+					u32 i = 0;
+					while (!n->m_index[i])
+						i++;
+					pointer = n->m_children[n->m_index[i] - 1];
+					break;
+				}
+				default: {
+					const wfRadixMapNode256 *n = static_cast<const wfRadixMapNode256*>(node);
+					u32 i = 0;
+					while (!n->m_children[i])
+						i++;
+					pointer = n->m_children[i];
+					break;
+				}
+			}
+		}
+		return wfRadixMapAsLeaf(pointer);
+	}
+
+	// the full prefix of a node at depth, read from a leaf when not stored inline
+	inline const unsigned char *wfRadixMapPrefixOf(const wfRadixMapNode *node, size_t depth) {
+		if (node->m_prefixLength <= wfRadixMapPrefix)
+			return node->m_prefix;
+		return wfRadixMapMinimum(node)->m_key + depth;
+	}
+
+	// number of prefix bytes of the node matching the key from depth on
+	inline size_t wfRadixMapMatch(const wfRadixMapNode *node, const unsigned char *key, size_t length, size_t depth) {
+		const unsigned char *prefix = wfRadixMapPrefixOf(node, depth);
+		const size_t         limit  = wfMin(static_cast<size_t>(node->m_prefixLength), length - depth);
+		size_t               match  = 0;
+		while (match < limit && prefix[match] == key[depth + match])
+			match++;
+		return match;
+	}
+
+	//
+	// Lookups only compare the inline part of long prefixes, the skipped
+	// bytes are verified against the key of the leaf the search ends at.
+	//
+	inline bool wfRadixMapMatchOptimistic(const wfRadixMapNode *node, const unsigned char *key, size_t length, size_t depth) {
+		if (depth + node->m_prefixLength > length)
+			return false;
+
+		const u32 stored = wfMin(node->m_prefixLength, static_cast<u32>(wfRadixMapPrefix));
+		for (u32 i = 0; i < stored; i++) {
+			if (node->m_prefix[i] != key[depth + i])
+				return false;
+		}
+		return true;
+	}
+
+	inline bool wfRadixMapLeafEquals(const wfRadixMapLeaf *leaf, const unsigned char *key, size_t length) {
+		return leaf->m_length == length && memcmp(leaf->m_key, key, length) == 0;
+	}
+
+	inline bool wfRadixMapLeafPrefixes(const wfRadixMapLeaf *leaf, const unsigned char *key, size_t length) {
+		return leaf->m_length <= length && memcmp(leaf->m_key, key, leaf->m_length) == 0;
+	}
+}
+
+/*
+ * Class: wfRadixMap
+ *  An ordered map from byte string keys to values.
+ *
+ * Parameters:
+ *  V - The value data type to be stored in the <wfRadixMap>.
+ *
+ * Remarks:
+ *  The keys are copied into the map.  There is no iterator, <ForEach>,
+ *  <ForEachPrefix> and <LongestPrefix> walk the tree directly.
+ */
+template <typename V>
+struct wfRadixMap {
+	wfRadixMap() :
+		m_root  (wfNullPointer),
+		m_length(0)
+	{ }
+
+	~wfRadixMap() {
+		Destroy(m_root);
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of keys in the map.
+	 */
+	size_t Length() const { return m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the map is empty.
+	 */
+	bool   Empty () const { return m_length == 0; }
+
+	/*
+	 * Function: Insert
+	 *  Inserts a key associated with a value into the map.
+	 *
+	 * Parameters:
+	 *  key   - The key, copied into the map.
+	 *  value - The value to associate with the key.
+	 *
+	 * Returns:
+	 *  A reference to the value associated with the key, which is the value
+	 *  already associated with it if the map already contained the key.
+	 */
+	V& Insert(const wfStringRef& key, const V& value) {
+		return Insert(Bytes(key), key.Length(), value)->m_value;
+	}
+
+	/*
+	 * Function: operator[]
+	 *  Returns the value associated with a key, inserting a default
+	 *  constructed value first if the map does not contain the key.
+	 */
+	V& operator[](const wfStringRef& key) {
+		Leaf *leaf = FindLeaf(Bytes(key), key.Length());
+		return leaf ? leaf->m_value : Insert(Bytes(key), key.Length(), V())->m_value;
+	}
+
+	/*
+	 * Function: Find
+	 *  Returns the address of the value associated with a key, or
+	 *  *wfNullPointer* when the map does not contain the key.
+	 *
+	 * Remarks:
+	 *  The address stays valid until the key is erased.  There exists a
+	 *  const cv-qualified version of this function as well.
+	 */
+	V *Find(const wfStringRef& key) {
+		Leaf *leaf = FindLeaf(Bytes(key), key.Length());
+		return leaf ? &leaf->m_value : wfNullPointer;
+	}
+	const V *Find(const wfStringRef& key) const {
+		const Leaf *leaf = FindLeaf(Bytes(key), key.Length());
+		return leaf ? &leaf->m_value : wfNullPointer;
+	}
+
+	/*
+	 * Function: Count
+	 *  Returns 1 if the map contains the key; 0 otherwise.
+	 */
+	size_t Count(const wfStringRef& key) const {
+		return FindLeaf(Bytes(key), key.Length()) ? 1 : 0;
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes a key and its value.
+	 *
+	 * Returns:
+	 *  *true* if the map contained the key; *false* otherwise.
+	 */
+	bool Erase(const wfStringRef& key) {
+		const unsigned char *bytes  = Bytes(key);
+		const size_t         length = key.Length();
+
+		void                    **ref    = &m_root;
+		wfPrivate::wfRadixMapNode *parent = wfNullPointer;
+		void                    **above  = wfNullPointer;
+		size_t                    depth  = 0;
+		while (*ref) {
+			if (wfPrivate::wfRadixMapIsLeaf(*ref)) {
+				Leaf *leaf = static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(*ref));
+				if (!wfPrivate::wfRadixMapLeafEquals(leaf, bytes, length))
+					return false;
+
+				if (parent)
+					wfPrivate::wfRadixMapRemoveChild(above, parent, bytes[depth - 1]);
+				else
+					*ref = wfNullPointer;
+
+				DestroyLeaf(leaf);
+				return true;
+			}
+
+			wfPrivate::wfRadixMapNode *node = static_cast<wfPrivate::wfRadixMapNode*>(*ref);
+			if (wfPrivate::wfRadixMapMatch(node, bytes, length, depth) != node->m_prefixLength)
+				return false;
+
+			depth += node->m_prefixLength;
+			if (depth == length) {
+				if (!node->m_terminal)
+					return false;
+
+				Leaf *leaf = static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(node->m_terminal));
+				node->m_terminal = wfNullPointer;
+				if (node->m_type == wfPrivate::wfRadixMapType4)
+					wfPrivate::wfRadixMapCollapse(ref, static_cast<wfPrivate::wfRadixMapNode4*>(node));
+
+				DestroyLeaf(leaf);
+				return true;
+			}
+
+			void **child = wfPrivate::wfRadixMapFindChild(node, bytes[depth]);
+			if (!child)
+				return false;
+
+			above  = ref;
+			parent = node;
+			ref    = child;
+			depth ++;
+		}
+		return false;
+	}
+
+	/*
+	 * Function: Clear
+	 *  Erases every key.
+	 */
+	void Clear() {
+		Destroy(m_root);
+		m_root = wfNullPointer;
+	}
+
+	/*
+	 * Function: LongestPrefix
+	 *  Finds the longest key in the map that is a prefix of a string, for
+	 *  instance the most specific route for a path.
+	 *
+	 * Parameters:
+	 *  key   - The string to match.
+	 *  match - Receives a view of the key found (owned by the map) unless
+	 *          *wfNullPointer*.
+	 *
+	 * Returns:
+	 *  The address of the value associated with the key found, or
+	 *  *wfNullPointer* if no key is a prefix of the string.
+	 */
+	V *LongestPrefix(const wfStringRef& key, wfStringRef *match = wfNullPointer) const {
+		const unsigned char *bytes  = Bytes(key);
+		const size_t         length = key.Length();
+
+		const wfPrivate::wfRadixMapLeaf *best    = wfNullPointer;
+		const void                      *pointer = m_root;
+		size_t                           depth   = 0;
+		while (pointer) {
+			if (wfPrivate::wfRadixMapIsLeaf(pointer)) {
+				const wfPrivate::wfRadixMapLeaf *leaf = wfPrivate::wfRadixMapAsLeaf(pointer);
+				if (wfPrivate::wfRadixMapLeafPrefixes(leaf, bytes, length))
+					best = leaf;
+				break;
+			}
+
+			wfPrivate::wfRadixMapNode *node = static_cast<wfPrivate::wfRadixMapNode*>(const_cast<void*>(pointer));
+			if (!wfPrivate::wfRadixMapMatchOptimistic(node, bytes, length, depth))
+				break;
+
+			depth += node->m_prefixLength;
+			if (node->m_terminal && wfPrivate::wfRadixMapLeafPrefixes(wfPrivate::wfRadixMapAsLeaf(node->m_terminal), bytes, length))
+				best = wfPrivate::wfRadixMapAsLeaf(node->m_terminal);
+
+			if (depth == length)
+				break;
+
+			void **child = wfPrivate::wfRadixMapFindChild(node, bytes[depth]);
+			if (!child)
+				break;
+
+			pointer = *child;
+			depth ++;
+		}
+
+		if (!best)
+			return wfNullPointer;
+
+		if (match)
+			*match = wfStringRef(reinterpret_cast<const char*>(best->m_key), best->m_length);
+		return &static_cast<Leaf*>(const_cast<wfPrivate::wfRadixMapLeaf*>(best))->m_value;
+	}
+
+	/*
+	 * Function: ForEach
+	 *  Invokes a function on every key in order, as *function(key, value)*
+	 *  with the key as a <wfStringRef>.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied.
+	 *
+	 * Remarks:
+	 *  The map must not be modified by the function.  There exists a const
+	 *  cv-qualified version of this function as well, which passes values as
+	 *  *const*.
+	 */
+	template <typename F>
+	F ForEach(F function) {
+		Visit(m_root, function);
+		return function;
+	}
+	template <typename F>
+	F ForEach(F function) const {
+		ConstVisitor<F> visitor(function);
+		Visit(m_root, visitor);
+		return function;
+	}
+
+	/*
+	 * Function: ForEachPrefix
+	 *  Invokes a function on every key starting with a prefix in order, as
+	 *  *function(key, value)*.
+	 *
+	 * Remarks:
+	 *  The subtree of the prefix is found in O(prefix length) and then walked
+	 *  as a whole, keys not starting with the prefix are never visited.  See
+	 *  <ForEach>.
+	 */
+	template <typename F>
+	F ForEachPrefix(const wfStringRef& prefix, F function) {
+		if (void *subtree = FindPrefix(Bytes(prefix), prefix.Length()))
+			Visit(subtree, function);
+		return function;
+	}
+	template <typename F>
+	F ForEachPrefix(const wfStringRef& prefix, F function) const {
+		if (void *subtree = FindPrefix(Bytes(prefix), prefix.Length())) {
+			ConstVisitor<F> visitor(function);
+			Visit(subtree, visitor);
+		}
+		return function;
+	}
+
+private:
+	typedef wfPrivate::wfRadixMapValueLeaf<V> Leaf;
+
+	template <typename F>
+	struct ConstVisitor {
+		ConstVisitor(F& function) :
+			m_function(function)
+		{ }
+
+		void operator()(const wfStringRef& key, V& value) {
+			m_function(key, static_cast<const V&>(value));
+		}
+
+		F& m_function;
+	};
+
+	static const unsigned char *Bytes(const wfStringRef& key) {
+		return reinterpret_cast<const unsigned char*>(key.Data());
+	}
+
+	// the key bytes follow the leaf in the same allocation
+	Leaf *CreateLeaf(const unsigned char *key, size_t length, const V& value) {
+		unsigned char *memory = static_cast<unsigned char*>(g_miscHeap.Alloc(sizeof(Leaf) + length));
+		Leaf          *leaf   = reinterpret_cast<Leaf*>(memory);
+		memcpy(memory + sizeof(Leaf), key, length);
+		leaf->m_length = length;
+		leaf->m_key    = memory + sizeof(Leaf);
+		new (&leaf->m_value) V(value);
+		m_length ++;
+		return leaf;
+	}
+
+	void DestroyLeaf(Leaf *leaf) {
+		leaf->m_value.~V();
+		g_miscHeap.Free(leaf);
+		m_length --;
+	}
+
+	void Destroy(void *pointer) {
+		if (!pointer)
+			return;
+
+		if (wfPrivate::wfRadixMapIsLeaf(pointer)) {
+			DestroyLeaf(static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(pointer)));
+			return;
+		}
+
+		wfPrivate::wfRadixMapNode *node = static_cast<wfPrivate::wfRadixMapNode*>(pointer);
+		Destroy(node->m_terminal);
+		switch (node->m_type) {
+			case wfPrivate::wfRadixMapType4:
+				for (u32 i = 0; i < node->m_count; i++)
+					Destroy(static_cast<wfPrivate::wfRadixMapNode4*>(node)->m_children[i]);
+				break;
+			case wfPrivate::wfRadixMapType16:
+				for (u32 i = 0; i < node->m_count; i++)
+					Destroy(static_cast<wfPrivate::wfRadixMapNode16*>(node)->m_children[i]);
+				break;
+			case wfPrivate::wfRadixMapType48:
+				for (u32 i = 0; i < 48; i++)
+					Destroy(static_cast<wfPrivate::wfRadixMapNode48*>(node)->m_children[i]);
+				break;
+			default:
+				for (u32 i = 0; i < 256; i++)
+					Destroy(static_cast<wfPrivate::wfRadixMapNode256*>(node)->m_children[i]);
+				break;
+		}
+		wfPrivate::wfRadixMapFree(node);
+	}
+
+	// a leaf hangs off a new node either as its terminal or under its next byte
+	static void Attach(wfPrivate::wfRadixMapNode *node, Leaf *leaf, size_t depth) {
+		void *ref = node;
+		if (leaf->m_length == depth)
+			node->m_terminal = wfPrivate::wfRadixMapTag(leaf);
+		else
+			wfPrivate::wfRadixMapAddChild(&ref, node, leaf->m_key[depth], wfPrivate::wfRadixMapTag(leaf));
+	}
+
+	Leaf *Insert(const unsigned char *key, size_t length, const V& value) {
+		void  **ref   = &m_root;
+		size_t  depth = 0;
+		for (;;) {
+			if (!*ref) {
+				Leaf *leaf = CreateLeaf(key, length, value);
+				*ref = wfPrivate::wfRadixMapTag(leaf);
+				return leaf;
+			}
+
+			if (wfPrivate::wfRadixMapIsLeaf(*ref)) {
+				Leaf *leaf = static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(*ref));
+				if (wfPrivate::wfRadixMapLeafEquals(leaf, key, length))
+					return leaf;
+
+				// the leaf and the key share a prefix then diverge, or one ends
+				const size_t limit  = wfMin(leaf->m_length, length);
+				size_t       common = depth;
+				while (common < limit && leaf->m_key[common] == key[common])
+					common++;
+
+				wfPrivate::wfRadixMapNode *node = wfPrivate::wfRadixMapCreate(wfPrivate::wfRadixMapType4);
+				node->m_prefixLength = static_cast<u32>(common - depth);
+				memcpy(node->m_prefix, key + depth, wfMin(common - depth, static_cast<size_t>(wfPrivate::wfRadixMapPrefix)));
+
+				Leaf *fresh = CreateLeaf(key, length, value);
+				Attach(node, leaf,  common);
+				Attach(node, fresh, common);
+				*ref = node;
+				return fresh;
+			}
+
+			wfPrivate::wfRadixMapNode *node = static_cast<wfPrivate::wfRadixMapNode*>(*ref);
+			if (node->m_prefixLength) {
+				const size_t match = wfPrivate::wfRadixMapMatch(node, key, length, depth);
+				if (match < node->m_prefixLength) {
+					// split the prefix: a new node for the shared part, the old
+					// node below it under the byte where the key diverges
+					wfPrivate::wfRadixMapNode *split = wfPrivate::wfRadixMapCreate(wfPrivate::wfRadixMapType4);
+					split->m_prefixLength = static_cast<u32>(match);
+					memcpy(split->m_prefix, node->m_prefix, wfMin(match, static_cast<size_t>(wfPrivate::wfRadixMapPrefix)));
+
+					const unsigned char *prefix = wfPrivate::wfRadixMapPrefixOf(node, depth);
+					const unsigned char  byte   = prefix[match];
+					node->m_prefixLength -= static_cast<u32>(match + 1);
+					memmove(node->m_prefix, prefix + match + 1, wfMin(static_cast<size_t>(node->m_prefixLength), static_cast<size_t>(wfPrivate::wfRadixMapPrefix)));
+
+					void *ref4 = split;
+					wfPrivate::wfRadixMapAddChild(&ref4, split, byte, node);
+
+					Leaf *fresh = CreateLeaf(key, length, value);
+					Attach(split, fresh, depth + match);
+					*ref = split;
+					return fresh;
+				}
+				depth += node->m_prefixLength;
+			}
+
+			if (depth == length) {
+				if (node->m_terminal)
+					return static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(node->m_terminal));
+
+				Leaf *fresh = CreateLeaf(key, length, value);
+				node->m_terminal = wfPrivate::wfRadixMapTag(fresh);
+				return fresh;
+			}
+
+			void **child = wfPrivate::wfRadixMapFindChild(node, key[depth]);
+			if (!child) {
+				Leaf *fresh = CreateLeaf(key, length, value);
+				wfPrivate::wfRadixMapAddChild(ref, node, key[depth], wfPrivate::wfRadixMapTag(fresh));
+				return fresh;
+			}
+
+			ref = child;
+			depth ++;
+		}
+	}
+
+	Leaf *FindLeaf(const unsigned char *key, size_t length) const {
+		const void *pointer = m_root;
+		size_t      depth   = 0;
+		while (pointer) {
+			if (wfPrivate::wfRadixMapIsLeaf(pointer)) {
+				Leaf *leaf = static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(pointer));
+				return wfPrivate::wfRadixMapLeafEquals(leaf, key, length) ? leaf : wfNullPointer;
+			}
+
+			wfPrivate::wfRadixMapNode *node = static_cast<wfPrivate::wfRadixMapNode*>(const_cast<void*>(pointer));
+			if (!wfPrivate::wfRadixMapMatchOptimistic(node, key, length, depth))
+				return wfNullPointer;
+
+			depth += node->m_prefixLength;
+			if (depth == length) {
+				if (!node->m_terminal)
+					return wfNullPointer;
+
+				Leaf *leaf = static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(node->m_terminal));
+				return wfPrivate::wfRadixMapLeafEquals(leaf, key, length) ? leaf : wfNullPointer;
+			}
+
+			void **child = wfPrivate::wfRadixMapFindChild(node, key[depth]);
+			if (!child)
+				return wfNullPointer;
+
+			pointer = *child;
+			depth ++;
+		}
+		return wfNullPointer;
+	}
+
+	// the subtree holding exactly the keys starting with prefix
+	void *FindPrefix(const unsigned char *prefix, size_t length) const {
+		void   *pointer = m_root;
+		size_t  depth   = 0;
+		while (pointer) {
+			if (wfPrivate::wfRadixMapIsLeaf(pointer)) {
+				const wfPrivate::wfRadixMapLeaf *leaf = wfPrivate::wfRadixMapAsLeaf(pointer);
+				if (leaf->m_length < length || memcmp(leaf->m_key, prefix, length) != 0)
+					return wfNullPointer;
+				return pointer;
+			}
+
+			wfPrivate::wfRadixMapNode *node  = static_cast<wfPrivate::wfRadixMapNode*>(pointer);
+			const size_t               match = wfPrivate::wfRadixMapMatch(node, prefix, length, depth);
+			if (depth + match == length)
+				return pointer;
+			if (match != node->m_prefixLength)
+				return wfNullPointer;
+
+			depth += node->m_prefixLength;
+			void **child = wfPrivate::wfRadixMapFindChild(node, prefix[depth]);
+			if (!child)
+				return wfNullPointer;
+
+			pointer = *child;
+			depth ++;
+		}
+		return wfNullPointer;
+	}
+
+	template <typename F>
+	static void Visit(void *pointer, F& function) {
+		if (!pointer)
+			return;
+
+		if (wfPrivate::wfRadixMapIsLeaf(pointer)) {
+			Leaf *leaf = static_cast<Leaf*>(wfPrivate::wfRadixMapAsLeaf(pointer));
+			function(wfStringRef(reinterpret_cast<const char*>(leaf->m_key), leaf->m_length), leaf->m_value);
+			return;
+		}
+
+		// the terminal is a prefix of every other key below, it comes first
+		wfPrivate::wfRadixMapNode *node = static_cast<wfPrivate::wfRadixMapNode*>(pointer);
+		Visit(node->m_terminal, function);
+		switch (node->m_type) {
+			case wfPrivate::wfRadixMapType4:
+				for (u32 i = 0; i < node->m_count; i++)
+					Visit(static_cast<wfPrivate::wfRadixMapNode4*>(node)->m_children[i], function);
+				break;
+			case wfPrivate::wfRadixMapType16:
+				for (u32 i = 0; i < node->m_count; i++)
+					Visit(static_cast<wfPrivate::wfRadixMapNode16*>(node)->m_children[i], function);
+				break;
+			case wfPrivate::wfRadixMapType48: {
+				wfPrivate::wfRadixMapNode48 *n = static_cast<wfPrivate::wfRadixMapNode48*>(node);
+				for (u32 i = 0; i < 256; i++) {
+					if (n->m_index[i])
+						Visit(n->m_children[n->m_index[i] - 1], function);
+				}
+				break;
+			}
+			default:
+				for (u32 i = 0; i < 256; i++)
+					Visit(static_cast<wfPrivate::wfRadixMapNode256*>(node)->m_children[i], function);
+				break;
+		}
+	}
+
+	void   *m_root;
+	size_t  m_length;
+
+	wfRadixMap(const wfRadixMap&);
+	wfRadixMap& operator=(const wfRadixMap&);
+};
+
+#endif
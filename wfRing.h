@@ -0,0 +1,543 @@
+#ifndef WF_STDLIB_RING_HDR
+#define WF_STDLIB_RING_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+#include "wfAtomic.h"
+#include "wfThread.h"
+
+/*
+ * File: wfRing
+ *  Bounded lock-free queues between threads.
+ *
+ * >#include "wfRing.h"
+ *
+ *  Fixed capacity first-in first-out queues that allocate nothing once
+ *  constructed.  <wfSpscRing> connects exactly one producer with exactly
+ *  one consumer, <wfMpmcRing> any number of each.  Neither ever blocks: a
+ *  push into a full ring and a pop from an empty ring fail right away.
+ *  <wfBlockingRing> wraps either into a queue that waits instead, first
+ *  spinning for a short while and then sleeping.
+ *
+ *  Every operation has a batch form which moves a run of elements with a
+ *  single update of the shared indices, pipeline stages that pass many
+ *  small items should prefer those.
+ */
+
+namespace wfPrivate {
+	enum {
+		wfRingCacheLine = 64
+	};
+
+	// storage for elements constructed and destroyed in place
+	template <typename T, size_t N>
+	union wfRingStorage {
+		char        m_bytes[N * sizeof(T)];
+		long double m_align;
+		void       *m_alignPointer;
+
+		T *Data() { return reinterpret_cast<T*>(m_bytes); }
+	};
+}
+
+/*
+ * Class: wfSpscRing
+ *  A bounded wait-free queue for a single producer and a single consumer.
+ *
+ * Parameters:
+ *  T - The element data type.
+ *  N - The capacity, a power of two.
+ *
+ * Remarks:
+ *  The push index and the pop index live on cache lines of their own, so
+ *  that the producer and the consumer do not write to the same line.  Each
+ *  side also keeps the last value it read of the index of the other side,
+ *  and only reads the shared index again when that cached value says the
+ *  ring is full (or empty): in a steady stream the line of the other side
+ *  is read about once per lap rather than once per element.
+ *
+ *  <TryPush> and <TryPushBatch> must only be called from one thread at a
+ *  time, as must <TryPop> and <TryPopBatch>.  The elements are stored in
+ *  the object itself.
+ */
+template <typename T, size_t N>
+struct wfSpscRing {
+	typedef T ValueType;
+
+	wfSpscRing() :
+		m_tail      (0),
+		m_cachedHead(0),
+		m_head      (0),
+		m_cachedTail(0)
+	{
+		typedef char PowerOfTwo[(N > 1 && (N & (N - 1)) == 0) ? 1 : -1];
+		(void)sizeof(PowerOfTwo);
+	}
+
+	~wfSpscRing() {
+		for (size_t i = m_head; i != m_tail; i++)
+			m_storage.Data()[i & (N - 1)].~T();
+	}
+
+	/*
+	 * Function: Capacity
+	 *  Returns the number of elements the ring holds.
+	 */
+	static size_t Capacity() { return N; }
+
+	/*
+	 * Function: TryPush
+	 *  Adds a copy of an element at the back, from the producer.
+	 *
+	 * Returns:
+	 *  *true* if it was added; *false* if the ring is full.
+	 */
+	bool TryPush(const T& value) {
+		const size_t tail = m_tail;
+		if (tail - m_cachedHead == N) {
+			m_cachedHead = wfAtomicLoad(&m_head);
+			if (tail - m_cachedHead == N)
+				return false;
+		}
+		new (&m_storage.Data()[tail & (N - 1)]) T(value);
+		wfAtomicStore(&m_tail, tail + 1);
+		return true;
+	}
+
+	/*
+	 * Function: TryPushBatch
+	 *  Adds copies of as many elements of a run as fit, from the producer.
+	 *
+	 * Parameters:
+	 *  values - The elements to add, in order.
+	 *  count  - The number of elements.
+	 *
+	 * Returns:
+	 *  The number of elements added, from the start of the run.
+	 */
+	size_t TryPushBatch(const T *values, size_t count) {
+		const size_t tail = m_tail;
+		if (N - (tail - m_cachedHead) < count)
+			m_cachedHead = wfAtomicLoad(&m_head);
+
+		const size_t room = N - (tail - m_cachedHead);
+		if (count > room)
+			count = room;
+		for (size_t i = 0; i < count; i++)
+			new (&m_storage.Data()[(tail + i) & (N - 1)]) T(values[i]);
+		if (count)
+			wfAtomicStore(&m_tail, tail + count);
+		return count;
+	}
+
+	/*
+	 * Function: TryPop
+	 *  Removes the element at the front, from the consumer.
+	 *
+	 * Parameters:
+	 *  value - Receives the element.
+	 *
+	 * Returns:
+	 *  *true* if an element was removed; *false* if the ring is empty.
+	 */
+	bool TryPop(T& value) {
+		const size_t head = m_head;
+		if (head == m_cachedTail) {
+			m_cachedTail = wfAtomicLoad(&m_tail);
+			if (head == m_cachedTail)
+				return false;
+		}
+		T& slot = m_storage.Data()[head & (N - 1)];
+		value = slot;
+		slot.~T();
+		wfAtomicStore(&m_head, head + 1);
+		return true;
+	}
+
+	/*
+	 * Function: TryPopBatch
+	 *  Removes up to a number of elements from the front, from the consumer.
+	 *
+	 * Parameters:
+	 *  values - Receives the elements, in order.
+	 *  count  - The most elements to remove.
+	 *
+	 * Returns:
+	 *  The number of elements removed.
+	 */
+	size_t TryPopBatch(T *values, size_t count) {
+		const size_t head = m_head;
+		if (m_cachedTail - head < count)
+			m_cachedTail = wfAtomicLoad(&m_tail);
+
+		const size_t ready = m_cachedTail - head;
+		if (count > ready)
+			count = ready;
+		for (size_t i = 0; i < count; i++) {
+			T& slot = m_storage.Data()[(head + i) & (N - 1)];
+			values[i] = slot;
+			slot.~T();
+		}
+		if (count)
+			wfAtomicStore(&m_head, head + count);
+		return count;
+	}
+
+private:
+	// written by the producer
+	volatile size_t m_tail;
+	size_t          m_cachedHead;
+	char            m_padProducer[wfPrivate::wfRingCacheLine - 2 * sizeof(size_t)];
+
+	// written by the consumer
+	volatile size_t m_head;
+	size_t          m_cachedTail;
+	char            m_padConsumer[wfPrivate::wfRingCacheLine - 2 * sizeof(size_t)];
+
+	wfPrivate::wfRingStorage<T, N> m_storage;
+
+	wfSpscRing(const wfSpscRing&);
+	wfSpscRing& operator=(const wfSpscRing&);
+};
+
+namespace wfPrivate {
+	template <typename T>
+	struct wfMpmcRingCell {
+		volatile size_t m_sequence;
+		T               m_value;
+	};
+}
+
+/*
+ * Class: wfMpmcRing
+ *  A bounded lock-free queue for any number of producers and consumers.
+ *
+ * Parameters:
+ *  T - The element data type.
+ *
+ * Remarks:
+ *  Dmitry Vyukov's bounded queue.  Every slot carries a sequence number
+ *  telling for which lap of the push index it is free and for which lap
+ *  of the pop index it holds an element.  A thread claims a slot, or a run
+ *  of consecutive slots for a batch, with one compare-and-swap of the push
+ *  or pop index, then copies the elements and publishes each slot by
+ *  advancing its sequence.  The push index and the pop index live on cache
+ *  lines of their own.
+ *
+ *  A thread which is suspended between claiming a slot and publishing it
+ *  holds up the threads after it on the other side, who see that slot as
+ *  full (or empty) until it is published.
+ */
+template <typename T>
+struct wfMpmcRing {
+	typedef T ValueType;
+
+	/*
+	 * Constructor: wfMpmcRing
+	 *  Allocates a ring with room for at least a number of elements,
+	 *  rounded up to a power of two.
+	 */
+	explicit wfMpmcRing(size_t capacity, wfHeap *heap = &g_miscHeap) :
+		m_heap(heap),
+		m_tail(0),
+		m_head(0)
+	{
+		size_t rounded = 2;
+		while (rounded < capacity)
+			rounded *= 2;
+
+		m_mask  = rounded - 1;
+		m_cells = static_cast<Cell*>(m_heap->Alloc(rounded * sizeof(Cell)));
+		for (size_t i = 0; i < rounded; i++)
+			m_cells[i].m_sequence = i;
+	}
+
+	~wfMpmcRing() {
+		for (size_t i = m_head; i != m_tail; i++)
+			m_cells[i & m_mask].m_value.~T();
+		m_heap->Free(m_cells);
+	}
+
+	/*
+	 * Function: Capacity
+	 *  Returns the number of elements the ring holds.
+	 */
+	size_t Capacity() const { return m_mask + 1; }
+
+	/*
+	 * Function: TryPush
+	 *  Adds a copy of an element at the back.
+	 *
+	 * Returns:
+	 *  *true* if it was added; *false* if the ring is full.
+	 */
+	bool TryPush(const T& value) {
+		return TryPushBatch(&value, 1) == 1;
+	}
+
+	/*
+	 * Function: TryPushBatch
+	 *  Adds copies of as many elements of a run as there are free slots
+	 *  following each other.
+	 *
+	 * Parameters:
+	 *  values - The elements to add, in order.
+	 *  count  - The number of elements.
+	 *
+	 * Returns:
+	 *  The number of elements added, from the start of the run.
+	 *
+	 * Remarks:
+	 *  The elements are added next to each other, no other producer puts
+	 *  anything between them.
+	 */
+	size_t TryPushBatch(const T *values, size_t count) {
+		if (count == 0)
+			return 0;
+
+		size_t tail = wfAtomicLoadRelaxed(&m_tail);
+		size_t claimed;
+		for (;;) {
+			// a slot is free for this lap when its sequence is its position
+			claimed = 0;
+			while (claimed < count && wfAtomicLoad(&m_cells[(tail + claimed) & m_mask].m_sequence) == tail + claimed)
+				claimed ++;
+
+			if (claimed == 0) {
+				const size_t sequence = wfAtomicLoad(&m_cells[tail & m_mask].m_sequence);
+				if (static_cast<ptrdiff_t>(sequence - tail) < 0)
+					return 0;
+				tail = wfAtomicLoadRelaxed(&m_tail);
+				continue;
+			}
+
+			if (wfAtomicCompareExchange(&m_tail, tail, tail + claimed))
+				break;
+			wfCpuRelax();
+		}
+
+		for (size_t i = 0; i < claimed; i++) {
+			Cell& cell = m_cells[(tail + i) & m_mask];
+			new (&cell.m_value) T(values[i]);
+			wfAtomicStore(&cell.m_sequence, tail + i + 1);
+		}
+		return claimed;
+	}
+
+	/*
+	 * Function: TryPop
+	 *  Removes the element at the front.
+	 *
+	 * Parameters:
+	 *  value - Receives the element.
+	 *
+	 * Returns:
+	 *  *true* if an element was removed; *false* if the ring is empty.
+	 */
+	bool TryPop(T& value) {
+		return TryPopBatch(&value, 1) == 1;
+	}
+
+	/*
+	 * Function: TryPopBatch
+	 *  Removes up to a number of elements from the front, as many as are
+	 *  published following each other.
+	 *
+	 * Parameters:
+	 *  values - Receives the elements, in order.
+	 *  count  - The most elements to remove.
+	 *
+	 * Returns:
+	 *  The number of elements removed.
+	 */
+	size_t TryPopBatch(T *values, size_t count) {
+		if (count == 0)
+			return 0;
+
+		size_t head = wfAtomicLoadRelaxed(&m_head);
+		size_t claimed;
+		for (;;) {
+			// a slot holds an element for this lap when its sequence is one past
+			// its position
+			claimed = 0;
+			while (claimed < count && wfAtomicLoad(&m_cells[(head + claimed) & m_mask].m_sequence) == head + claimed + 1)
+				claimed ++;
+
+			if (claimed == 0) {
+				const size_t sequence = wfAtomicLoad(&m_cells[head & m_mask].m_sequence);
+				if (static_cast<ptrdiff_t>(sequence - (head + 1)) < 0)
+					return 0;
+				head = wfAtomicLoadRelaxed(&m_head);
+				continue;
+			}
+
+			if (wfAtomicCompareExchange(&m_head, head, head + claimed))
+				break;
+			wfCpuRelax();
+		}
+
+		for (size_t i = 0; i < claimed; i++) {
+			Cell& cell = m_cells[(head + i) & m_mask];
+			values[i] = cell.m_value;
+			cell.m_value.~T();
+			wfAtomicStore(&cell.m_sequence, head + i + m_mask + 1);
+		}
+		return claimed;
+	}
+
+private:
+	typedef wfPrivate::wfMpmcRingCell<T> Cell;
+
+	wfHeap          *m_heap;
+	Cell            *m_cells;
+	size_t           m_mask;
+	char             m_padShared[wfPrivate::wfRingCacheLine - 3 * sizeof(void*)];
+
+	volatile size_t  m_tail;
+	char             m_padTail[wfPrivate::wfRingCacheLine - sizeof(size_t)];
+
+	volatile size_t  m_head;
+	char             m_padHead[wfPrivate::wfRingCacheLine - sizeof(size_t)];
+
+	wfMpmcRing(const wfMpmcRing&);
+	wfMpmcRing& operator=(const wfMpmcRing&);
+};
+
+/*
+ * Class: wfBlockingRing
+ *  A ring whose push waits while it is full and whose pop waits while it
+ *  is empty.
+ *
+ * Parameters:
+ *  R - The ring, a <wfSpscRing> or a <wfMpmcRing>.
+ *
+ * Remarks:
+ *  A waiting thread retries for a short while, which covers the common
+ *  case of the other side being just behind, and then sleeps on a
+ *  condition variable.  Threads only take the mutex to sleep and to wake
+ *  sleepers, a ring where nobody sleeps costs a fence and a load per
+ *  operation over the ring it wraps.  The rules of *R* about which
+ *  threads may push and pop still apply.
+ */
+template <typename R>
+struct wfBlockingRing {
+	typedef typename R::ValueType T;
+
+	wfBlockingRing() :
+		m_pushWaiters(0),
+		m_popWaiters (0)
+	{ }
+
+	/*
+	 * Constructor: wfBlockingRing
+	 *  Constructs the ring with an argument, such as the capacity of a
+	 *  <wfMpmcRing>.
+	 */
+	template <typename A>
+	explicit wfBlockingRing(const A& argument) :
+		m_ring       (argument),
+		m_pushWaiters(0),
+		m_popWaiters (0)
+	{ }
+
+	/*
+	 * Function: GetRing
+	 *  Returns the wrapped ring, for pushing and popping without waiting.
+	 */
+	R& GetRing() { return m_ring; }
+
+	/*
+	 * Function: Push
+	 *  Adds a copy of an element at the back, waiting for room.
+	 */
+	void Push(const T& value) {
+		PushBatch(&value, 1);
+	}
+
+	/*
+	 * Function: PushBatch
+	 *  Adds copies of a run of elements, waiting for room as often as
+	 *  needed until all of them have been added.
+	 */
+	void PushBatch(const T *values, size_t count) {
+		while (count) {
+			size_t pushed = m_ring.TryPushBatch(values, count);
+			for (u32 spins = 0; pushed == 0 && spins < kSpins; spins++) {
+				wfCpuRelax();
+				pushed = m_ring.TryPushBatch(values, count);
+			}
+
+			if (pushed == 0) {
+				wfLockGuard<wfMutex> guard(m_lock);
+				wfAtomicFetchAdd(&m_pushWaiters, 1u);
+				while ((pushed = m_ring.TryPushBatch(values, count)) == 0)
+					m_notFull.Wait(m_lock);
+				wfAtomicFetchAdd(&m_pushWaiters, ~0u);
+			}
+
+			values += pushed;
+			count  -= pushed;
+			Wake(m_popWaiters, m_notEmpty);
+		}
+	}
+
+	/*
+	 * Function: Pop
+	 *  Removes the element at the front, waiting for one.
+	 */
+	void Pop(T& value) {
+		PopBatch(&value, 1);
+	}
+
+	/*
+	 * Function: PopBatch
+	 *  Removes up to a number of elements from the front, waiting until
+	 *  there is at least one.
+	 *
+	 * Returns:
+	 *  The number of elements removed, at least one.
+	 */
+	size_t PopBatch(T *values, size_t count) {
+		size_t popped = m_ring.TryPopBatch(values, count);
+		for (u32 spins = 0; popped == 0 && spins < kSpins; spins++) {
+			wfCpuRelax();
+			popped = m_ring.TryPopBatch(values, count);
+		}
+
+		if (popped == 0) {
+			wfLockGuard<wfMutex> guard(m_lock);
+			wfAtomicFetchAdd(&m_popWaiters, 1u);
+			while ((popped = m_ring.TryPopBatch(values, count)) == 0)
+				m_notEmpty.Wait(m_lock);
+			wfAtomicFetchAdd(&m_popWaiters, ~0u);
+		}
+
+		Wake(m_pushWaiters, m_notFull);
+		return popped;
+	}
+
+private:
+	enum { kSpins = 1024 };
+
+	// the fence orders the update of the ring before the load of the
+	// waiters: a waiter either sees the update when it retries under the
+	// lock, or has registered before and is woken here
+	void Wake(volatile u32& waiters, wfConditionVariable& condition) {
+		wfAtomicFence();
+		if (wfAtomicLoadRelaxed(&waiters) == 0)
+			return;
+		wfLockGuard<wfMutex> guard(m_lock);
+		condition.NotifyAll();
+	}
+
+	R                   m_ring;
+	wfMutex             m_lock;
+	wfConditionVariable m_notFull;
+	wfConditionVariable m_notEmpty;
+	volatile u32        m_pushWaiters;
+	volatile u32        m_popWaiters;
+
+	wfBlockingRing(const wfBlockingRing&);
+	wfBlockingRing& operator=(const wfBlockingRing&);
+};
+
+#endif
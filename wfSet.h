@@ -3,12 +3,74 @@
 #include "wfAlgorithm.h"
 #include "wfFunctional.h"
 #include "wfNullPointer.h"
+#include "wfPair.h"
 
-namespace wfPrivate {
+/*
+ * Type: wfSetAugment
+ *  Selects the extra bookkeeping kept in every node of a <wfSet> or
+ *  <wfMap>, given as the last template argument of the container.
+ *
+ * Values:
+ *   kSetAugment_None -- No extra bookkeeping (the default)
+ *   kSetAugment_Rank -- Every node keeps the size of its subtree, which
+ *                       enables <wfSet::Rank> and <wfSet::Select> in
+ *                       O(log n) at the cost of one *size_t* per node
+ */
+enum wfSetAugment {
+	kSetAugment_None,
+	kSetAugment_Rank
+};
 
+namespace wfPrivate {
+	//
+	// The part of an element the tree is ordered by.  A set orders its
+	// elements by the whole value, a set of <wfPair> (which is what a
+	// <wfMap> is) orders its elements by the first member of the pair
+	// only.
+	//
 	template <typename T>
-	struct wfSetNode {
+	struct wfSetKey {
+		typedef T Type;
+		static const T& Get(const T& data) { return data; }
+	};
+
+	template <typename T, typename U>
+	struct wfSetKey<wfPair<T, U> > {
+		typedef T Type;
+		static const T& Get(const wfPair<T, U>& data) { return data.first; }
+	};
+
+
+	//
+	// Node augmentation: nothing at all unless asked for, in which case the
+	// node carries the size of the subtree rooted at it (nil is size 0).
+	//
+	template <wfSetAugment A>
+	struct wfSetNodeAugment {
+		wfSetNodeAugment(size_t) { }
+
+		template <typename N>
+		static void Update(N *) { }
+	};
+
+	template <>
+	struct wfSetNodeAugment<kSetAugment_Rank> {
+		wfSetNodeAugment(size_t size) :
+			m_size(size)
+		{ }
+
+		template <typename N>
+		static void Update(N *node) {
+			node->m_size = node->m_left->m_size + node->m_right->m_size + 1;
+		}
+
+		size_t m_size;
+	};
+
+	template <typename T, wfSetAugment A = kSetAugment_None>
+	struct wfSetNode : wfSetNodeAugment<A> {
 		wfSetNode() :
+			wfSetNodeAugment<A>(0),
 			m_level (0),
 			m_parent(this),
 			m_left  (this),
@@ -16,6 +78,7 @@ namespace wfPrivate {
 		{ };
 		
 		wfSetNode(const T& data, wfSetNode *sides, wfSetNode *parent) :
+			wfSetNodeAugment<A>(1),
 			m_data  (data),
 			m_level (1),
 			m_parent(parent),
@@ -37,11 +100,11 @@ namespace wfPrivate {
 		
 	protected:
 		
-		template <typename U>             friend struct wfSetIterator;
-		template <typename U>             friend struct wfSetConstIterator;
-		template <typename U>             friend struct wfSet;
-		template <typename U, typename V> friend struct wfMap;
-		template <typename U, typename V> friend struct wfPair;
+		template <typename U, wfSetAugment>             friend struct wfSetIterator;
+		template <typename U, wfSetAugment>             friend struct wfSetConstIterator;
+		template <typename U, wfSetAugment>             friend struct wfSet;
+		template <typename U, typename V, wfSetAugment> friend struct wfMap;
+		template <typename U, typename V>               friend struct wfPair;
 	};
 }
 
@@ -49,19 +112,24 @@ namespace wfPrivate {
  * Class: wfSet
  *  An efficent associative container using AA tree
  *
+ * Parameters:
+ *  T - The element data type to be stored in the <wfSet>.
+ *  A - The <wfSetAugment> bookkeeping to keep in every node, defaults
+ *      to *kSetAugment_None*.
+ *
  * Remarks:
  *  An efficent associative container using AA tree.  Can be used for
  *  efficent key-value associations that are ordered, while retaining
  *  efficent insertion and search time.
  */
-template <typename T>
+template <typename T, wfSetAugment A = kSetAugment_None>
 struct wfSet;
 
 /*
  * Class: wfSetIterator
  *  Bidirectional iterator, no offsets.
  */
-template<typename T>
+template<typename T, wfSetAugment A = kSetAugment_None>
 struct wfSetIterator {
 	typedef ptrdiff_t DifferenceType;
 	typedef T         ValueType;
@@ -72,7 +140,7 @@ struct wfSetIterator {
 		m_node(wfNullPointer)
 	{ };
 	
-	wfSetIterator(wfPrivate::wfSetNode<T> *node) :
+	wfSetIterator(wfPrivate::wfSetNode<T, A> *node) :
 		m_node(node)
 	{ };
 	
@@ -90,14 +158,14 @@ struct wfSetIterator {
 				m_node = m_node->m_left;
 			}
 		} else {
-			wfPrivate::wfSetNode<T> *node = m_node->m_parent;
+			wfPrivate::wfSetNode<T, A> *node = m_node->m_parent;
 			while (m_node == node->m_right) {
 				m_node = node;
 				node   = node->m_parent;
 			}
 			
-			if (m_node->m_right != node)
-				m_node = node;
+			// climbed out of the root: node is the nil end
+			m_node = node;
 		}
 		
 		return *this;
@@ -110,14 +178,13 @@ struct wfSetIterator {
 				m_node = m_node->m_right;
 			}
 		} else {
-			wfPrivate::wfSetNode<T> *node = m_node->m_parent;
+			wfPrivate::wfSetNode<T, A> *node = m_node->m_parent;
 			while (m_node->m_level != 0 && m_node == node->m_left) {
 				m_node = node;
 				node   = node->m_parent;
 			}
 			
-			if (m_node->m_left != node)
-				m_node = node;
+			m_node = node;
 		}
 		
 		return *this;
@@ -146,21 +213,22 @@ struct wfSetIterator {
 	) { return a.m_node != b.m_node; }
 	
 protected:
-	wfPrivate::wfSetNode<T> *m_node;
+	wfPrivate::wfSetNode<T, A> *m_node;
 	
-	template <typename U> friend struct wfSetIterator;
-	template <typename U> friend struct wfSetConstIterator;
+	template <typename U, wfSetAugment> friend struct wfSetIterator;
+	template <typename U, wfSetAugment> friend struct wfSetConstIterator;
+	template <typename U, wfSetAugment> friend struct wfSet;
 };
 
-template <typename T>
-struct wfSetConstIterator : wfSetIterator<T> {
-	typedef typename wfIteratorTraits<T>::DifferenceType DifferenceType;
-	typedef typename wfIteratorTraits<T>::ValueType      ValueType;
+template <typename T, wfSetAugment A = kSetAugment_None>
+struct wfSetConstIterator : wfSetIterator<T, A> {
+	typedef ptrdiff_t DifferenceType;
+	typedef T         ValueType;
 
     typedef const T* PointerType;
     typedef const T& ReferenceType;
 	
-	wfSetConstIterator(const wfSetIterator<T> &it) {
+	wfSetConstIterator(const wfSetIterator<T, A> &it) {
 		this->m_node = it.m_node;
 	}
 	
@@ -168,7 +236,77 @@ struct wfSetConstIterator : wfSetIterator<T> {
 	PointerType   operator ->() const { return &this->m_node->m_data; }
 };
 
-template <typename T>
+/*
+ * Class: wfSetNodeHandle
+ *  Owns a node taken out of a <wfSet> or <wfMap> with <wfSet::Extract>.
+ *
+ * Remarks:
+ *  The element stays in the memory it was allocated in while it is moved
+ *  from one container to another with <wfSet::Insert>, nothing is
+ *  allocated, copied or freed.  The element can be modified through the
+ *  handle, including its key, before it is inserted again.
+ *
+ *  Copying a handle transfers the node to the copy and leaves the source
+ *  empty.  A handle still owning a node when it is destroyed destroys the
+ *  element and frees the node.
+ */
+template <typename T, wfSetAugment A = kSetAugment_None>
+struct wfSetNodeHandle {
+	wfSetNodeHandle() :
+		m_node(wfNullPointer)
+	{ }
+
+	wfSetNodeHandle(const wfSetNodeHandle& handle) :
+		m_node(handle.Release())
+	{ }
+
+	wfSetNodeHandle& operator=(const wfSetNodeHandle& handle) {
+		if (&handle != this) {
+			Destroy();
+			m_node = handle.Release();
+		}
+		return *this;
+	}
+
+	~wfSetNodeHandle() {
+		Destroy();
+	}
+
+	/*
+	 * Function: Empty
+	 *  Tests if the handle owns no node.
+	 */
+	bool Empty() const { return m_node == wfNullPointer; }
+
+	T& operator * () const { return  m_node->m_data; }
+	T* operator ->() const { return &m_node->m_data; }
+
+private:
+	explicit wfSetNodeHandle(wfPrivate::wfSetNode<T, A> *node) :
+		m_node(node)
+	{ }
+
+	wfPrivate::wfSetNode<T, A> *Release() const {
+		wfPrivate::wfSetNode<T, A> *node = m_node;
+		m_node = wfNullPointer;
+		return node;
+	}
+
+	void Destroy() {
+		if (!m_node)
+			return;
+
+		m_node->wfPrivate::wfSetNode<T, A>::~wfSetNode();
+		g_miscHeap.Free(m_node);
+		m_node = wfNullPointer;
+	}
+
+	mutable wfPrivate::wfSetNode<T, A> *m_node;
+
+	template <typename U, wfSetAugment> friend struct wfSet;
+};
+
+template <typename T, wfSetAugment A>
 struct wfSet {
 	/*
 	 * Type: Iterator
@@ -178,7 +316,7 @@ struct wfSet {
 	 * Remarks:
 	 *  A type *Iterator* can be used to modify the value of an element.
 	 */
-	typedef wfSetIterator<T>                 Iterator;
+	typedef wfSetIterator<T, A>              Iterator;
 	
 	/*
 	 * Type: ConstIterator
@@ -188,7 +326,7 @@ struct wfSet {
 	 * Remarks:
 	 *  A type *ConstIterator* cannot be used to modify the value of an element.
 	 */
-	typedef wfSetConstIterator<T>            ConstIterator;
+	typedef wfSetConstIterator<T, A>         ConstIterator;
 	
 	/*
 	 * Type: ReverseIterator
@@ -210,9 +348,16 @@ struct wfSet {
 	 *  iterate through the <wfSet> in reverse.
 	 */
 	typedef wfReverseIterator<ConstIterator> ConstReverseIterator;
-	
+
+	/*
+	 * Type: NodeHandle
+	 *  A type that owns an element removed from a <wfSet> with <Extract>, along with
+	 *  the memory of its node.
+	 */
+	typedef wfSetNodeHandle<T, A>            NodeHandle;
+
 	wfSet() :
-		m_root  (new (reinterpret_cast<wfPrivate::wfSetNode<T>*>(g_miscHeap.Alloc(sizeof(wfPrivate::wfSetNode<T>)))) wfPrivate::wfSetNode<T>),
+		m_root  (new (reinterpret_cast<wfPrivate::wfSetNode<T, A>*>(g_miscHeap.Alloc(sizeof(wfPrivate::wfSetNode<T, A>)))) wfPrivate::wfSetNode<T, A>),
 		m_nil   (wfNullPointer),
 		m_length(static_cast<size_t>(0))
 	{
@@ -222,7 +367,7 @@ struct wfSet {
 	~wfSet() {
 		this->DestroyNode(m_root);
 
-		m_nil->wfPrivate::wfSetNode<T>::~wfSetNode();
+		m_nil->wfPrivate::wfSetNode<T, A>::~wfSetNode();
 		g_miscHeap.Free(m_nil);
 	}
 	
@@ -259,7 +404,7 @@ struct wfSet {
 	 *  a const cv-qualified version of this function as well.
 	 */
 	Iterator Begin() {
-		wfPrivate::wfSetNode<T> *node = m_root;
+		wfPrivate::wfSetNode<T, A> *node = m_root;
 		while (node != m_nil) {
 			if (node->m_left == m_nil)
 				break;
@@ -270,7 +415,7 @@ struct wfSet {
 		return Iterator(node);
 	}
 	ConstIterator Begin() const {
-		wfPrivate::wfSetNode<T> *node = m_root;
+		wfPrivate::wfSetNode<T, A> *node = m_root;
 		while (node != m_nil) {
 			if (node->m_left == m_nil)
 				break;
@@ -314,14 +459,14 @@ struct wfSet {
 	 *  as well.
 	 */
 	Iterator End() {
-		wfPrivate::wfSetNode<T> *node = m_root;
+		wfPrivate::wfSetNode<T, A> *node = m_root;
 		while (node != m_nil)
 			node = node->m_right;
 			
 		return Iterator(node);
 	}
 	ConstIterator End() const {
-		wfPrivate::wfSetNode<T> *node = m_root;
+		wfPrivate::wfSetNode<T, A> *node = m_root;
 		while (node != m_nil)
 			node = node->m_right;
 			
@@ -366,17 +511,103 @@ struct wfSet {
 	T& Insert(const T& data) {
 		return Insert(m_root, data)->m_data;
 	}
-	
+
+	/*
+	 * Function: Insert
+	 *  Links the node owned by a <NodeHandle> into a <wfSet>.
+	 *
+	 * Parameters:
+	 *  handle - The handle of a node extracted from this or another set of the
+	 *           same type.  It is left empty if the node was linked.
+	 *
+	 * Returns:
+	 *  A reference to the element linked, or to the element which already exists
+	 *  if the set had already contained an element whose key value was
+	 *  equivalently ordered, in which case the handle keeps its node.
+	 *
+	 * Remarks:
+	 *  Nothing is allocated or copied.  The handle must not be empty.
+	 */
+	T& Insert(NodeHandle& handle) {
+		wfPrivate::wfSetNode<T, A> *node = Insert(m_root, Key::Get(handle.m_node->m_data), wfNullPointer, handle.m_node);
+		if (node == handle.m_node)
+			handle.m_node = wfNullPointer;
+
+		return node->m_data;
+	}
+
+	/*
+	 * Function: Extract
+	 *  Unlinks an element from a <wfSet> without destroying it.
+	 *
+	 * Parameters:
+	 *  it - An iterator addressing the element to unlink, which must not be
+	 *       <End>.
+	 *
+	 * Returns:
+	 *  A <NodeHandle> owning the element and its node.
+	 *
+	 * Remarks:
+	 *  Iterators addressing other elements remain valid, nodes are relinked
+	 *  rather than having elements copied between them.  The handle can be given
+	 *  to <Insert> of any set of the same type, for instance to move an element
+	 *  from one set to another without allocating.
+	 */
+	NodeHandle Extract(Iterator it) {
+		return NodeHandle(Erase(m_root, Key::Get(NodeOf(it)->m_data)));
+	}
+
+	/*
+	 * Function: Merge
+	 *  Moves every element of another <wfSet> whose key is not already present
+	 *  into this one.
+	 *
+	 * Parameters:
+	 *  set - The set to take the elements from.  Elements whose key is already
+	 *        present are left in it.
+	 *
+	 * Remarks:
+	 *  The nodes of *set* are relinked, nothing is allocated or copied.  Merging
+	 *  into an empty set takes over the whole tree in O(1).
+	 */
+	void Merge(wfSet& set) {
+		if (&set == this)
+			return;
+
+		if (Empty()) {
+			wfPrivate::wfSetNode<T, A> *root = m_root;
+			wfPrivate::wfSetNode<T, A> *nil  = m_nil;
+
+			m_root       = set.m_root;
+			m_nil        = set.m_nil;
+			m_length     = set.m_length;
+			set.m_root   = root;
+			set.m_nil    = nil;
+			set.m_length = 0;
+			return;
+		}
+
+		Iterator it = set.Begin();
+		while (it != Iterator(set.m_nil)) {
+			wfPrivate::wfSetNode<T, A> *node = NodeOf(it++);
+			if (FindNode(Key::Get(node->m_data)) != m_nil)
+				continue;
+
+			set.Erase(set.m_root, Key::Get(node->m_data));
+			Insert(m_root, Key::Get(node->m_data), wfNullPointer, node);
+		}
+	}
+
 	/*
 	 * Function: Clear
 	 *  Erases all the elements of a <wfSet>.
 	 */
 	void Clear() {
 		DestroyNode(m_root);
-		m_nil->wfPrivate::wfSetNode<T>::~wfSetNode();
+		m_nil->wfPrivate::wfSetNode<T, A>::~wfSetNode();
 		g_miscHeap.Free(m_nil);
 		
-		m_root   = new (reinterpret_cast<wfPrivate::wfSetNode<T>*>(g_miscHeap.Alloc(sizeof(wfPrivate::wfSetNode<T>)))) wfPrivate::wfSetNode<T>;
+		m_root   = new (reinterpret_cast<wfPrivate::wfSetNode<T, A>*>(g_miscHeap.Alloc(sizeof(wfPrivate::wfSetNode<T, A>)))) wfPrivate::wfSetNode<T, A>;
 		m_nil    = m_root;
 		m_length = 0;
 	}
@@ -386,12 +617,21 @@ struct wfSet {
 	 *  Removes an element in a <wfSet> matching a specified key.
 	 *
 	 * Parameters:
-	 *  key - The key of the element to be removed from the set.
+	 *  key - The key of the element to be removed from the set, converted
+	 *        to the key type unless it is opted in with
+	 *        <wfFunctional::wfTransparentKey>, see <Find>.
+	 *
+	 * Remarks:
+	 *  Nothing is removed if no element matches the key.
 	 */
-	void Erase(const T& key) {
-		wfPrivate::wfSetNode<T> *store = Erase(m_root, key);
-        store->wfPrivate::wfSetNode<T>::~wfSetNode();
-        g_miscHeap.Free(store);
+	template <typename U>
+	void Erase(const U& key) {
+		wfPrivate::wfSetNode<T, A> *store = Erase(m_root, Probe(key));
+		if (!store)
+			return;
+
+		store->wfPrivate::wfSetNode<T, A>::~wfSetNode();
+		g_miscHeap.Free(store);
 	}
 	
 	/*
@@ -415,24 +655,227 @@ struct wfSet {
 	 *  is assigned to a *ConstIterator*, the <wfSet> object cannot be modified.  If the
 	 *  return value of *Find* is assigned to an *Iterator*, the <wfSet> object can be
 	 *  modified.  There exists a const cv-qualified version of this function as well.
+	 *
+	 *  A key of a type opted in with <wfFunctional::wfTransparentKey>, for instance a
+	 *  <wfStringRef> for a set of C strings, is ordered against the elements as it is
+	 *  with <wfFunctional::wfCompare>.  A key of any other type is converted to the key
+	 *  type first, the same holds for every other lookup taking a key.
 	 */
-	Iterator      Find(const T& key)       { return Iterator     (Find(m_root, key)); }
-	ConstIterator Find(const T& key) const { return ConstIterator(Find(m_root, key)); }
+	template <typename U> Iterator      Find(const U& key)       { return Iterator     (FindNode(Probe(key))); }
+	template <typename U> ConstIterator Find(const U& key) const { return ConstIterator(FindNode(Probe(key))); }
+
+	/*
+	 * Function: Count
+	 *  Returns the number of elements in a <wfSet> whose key matches a specified key.
+	 *
+	 * Parameters:
+	 *  key - The key of the elements to be matched from the set.
+	 *
+	 * Returns:
+	 *  1 if the <wfSet> contains an element whose sort key matches the key; 0 otherwise.
+	 */
+	template <typename U>
+	size_t Count(const U& key) const {
+		return (FindNode(Probe(key)) != m_nil) ? 1 : 0;
+	}
+
+	/*
+	 * Function: LowerBound
+	 *  Returns an iterator to the first element in a <wfSet> with a key that is equal
+	 *  to or greater than a specified key.
+	 *
+	 * Parameters:
+	 *  key - The argument key to be compared with the sort key of an element from the
+	 *        <wfSet> being searched.
+	 *
+	 * Returns:
+	 *  An iterator or const iterator that addresses the location of the first element
+	 *  with a key that is equal to or greater than the argument key, or that addresses
+	 *  the location succeeding the last element in the set if no match is found.  There
+	 *  exists a const cv-qualified version of this function as well.
+	 */
+	template <typename U> Iterator      LowerBound(const U& key)       { return Iterator     (LowerBoundNode(Probe(key))); }
+	template <typename U> ConstIterator LowerBound(const U& key) const { return ConstIterator(LowerBoundNode(Probe(key))); }
+
+	/*
+	 * Function: UpperBound
+	 *  Returns an iterator to the first element in a <wfSet> with a key that is greater
+	 *  than a specified key.
+	 *
+	 * Parameters:
+	 *  key - The argument key to be compared with the sort key of an element from the
+	 *        <wfSet> being searched.
+	 *
+	 * Returns:
+	 *  An iterator or const iterator that addresses the location of the first element
+	 *  with a key that is greater than the argument key, or that addresses the location
+	 *  succeeding the last element in the set if no match is found.  There exists a
+	 *  const cv-qualified version of this function as well.
+	 */
+	template <typename U> Iterator      UpperBound(const U& key)       { return Iterator     (UpperBoundNode(Probe(key))); }
+	template <typename U> ConstIterator UpperBound(const U& key) const { return ConstIterator(UpperBoundNode(Probe(key))); }
+
+	/*
+	 * Function: EqualRange
+	 *  Returns a pair of iterators respectively to the first element in a <wfSet> with a
+	 *  key that is equal to a specified key and to the first element in the set with a
+	 *  key that is greater than the key.
+	 *
+	 * Parameters:
+	 *  key - The argument key to be compared with the sort key of an element from the
+	 *        <wfSet> being searched.
+	 *
+	 * Returns:
+	 *  A pair of iterators where *first* is the <LowerBound> of the key and *second*
+	 *  is the <UpperBound> of the key.  There exists a const cv-qualified version of
+	 *  this function as well.
+	 *
+	 * Remarks:
+	 *  Since the elements of a <wfSet> are unique the range is either empty or holds
+	 *  exactly one element, the upper bound is therefor found from the lower bound
+	 *  rather than with a second descent of the tree.
+	 */
+	template <typename U>
+	wfPair<Iterator, Iterator> EqualRange(const U& key) {
+		typename wfPrivate::wfLookupKey<U, KeyType>::Type probe = Probe(key);
+		Iterator lower(LowerBoundNode(probe));
+		Iterator upper(lower);
+		if (lower != End() && Compare(probe, NodeOf(lower)) == 0)
+			++upper;
+
+		return wfPair<Iterator, Iterator>(lower, upper);
+	}
+	template <typename U>
+	wfPair<ConstIterator, ConstIterator> EqualRange(const U& key) const {
+		typename wfPrivate::wfLookupKey<U, KeyType>::Type probe = Probe(key);
+		Iterator lower(LowerBoundNode(probe));
+		Iterator upper(lower);
+		if (lower != Iterator(m_nil) && Compare(probe, NodeOf(lower)) == 0)
+			++upper;
+
+		return wfPair<ConstIterator, ConstIterator>(lower, upper);
+	}
+
+	/*
+	 * Function: VisitRange
+	 *  Invokes a function on every element of a <wfSet> whose key lies within the
+	 *  half open range *[lo, hi)*, in order.
+	 *
+	 * Parameters:
+	 *  lo       - The inclusive lower bound of the range.
+	 *  hi       - The exclusive upper bound of the range.
+	 *  function - The function object invoked as *function(element)* for each element
+	 *             in the range.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied to the elements, this
+	 *  is how results accumulated by the function object are obtained.
+	 *
+	 * Remarks:
+	 *  The tree is walked directly rather than through iterators, any subtree which
+	 *  lies entirely below *lo* or entirely at or above *hi* is never entered.  The
+	 *  walk visits O(log n + k) nodes for *k* elements in range.  The set must not be
+	 *  modified by the function.  There exists a const cv-qualified version of this
+	 *  function as well, which passes elements as *const*.
+	 */
+	template <typename L, typename H, typename F>
+	F VisitRange(const L& lo, const H& hi, F function) {
+		VisitRange(m_root, Probe(lo), Probe(hi), function);
+		return function;
+	}
+	template <typename L, typename H, typename F>
+	F VisitRange(const L& lo, const H& hi, F function) const {
+		VisitRange(m_root, Probe(lo), Probe(hi), function);
+		return function;
+	}
+
+	/*
+	 * Function: Rank
+	 *  Returns the position a specified key has (or would have) in the ordered
+	 *  sequence of elements of a <wfSet>.
+	 *
+	 * Parameters:
+	 *  key - The argument key to be compared with the sort key of an element from the
+	 *        <wfSet> being searched.
+	 *
+	 * Returns:
+	 *  The number of elements whose key is less than the argument key, that is the
+	 *  zero-based index of the <LowerBound> of the key.
+	 *
+	 * Remarks:
+	 *  Only available for sets augmented with *kSetAugment_Rank*, it runs in O(log n).
+	 */
+	template <typename U>
+	size_t Rank(const U& key) const {
+		typename wfPrivate::wfLookupKey<U, KeyType>::Type probe = Probe(key);
+		const wfPrivate::wfSetNode<T, A>                 *node  = m_root;
+		size_t                                            rank  = 0;
+		while (node != m_nil) {
+			if (Compare(probe, node) <= 0) {
+				node  = node->m_left;
+			} else {
+				rank += node->m_left->m_size + 1;
+				node  = node->m_right;
+			}
+		}
+
+		return rank;
+	}
+
+	/*
+	 * Function: Select
+	 *  Returns an iterator to the element at a specified position in the ordered
+	 *  sequence of elements of a <wfSet>.
+	 *
+	 * Parameters:
+	 *  index - The zero-based position of the element.
+	 *
+	 * Returns:
+	 *  An iterator or const iterator addressing the element at position *index*, or
+	 *  the location succeeding the last element in the set if *index* is not less
+	 *  than <Length>.  There exists a const cv-qualified version of this function as
+	 *  well.
+	 *
+	 * Remarks:
+	 *  Only available for sets augmented with *kSetAugment_Rank*, it runs in O(log n).
+	 *  For instance the median of a set is *Select(Length() / 2)*.
+	 */
+	Iterator      Select(size_t index)       { return Iterator     (SelectNode(index)); }
+	ConstIterator Select(size_t index) const { return ConstIterator(SelectNode(index)); }
 	
 protected:
-	void DestroyNode(wfPrivate::wfSetNode<T> *node) {
+	typedef wfPrivate::wfSetKey<T>          Key;
+	typedef typename Key::Type              KeyType;
+	typedef wfPrivate::wfSetNodeAugment<A>  Augment;
+
+	//
+	// One three-way comparison per visited node, rather than an equality
+	// test followed by an ordering test.
+	//
+	template <typename U>
+	static int Compare(const U& key, const wfPrivate::wfSetNode<T, A> *node) {
+		return wfFunctional::wfCompare<U, KeyType>()(key, Key::Get(node->m_data));
+	}
+
+	// the key a lookup searches the tree with, see wfPrivate::wfLookupKey
+	template <typename U>
+	static typename wfPrivate::wfLookupKey<U, KeyType>::Type Probe(const U& key) {
+		return key;
+	}
+
+	void DestroyNode(wfPrivate::wfSetNode<T, A> *node) {
 		if (node == m_nil)
 			return;
 			
 		DestroyNode(node->m_left);
 		DestroyNode(node->m_right);
 		
-		node->wfPrivate::wfSetNode<T>::~wfSetNode();
+		node->wfPrivate::wfSetNode<T, A>::~wfSetNode();
 		g_miscHeap.Free(node);
 	}
 	
-	void Skew(wfPrivate::wfSetNode<T> *&n1) {
-		wfPrivate::wfSetNode<T> *n2 = wfNullPointer;
+	void Skew(wfPrivate::wfSetNode<T, A> *&n1) {
+		wfPrivate::wfSetNode<T, A> *n2 = wfNullPointer;
 		
 		if (n1->m_level && n1->m_level == n1->m_left->m_level) {
 			n2                    = n1->m_left;
@@ -441,12 +884,14 @@ protected:
 			n1->m_left->m_parent  = n1;
 			n2->m_right           = n1;
 			n2->m_right->m_parent = n2;
+			Augment::Update(n1);
+			Augment::Update(n2);
 			n1                    = n2;
 		}
 	}
 	
-	void Split(wfPrivate::wfSetNode<T> *&n1) {
-		wfPrivate::wfSetNode<T> *n2 = wfNullPointer;
+	void Split(wfPrivate::wfSetNode<T, A> *&n1) {
+		wfPrivate::wfSetNode<T, A> *n2 = wfNullPointer;
 		
 		if (n1->m_level && n1->m_level == n1->m_right->m_right->m_level) {
 			n2                    = n1->m_right;
@@ -455,58 +900,113 @@ protected:
 			n1->m_right->m_parent = n1;
 			n2->m_left            = n1;
 			n2->m_left->m_parent  = n2;
+			Augment::Update(n1);
+			Augment::Update(n2);
 			n1                    = n2;
 			n1->m_level           = n1->m_level + 1;
 		}
 	}
+
+	//
+	// Restores the AA invariants of a node whose subtree just lost an
+	// element: levels are lowered where a child fell two levels below,
+	// then the horizontal links are fixed with skews and splits.
+	//
+	void Rebalance(wfPrivate::wfSetNode<T, A> *&node) {
+		Augment::Update(node);
+
+		const size_t level = wfMin(node->m_left->m_level, node->m_right->m_level) + 1;
+		if (level < node->m_level) {
+			node->m_level = level;
+			if (level < node->m_right->m_level)
+				node->m_right->m_level = level;
+
+			Skew (node);
+			Skew (node->m_right);
+			Skew (node->m_right->m_right);
+			Split(node);
+			Split(node->m_right);
+		}
+	}
 	
-	template <typename U>
-	wfPrivate::wfSetNode<T> *Insert(wfPrivate::wfSetNode<T> *&node, const U& data, wfPrivate::wfSetNode<T> *prev = wfNullPointer) {
-		wfPrivate::wfSetNode<T> *ret = wfNullPointer;
-		
+	wfPrivate::wfSetNode<T, A> *Insert(wfPrivate::wfSetNode<T, A> *&node, const T& data) {
+		return Insert(node, Key::Get(data), &data, wfNullPointer);
+	}
+
+	//
+	// Either constructs a node from data or, when given one, links an
+	// extracted node in its place.
+	//
+	wfPrivate::wfSetNode<T, A> *Insert(wfPrivate::wfSetNode<T, A> *&node, const KeyType& key, const T *data, wfPrivate::wfSetNode<T, A> *link, wfPrivate::wfSetNode<T, A> *prev = wfNullPointer) {
 		if (node == m_nil) {
 			if (!prev)
 				 prev = m_root;
-				 
-			node = new (reinterpret_cast<wfPrivate::wfSetNode<T>*>(g_miscHeap.Alloc(sizeof(wfPrivate::wfSetNode<T>)))) wfPrivate::wfSetNode<T> (data, m_nil, prev);
+
+			if (link) {
+				link->m_left   = m_nil;
+				link->m_right  = m_nil;
+				link->m_parent = prev;
+				link->m_level  = 1;
+				Augment::Update(link);
+				node = link;
+			} else {
+				node = new (reinterpret_cast<wfPrivate::wfSetNode<T, A>*>(g_miscHeap.Alloc(sizeof(wfPrivate::wfSetNode<T, A>)))) wfPrivate::wfSetNode<T, A> (*data, m_nil, prev);
+			}
 			m_length ++;
 
             return node;
 		}
+
+		const int compare = Compare(key, node);
+		if (compare == 0)
+			return node;
+
+		wfPrivate::wfSetNode<T, A> *ret = Insert(((compare > 0)
+			? node->m_right
+			: node->m_left
+		), key, data, link, node);
 		
-		if (!wfFunctional::wfEqual<U, U>()(data, node->m_data)) {
-			ret = Insert(((wfFunctional::wfGreater<U, U>()(data, node->m_data))
-				? node->m_right
-				: node->m_left
-			), data, node);
-			
-			if (!ret)
-				return wfNullPointer;
-		}
-		
+		Augment::Update(node);
 		Skew (node);
 		Split(node);
 		
 		return ret;
 	}
 	
+	//
+	// Unlinks the node matching key and returns it, or null if there is
+	// none.  A node with two children is replaced by its in-order
+	// predecessor, which is itself unlinked and then takes over the links
+	// and level of the node, so that no element is ever copied and every
+	// other node stays where iterators expect it.
+	//
 	template <typename U>
-	wfPrivate::wfSetNode<T> *Erase(wfPrivate::wfSetNode<T> *&node, const U& key) {
+	wfPrivate::wfSetNode<T, A> *Erase(wfPrivate::wfSetNode<T, A> *&node, const U& key) {
 		if (node == m_nil)
 			return wfNullPointer;
-			
-		if (wfFunctional::wfEqual<U, T>()(key, node->m_data)) {
+
+		wfPrivate::wfSetNode<T, A> *ret     = wfNullPointer;
+		const int                   compare = Compare(key, node);
+		if (compare == 0) {
 			if (node->m_left != m_nil && node->m_right != m_nil) {
-				wfPrivate::wfSetNode<T> *heir = node->m_left;
+				wfPrivate::wfSetNode<T, A> *heir = node->m_left;
 				while (heir->m_right != m_nil)
 					heir = heir->m_right;
-					
-				node->m_data = heir->m_data;
-				
-				return Erase(node->m_left, node->m_data);
+
+				Erase(node->m_left, Key::Get(heir->m_data));
+
+				heir->m_left            = node->m_left;
+				heir->m_right           = node->m_right;
+				heir->m_level           = node->m_level;
+				heir->m_parent          = node->m_parent;
+				heir->m_left->m_parent  = heir;
+				heir->m_right->m_parent = heir;
+
+				ret  = node;
+				node = heir;
 			} else {
-				wfPrivate::wfSetNode<T> *ret = node;
-				wfPrivate::wfSetNode<T> *par = node->m_parent;
+				wfPrivate::wfSetNode<T, A> *par = node->m_parent;
+				ret = node;
 				
 				node = ((node->m_left == m_nil)
 					 ? node->m_right
@@ -516,32 +1016,128 @@ protected:
 				node->m_parent = par;
 				m_length --;
 				
+				// the child took the place of the node as is
 				return ret;
 			}
 		} else {
-			return Erase(((wfFunctional::wfLess<U, T>()(key, node->m_data))
+			ret = Erase(((compare < 0)
 						? node->m_left
 						: node->m_right
 			), key);
 		}
+
+		if (ret)
+			Rebalance(node);
+
+		return ret;
 	}
 	
-	wfPrivate::wfSetNode<T> *Find(wfPrivate::wfSetNode<T> *node, const T& key, bool add=false) {
-		if (node == m_nil)
-			return (add) ? Insert(m_root, T()) : m_nil;
+	template <typename U>
+	wfPrivate::wfSetNode<T, A> *FindNode(const U& key) const {
+		wfPrivate::wfSetNode<T, A> *node = m_root;
+		while (node != m_nil) {
+			const int compare = Compare(key, node);
+			if (compare == 0)
+				break;
+
+			node = (compare < 0) ? node->m_left : node->m_right;
+		}
 		
-		if (!wfFunctional::wfEqual<T, T>()(key, node->m_data))
-			return Find(((wfFunctional::wfLess<T, T>()(key, node->m_data))
-					? node->m_left
-					: node->m_right
-			), key, add);
-			
 		return node;
 	}
+
+	template <typename U>
+	wfPrivate::wfSetNode<T, A> *UpperBoundNode(const U& key) const {
+		wfPrivate::wfSetNode<T, A> *node  = m_root;
+		wfPrivate::wfSetNode<T, A> *bound = m_nil;
+		while (node != m_nil) {
+			if (Compare(key, node) < 0) {
+				bound = node;
+				node  = node->m_left;
+			} else {
+				node  = node->m_right;
+			}
+		}
+		
+		return bound;
+	}
+
+	template <typename L, typename H, typename F>
+	void VisitRange(wfPrivate::wfSetNode<T, A> *node, const L& lo, const H& hi, F& function) {
+		while (node != m_nil) {
+			const bool aboveLo = Compare(lo, node) <= 0;
+			const bool belowHi = Compare(hi, node) >  0;
+
+			if (aboveLo)
+				VisitRange(node->m_left, lo, hi, function);
+			if (aboveLo && belowHi)
+				function(node->m_data);
+			if (!belowHi)
+				return;
+
+			// right subtree is a tail call
+			node = node->m_right;
+		}
+	}
+
+	template <typename L, typename H, typename F>
+	void VisitRange(const wfPrivate::wfSetNode<T, A> *node, const L& lo, const H& hi, F& function) const {
+		while (node != m_nil) {
+			const bool aboveLo = Compare(lo, node) <= 0;
+			const bool belowHi = Compare(hi, node) >  0;
+
+			if (aboveLo)
+				VisitRange(static_cast<const wfPrivate::wfSetNode<T, A>*>(node->m_left), lo, hi, function);
+			if (aboveLo && belowHi)
+				function(static_cast<const T&>(node->m_data));
+			if (!belowHi)
+				return;
+
+			node = node->m_right;
+		}
+	}
+
+	wfPrivate::wfSetNode<T, A> *SelectNode(size_t index) const {
+		wfPrivate::wfSetNode<T, A> *node = m_root;
+		while (node != m_nil) {
+			const size_t left = node->m_left->m_size;
+			if (index == left)
+				break;
+
+			if (index < left) {
+				node   = node->m_left;
+			} else {
+				index -= left + 1;
+				node   = node->m_right;
+			}
+		}
+
+		return node;
+	}
+
+	static wfPrivate::wfSetNode<T, A> *NodeOf(const Iterator& it) {
+		return it.m_node;
+	}
+
+	template <typename U>
+	wfPrivate::wfSetNode<T, A> *LowerBoundNode(const U& key) const {
+		wfPrivate::wfSetNode<T, A> *node  = m_root;
+		wfPrivate::wfSetNode<T, A> *bound = m_nil;
+		while (node != m_nil) {
+			if (Compare(key, node) <= 0) {
+				bound = node;
+				node  = node->m_left;
+			} else {
+				node  = node->m_right;
+			}
+		}
+		
+		return bound;
+	}
 	
 	
-	wfPrivate::wfSetNode<T> *m_root;
-	wfPrivate::wfSetNode<T> *m_nil;
+	wfPrivate::wfSetNode<T, A> *m_root;
+	wfPrivate::wfSetNode<T, A> *m_nil;
 	
 private:
 	size_t                   m_length;
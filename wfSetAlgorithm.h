@@ -0,0 +1,432 @@
+#ifndef WF_STDLIB_SETALGORITHM_HDR
+#define WF_STDLIB_SETALGORITHM_HDR
+#include "wfAlgorithm.h"
+#include "wfFunctional.h"
+
+/*
+ * File: wfSetAlgorithm
+ *  Union, intersection, difference and symmetric difference of two
+ *  sorted ranges in a single linear merge pass.
+ *
+ * >#include "wfSetAlgorithm.h"
+ *
+ *  The ranges can be anything that iterates in ascending order without
+ *  duplicates: the iterators of a <wfSet> or <wfMap>, a sorted <wfVector>,
+ *  or plain sorted arrays.  The result is written through an output
+ *  iterator, use <wfBackInserter> to append to a <wfVector> or <wfInserter>
+ *  to insert into a <wfSet>.
+ *
+ *  When both ranges are random-access (pointers, which includes <wfVector>
+ *  iterators) and one is much longer than the other, intersection and
+ *  difference gallop through the longer range with an exponential search
+ *  instead of stepping over it, which costs O(m log(n / m)) comparisons
+ *  for ranges of length *m* and *n*.  Intersection of two sorted *u32*
+ *  arrays into a *u32* array uses an SSE2 kernel when available.
+ *
+ *  Elements are ordered with <wfFunctional::wfCompare>, or with a three-way
+ *  comparison function object passed as the last argument.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define WF_STDLIB_SETALGORITHM_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace wfPrivate {
+	struct wfSetAlgorithmCompare {
+		template <typename T, typename U>
+		int operator()(const T& lhs, const U& rhs) const {
+			return wfFunctional::wfCompare<T, U>()(lhs, rhs);
+		}
+	};
+
+	enum {
+		// one range must be this many times longer before galloping pays off
+		wfSetAlgorithmGallopRatio = 32
+	};
+
+	//
+	// Exponential search for the first element in [first, last) that is not
+	// ordered before value, followed by a binary search of the last step.
+	//
+	template <typename T, typename U, typename C>
+	const T *wfSetGallop(const T *first, const T *last, const U& value, C& compare) {
+		if (first == last || compare(*first, value) >= 0)
+			return first;
+
+		const size_t length = static_cast<size_t>(last - first);
+		size_t       lo     = 0;
+		size_t       hi     = 1;
+
+		// first[lo] is always ordered before value
+		while (hi < length && compare(first[hi], value) < 0) {
+			lo  = hi;
+			hi  = (hi << 1) + 1;
+		}
+		if (hi > length)
+			hi = length;
+
+		while (lo + 1 < hi) {
+			const size_t mid = lo + ((hi - lo) >> 1);
+			if (compare(first[mid], value) < 0)
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		return first + hi;
+	}
+
+	template <typename T, typename U, typename O, typename C>
+	O wfSetIntersectionRandom(const T *first1, const T *last1, const U *first2, const U *last2, O out, C compare) {
+		const size_t length1 = static_cast<size_t>(last1 - first1);
+		const size_t length2 = static_cast<size_t>(last2 - first2);
+
+		if (length2 / wfSetAlgorithmGallopRatio > length1) {
+			for (; first1 != last1; ++first1) {
+				first2 = wfSetGallop(first2, last2, *first1, compare);
+				if (first2 == last2)
+					break;
+				if (compare(*first2, *first1) == 0)
+					*out++ = *first1;
+			}
+			return out;
+		}
+
+		if (length1 / wfSetAlgorithmGallopRatio > length2) {
+			for (; first2 != last2; ++first2) {
+				first1 = wfSetGallop(first1, last1, *first2, compare);
+				if (first1 == last1)
+					break;
+				if (compare(*first1, *first2) == 0)
+					*out++ = *first1++;
+			}
+			return out;
+		}
+
+		while (first1 != last1 && first2 != last2) {
+			const int order = compare(*first1, *first2);
+			if (order < 0) {
+				++first1;
+			} else if (order > 0) {
+				++first2;
+			} else {
+				*out++ = *first1++;
+				++first2;
+			}
+		}
+		return out;
+	}
+
+	//
+	// Sorted u32 arrays: four by four block compare.  Every element of a
+	// block of the first range is compared against all four rotations of a
+	// block of the second range at once, the matches are emitted in order
+	// from the comparison mask, and whichever block has the smaller last
+	// element is advanced (both on a tie).
+	//
+	inline u32 *wfSetIntersectionRandom(const u32 *first1, const u32 *last1, const u32 *first2, const u32 *last2, u32 *out, wfSetAlgorithmCompare compare) {
+		const size_t length1 = static_cast<size_t>(last1 - first1);
+		const size_t length2 = static_cast<size_t>(last2 - first2);
+
+		if (length1 / wfSetAlgorithmGallopRatio > length2 || length2 / wfSetAlgorithmGallopRatio > length1)
+			return wfSetIntersectionRandom<u32, u32, u32*, wfSetAlgorithmCompare>(first1, last1, first2, last2, out, compare);
+
+#ifdef WF_STDLIB_SETALGORITHM_SSE2
+		while (last1 - first1 >= 4 && last2 - first2 >= 4) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first1));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first2));
+
+			const __m128i m = _mm_or_si128(
+				_mm_or_si128(
+					_mm_cmpeq_epi32(a, b),
+					_mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1)))
+				),
+				_mm_or_si128(
+					_mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))),
+					_mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3)))
+				)
+			);
+
+			int mask = _mm_movemask_ps(_mm_castsi128_ps(m));
+			for (const u32 *element = first1; mask; mask >>= 1, ++element) {
+				if (mask & 1)
+					*out++ = *element;
+			}
+
+			const u32 max1 = first1[3];
+			const u32 max2 = first2[3];
+			if (max1 <= max2) first1 += 4;
+			if (max2 <= max1) first2 += 4;
+		}
+#endif
+
+		while (first1 != last1 && first2 != last2) {
+			if (*first1 < *first2) {
+				++first1;
+			} else if (*first2 < *first1) {
+				++first2;
+			} else {
+				*out++ = *first1++;
+				++first2;
+			}
+		}
+		return out;
+	}
+
+	template <typename T, typename U, typename O, typename C>
+	O wfSetDifferenceRandom(const T *first1, const T *last1, const U *first2, const U *last2, O out, C compare) {
+		const size_t length1 = static_cast<size_t>(last1 - first1);
+		const size_t length2 = static_cast<size_t>(last2 - first2);
+
+		if (length2 / wfSetAlgorithmGallopRatio > length1) {
+			for (; first1 != last1; ++first1) {
+				first2 = wfSetGallop(first2, last2, *first1, compare);
+				if (first2 == last2 || compare(*first2, *first1) != 0)
+					*out++ = *first1;
+			}
+			return out;
+		}
+
+		if (length1 / wfSetAlgorithmGallopRatio > length2) {
+			for (; first2 != last2 && first1 != last1; ++first2) {
+				const T *until = wfSetGallop(first1, last1, *first2, compare);
+				while (first1 != until)
+					*out++ = *first1++;
+				if (first1 != last1 && compare(*first1, *first2) == 0)
+					++first1;
+			}
+			while (first1 != last1)
+				*out++ = *first1++;
+			return out;
+		}
+
+		while (first1 != last1 && first2 != last2) {
+			const int order = compare(*first1, *first2);
+			if (order < 0) {
+				*out++ = *first1++;
+			} else if (order > 0) {
+				++first2;
+			} else {
+				++first1;
+				++first2;
+			}
+		}
+		while (first1 != last1)
+			*out++ = *first1++;
+		return out;
+	}
+}
+
+/*
+ * Function: wfSetUnion
+ *  Writes every element that is in either of two sorted ranges, in order.
+ *
+ * Parameters:
+ *  first1  - An input iterator addressing the first element of the first range.
+ *  last1   - An input iterator addressing one past the last element of the first range.
+ *  first2  - An input iterator addressing the first element of the second range.
+ *  last2   - An input iterator addressing one past the last element of the second range.
+ *  out     - An output iterator addressing where the result is written.
+ *  compare - Optional three-way comparison function object (see <wfFunctional::wfCompare>).
+ *
+ * Returns:
+ *  An output iterator addressing one past the last element written.
+ *
+ * Remarks:
+ *  Elements found in both ranges are written once, from the first range.
+ *
+ * Complexity:
+ *  Linear, at most *(last1 - first1) + (last2 - first2)* comparisons.
+ */
+template <typename I1, typename I2, typename O, typename C>
+O wfSetUnion(I1 first1, I1 last1, I2 first2, I2 last2, O out, C compare) {
+	while (first1 != last1 && first2 != last2) {
+		const int order = compare(*first1, *first2);
+		if (order < 0) {
+			*out++ = *first1;
+			++first1;
+		} else if (order > 0) {
+			*out++ = *first2;
+			++first2;
+		} else {
+			*out++ = *first1;
+			++first1;
+			++first2;
+		}
+	}
+	for (; first1 != last1; ++first1) *out++ = *first1;
+	for (; first2 != last2; ++first2) *out++ = *first2;
+	return out;
+}
+
+template <typename I1, typename I2, typename O>
+O wfSetUnion(I1 first1, I1 last1, I2 first2, I2 last2, O out) {
+	return wfSetUnion(first1, last1, first2, last2, out, wfPrivate::wfSetAlgorithmCompare());
+}
+
+/*
+ * Function: wfSetIntersection
+ *  Writes every element that is in both of two sorted ranges, in order.
+ *
+ * Parameters:
+ *  first1  - An input iterator addressing the first element of the first range.
+ *  last1   - An input iterator addressing one past the last element of the first range.
+ *  first2  - An input iterator addressing the first element of the second range.
+ *  last2   - An input iterator addressing one past the last element of the second range.
+ *  out     - An output iterator addressing where the result is written.
+ *  compare - Optional three-way comparison function object (see <wfFunctional::wfCompare>).
+ *
+ * Returns:
+ *  An output iterator addressing one past the last element written.
+ *
+ * Remarks:
+ *  The elements written are taken from the first range.  For pointer ranges the
+ *  longer range is galloped through when the lengths differ by more than a factor
+ *  of 32, and two sorted *u32* arrays intersected into a *u32* array use an SSE2
+ *  block-compare kernel.  The output may not overlap the second range.
+ *
+ * Complexity:
+ *  Linear, at most *(last1 - first1) + (last2 - first2)* comparisons; when
+ *  galloping O(m log(n / m)) for lengths *m < n*.
+ */
+template <typename I1, typename I2, typename O, typename C>
+O wfSetIntersection(I1 first1, I1 last1, I2 first2, I2 last2, O out, C compare) {
+	while (first1 != last1 && first2 != last2) {
+		const int order = compare(*first1, *first2);
+		if (order < 0) {
+			++first1;
+		} else if (order > 0) {
+			++first2;
+		} else {
+			*out++ = *first1;
+			++first1;
+			++first2;
+		}
+	}
+	return out;
+}
+
+template <typename I1, typename I2, typename O>
+O wfSetIntersection(I1 first1, I1 last1, I2 first2, I2 last2, O out) {
+	return wfSetIntersection(first1, last1, first2, last2, out, wfPrivate::wfSetAlgorithmCompare());
+}
+
+template <typename T, typename U, typename O, typename C>
+O wfSetIntersection(T *first1, T *last1, U *first2, U *last2, O out, C compare) {
+	return wfPrivate::wfSetIntersectionRandom<T, U, O, C>(first1, last1, first2, last2, out, compare);
+}
+
+template <typename T, typename U, typename O>
+O wfSetIntersection(T *first1, T *last1, U *first2, U *last2, O out) {
+	// const qualified so the u32 kernel is an exact match
+	return wfPrivate::wfSetIntersectionRandom(
+		static_cast<const T*>(first1),
+		static_cast<const T*>(last1),
+		static_cast<const U*>(first2),
+		static_cast<const U*>(last2),
+		out,
+		wfPrivate::wfSetAlgorithmCompare()
+	);
+}
+
+/*
+ * Function: wfSetDifference
+ *  Writes every element of a sorted range that is not in a second sorted range,
+ *  in order.
+ *
+ * Parameters:
+ *  first1  - An input iterator addressing the first element of the first range.
+ *  last1   - An input iterator addressing one past the last element of the first range.
+ *  first2  - An input iterator addressing the first element of the second range.
+ *  last2   - An input iterator addressing one past the last element of the second range.
+ *  out     - An output iterator addressing where the result is written.
+ *  compare - Optional three-way comparison function object (see <wfFunctional::wfCompare>).
+ *
+ * Returns:
+ *  An output iterator addressing one past the last element written.
+ *
+ * Remarks:
+ *  For pointer ranges the longer range is galloped through when the lengths differ
+ *  by more than a factor of 32.
+ *
+ * Complexity:
+ *  Linear, at most *(last1 - first1) + (last2 - first2)* comparisons.
+ */
+template <typename I1, typename I2, typename O, typename C>
+O wfSetDifference(I1 first1, I1 last1, I2 first2, I2 last2, O out, C compare) {
+	while (first1 != last1 && first2 != last2) {
+		const int order = compare(*first1, *first2);
+		if (order < 0) {
+			*out++ = *first1;
+			++first1;
+		} else if (order > 0) {
+			++first2;
+		} else {
+			++first1;
+			++first2;
+		}
+	}
+	for (; first1 != last1; ++first1) *out++ = *first1;
+	return out;
+}
+
+template <typename I1, typename I2, typename O>
+O wfSetDifference(I1 first1, I1 last1, I2 first2, I2 last2, O out) {
+	return wfSetDifference(first1, last1, first2, last2, out, wfPrivate::wfSetAlgorithmCompare());
+}
+
+template <typename T, typename U, typename O, typename C>
+O wfSetDifference(T *first1, T *last1, U *first2, U *last2, O out, C compare) {
+	return wfPrivate::wfSetDifferenceRandom<T, U, O, C>(first1, last1, first2, last2, out, compare);
+}
+
+template <typename T, typename U, typename O>
+O wfSetDifference(T *first1, T *last1, U *first2, U *last2, O out) {
+	return wfSetDifference(first1, last1, first2, last2, out, wfPrivate::wfSetAlgorithmCompare());
+}
+
+/*
+ * Function: wfSetSymmetricDifference
+ *  Writes every element that is in exactly one of two sorted ranges, in order.
+ *
+ * Parameters:
+ *  first1  - An input iterator addressing the first element of the first range.
+ *  last1   - An input iterator addressing one past the last element of the first range.
+ *  first2  - An input iterator addressing the first element of the second range.
+ *  last2   - An input iterator addressing one past the last element of the second range.
+ *  out     - An output iterator addressing where the result is written.
+ *  compare - Optional three-way comparison function object (see <wfFunctional::wfCompare>).
+ *
+ * Returns:
+ *  An output iterator addressing one past the last element written.
+ *
+ * Complexity:
+ *  Linear, at most *(last1 - first1) + (last2 - first2)* comparisons.
+ */
+template <typename I1, typename I2, typename O, typename C>
+O wfSetSymmetricDifference(I1 first1, I1 last1, I2 first2, I2 last2, O out, C compare) {
+	while (first1 != last1 && first2 != last2) {
+		const int order = compare(*first1, *first2);
+		if (order < 0) {
+			*out++ = *first1;
+			++first1;
+		} else if (order > 0) {
+			*out++ = *first2;
+			++first2;
+		} else {
+			++first1;
+			++first2;
+		}
+	}
+	for (; first1 != last1; ++first1) *out++ = *first1;
+	for (; first2 != last2; ++first2) *out++ = *first2;
+	return out;
+}
+
+template <typename I1, typename I2, typename O>
+O wfSetSymmetricDifference(I1 first1, I1 last1, I2 first2, I2 last2, O out) {
+	return wfSetSymmetricDifference(first1, last1, first2, last2, out, wfPrivate::wfSetAlgorithmCompare());
+}
+
+#endif
@@ -1,5 +1,6 @@
 #ifndef WF_STDLIB_SINGLELIST_HDR
 #define WF_STDLIB_SINGLELIST_HDR
+#include "wfStandard.h"
 #include "wfNullPointer.h"
 
 namespace wfPrivate {
@@ -13,6 +14,18 @@ namespace wfPrivate {
 		T                 m_data;
 		wfSingleListNode *m_next;
 	};
+
+	// a run of nodes allocated at once, the nodes follow the header
+	struct wfSingleListSlab {
+		union {
+			wfSingleListSlab *m_next;
+			long double       m_align;
+		};
+	};
+
+	enum {
+		wfSingleListSlabMinimum = 16
+	};
 }
 
 /*
@@ -26,6 +39,13 @@ namespace wfPrivate {
  *  <wfSingleList> arranges elements of a given type in a linear arrangement
  *  and, like vectors, allows fast random access to any element and efficent
  *  insertion and deletion at the back of the container.
+ *
+ *  Nodes are allocated in slabs of at least 16, or one slab for the whole
+ *  range given to <wfSingleList::PushFront> or <wfSingleList::Assign>.
+ *  Popped nodes go on a free list of the <wfSingleList> and are reused by
+ *  the next push, the memory is only returned to the heap when the list is
+ *  destroyed.  A list that is cleared and refilled over and over allocates
+ *  nothing once it has reached its largest length.
  */
 template <typename T>
 struct wfSingleList;
@@ -80,6 +100,7 @@ protected:
 
 	template<typename U> friend struct wfSingleListIterator;
 	template<typename U> friend struct wfSingleListConstIterator;
+	template<typename U> friend struct wfSingleList;
 };
 
 /*
@@ -129,20 +150,37 @@ struct wfSingleList {
 	typedef wfSingleListConstIterator<T> ConstIterator;
 
 	wfSingleList() :
-		m_head  (wfNullPointer),
-		m_length(0)
+		m_head     (wfNullPointer),
+		m_tail     (wfNullPointer),
+		m_length   (0),
+		m_free     (wfNullPointer),
+		m_freeTail (wfNullPointer),
+		m_freeCount(0),
+		m_slabs    (wfNullPointer),
+		m_slabsTail(wfNullPointer)
 	{ };
 
 	wfSingleList(const wfSingleList& list) :
-		m_head (wfNullPointer),
-		m_length(0)
+		m_head     (wfNullPointer),
+		m_tail     (wfNullPointer),
+		m_length   (0),
+		m_free     (wfNullPointer),
+		m_freeTail (wfNullPointer),
+		m_freeCount(0),
+		m_slabs    (wfNullPointer),
+		m_slabsTail(wfNullPointer)
 	{
-		for (ConstIterator i = list.Begin(); i != list.End(); ++i)
-			PushFront(*i);
-		Reverse();
+		Assign(list.Begin(), list.End());
 	}
 
-	~wfSingleList() { Clear(); }
+	~wfSingleList() {
+		Clear();
+		while (m_slabs) {
+			wfPrivate::wfSingleListSlab *next = m_slabs->m_next;
+			g_miscHeap.Free(m_slabs);
+			m_slabs = next;
+		}
+	}
 
 	/*
 	 * Function: Reverse
@@ -153,6 +191,7 @@ struct wfSingleList {
 		wfPrivate::wfSingleListNode<T> *i = m_head;
 		wfPrivate::wfSingleListNode<T> *n;
 
+		m_tail = m_head;
 		while (i) {
 			n         = i->m_next;
 			i->m_next = p;
@@ -192,17 +231,33 @@ struct wfSingleList {
 	 *  const cv-qualified version of this function as well.
 	 */
 	Iterator      End()         { return Iterator     ();       }
-	ConstIterator End()   const { return ConstIterator();       }
+	ConstIterator End()   const { return ConstIterator(Iterator()); }
 
 	T&       Front()       { return *Begin(); }
 	const T& Front() const { return *Begin(); }
 
 	wfSingleList& operator = (const wfSingleList& lst) {
-		wfSingleList tmp(lst);
-		Swap        (tmp);
+		if (this != &lst)
+			Assign(lst.Begin(), lst.End());
 		return *this;
 	}
 
+	/*
+	 * Function: Swap
+	 *  Exchanges the contents, and the nodes kept for reuse, of two
+	 *  <wfSingleList>s.
+	 */
+	void Swap(wfSingleList& list) {
+		SwapMember(m_head,      list.m_head);
+		SwapMember(m_tail,      list.m_tail);
+		SwapMember(m_length,    list.m_length);
+		SwapMember(m_free,      list.m_free);
+		SwapMember(m_freeTail,  list.m_freeTail);
+		SwapMember(m_freeCount, list.m_freeCount);
+		SwapMember(m_slabs,     list.m_slabs);
+		SwapMember(m_slabsTail, list.m_slabsTail);
+	}
+
 	/*
 	 * Function: Clear
 	 *  Erases all the elements of a <wfSingleList>
@@ -210,12 +265,21 @@ struct wfSingleList {
 	 * Remarks:
 	 *  *Clear* is functionally equivlant to:
 	 *  (start code)
-	 *  while (!Empty()) PopBack();
+	 *  while (!Empty()) PopFront();
 	 *  (end code)
+	 *  but hands the whole chain of nodes to the free list at once.
 	 */
 	void Clear() {
-		while (m_length > 0)
-			PopFront();
+		if (!m_head)
+			return;
+
+		for (wfPrivate::wfSingleListNode<T> *node = m_head; node; node = node->m_next)
+			node->m_data.~T();
+
+		Release(m_head, m_tail, m_length);
+		m_head   = wfNullPointer;
+		m_tail   = wfNullPointer;
+		m_length = 0;
 	}
 
 	/*
@@ -226,13 +290,86 @@ struct wfSingleList {
 	 *  data - The element to add to the beginning of the <wfSingleList>.
 	 */
 	void PushFront(const T& data) {
-		wfPrivate::wfSingleListNode<T> *tmp = new (g_miscHeap.Alloc(sizeof(wfPrivate::wfSingleListNode<T>))) wfPrivate::wfSingleListNode<T>(data, m_head);
-		tmp->m_next                         = m_head;
-		m_head                              = tmp;
+		Reserve(1);
+		wfPrivate::wfSingleListNode<T> *node = m_free;
+		m_free = node->m_next;
+		if (!m_free)
+			m_freeTail = wfNullPointer;
+		m_freeCount --;
+
+		new (node) wfPrivate::wfSingleListNode<T>(data, m_head);
+		if (!m_head)
+			m_tail = node;
+		m_head = node;
 
 		m_length ++;
 	}
 
+	/*
+	 * Function: PushFront
+	 *  Adds copies of a range of elements to the beginning of a
+	 *  <wfSingleList>, keeping their order.
+	 *
+	 * Parameters:
+	 *  first - An iterator to the first element of the range.
+	 *  last  - An iterator to the location succeeding the last element.
+	 *
+	 * Remarks:
+	 *  The range is walked twice, once to count it.  The nodes missing
+	 *  from the free list are allocated as a single slab.
+	 */
+	template <typename I>
+	void PushFront(I first, I last) {
+		size_t count = 0;
+		for (I i = first; i != last; ++i)
+			count ++;
+		if (count == 0)
+			return;
+
+		Reserve(count);
+
+		// construct the run in order at the front of the free list, then
+		// cut it off and put it in front of the head
+		wfPrivate::wfSingleListNode<T> *node = m_free;
+		wfPrivate::wfSingleListNode<T> *tail = wfNullPointer;
+		for (I i = first; i != last; ++i) {
+			wfPrivate::wfSingleListNode<T> *next = node->m_next;
+			new (node) wfPrivate::wfSingleListNode<T>(*i, next);
+			tail = node;
+			node = next;
+		}
+
+		wfPrivate::wfSingleListNode<T> *head = m_free;
+		m_free       = node;
+		if (!m_free)
+			m_freeTail = wfNullPointer;
+		m_freeCount -= count;
+
+		tail->m_next = m_head;
+		if (!m_head)
+			m_tail = tail;
+		m_head       = head;
+		m_length    += count;
+	}
+
+	/*
+	 * Function: Assign
+	 *  Replaces the contents of a <wfSingleList> with copies of a range of
+	 *  elements, reusing the nodes of the elements replaced.
+	 *
+	 * Parameters:
+	 *  first - An iterator to the first element of the range.
+	 *  last  - An iterator to the location succeeding the last element.
+	 *
+	 * Remarks:
+	 *  The range must not be part of the <wfSingleList> itself.
+	 */
+	template <typename I>
+	void Assign(I first, I last) {
+		Clear();
+		PushFront(first, last);
+	}
+
 	/*
 	 * Function: PopFront
 	 *  Deletes the element at the beginning of a <wfSingleList>.
@@ -242,16 +379,69 @@ struct wfSingleList {
 			return;
 		}
 
-		wfPrivate::wfSingleListNode<T> *head = m_head->m_next;
+		wfPrivate::wfSingleListNode<T> *head = m_head;
+		m_head = head->m_next;
+		if (!m_head)
+			m_tail = wfNullPointer;
 
-		// call dtor then frees
-		//m_head->~wfPrivate::wfSingleListNode<T>();
-		g_miscHeap.Free(m_head);
-		m_head = head;
+		head->m_data.~T();
+		Release(head, head, 1);
 
 		m_length --;
 	}
 
+	/*
+	 * Function: SpliceAfter
+	 *  Moves all the elements of another <wfSingleList> in after an element,
+	 *  in O(1).
+	 *
+	 * Parameters:
+	 *  position - An iterator to the element after which to insert, which
+	 *             must not be <End>.
+	 *  list     - The list to take the elements of, left empty.
+	 *
+	 * Remarks:
+	 *  The nodes stay where they are, so the memory they live in moves
+	 *  along: the slabs and free nodes of *list* are taken over as well.
+	 */
+	void SpliceAfter(Iterator position, wfSingleList& list) {
+		if (list.Empty() || &list == this)
+			return;
+
+		wfPrivate::wfSingleListNode<T> *node = position.m_end;
+		list.m_tail->m_next = node->m_next;
+		node->m_next        = list.m_head;
+		if (node == m_tail)
+			m_tail = list.m_tail;
+		m_length += list.m_length;
+
+		list.m_head   = wfNullPointer;
+		list.m_tail   = wfNullPointer;
+		list.m_length = 0;
+		Adopt(list);
+	}
+
+	/*
+	 * Function: SpliceFront
+	 *  Moves all the elements of another <wfSingleList> to the beginning, in
+	 *  O(1).  Like <SpliceAfter> this takes over the memory of *list*.
+	 */
+	void SpliceFront(wfSingleList& list) {
+		if (list.Empty() || &list == this)
+			return;
+
+		list.m_tail->m_next = m_head;
+		if (!m_head)
+			m_tail = list.m_tail;
+		m_head    = list.m_head;
+		m_length += list.m_length;
+
+		list.m_head   = wfNullPointer;
+		list.m_tail   = wfNullPointer;
+		list.m_length = 0;
+		Adopt(list);
+	}
+
 	/*
 	 * Function: Length
 	 *  Returns the number of elements in a <wfSingleList>.
@@ -271,8 +461,78 @@ struct wfSingleList {
 	bool   Empty () const { return (m_length == 0); }
 	
 private:
-	wfPrivate::wfSingleListNode<T> *m_head;
-	size_t                          m_length;
+	typedef wfPrivate::wfSingleListNode<T> Node;
+
+	template <typename U>
+	static void SwapMember(U& a, U& b) {
+		U c = a;
+		a   = b;
+		b   = c;
+	}
+
+	// makes sure the free list holds at least count nodes
+	void Reserve(size_t count) {
+		if (m_freeCount >= count)
+			return;
+
+		size_t needed = count - m_freeCount;
+		if (needed < wfPrivate::wfSingleListSlabMinimum)
+			needed = wfPrivate::wfSingleListSlabMinimum;
+
+		wfPrivate::wfSingleListSlab *slab = static_cast<wfPrivate::wfSingleListSlab*>(
+			g_miscHeap.Alloc(sizeof(wfPrivate::wfSingleListSlab) + needed * sizeof(Node))
+		);
+		slab->m_next = m_slabs;
+		if (!m_slabs)
+			m_slabsTail = slab;
+		m_slabs = slab;
+
+		Node *nodes = reinterpret_cast<Node*>(slab + 1);
+		for (size_t i = 0; i + 1 < needed; i++)
+			nodes[i].m_next = &nodes[i + 1];
+		Release(&nodes[0], &nodes[needed - 1], needed);
+	}
+
+	// puts the chain of destroyed nodes [first, last] on the free list
+	void Release(Node *first, Node *last, size_t count) {
+		last->m_next = m_free;
+		if (!m_free)
+			m_freeTail = last;
+		m_free       = first;
+		m_freeCount += count;
+	}
+
+	// takes over the slabs and the free nodes of an emptied list
+	void Adopt(wfSingleList& list) {
+		if (list.m_free) {
+			list.m_freeTail->m_next = m_free;
+			if (!m_free)
+				m_freeTail = list.m_freeTail;
+			m_free       = list.m_free;
+			m_freeCount += list.m_freeCount;
+		}
+		if (list.m_slabs) {
+			list.m_slabsTail->m_next = m_slabs;
+			if (!m_slabs)
+				m_slabsTail = list.m_slabsTail;
+			m_slabs = list.m_slabs;
+		}
+
+		list.m_free      = wfNullPointer;
+		list.m_freeTail  = wfNullPointer;
+		list.m_freeCount = 0;
+		list.m_slabs     = wfNullPointer;
+		list.m_slabsTail = wfNullPointer;
+	}
+
+	Node                        *m_head;
+	Node                        *m_tail;
+	size_t                       m_length;
+	Node                        *m_free;
+	Node                        *m_freeTail;
+	size_t                       m_freeCount;
+	wfPrivate::wfSingleListSlab *m_slabs;
+	wfPrivate::wfSingleListSlab *m_slabsTail;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,306 @@
+#ifndef WF_STDLIB_SLOTMAP_HDR
+#define WF_STDLIB_SLOTMAP_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+
+/*
+ * File: wfSlotMap
+ *  A pool of objects addressed by generational handles.
+ *
+ * >#include "wfSlotMap.h"
+ *
+ *  Objects are stored packed in one array, a second array of slots maps
+ *  the stable index in a handle to the current position of the object.
+ *  Erasing moves the last object into the hole and updates its slot,
+ *  iteration is therefor a scan over contiguous objects.
+ *
+ *  A handle is a *u64* made of the slot index and the generation of the
+ *  slot.  Every slot counts how many times it has been reused, a handle
+ *  kept after its object was erased no longer matches the generation of
+ *  the slot and is rejected by <wfSlotMap::Find>, even when the slot has
+ *  since been reused for another object.  No reference count or separate
+ *  allocation per object is involved.
+ */
+
+namespace wfPrivate {
+	struct wfSlotMapSlot {
+		u32 m_index;      // position of the object, or the next free slot
+		u32 m_generation; // odd while the slot is in use
+	};
+}
+
+/*
+ * Type: wfSlotMapHandle
+ *  The handle of an object in a <wfSlotMap>, the generation of the slot in
+ *  the upper 32 bits and its index in the lower 32 bits.  *0* is never
+ *  the handle of an object.
+ */
+typedef u64 wfSlotMapHandle;
+
+/*
+ * Class: wfSlotMap
+ *  A densely stored pool of objects with O(1) insertion, erasure and
+ *  lookup by handle.
+ *
+ * Parameters:
+ *  T - The object data type to be stored in the <wfSlotMap>.
+ *
+ * Remarks:
+ *  Objects move when another object is erased and when the pool grows,
+ *  keep handles rather than pointers.  A slot is reused 2^31 times before
+ *  its generation wraps around, a handle kept for that long could match
+ *  again.
+ */
+template <typename T>
+struct wfSlotMap {
+	/*
+	 * Type: Iterator
+	 *  A type that provides a random-access iterator over the objects, which
+	 *  is a pointer.
+	 */
+	typedef T*       Iterator;
+
+	/*
+	 * Type: ConstIterator
+	 *  A type that provides a random-access iterator over *const* objects.
+	 */
+	typedef const T* ConstIterator;
+
+	explicit wfSlotMap(wfHeap *heap = &g_miscHeap) :
+		m_heap    (heap),
+		m_values  (wfNullPointer),
+		m_owners  (wfNullPointer),
+		m_length  (0),
+		m_capacity(0),
+		m_slots   (wfNullPointer),
+		m_count   (0),
+		m_free    (kNoSlot)
+	{ }
+
+	~wfSlotMap() {
+		for (size_t i = 0; i < m_length; i++)
+			m_values[i].~T();
+
+		m_heap->Free(m_values);
+		m_heap->Free(m_owners);
+		m_heap->Free(m_slots);
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of objects in the pool.
+	 */
+	size_t Length() const { return m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the pool is empty.
+	 */
+	bool   Empty () const { return m_length == 0; }
+
+	/*
+	 * Function: Begin
+	 *  Returns an iterator to the first object.  There exists a const
+	 *  cv-qualified version of this function as well.
+	 */
+	Iterator      Begin()       { return m_values; }
+	ConstIterator Begin() const { return m_values; }
+
+	/*
+	 * Function: End
+	 *  Returns an iterator to the location succeeding the last object.  There
+	 *  exists a const cv-qualified version of this function as well.
+	 */
+	Iterator      End()       { return m_values + m_length; }
+	ConstIterator End() const { return m_values + m_length; }
+
+	/*
+	 * Function: Insert
+	 *  Adds a copy of an object to the pool.
+	 *
+	 * Returns:
+	 *  The handle of the object.
+	 */
+	wfSlotMapHandle Insert(const T& value) {
+		if (m_length == m_capacity) {
+			// the value may be an object of the pool, which growing frees
+			const T copy(value);
+			Reserve(m_capacity ? m_capacity * 2 : 16);
+			return Insert(copy);
+		}
+
+		// every slot has been handed out by now, the free list has one
+		const u32                 index = m_free;
+		wfPrivate::wfSlotMapSlot &slot  = m_slots[index];
+		m_free = slot.m_index;
+
+		new (&m_values[m_length]) T(value);
+		m_owners[m_length] = index;
+		slot.m_index       = static_cast<u32>(m_length);
+		slot.m_generation ++;
+		m_length ++;
+
+		return Handle(index, slot.m_generation);
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes the object of a handle, moving the last object into its place.
+	 *
+	 * Returns:
+	 *  *true* if the handle was valid; *false* if it was stale or invalid.
+	 */
+	bool Erase(wfSlotMapHandle handle) {
+		wfPrivate::wfSlotMapSlot *slot = Lookup(handle);
+		if (!slot)
+			return false;
+
+		const u32 position = slot->m_index;
+		const u32 last     = static_cast<u32>(--m_length);
+		if (position != last) {
+			m_values[position]                  = m_values[last];
+			m_owners[position]                  = m_owners[last];
+			m_slots[m_owners[position]].m_index = position;
+		}
+		m_values[last].~T();
+
+		Release(static_cast<u32>(handle));
+		return true;
+	}
+
+	/*
+	 * Function: Find
+	 *  Returns the address of the object of a handle, or *wfNullPointer* if
+	 *  the handle is stale or invalid.  There exists a const cv-qualified
+	 *  version of this function as well.
+	 *
+	 * Remarks:
+	 *  The address is valid until the next <Insert> or <Erase>.
+	 */
+	T *Find(wfSlotMapHandle handle) {
+		const wfPrivate::wfSlotMapSlot *slot = Lookup(handle);
+		return slot ? &m_values[slot->m_index] : wfNullPointer;
+	}
+	const T *Find(wfSlotMapHandle handle) const {
+		const wfPrivate::wfSlotMapSlot *slot = Lookup(handle);
+		return slot ? &m_values[slot->m_index] : wfNullPointer;
+	}
+
+	/*
+	 * Function: Contains
+	 *  Tests if a handle addresses an object in the pool.
+	 */
+	bool Contains(wfSlotMapHandle handle) const { return Lookup(handle) != wfNullPointer; }
+
+	/*
+	 * Function: HandleOf
+	 *  Returns the handle of the object at a position of the dense array,
+	 *  for instance of an object reached by iterating.
+	 */
+	wfSlotMapHandle HandleOf(size_t position) const {
+		const u32 index = m_owners[position];
+		return Handle(index, m_slots[index].m_generation);
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every object, every handle handed out so far becomes stale.
+	 */
+	void Clear() {
+		while (m_length) {
+			m_length --;
+			m_values[m_length].~T();
+			Release(m_owners[m_length]);
+		}
+	}
+
+	/*
+	 * Function: Reserve
+	 *  Makes room for a number of objects.
+	 */
+	void Reserve(size_t capacity) {
+		if (capacity <= m_capacity)
+			return;
+
+		T                        *values = static_cast<T*>(m_heap->Alloc(capacity * sizeof(T)));
+		u32                      *owners = static_cast<u32*>(m_heap->Alloc(capacity * sizeof(u32)));
+		wfPrivate::wfSlotMapSlot *slots  = static_cast<wfPrivate::wfSlotMapSlot*>(m_heap->Alloc(capacity * sizeof(wfPrivate::wfSlotMapSlot)));
+
+		for (size_t i = 0; i < m_length; i++) {
+			new (&values[i]) T(m_values[i]);
+			m_values[i].~T();
+		}
+		if (m_length)
+			memcpy(owners, m_owners, m_length * sizeof(u32));
+		if (m_count)
+			memcpy(slots, m_slots, m_count * sizeof(wfPrivate::wfSlotMapSlot));
+
+		// the new slots go on the free list in index order
+		for (size_t i = capacity; i-- > m_count; ) {
+			slots[i].m_index      = m_free;
+			slots[i].m_generation = 0;
+			m_free                = static_cast<u32>(i);
+		}
+
+		m_heap->Free(m_values);
+		m_heap->Free(m_owners);
+		m_heap->Free(m_slots);
+
+		m_values   = values;
+		m_owners   = owners;
+		m_slots    = slots;
+		m_capacity = capacity;
+		m_count    = capacity;
+	}
+
+	/*
+	 * Function: ForEach
+	 *  Invokes a function on every object in dense order, as
+	 *  *function(handle, object)*.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied.
+	 */
+	template <typename F>
+	F ForEach(F function) {
+		for (size_t i = 0; i < m_length; i++)
+			function(HandleOf(i), m_values[i]);
+		return function;
+	}
+
+private:
+	enum { kNoSlot = 0xFFFFFFFFu };
+
+	static wfSlotMapHandle Handle(u32 index, u32 generation) {
+		return (static_cast<u64>(generation) << 32) | index;
+	}
+
+	wfPrivate::wfSlotMapSlot *Lookup(wfSlotMapHandle handle) const {
+		const u32 index      = static_cast<u32>(handle);
+		const u32 generation = static_cast<u32>(handle >> 32);
+		if (index >= m_count || !(generation & 1) || m_slots[index].m_generation != generation)
+			return wfNullPointer;
+		return &m_slots[index];
+	}
+
+	// bumping the generation to even marks the slot free and its handles stale
+	void Release(u32 index) {
+		m_slots[index].m_generation ++;
+		m_slots[index].m_index = m_free;
+		m_free                 = index;
+	}
+
+	wfHeap                   *m_heap;
+	T                        *m_values;
+	u32                      *m_owners;
+	size_t                    m_length;
+	size_t                    m_capacity;
+	wfPrivate::wfSlotMapSlot *m_slots;
+	size_t                    m_count;
+	u32                       m_free;
+
+	wfSlotMap(const wfSlotMap&);
+	wfSlotMap& operator=(const wfSlotMap&);
+};
+
+#endif
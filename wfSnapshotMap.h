@@ -0,0 +1,331 @@
+#ifndef WF_STDLIB_SNAPSHOTMAP_HDR
+#define WF_STDLIB_SNAPSHOTMAP_HDR
+#include "wfEpoch.h"
+#include "wfFunctional.h"
+#include "wfPair.h"
+
+/*
+ * File: wfSnapshotMap
+ *  A map for data that is read constantly and written rarely.
+ *
+ * >#include "wfSnapshotMap.h"
+ *
+ *  The contents are an immutable sorted array of key-value pairs behind an
+ *  atomic pointer.  Readers load the pointer and binary search the array,
+ *  they never take a lock and never perform a read-modify-write, the only
+ *  shared memory they write is their own <wfEpochParticipant>.  Writers are
+ *  serialized by a mutex, copy the array with their change applied,
+ *  publish the copy with a single store and retire the old array to the
+ *  map's <wfEpochDomain>, which destroys it once no reader can still be
+ *  looking at it.
+ *
+ *  Every write therefor costs O(n), use <wfSnapshotMap::Assign> to publish
+ *  many changes at once.  Lookups are O(log n) over contiguous memory.
+ */
+
+namespace wfPrivate {
+	template <typename K, typename V>
+	struct wfSnapshotMapVersion {
+		size_t        m_length;
+		wfPair<K, V> *m_data;
+
+		static wfSnapshotMapVersion *Create(size_t length) {
+			// the pairs follow the header in the same allocation
+			const size_t header = (sizeof(wfSnapshotMapVersion) + sizeof(void*) * 2 - 1) & ~(sizeof(void*) * 2 - 1);
+			unsigned char *memory = reinterpret_cast<unsigned char*>(
+				g_miscHeap.Alloc(header + length * sizeof(wfPair<K, V>))
+			);
+
+			wfSnapshotMapVersion *version = reinterpret_cast<wfSnapshotMapVersion*>(memory);
+			version->m_length = 0;
+			version->m_data   = reinterpret_cast<wfPair<K, V>*>(memory + header);
+			return version;
+		}
+
+		static void Destroy(void *object) {
+			wfSnapshotMapVersion *version = static_cast<wfSnapshotMapVersion*>(object);
+			for (size_t i = 0; i < version->m_length; i++)
+				version->m_data[i].~wfPair<K, V>();
+			g_miscHeap.Free(version);
+		}
+
+		void Append(const wfPair<K, V>& pair) {
+			new (&m_data[m_length++]) wfPair<K, V>(pair);
+		}
+
+		// index of the first pair not ordered before key
+		template <typename U>
+		size_t LowerBound(const U& key) const {
+			size_t lo = 0;
+			size_t hi = m_length;
+			while (lo < hi) {
+				const size_t mid = lo + ((hi - lo) >> 1);
+				if (wfFunctional::wfCompare<K, U>()(m_data[mid].first, key) < 0)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			return lo;
+		}
+
+		// whether the pair at an index from LowerBound has the key
+		template <typename U>
+		bool Matches(size_t index, const U& key) const {
+			return index != m_length && wfFunctional::wfCompare<K, U>()(m_data[index].first, key) == 0;
+		}
+
+		template <typename U>
+		const wfPair<K, V> *Find(const U& key) const {
+			const size_t index = LowerBound(key);
+			return Matches(index, key) ? &m_data[index] : wfNullPointer;
+		}
+	};
+}
+
+/*
+ * Class: wfSnapshotMap
+ *  An ordered map of key-value pairs with wait-free readers.
+ *
+ * Parameters:
+ *  K - The key data type to be stored in the <wfSnapshotMap>.
+ *  V - The value data type to be stored in the <wfSnapshotMap>.
+ *
+ * Remarks:
+ *  Reading requires a <wfSnapshotMap::Reader>, one per reading thread,
+ *  which is the thread's participant in the epoch domain of the map.
+ */
+template <typename K, typename V>
+struct wfSnapshotMap {
+	typedef wfPrivate::wfSnapshotMapVersion<K, V> Version;
+
+	/*
+	 * Class: Reader
+	 *  The read side of a <wfSnapshotMap> for a single thread.
+	 *
+	 * Remarks:
+	 *  Construct one per reading thread and keep it around, construction
+	 *  joins the epoch domain of the map.  Every lookup reads a consistent
+	 *  version of the map, the latest one published when the lookup began.
+	 */
+	struct Reader {
+		explicit Reader(wfSnapshotMap& map) :
+			m_map        (map),
+			m_participant(map.m_domain.Join())
+		{ }
+
+		~Reader() {
+			m_map.m_domain.Leave(m_participant);
+		}
+
+		/*
+		 * Function: Find
+		 *  Looks up the value associated with a key.
+		 *
+		 * Parameters:
+		 *  key   - The key to look up, converted to *K* first unless
+		 *          <wfFunctional::wfTransparentKey> opts its type in.  The
+		 *          same holds for <Count> and <wfSnapshotMap::Erase>.
+		 *  value - Receives a copy of the value if the key is present.
+		 *
+		 * Returns:
+		 *  *true* if the key is present; *false* otherwise.
+		 */
+		template <typename U>
+		bool Find(const U& key, V& value) const {
+			wfEpochGuard guard(m_participant);
+			const wfPair<K, V> *pair = wfAtomicLoad(&m_map.m_version)->Find(Probe(key));
+			if (!pair)
+				return false;
+
+			value = pair->second;
+			return true;
+		}
+
+		/*
+		 * Function: Count
+		 *  Returns 1 if the key is present; 0 otherwise.
+		 */
+		template <typename U>
+		size_t Count(const U& key) const {
+			wfEpochGuard guard(m_participant);
+			return wfAtomicLoad(&m_map.m_version)->Find(Probe(key)) ? 1 : 0;
+		}
+
+		/*
+		 * Function: ForEach
+		 *  Invokes a function on every pair of one version of the map, in key
+		 *  order, as *function(key, value)*.
+		 *
+		 * Returns:
+		 *  A copy of the function object after it has been applied.
+		 *
+		 * Remarks:
+		 *  The version is held for the duration of the call which delays
+		 *  reclamation of every version published meanwhile, keep the function
+		 *  short.
+		 */
+		template <typename F>
+		F ForEach(F function) const {
+			wfEpochGuard guard(m_participant);
+			const Version *version = wfAtomicLoad(&m_map.m_version);
+			for (size_t i = 0; i < version->m_length; i++)
+				function(static_cast<const K&>(version->m_data[i].first), static_cast<const V&>(version->m_data[i].second));
+			return function;
+		}
+
+		/*
+		 * Function: Length
+		 *  Returns the number of pairs in the current version.
+		 */
+		size_t Length() const {
+			wfEpochGuard guard(m_participant);
+			return wfAtomicLoad(&m_map.m_version)->m_length;
+		}
+
+	private:
+		wfSnapshotMap      &m_map;
+		wfEpochParticipant *m_participant;
+
+		Reader(const Reader&);
+		Reader& operator=(const Reader&);
+	};
+
+	wfSnapshotMap() :
+		m_version(Version::Create(0))
+	{ }
+
+	/*
+	 * Destructor: wfSnapshotMap
+	 *  Destroys the map, every <Reader> must have been destroyed first.
+	 */
+	~wfSnapshotMap() {
+		Version::Destroy(m_version);
+	}
+
+	/*
+	 * Function: Upsert
+	 *  Publishes a version of the map with a key associated with a value,
+	 *  inserting the key or replacing its value.
+	 *
+	 * Returns:
+	 *  *true* if the key was inserted; *false* if its value was replaced.
+	 */
+	bool Upsert(const K& key, const V& value) {
+		wfLockGuard<wfMutex> guard(m_writer);
+
+		const Version *current = m_version;
+		const size_t   index   = current->LowerBound(key);
+		const bool     found   = current->Matches(index, key);
+
+		Version *next = Version::Create(current->m_length + (found ? 0 : 1));
+		for (size_t i = 0; i < index; i++)
+			next->Append(current->m_data[i]);
+		next->Append(wfPair<K, V>(key, value));
+		for (size_t i = index + (found ? 1 : 0); i < current->m_length; i++)
+			next->Append(current->m_data[i]);
+
+		Publish(next);
+		return !found;
+	}
+
+	/*
+	 * Function: Erase
+	 *  Publishes a version of the map without a key.
+	 *
+	 * Returns:
+	 *  *true* if the key was present; *false* otherwise, in which case
+	 *  nothing is published.
+	 */
+	template <typename U>
+	bool Erase(const U& key) {
+		wfLockGuard<wfMutex> guard(m_writer);
+
+		typename wfPrivate::wfLookupKey<U, K>::Type probe = Probe(key);
+		const Version *current = m_version;
+		const size_t   index   = current->LowerBound(probe);
+		if (!current->Matches(index, probe))
+			return false;
+
+		Version *next = Version::Create(current->m_length - 1);
+		for (size_t i = 0; i < current->m_length; i++) {
+			if (i != index)
+				next->Append(current->m_data[i]);
+		}
+
+		Publish(next);
+		return true;
+	}
+
+	/*
+	 * Function: Assign
+	 *  Publishes a version of the map holding exactly the pairs of a range.
+	 *
+	 * Parameters:
+	 *  first - An input iterator addressing the first <wfPair> of the range.
+	 *  last  - An input iterator addressing one past the last pair of the range.
+	 *
+	 * Remarks:
+	 *  The range must be sorted by key without duplicates, for instance the
+	 *  iterators of a <wfMap> built up by the writer.  This is how to publish
+	 *  any number of changes for the price of a single copy.
+	 */
+	template <typename I>
+	void Assign(I first, I last) {
+		size_t length = 0;
+		for (I it = first; it != last; ++it)
+			length++;
+
+		Version *next = Version::Create(length);
+		for (; first != last; ++first)
+			next->Append(*first);
+
+		wfLockGuard<wfMutex> guard(m_writer);
+		Publish(next);
+	}
+
+	/*
+	 * Function: Clear
+	 *  Publishes an empty version of the map.
+	 */
+	void Clear() {
+		wfLockGuard<wfMutex> guard(m_writer);
+		Publish(Version::Create(0));
+	}
+
+	/*
+	 * Function: Collect
+	 *  Destroys the versions no reader can still be looking at.
+	 *
+	 * Returns:
+	 *  The number of versions still waiting to be destroyed.
+	 *
+	 * Remarks:
+	 *  Publishing already collects, calling *Collect* is only needed to free
+	 *  the memory of old versions when no further writes are coming.
+	 */
+	size_t Collect() {
+		return m_domain.Collect();
+	}
+
+private:
+	// the key a lookup searches a version with, see wfPrivate::wfLookupKey
+	template <typename U>
+	static typename wfPrivate::wfLookupKey<U, K>::Type Probe(const U& key) {
+		return key;
+	}
+
+	void Publish(Version *next) {
+		Version *previous = m_version;
+		wfAtomicStore(&m_version, next);
+		m_domain.Retire(previous, &Version::Destroy);
+	}
+
+	Version *volatile m_version;
+	wfMutex           m_writer;
+	wfEpochDomain     m_domain;
+
+	wfSnapshotMap(const wfSnapshotMap&);
+	wfSnapshotMap& operator=(const wfSnapshotMap&);
+};
+
+#endif
@@ -0,0 +1,455 @@
+#ifndef WF_STDLIB_SPARSESET_HDR
+#define WF_STDLIB_SPARSESET_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+
+/*
+ * File: wfSparseSet
+ *  Sets and maps keyed by small integer identifiers.
+ *
+ * >#include "wfSparseSet.h"
+ *
+ *  <wfSparseSet> keeps two arrays: a sparse one indexed by identifier,
+ *  holding the position of the identifier in a dense one, which holds the
+ *  identifiers packed without holes.  Insertion appends to the dense array,
+ *  erasure moves the last element of the dense array into the hole, and
+ *  membership is one lookup in each array, all O(1).  Iterating visits the
+ *  dense array front to back, a linear scan over exactly the live
+ *  identifiers in no particular order.
+ *
+ *  <wfDenseMap> adds an array of values parallel to the dense identifiers,
+ *  iterating the values of a <wfDenseMap> is a scan over contiguous memory.
+ *
+ *  The sparse array is split into pages which are only allocated once an
+ *  identifier in their range is inserted, a handful of large identifiers
+ *  do not cost an array as large as the largest one.  Everything is
+ *  allocated from the <wfHeap> given on construction.
+ */
+
+namespace wfPrivate {
+	enum {
+		wfSparseSetPageBits = 12,
+		wfSparseSetPageSize = 1 << wfSparseSetPageBits,
+		wfSparseSetPageMask = wfSparseSetPageSize - 1
+	};
+}
+
+/*
+ * Class: wfSparseSet
+ *  A set of *u32* identifiers with O(1) insertion, erasure and membership.
+ *
+ * Remarks:
+ *  Any *u32* identifier can be stored.  The order of the dense array
+ *  changes on <Erase>, the element erased is replaced by the last one.
+ */
+struct wfSparseSet {
+	/*
+	 * Type: ConstIterator
+	 *  A type that provides a random-access iterator over the identifiers
+	 *  in the dense array, which is a pointer.
+	 */
+	typedef const u32* ConstIterator;
+
+	/*
+	 * Constant: kInvalid
+	 *  The position returned by <Index> for an identifier not in the set.
+	 */
+	static const u32 kInvalid = 0xFFFFFFFFu;
+
+	explicit wfSparseSet(wfHeap *heap = &g_miscHeap) :
+		m_heap    (heap),
+		m_pages   (wfNullPointer),
+		m_count   (0),
+		m_dense   (wfNullPointer),
+		m_length  (0),
+		m_capacity(0)
+	{ }
+
+	~wfSparseSet() {
+		for (size_t i = 0; i < m_count; i++)
+			m_heap->Free(m_pages[i]);
+
+		m_heap->Free(m_pages);
+		m_heap->Free(m_dense);
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of identifiers in the set.
+	 */
+	size_t Length() const { return m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the set is empty.
+	 */
+	bool   Empty () const { return m_length == 0; }
+
+	/*
+	 * Function: Begin
+	 *  Returns an iterator to the first identifier of the dense array.
+	 */
+	ConstIterator Begin() const { return m_dense;            }
+
+	/*
+	 * Function: End
+	 *  Returns an iterator to the location succeeding the last identifier
+	 *  of the dense array.
+	 */
+	ConstIterator End  () const { return m_dense + m_length; }
+
+	/*
+	 * Function: operator[]
+	 *  Returns the identifier at a position of the dense array.
+	 */
+	u32 operator[](size_t index) const { return m_dense[index]; }
+
+	/*
+	 * Function: Index
+	 *  Returns the position of an identifier in the dense array, or
+	 *  <kInvalid> when the identifier is not in the set.
+	 */
+	u32 Index(u32 id) const {
+		const size_t page = id >> wfPrivate::wfSparseSetPageBits;
+		if (page >= m_count || !m_pages[page])
+			return kInvalid;
+
+		return m_pages[page][id & wfPrivate::wfSparseSetPageMask];
+	}
+
+	/*
+	 * Function: Contains
+	 *  Tests if an identifier is in the set.
+	 */
+	bool Contains(u32 id) const { return Index(id) != kInvalid; }
+
+	/*
+	 * Function: Count
+	 *  Returns 1 if the identifier is in the set; 0 otherwise.
+	 */
+	size_t Count(u32 id) const { return Contains(id) ? 1 : 0; }
+
+	/*
+	 * Function: Insert
+	 *  Inserts an identifier at the end of the dense array.
+	 *
+	 * Returns:
+	 *  *true* if the identifier was inserted; *false* if it was already in
+	 *  the set.
+	 */
+	bool Insert(u32 id) {
+		u32 &slot = Slot(id);
+		if (slot != kInvalid)
+			return false;
+
+		if (m_length == m_capacity)
+			Reserve(m_capacity ? m_capacity * 2 : 16);
+
+		slot                = static_cast<u32>(m_length);
+		m_dense[m_length++] = id;
+		return true;
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes an identifier, moving the last identifier of the dense array
+	 *  into its position.
+	 *
+	 * Returns:
+	 *  *true* if the identifier was in the set; *false* otherwise.
+	 */
+	bool Erase(u32 id) {
+		const u32 index = Index(id);
+		if (index == kInvalid)
+			return false;
+
+		const u32 last = m_dense[--m_length];
+		m_dense[index] = last;
+		m_pages[last >> wfPrivate::wfSparseSetPageBits][last & wfPrivate::wfSparseSetPageMask] = index;
+		m_pages[id   >> wfPrivate::wfSparseSetPageBits][id   & wfPrivate::wfSparseSetPageMask] = kInvalid;
+		return true;
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every identifier in O(<Length>), the memory is kept.
+	 */
+	void Clear() {
+		for (size_t i = 0; i < m_length; i++)
+			m_pages[m_dense[i] >> wfPrivate::wfSparseSetPageBits][m_dense[i] & wfPrivate::wfSparseSetPageMask] = kInvalid;
+		m_length = 0;
+	}
+
+	/*
+	 * Function: Reserve
+	 *  Makes room in the dense array for a number of identifiers.
+	 */
+	void Reserve(size_t capacity) {
+		if (capacity <= m_capacity)
+			return;
+
+		u32 *dense = static_cast<u32*>(m_heap->Alloc(capacity * sizeof(u32)));
+		if (m_length)
+			memcpy(dense, m_dense, m_length * sizeof(u32));
+
+		m_heap->Free(m_dense);
+		m_dense    = dense;
+		m_capacity = capacity;
+	}
+
+private:
+	// the sparse entry of an identifier, allocating its page if needed
+	u32 &Slot(u32 id) {
+		const size_t page = id >> wfPrivate::wfSparseSetPageBits;
+		if (page >= m_count) {
+			size_t count = m_count ? m_count : 1;
+			while (count <= page)
+				count *= 2;
+
+			u32 **pages = static_cast<u32**>(m_heap->Alloc(count * sizeof(u32*)));
+			for (size_t i = 0; i < count; i++)
+				pages[i] = (i < m_count) ? m_pages[i] : wfNullPointer;
+
+			m_heap->Free(m_pages);
+			m_pages = pages;
+			m_count = count;
+		}
+
+		if (!m_pages[page]) {
+			m_pages[page] = static_cast<u32*>(m_heap->Alloc(wfPrivate::wfSparseSetPageSize * sizeof(u32)));
+			memset(m_pages[page], 0xFF, wfPrivate::wfSparseSetPageSize * sizeof(u32));
+		}
+
+		return m_pages[page][id & wfPrivate::wfSparseSetPageMask];
+	}
+
+	wfHeap  *m_heap;
+	u32    **m_pages;
+	size_t   m_count;
+	u32     *m_dense;
+	size_t   m_length;
+	size_t   m_capacity;
+
+	wfSparseSet(const wfSparseSet&);
+	wfSparseSet& operator=(const wfSparseSet&);
+};
+
+/*
+ * Class: wfDenseMap
+ *  A map from *u32* identifiers to values stored contiguously.
+ *
+ * Parameters:
+ *  T - The value data type to be stored in the <wfDenseMap>.
+ *
+ * Remarks:
+ *  Values are stored in an array parallel to the dense identifiers of a
+ *  <wfSparseSet>: the value at position *i* belongs to *Keys()[i]*.  Like
+ *  the identifiers, the last value is moved into the place of an erased
+ *  one, and values are moved when the array grows, so pointers to values
+ *  are invalidated by <Insert> and <Erase>.
+ */
+template <typename T>
+struct wfDenseMap {
+	/*
+	 * Type: Iterator
+	 *  A type that provides a random-access iterator over the values, which
+	 *  is a pointer.
+	 */
+	typedef T*       Iterator;
+
+	/*
+	 * Type: ConstIterator
+	 *  A type that provides a random-access iterator over *const* values.
+	 */
+	typedef const T* ConstIterator;
+
+	explicit wfDenseMap(wfHeap *heap = &g_miscHeap) :
+		m_keys    (heap),
+		m_heap    (heap),
+		m_values  (wfNullPointer),
+		m_capacity(0)
+	{ }
+
+	~wfDenseMap() {
+		Clear();
+		m_heap->Free(m_values);
+	}
+
+	/*
+	 * Function: Length
+	 *  Returns the number of values in the map.
+	 */
+	size_t Length() const { return m_keys.Length(); }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the map is empty.
+	 */
+	bool   Empty () const { return m_keys.Empty();  }
+
+	/*
+	 * Function: Keys
+	 *  Returns the set of identifiers of the map, its dense array is in the
+	 *  same order as the values.
+	 */
+	const wfSparseSet& Keys() const { return m_keys; }
+
+	/*
+	 * Function: Begin
+	 *  Returns an iterator to the first value.  There exists a const
+	 *  cv-qualified version of this function as well.
+	 */
+	Iterator      Begin()       { return m_values; }
+	ConstIterator Begin() const { return m_values; }
+
+	/*
+	 * Function: End
+	 *  Returns an iterator to the location succeeding the last value.
+	 *  There exists a const cv-qualified version of this function as well.
+	 */
+	Iterator      End()       { return m_values + Length(); }
+	ConstIterator End() const { return m_values + Length(); }
+
+	/*
+	 * Function: Contains
+	 *  Tests if the map holds a value for an identifier.
+	 */
+	bool   Contains(u32 id) const { return m_keys.Contains(id); }
+
+	/*
+	 * Function: Count
+	 *  Returns 1 if the map holds a value for the identifier; 0 otherwise.
+	 */
+	size_t Count   (u32 id) const { return m_keys.Count(id);    }
+
+	/*
+	 * Function: Find
+	 *  Returns the address of the value of an identifier, or
+	 *  *wfNullPointer* if the map holds none.  There exists a const
+	 *  cv-qualified version of this function as well.
+	 */
+	T *Find(u32 id) {
+		const u32 index = m_keys.Index(id);
+		return (index != wfSparseSet::kInvalid) ? &m_values[index] : wfNullPointer;
+	}
+	const T *Find(u32 id) const {
+		const u32 index = m_keys.Index(id);
+		return (index != wfSparseSet::kInvalid) ? &m_values[index] : wfNullPointer;
+	}
+
+	/*
+	 * Function: Insert
+	 *  Associates a value with an identifier the map holds no value for.
+	 *
+	 * Returns:
+	 *  A reference to the value of the identifier, which is the value already
+	 *  held if there was one.
+	 */
+	T& Insert(u32 id, const T& value) {
+		const u32 index = m_keys.Index(id);
+		if (index != wfSparseSet::kInvalid)
+			return m_values[index];
+
+		if (Length() == m_capacity) {
+			// the value may be held by the map, which growing frees
+			const T copy(value);
+			Grow(m_capacity ? m_capacity * 2 : 16);
+			return Insert(id, copy);
+		}
+
+		const size_t position = Length();
+		new (&m_values[position]) T(value);
+		m_keys.Insert(id);
+		return m_values[position];
+	}
+
+	/*
+	 * Function: operator[]
+	 *  Returns the value of an identifier, inserting a default constructed
+	 *  value first if the map holds none.
+	 */
+	T& operator[](u32 id) {
+		const u32 index = m_keys.Index(id);
+		return (index != wfSparseSet::kInvalid) ? m_values[index] : Insert(id, T());
+	}
+
+	/*
+	 * Function: Erase
+	 *  Removes the value of an identifier, moving the last value into its
+	 *  place.
+	 *
+	 * Returns:
+	 *  *true* if the map held a value for the identifier; *false* otherwise.
+	 */
+	bool Erase(u32 id) {
+		const u32 index = m_keys.Index(id);
+		if (index == wfSparseSet::kInvalid)
+			return false;
+
+		const size_t last = Length() - 1;
+		if (index != last)
+			m_values[index] = m_values[last];
+		m_values[last].~T();
+
+		m_keys.Erase(id);
+		return true;
+	}
+
+	/*
+	 * Function: Clear
+	 *  Removes every value, the memory is kept.
+	 */
+	void Clear() {
+		for (size_t i = 0; i < Length(); i++)
+			m_values[i].~T();
+		m_keys.Clear();
+	}
+
+	/*
+	 * Function: Reserve
+	 *  Makes room for a number of values.
+	 */
+	void Reserve(size_t capacity) {
+		if (capacity > m_capacity)
+			Grow(capacity);
+	}
+
+	/*
+	 * Function: ForEach
+	 *  Invokes a function on every value in dense order, as
+	 *  *function(id, value)*.
+	 *
+	 * Returns:
+	 *  A copy of the function object after it has been applied.
+	 */
+	template <typename F>
+	F ForEach(F function) {
+		for (size_t i = 0; i < Length(); i++)
+			function(m_keys[i], m_values[i]);
+		return function;
+	}
+
+private:
+	void Grow(size_t capacity) {
+		T *values = static_cast<T*>(m_heap->Alloc(capacity * sizeof(T)));
+		for (size_t i = 0; i < Length(); i++) {
+			new (&values[i]) T(m_values[i]);
+			m_values[i].~T();
+		}
+
+		m_heap->Free(m_values);
+		m_values   = values;
+		m_capacity = capacity;
+		m_keys.Reserve(capacity);
+	}
+
+	wfSparseSet  m_keys;
+	wfHeap      *m_heap;
+	T           *m_values;
+	size_t       m_capacity;
+
+	wfDenseMap(const wfDenseMap&);
+	wfDenseMap& operator=(const wfDenseMap&);
+};
+
+#endif
@@ -2,17 +2,33 @@
 #define WF_STDLIB_STACKLIST_HDR
 #include "wfStandard.h"
 #include "wfNullPointer.h"
+#include "wfAtomic.h"
 
 namespace wfPrivate {
+	enum {
+		wfStackListBlockBytes  = 512,
+		wfStackListBlockMinimum = 8
+	};
+
+	//
+	// A block of the stack: the link to the block below followed by room
+	// for *wfStackListBlock::Capacity* elements.  The header is padded to
+	// the alignment malloc guarantees so the elements after it are aligned.
+	//
 	template <typename T>
-	struct wfStackListNode {
-		wfStackListNode(const T& data, wfStackListNode *below = wfNullPointer) :
-			m_below(below),
-			m_data (data)
-		{ };
-
-		wfStackListNode *m_below;
-		T                m_data;
+	struct wfStackListBlock {
+		enum {
+			Capacity = sizeof(T) * wfStackListBlockMinimum > wfStackListBlockBytes
+				? static_cast<size_t>(wfStackListBlockMinimum)
+				: wfStackListBlockBytes / sizeof(T)
+		};
+
+		union {
+			wfStackListBlock *m_below;
+			long double       m_align;
+		};
+
+		T *Data() { return reinterpret_cast<T*>(this + 1); }
 	};
 };
 
@@ -21,7 +37,7 @@ namespace wfPrivate {
  * Standard LIFO Stack
  *
  * >#include "wfStackList.h"
- * 
+ *
  * Parameters:
  *  T - The element data type to be stored in the stack.
  *
@@ -29,7 +45,13 @@ namespace wfPrivate {
  *  This container unlike many containers in the Wayfroward standard
  *  library lacks iterators. If iterators are required use <wfSingleList>
  * (a LIFO singly linked list).
- */   
+ *
+ *  Elements are stored in blocks of about 512 bytes (at least 8 elements)
+ *  chained from the top down, so pushing and popping only allocates or
+ *  frees once per block.  The block last emptied is kept as a spare, a
+ *  stack that goes back and forth across the boundary of a block does not
+ *  allocate at all.
+ */
 template <typename T>
 struct wfStackList {
 	/*
@@ -37,24 +59,25 @@ struct wfStackList {
 	 *  Initializes the stack list.
 	 */
 	wfStackList() :
-		m_topnode(wfNullPointer),
-		m_length (0)
+		m_top   (wfNullPointer),
+		m_spare (wfNullPointer),
+		m_count (0),
+		m_length(0)
 	{ }
 
 	/*
 	 * Destructor: wfStackList
-	 *  Calls <PopBack> until the length is 0.  This effectivly deletes
-	 *  all elements and frees memory.
+	 *  Calls <Clear> and frees the spare block.
 	 */
 	~wfStackList() {
-		while (m_length > 0)
-			PopBack();
+		Clear();
+		g_miscHeap.Free(m_spare);
 	}
 
 	/*
 	 * Function: Length
 	 *  Returns the current wfStackList length.
-	 */   
+	 */
 	size_t Length() const { return m_length; }
 
 	/*
@@ -67,13 +90,13 @@ struct wfStackList {
 	 * Function: Top
 	 * Returns a reference to the top-most node on the stack.
 	 */
-	T& Top() { return m_topnode->data; }
+	T& Top() { return m_top->Data()[m_count - 1]; }
 
 	/*
 	 * Function: Top
 	 * Returns a const reference to the top-mode node on the stack.
 	 */
-	const T& Top() const { return m_topnode->data; }
+	const T& Top() const { return m_top->Data()[m_count - 1]; }
 
 	/*
 	 * Function: PushBack
@@ -84,9 +107,20 @@ struct wfStackList {
 	 *  data - The data to push back
 	 */
 	void PushBack(const T& data) {
-		wfPrivate::wfStackListNode<T> *tmp = new (reinterpret_cast<wfPrivate::wfStackListNode<T>*>(g_miscHeap.Alloc(sizeof(wfPrivate::wfStackListNode<T>)))) wfPrivate::wfStackListNode<T>(data, m_topnode);
-		m_topnode                          = tmp;
+		if (!m_top || m_count == Block::Capacity) {
+			Block *block = m_spare;
+			if (block)
+				m_spare = wfNullPointer;
+			else
+				block = static_cast<Block*>(g_miscHeap.Alloc(sizeof(Block) + Block::Capacity * sizeof(T)));
 
+			block->m_below = m_top;
+			m_top          = block;
+			m_count        = 0;
+		}
+
+		new (&m_top->Data()[m_count]) T(data);
+		m_count  ++;
 		m_length ++;
 	}
 
@@ -95,18 +129,24 @@ struct wfStackList {
 	 *  Pops out the current top node.
 	 */
 	void PopBack() {
-		wfPrivate::wfStackListNode<T> *tmp = m_topnode;
-		m_topnode                          = tmp->m_below;
-
-		tmp->~wfPrivate::wfStackListNode<T>();
-		g_miscHeap.Free(tmp);
+		m_count  --;
 		m_length --;
+		m_top->Data()[m_count].~T();
+
+		if (m_count == 0) {
+			Block *block = m_top;
+			m_top        = block->m_below;
+			m_count      = m_top ? static_cast<size_t>(Block::Capacity) : 0;
+
+			g_miscHeap.Free(m_spare);
+			m_spare = block;
+		}
 	}
 
 	/*
 	 * Function: Clear
 	 *  Calls *PopBack* until the <wfStackList> is empty.  This effectivly
-	 *  frees all memory as well.
+	 *  frees all memory as well, but for the spare block.
 	 *
 	 * Remarks:
 	 *  *Clear* is functionally equivlant to:
@@ -119,8 +159,144 @@ struct wfStackList {
 			PopBack();
 	}
 private:
-	wfPrivate::wfStackListNode<T> *m_topnode;
-	size_t                         m_length;
+	typedef wfPrivate::wfStackListBlock<T> Block;
+
+	Block  *m_top;
+	Block  *m_spare;
+	size_t  m_count;  // elements in the top block
+	size_t  m_length;
+
+	wfStackList(const wfStackList&);
+	wfStackList& operator=(const wfStackList&);
+};
+
+/*
+ * Struct: wfLockFreeStackNode
+ *  The node every item in a <wfLockFreeStack> has as a member.
+ *
+ * Parameters:
+ *  T - The item data type.
+ */
+template <typename T>
+struct wfLockFreeStackNode {
+	wfLockFreeStackNode() :
+		m_below(wfNullPointer),
+		m_item (wfNullPointer)
+	{ }
+
+	explicit wfLockFreeStackNode(T *item) :
+		m_below(wfNullPointer),
+		m_item (item)
+	{ }
+
+	/*
+	 * Function: Init
+	 *  Sets the item of a node constructed without one.
+	 */
+	void Init(T *item) { m_item = item; }
+
+private:
+	template <typename> friend struct wfLockFreeStack;
+
+	wfLockFreeStackNode *volatile m_below;
+	T                            *m_item;
+
+	wfLockFreeStackNode(const wfLockFreeStackNode&);
+	wfLockFreeStackNode& operator=(const wfLockFreeStackNode&);
+};
+
+/*
+ * Struct: wfLockFreeStack
+ *  A lock-free intrusive LIFO stack (a Treiber stack), for free lists
+ *  shared between threads.
+ *
+ * >#include "wfStackList.h"
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  <Push> and <Pop> are safe from any number of threads at once.  The top
+ *  of the stack is a tagged pointer: the pointer to the top node packed
+ *  with a counter bumped on every change, compared and exchanged as one
+ *  64-bit word, so that a <Pop> that read a node which was popped and
+ *  pushed back since does not succeed (the ABA problem).  On 64-bit
+ *  targets the pointer takes the low 48 bits and the tag the high 16,
+ *  which assumes user space addresses fit in 48 bits as they do on x64
+ *  and AArch64.
+ *
+ *  A <Pop> may read the node below a top node that another thread popped
+ *  in the meantime, so a popped node must stay readable memory while the
+ *  stack is in use; free lists satisfy this since their nodes are only
+ *  ever recycled, never returned to the heap.
+ */
+template <typename T>
+struct wfLockFreeStack {
+	typedef wfLockFreeStackNode<T> Node;
+
+	wfLockFreeStack() :
+		m_top(0)
+	{ }
+
+	/*
+	 * Function: Push
+	 *  Puts a node on top of the stack.
+	 */
+	void Push(Node *node) {
+		u64 top = wfAtomicLoadRelaxed(&m_top);
+		for (;;) {
+			wfAtomicStoreRelaxed(&node->m_below, Pointer(top));
+			if (wfAtomicCompareExchange(&m_top, top, Pack(node, top)))
+				return;
+			wfCpuRelax();
+		}
+	}
+
+	/*
+	 * Function: Pop
+	 *  Takes the node off the top of the stack.
+	 *
+	 * Returns:
+	 *  The item of the node, or *wfNullPointer* if the stack is empty.
+	 */
+	T *Pop() {
+		u64 top = wfAtomicLoad(&m_top);
+		for (;;) {
+			Node *node = Pointer(top);
+			if (!node)
+				return wfNullPointer;
+			if (wfAtomicCompareExchange(&m_top, top, Pack(wfAtomicLoadRelaxed(&node->m_below), top)))
+				return node->m_item;
+			wfCpuRelax();
+		}
+	}
+
+	/*
+	 * Function: Empty
+	 *  Tests if the stack is empty, which may have changed by the time the
+	 *  caller looks at the answer.
+	 */
+	bool Empty() const { return Pointer(wfAtomicLoad(&m_top)) == wfNullPointer; }
+
+private:
+	enum {
+		kPointerBits = sizeof(void*) == 8 ? 48 : 32
+	};
+
+	static Node *Pointer(u64 top) {
+		return reinterpret_cast<Node*>(static_cast<size_t>(top & ((static_cast<u64>(1) << kPointerBits) - 1)));
+	}
+
+	// the new top with the tag of the old one plus one
+	static u64 Pack(Node *node, u64 top) {
+		const u64 tag = (top >> kPointerBits) + 1;
+		return (tag << kPointerBits) | static_cast<u64>(reinterpret_cast<size_t>(node));
+	}
+
+	volatile u64 m_top;
+
+	wfLockFreeStack(const wfLockFreeStack&);
+	wfLockFreeStack& operator=(const wfLockFreeStack&);
 };
 
 #endif
@@ -106,6 +106,26 @@ inline bool wfCPUHasSSE41();
  */  
 inline bool wfCPUHasSSE42();
 
+/*
+ * Function: wfCPUHasAVX
+ *  Used to determine if the running host supports AVX instruction set,
+ *  and the operating system saves the AVX registers.
+ *
+ * Returns:
+ *  True if the CPU supports AVX, otherwise false.
+ */
+inline bool wfCPUHasAVX();
+
+/*
+ * Function: wfCPUHasAVX2
+ *  Used to determine if the running host supports AVX2 instruction set,
+ *  and the operating system saves the AVX registers.
+ *
+ * Returns:
+ *  True if the CPU supports AVX2, otherwise false.
+ */
+inline bool wfCPUHasAVX2();
+
 /*
  * Function: wfCPUHasNEON
  *  Used to determine if the running host supports NEON instruction set.
@@ -115,6 +135,16 @@ inline bool wfCPUHasSSE42();
  */  
 inline bool wfCPUHasNEON();
 
+/*
+ * Function: wfCPUThreadCount
+ *  Used to determine how many hardware threads the running host has
+ *  online, that is cores times the threads each core runs.
+ *
+ * Returns:
+ *  The number of hardware threads, at least one.
+ */
+inline uint32_t wfCPUThreadCount();
+
 /* =================================================================== */
 /* =================================================================== */
 /* ============= READ THE COMMENT BLOW IF YOU DARE =================== */
@@ -132,6 +162,18 @@ inline bool wfCPUHasNEON();
 #   include <sys/sysctl.h>
 #   include <sys/signal.h>
 #endif
+
+#if defined(_WIN32)
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <unistd.h>
+#endif
  
 #define CPUID_I386_GNUC(STORE)                                         \
     __asm__ (                                                          \
@@ -226,7 +268,8 @@ inline bool wfCPUHasNEON();
 
 /*
  * CPUID macros for filling in the four components as mandated by the
- * CPUID specification.
+ * CPUID specification.  ECX is cleared to select the first sub-leaf of
+ * leaves that have them (leaf 7), the others ignore it.
  */
 #define CPUID_LOAD_I386_GNUC(FUNC, A1, A2, A3, A4)                     \
     __asm__ __volatile__ (                                             \
@@ -240,7 +283,8 @@ inline bool wfCPUHasNEON();
                 "=c"(A3),                                              \
                 "=d"(A4)                                               \
             :                                                          \
-                "a" (FUNC)                                             \
+                "a" (FUNC),                                            \
+                "2" (0)                                                \
     )
 #define CPUID_LOAD_AMD64_GNUC(FUNC, A1, A2, A3, A4)                    \
    __asm__ __volatile__ (                                              \
@@ -254,11 +298,13 @@ inline bool wfCPUHasNEON();
                 "=c"(A3),                                              \
                 "=d"(A4)                                               \
             :                                                          \
-                "a" (FUNC)                                             \
+                "a" (FUNC),                                            \
+                "2" (0)                                                \
     )
 #define CPUID_LOAD_I386_MSVC(FUNC, A1, A2, A3, A4)                     \
     do {                                                               \
         __asm mov   eax,         FUNC                                  \
+        __asm xor   ecx,         ecx                                   \
         __asm cpuid                                                    \
         __asm mov   A1,          eax                                   \
         __asm mov   A2,          ebx                                   \
@@ -269,7 +315,7 @@ inline bool wfCPUHasNEON();
 #define CPUID_LOAD_AMD64_MSVC(FUNC, A1, A2, A3, A4)                    \
     do {                                                               \
         int load[4] = {-1};                                            \
-        __cpuid(load, FUNC);                                           \
+        __cpuidex(load, FUNC, 0);                                      \
         A1 = load[0];                                                  \
         A2 = load[1];                                                  \
         A3 = load[2];                                                  \
@@ -307,6 +353,30 @@ inline bool wfCPUHasNEON();
 #	define CPUID_LOAD(FUNC, L)
 #endif
 
+/*
+ * XGETBV reads which register states the operating system saves on a
+ * context switch, AVX is only usable when it saves XMM and YMM.  Emitted
+ * as bytes since older assemblers do not know the mnemonic.
+ */
+#if defined(__GNUC__) && (defined(i386) || defined(__x86_64__))
+#   define XGETBV_LOAD(LOW)                                            \
+    do {                                                               \
+        unsigned int high;                                             \
+        __asm__ __volatile__ (                                         \
+            ".byte 0x0f, 0x01, 0xd0"                                   \
+                : "=a"(LOW), "=d"(high)                                \
+                : "c" (0)                                              \
+        );                                                             \
+    } while (0)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#   include <immintrin.h>
+#   define XGETBV_LOAD(LOW)                                            \
+        ((LOW) = (unsigned int)_xgetbv(0))
+#else
+#   define XGETBV_LOAD(LOW)                                            \
+        ((LOW) = 0)
+#endif
+
 /*
  * Brute force method at determining if AltiVec is supported by issuing
  * an illegal instruction and catching the signal.  This is probably
@@ -355,12 +425,14 @@ namespace wfPrivate {
         kCpuFeatureSSE3     = 1 << 7,
         kCpuFeatureSSE41    = 1 << 8,
         kCpuFeatureSSE42    = 1 << 9,
-		kCpuFeatureNEON     = 1 << 10
+		kCpuFeatureNEON     = 1 << 10,
+        kCpuFeatureAVX      = 1 << 11,
+        kCpuFeatureAVX2     = 1 << 12
     };
 
     static uint32_t wfSystemInfoCPUSupport = 0xFFFFFFFF;
 
-    bool wfSystemInfoHasCPUID() {
+    inline bool wfSystemInfoHasCPUID() {
         int ret = false;
 #       if defined(__GNUC__)
 #           if defined(i386)
@@ -384,7 +456,7 @@ namespace wfPrivate {
         return !!ret;
     }
 
-    int wfSystemInfoGetFeatures() {
+    inline int wfSystemInfoGetFeatures() {
         int features = 0;
         int lanes[4];
 
@@ -398,13 +470,13 @@ namespace wfPrivate {
     }
 
 #   define IMPLEMENT_BASIC_CHECK(NAME, VAL)                            \
-        bool wfSystemInfoHas##NAME(void) {                             \
+        inline bool wfSystemInfoHas##NAME(void) {                      \
             if (wfSystemInfoHasCPUID())                                \
                 return !!(wfSystemInfoGetFeatures() & (VAL));          \
             return false;                                              \
         }
 #   define IMPLEMENT_CPUID_CHECK(NAME, FUN1, CMP, FUN2, IDX, VAL)      \
-        bool wfSystemInfoHas##NAME(void) {                             \
+        inline bool wfSystemInfoHas##NAME(void) {                      \
             if (wfSystemInfoHasCPUID()) {                              \
                 int lanes[4];                                          \
                 CPUID_LOAD(FUN1, lanes);                               \
@@ -433,7 +505,7 @@ namespace wfPrivate {
     #undef IMPLEMENT_BASIC_CHECK
     #undef IMPLEMENT_CPUID_CHECK
 
-    bool wfSystemInfoHasALTIVEC(void) {
+    inline bool wfSystemInfoHasALTIVEC(void) {
         /* runtime check */
 #       if defined(__ppc__) || defined(__PPC__)
             bool   ret           = false;
@@ -459,7 +531,43 @@ namespace wfPrivate {
         return false;
     }
 	
-	bool wfSystemInfoHasNEON(void) {
+    /*
+     * AVX needs both the CPU (leaf 1 ECX bit 28) and the operating system
+     * (OSXSAVE, leaf 1 ECX bit 27, with XMM and YMM state enabled in XCR0).
+     * AVX2 is leaf 7 EBX bit 5 on top of that.
+     */
+    inline bool wfSystemInfoHasAVX(void) {
+        if (!wfSystemInfoHasCPUID())
+            return false;
+
+        int lanes[4] = { 0, 0, 0, 0 };
+        CPUID_LOAD(0, lanes);
+        if (lanes[0] < 1)
+            return false;
+
+        CPUID_LOAD(1, lanes);
+        if ((lanes[2] & 0x18000000) != 0x18000000)
+            return false;
+
+        unsigned int xcr0;
+        XGETBV_LOAD(xcr0);
+        return (xcr0 & 6) == 6;
+    }
+
+    inline bool wfSystemInfoHasAVX2(void) {
+        if (!wfSystemInfoHasAVX())
+            return false;
+
+        int lanes[4] = { 0, 0, 0, 0 };
+        CPUID_LOAD(0, lanes);
+        if (lanes[0] < 7)
+            return false;
+
+        CPUID_LOAD(7, lanes);
+        return !!(lanes[1] & 0x00000020);
+    }
+
+	inline bool wfSystemInfoHasNEON(void) {
 #		if defined(__ARM_NEON__)
 			return true;
 #		endif /*! defined(__ARM_NEON__) */
@@ -467,7 +575,7 @@ namespace wfPrivate {
 		return false;
 	}
 
-    uint32_t wfSystemInfoGetSupport() {
+    inline uint32_t wfSystemInfoGetSupport() {
         if (wfSystemInfoCPUSupport != 0xFFFFFFFF) {
             return wfSystemInfoCPUSupport;
         }
@@ -483,10 +591,35 @@ namespace wfPrivate {
         if (wfSystemInfoHasSSE41())   wfSystemInfoCPUSupport |= kCpuFeatureSSE41;
         if (wfSystemInfoHasSSE42())   wfSystemInfoCPUSupport |= kCpuFeatureSSE42;
 		if (wfSystemInfoHasNEON())    wfSystemInfoCPUSupport |= kCpuFeatureNEON;
+        if (wfSystemInfoHasAVX())     wfSystemInfoCPUSupport |= kCpuFeatureAVX;
+        if (wfSystemInfoHasAVX2())    wfSystemInfoCPUSupport |= kCpuFeatureAVX2;
 
         return wfSystemInfoCPUSupport;
     }
 
+    static uint32_t wfSystemInfoThreads = 0;
+
+    inline uint32_t wfSystemInfoGetThreads() {
+        if (wfSystemInfoThreads != 0) {
+            return wfSystemInfoThreads;
+        }
+
+#       if defined(_WIN32)
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            wfSystemInfoThreads = (uint32_t)info.dwNumberOfProcessors;
+#       elif defined(_SC_NPROCESSORS_ONLN)
+            long online = sysconf(_SC_NPROCESSORS_ONLN);
+            wfSystemInfoThreads = online > 0 ? (uint32_t)online : 0;
+#       endif /*! defined(_WIN32) */
+
+        /* not knowing is as good as a single thread */
+        if (wfSystemInfoThreads == 0)
+            wfSystemInfoThreads = 1;
+
+        return wfSystemInfoThreads;
+    }
+
 #ifdef __cplusplus
 } /* namespace wfPrivate */
 #endif
@@ -501,6 +634,10 @@ inline bool wfCPUHasSSE3()    { return (NS wfSystemInfoGetSupport() & NS kCpuFea
 inline bool wfCPUHasSSE41()   { return (NS wfSystemInfoGetSupport() & NS kCpuFeatureSSE41);   }
 inline bool wfCPUHasSSE42()   { return (NS wfSystemInfoGetSupport() & NS kCpuFeatureSSE42);   }
 inline bool wfCPUHasNEON()    { return (NS wfSystemInfoGetSupport() & NS kCpuFeatureNEON);    }
+inline bool wfCPUHasAVX()     { return (NS wfSystemInfoGetSupport() & NS kCpuFeatureAVX);     }
+inline bool wfCPUHasAVX2()    { return (NS wfSystemInfoGetSupport() & NS kCpuFeatureAVX2);    }
+
+inline uint32_t wfCPUThreadCount() { return NS wfSystemInfoGetThreads(); }
 
 /* undef the "namespace" C/C++ agnostic macro defined earlier */
 #undef NS
@@ -518,5 +655,6 @@ inline bool wfCPUHasNEON()    { return (NS wfSystemInfoGetSupport() & NS kCpuFea
 #undef CPUID_LOAD_I386_GNUC
 #undef CPUID_LOAD_I386_MSVC
 #undef CPUID_LOAD
+#undef XGETBV_LOAD
 
 #endif /*! WF_STDLIB_SYSTEMINFO_HDR */
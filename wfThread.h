@@ -0,0 +1,300 @@
+#ifndef WF_STDLIB_THREAD_HDR
+#define WF_STDLIB_THREAD_HDR
+#include "wfAtomic.h"
+#include "wfNullPointer.h"
+
+/*
+ * File: wfThread
+ *  Threads and the locks to share data between them.
+ *
+ * >#include "wfThread.h"
+ *
+ *  Thin wrappers over POSIX threads, or the Win32 thread API, slim
+ *  reader/writer locks and condition variables on Windows.  <wfSpinLock>
+ *  is built on <wfAtomic> alone.
+ */
+
+#if defined(_WIN32)
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#   define WF_STDLIB_THREAD_WIN32
+#else
+#   include <pthread.h>
+#   include <sched.h>
+#   define WF_STDLIB_THREAD_POSIX
+#endif
+
+/*
+ * Function: wfThreadYield
+ *  Gives up the remainder of the time slice of the calling thread.
+ */
+inline void wfThreadYield() {
+#ifdef WF_STDLIB_THREAD_WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+/*
+ * Class: wfThread
+ *  A thread of execution.
+ *
+ * Remarks:
+ *  A thread runs a plain function taking a single *void** argument.  A
+ *  started thread must be joined with <Join> before the <wfThread> is
+ *  destroyed.
+ */
+struct wfThread {
+	typedef void (*Function)(void *argument);
+
+	wfThread() :
+		m_function(wfNullPointer),
+		m_argument(wfNullPointer),
+		m_started (false)
+	{ }
+
+	/*
+	 * Function: Start
+	 *  Starts running a function on a new thread.
+	 *
+	 * Parameters:
+	 *  function - The function to run.
+	 *  argument - The argument passed to the function.
+	 *
+	 * Returns:
+	 *  *true* if the thread was started; *false* otherwise.
+	 */
+	bool Start(Function function, void *argument) {
+		if (m_started)
+			return false;
+
+		m_function = function;
+		m_argument = argument;
+#ifdef WF_STDLIB_THREAD_WIN32
+		m_handle  = CreateThread(wfNullPointer, 0, &wfThread::Entry, this, 0, wfNullPointer);
+		m_started = (m_handle != wfNullPointer);
+#else
+		m_started = (pthread_create(&m_handle, wfNullPointer, &wfThread::Entry, this) == 0);
+#endif
+		return m_started;
+	}
+
+	/*
+	 * Function: Join
+	 *  Waits for a started thread to finish.
+	 */
+	void Join() {
+		if (!m_started)
+			return;
+#ifdef WF_STDLIB_THREAD_WIN32
+		WaitForSingleObject(m_handle, INFINITE);
+		CloseHandle(m_handle);
+#else
+		pthread_join(m_handle, wfNullPointer);
+#endif
+		m_started = false;
+	}
+
+	/*
+	 * Function: Joinable
+	 *  Tests if the thread was started and not yet joined.
+	 */
+	bool Joinable() const { return m_started; }
+
+private:
+#ifdef WF_STDLIB_THREAD_WIN32
+	static DWORD WINAPI Entry(LPVOID self) {
+		static_cast<wfThread*>(self)->m_function(static_cast<wfThread*>(self)->m_argument);
+		return 0;
+	}
+	HANDLE    m_handle;
+#else
+	static void *Entry(void *self) {
+		static_cast<wfThread*>(self)->m_function(static_cast<wfThread*>(self)->m_argument);
+		return wfNullPointer;
+	}
+	pthread_t m_handle;
+#endif
+
+	Function m_function;
+	void    *m_argument;
+	bool     m_started;
+
+	wfThread(const wfThread&);
+	wfThread& operator=(const wfThread&);
+};
+
+/*
+ * Class: wfMutex
+ *  A mutual exclusion lock that puts waiting threads to sleep.
+ */
+struct wfMutex {
+#ifdef WF_STDLIB_THREAD_WIN32
+	wfMutex()       { InitializeSRWLock(&m_lock); }
+	void Lock()     { AcquireSRWLockExclusive(&m_lock); }
+	bool TryLock()  { return TryAcquireSRWLockExclusive(&m_lock) != 0; }
+	void Unlock()   { ReleaseSRWLockExclusive(&m_lock); }
+private:
+	SRWLOCK m_lock;
+#else
+	wfMutex()       { pthread_mutex_init(&m_lock, wfNullPointer); }
+	~wfMutex()      { pthread_mutex_destroy(&m_lock); }
+	void Lock()     { pthread_mutex_lock(&m_lock); }
+	bool TryLock()  { return pthread_mutex_trylock(&m_lock) == 0; }
+	void Unlock()   { pthread_mutex_unlock(&m_lock); }
+private:
+	pthread_mutex_t m_lock;
+#endif
+
+	friend struct wfConditionVariable;
+
+	wfMutex(const wfMutex&);
+	wfMutex& operator=(const wfMutex&);
+};
+
+/*
+ * Class: wfConditionVariable
+ *  Puts threads to sleep until another thread signals a change to some
+ *  state protected by a <wfMutex>.
+ *
+ * Remarks:
+ *  <Wait> must be called with the mutex held, it releases the mutex while
+ *  the thread sleeps and takes it again before returning.  A wait can
+ *  return without a notification, always wait in a loop that tests the
+ *  state it waits for.
+ */
+struct wfConditionVariable {
+#ifdef WF_STDLIB_THREAD_WIN32
+	wfConditionVariable()     { InitializeConditionVariable(&m_condition); }
+	void Wait(wfMutex& mutex) { SleepConditionVariableSRW(&m_condition, &mutex.m_lock, INFINITE, 0); }
+	void NotifyOne()          { WakeConditionVariable(&m_condition); }
+	void NotifyAll()          { WakeAllConditionVariable(&m_condition); }
+private:
+	CONDITION_VARIABLE m_condition;
+#else
+	wfConditionVariable()     { pthread_cond_init(&m_condition, wfNullPointer); }
+	~wfConditionVariable()    { pthread_cond_destroy(&m_condition); }
+	void Wait(wfMutex& mutex) { pthread_cond_wait(&m_condition, &mutex.m_lock); }
+	void NotifyOne()          { pthread_cond_signal(&m_condition); }
+	void NotifyAll()          { pthread_cond_broadcast(&m_condition); }
+private:
+	pthread_cond_t m_condition;
+#endif
+
+	wfConditionVariable(const wfConditionVariable&);
+	wfConditionVariable& operator=(const wfConditionVariable&);
+};
+
+/*
+ * Class: wfRWLock
+ *  A reader/writer lock: any number of readers or a single writer.
+ *
+ * Remarks:
+ *  <Lock> and <Unlock> take the lock exclusively, <LockShared> and
+ *  <UnlockShared> take it shared with other readers.
+ */
+struct wfRWLock {
+#ifdef WF_STDLIB_THREAD_WIN32
+	wfRWLock()           { InitializeSRWLock(&m_lock); }
+	void Lock()          { AcquireSRWLockExclusive(&m_lock); }
+	void Unlock()        { ReleaseSRWLockExclusive(&m_lock); }
+	void LockShared()    { AcquireSRWLockShared(&m_lock); }
+	void UnlockShared()  { ReleaseSRWLockShared(&m_lock); }
+private:
+	SRWLOCK m_lock;
+#else
+	wfRWLock()           { pthread_rwlock_init(&m_lock, wfNullPointer); }
+	~wfRWLock()          { pthread_rwlock_destroy(&m_lock); }
+	void Lock()          { pthread_rwlock_wrlock(&m_lock); }
+	void Unlock()        { pthread_rwlock_unlock(&m_lock); }
+	void LockShared()    { pthread_rwlock_rdlock(&m_lock); }
+	void UnlockShared()  { pthread_rwlock_unlock(&m_lock); }
+private:
+	pthread_rwlock_t m_lock;
+#endif
+
+	wfRWLock(const wfRWLock&);
+	wfRWLock& operator=(const wfRWLock&);
+};
+
+/*
+ * Class: wfSpinLock
+ *  A mutual exclusion lock that busy-waits, for critical sections of a
+ *  few instructions.
+ *
+ * Remarks:
+ *  Waiting threads spin on a plain load and only retry the exchange once
+ *  the lock looks free, and yield their time slice after spinning for a
+ *  while so that an oversubscribed machine still makes progress.
+ */
+struct wfSpinLock {
+	wfSpinLock() :
+		m_locked(0)
+	{ }
+
+	void Lock() {
+		for (u32 spins = 0; wfAtomicExchange(&m_locked, 1u) != 0; ) {
+			while (wfAtomicLoadRelaxed(&m_locked) != 0) {
+				if (++spins < 64)
+					wfCpuRelax();
+				else
+					wfThreadYield();
+			}
+		}
+	}
+
+	bool TryLock() {
+		return wfAtomicLoadRelaxed(&m_locked) == 0 && wfAtomicExchange(&m_locked, 1u) == 0;
+	}
+
+	void Unlock() {
+		wfAtomicStore(&m_locked, 0u);
+	}
+
+private:
+	volatile u32 m_locked;
+
+	wfSpinLock(const wfSpinLock&);
+	wfSpinLock& operator=(const wfSpinLock&);
+};
+
+/*
+ * Class: wfLockGuard
+ *  Holds a lock exclusively for the lifetime of the guard.
+ *
+ * Parameters:
+ *  T - Any lock type with *Lock* and *Unlock*.
+ */
+template <typename T>
+struct wfLockGuard {
+	explicit wfLockGuard(T& lock) : m_lock(lock) { m_lock.Lock(); }
+	~wfLockGuard() { m_lock.Unlock(); }
+private:
+	T& m_lock;
+
+	wfLockGuard(const wfLockGuard&);
+	wfLockGuard& operator=(const wfLockGuard&);
+};
+
+/*
+ * Class: wfSharedLockGuard
+ *  Holds a <wfRWLock> shared for the lifetime of the guard.
+ */
+template <typename T>
+struct wfSharedLockGuard {
+	explicit wfSharedLockGuard(T& lock) : m_lock(lock) { m_lock.LockShared(); }
+	~wfSharedLockGuard() { m_lock.UnlockShared(); }
+private:
+	T& m_lock;
+
+	wfSharedLockGuard(const wfSharedLockGuard&);
+	wfSharedLockGuard& operator=(const wfSharedLockGuard&);
+};
+
+#endif
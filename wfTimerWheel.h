@@ -0,0 +1,264 @@
+#ifndef WF_STDLIB_TIMERWHEEL_HDR
+#define WF_STDLIB_TIMERWHEEL_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+#include "wfIntrusiveList.h"
+
+/*
+ * File: wfTimerWheel
+ *  A hierarchical timing wheel for scheduling timers by tick.
+ *
+ * >#include "wfTimerWheel.h"
+ *
+ *  The wheel is four levels of 256 slots, every slot a <wfIntrusiveList>
+ *  of timers.  Level 0 has a slot per tick, level 1 a slot per 256 ticks
+ *  and so on, a timer lives in the lowest level whose slots are as wide
+ *  as the distance to its deadline allows.  Scheduling a timer appends it
+ *  to a slot and cancelling it unlinks it, both O(1) whatever the number
+ *  of pending timers.
+ *
+ *  Advancing the wheel by a tick fires the one level 0 slot that tick
+ *  points at.  Whenever the lower level comes round, the next slot of the
+ *  level above is emptied and its timers are scheduled again, which drops
+ *  each of them into a level closer to its deadline: a timer is moved at
+ *  most once per level before it fires, so the cost of a tick does not
+ *  depend on how many timers are pending.  Timers more than 2^32 ticks out
+ *  wait in an overflow list looked at once every 2^32 ticks.
+ */
+
+template <typename> struct wfTimerWheel;
+
+/*
+ * Class: wfTimerWheelNode
+ *  The node every item in a <wfTimerWheel> has as a member.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  Like a <wfIntrusiveListNode>, which it is built on, a timer node
+ *  cancels itself when destroyed, so an item can be freed while its timer
+ *  is pending.  The copy of a node is never scheduled and assigning to a
+ *  node leaves it scheduled as it was.
+ */
+template <typename T>
+struct wfTimerWheelNode : private wfIntrusiveListNode<T> {
+	wfTimerWheelNode() :
+		m_deadline(0)
+	{ }
+
+	explicit wfTimerWheelNode(T *item) :
+		wfIntrusiveListNode<T>(item),
+		m_deadline(0)
+	{ }
+
+	wfTimerWheelNode(const wfTimerWheelNode&) :
+		wfIntrusiveListNode<T>(),
+		m_deadline(0)
+	{ }
+
+	wfTimerWheelNode& operator=(const wfTimerWheelNode&) {
+		return *this;
+	}
+
+	/*
+	 * Function: Init
+	 *  Sets the item of a node constructed without one.
+	 */
+	void Init(T *item) { wfIntrusiveListNode<T>::Init(item); }
+
+	/*
+	 * Function: GetItem
+	 *  Returns the item of the node.
+	 */
+	T *GetItem() const { return wfIntrusiveListNode<T>::GetItem(); }
+
+	/*
+	 * Function: IsScheduled
+	 *  Tests if the timer is pending in a wheel.
+	 */
+	bool IsScheduled() const { return wfIntrusiveListNode<T>::IsLinked(); }
+
+	/*
+	 * Function: GetDeadline
+	 *  Returns the tick the timer fires at, or last fired at.
+	 */
+	u64 GetDeadline() const { return m_deadline; }
+
+	/*
+	 * Function: Cancel
+	 *  Takes the timer out of its wheel, if it is pending, in O(1).
+	 */
+	void Cancel() { wfIntrusiveListNode<T>::Unlink(); }
+
+private:
+	template <typename> friend struct wfTimerWheel;
+
+	u64 m_deadline;
+};
+
+/*
+ * Class: wfTimerWheel
+ *  A hierarchical timing wheel of items that embed a <wfTimerWheelNode>.
+ *
+ * Parameters:
+ *  T - The item data type.
+ *
+ * Remarks:
+ *  The wheel owns none of its timers and has no notion of time other than
+ *  its tick count, which starts at zero and moves only by <Advance>.  As
+ *  with <wfIntrusiveList> there is no count of pending timers, a timer can
+ *  cancel itself without the wheel knowing.  Destroying or clearing the
+ *  wheel cancels every timer left in it.
+ */
+template <typename T>
+struct wfTimerWheel {
+	typedef wfTimerWheelNode<T> Node;
+
+	wfTimerWheel() :
+		m_now(0)
+	{ }
+
+	/*
+	 * Function: Now
+	 *  Returns the current tick.
+	 */
+	u64 Now() const { return m_now; }
+
+	/*
+	 * Function: Schedule
+	 *  Schedules a timer to fire at a tick, in O(1).
+	 *
+	 * Parameters:
+	 *  node     - The node of the timer.
+	 *  deadline - The tick to fire at.
+	 *
+	 * Remarks:
+	 *  A timer already pending, in this wheel or another, is moved.  The
+	 *  current tick has already fired, a deadline at or before it fires on
+	 *  the next tick.
+	 */
+	void Schedule(Node *node, u64 deadline) {
+		node->m_deadline = deadline > m_now ? deadline : m_now + 1;
+		Place(node);
+	}
+
+	/*
+	 * Function: ScheduleAfter
+	 *  Schedules a timer to fire a number of ticks from now, in O(1).
+	 *
+	 * Parameters:
+	 *  node  - The node of the timer.
+	 *  ticks - The number of ticks to fire after.
+	 */
+	void ScheduleAfter(Node *node, u64 ticks) {
+		Schedule(node, m_now + ticks);
+	}
+
+	/*
+	 * Function: Cancel
+	 *  Takes a timer out of the wheel, in O(1).
+	 */
+	void Cancel(Node *node) { node->Cancel(); }
+
+	/*
+	 * Function: Advance
+	 *  Moves the wheel forward, invoking a function on the item of every
+	 *  timer whose deadline is passed as *function(item)* with a pointer to
+	 *  the item.
+	 *
+	 * Parameters:
+	 *  ticks    - The number of ticks to move forward.
+	 *  function - The function to invoke.
+	 *
+	 * Returns:
+	 *  The number of timers fired.
+	 *
+	 * Remarks:
+	 *  Timers fire in order of deadline, the wheel's tick is the deadline
+	 *  of the timer when the function is invoked on it.  The timer is out of
+	 *  the wheel by then, the function may schedule it again, cancel other
+	 *  timers or destroy the item.  The cost is a constant per tick plus the
+	 *  timers fired and moved down, skipping over a long stretch of idle
+	 *  ticks is still linear in the ticks.
+	 */
+	template <typename F>
+	size_t Advance(u64 ticks, F function) {
+		size_t fired = 0;
+		while (ticks--)
+			fired += Tick(function);
+		return fired;
+	}
+
+	/*
+	 * Function: Clear
+	 *  Cancels every pending timer.
+	 */
+	void Clear() {
+		for (size_t level = 0; level < kLevels; level++)
+			for (size_t slot = 0; slot < kSlots; slot++)
+				m_slots[level][slot].Clear();
+		m_overflow.Clear();
+	}
+
+private:
+	wfTimerWheel(const wfTimerWheel&);
+	wfTimerWheel& operator=(const wfTimerWheel&);
+
+	enum {
+		kLevelBits = 8,
+		kSlots     = 1 << kLevelBits,
+		kLevels    = 4
+	};
+
+	// the lowest level whose slots above the timer's agree with the current
+	// tick, so the slot the timer lands in comes round before its deadline
+	void Place(Node *node) {
+		const u64 deadline = node->m_deadline;
+		for (size_t level = 0; level < kLevels; level++) {
+			const size_t shift = (level + 1) * kLevelBits;
+			if ((deadline >> shift) == (m_now >> shift)) {
+				m_slots[level][(deadline >> (shift - kLevelBits)) & (kSlots - 1)].Append(node);
+				return;
+			}
+		}
+		m_overflow.Append(node);
+	}
+
+	// schedules the timers of a slot again, relative to the current tick
+	void Cascade(wfIntrusiveList<T>& slot) {
+		wfIntrusiveList<T> moving;
+		moving.Append(slot);
+		while (!moving.Empty())
+			Place(static_cast<Node*>(moving.Begin().GetNode()));
+	}
+
+	template <typename F>
+	size_t Tick(F& function) {
+		m_now++;
+
+		// from the top down, so timers cascaded out of a level land in the
+		// slots of the levels below before those are cascaded in turn
+		if ((m_now & ((static_cast<u64>(1) << (kLevels * kLevelBits)) - 1)) == 0)
+			Cascade(m_overflow);
+		for (size_t level = kLevels - 1; level > 0; level--) {
+			const size_t shift = level * kLevelBits;
+			if ((m_now & ((static_cast<u64>(1) << shift) - 1)) == 0)
+				Cascade(m_slots[level][(m_now >> shift) & (kSlots - 1)]);
+		}
+
+		wfIntrusiveList<T> expired;
+		expired.Append(m_slots[0][m_now & (kSlots - 1)]);
+
+		size_t fired = 0;
+		for (T *item; (item = expired.TakeFirst()) != wfNullPointer; fired++)
+			function(item);
+		return fired;
+	}
+
+	wfIntrusiveList<T> m_slots[kLevels][kSlots];
+	wfIntrusiveList<T> m_overflow;
+	u64                m_now;
+};
+
+#endif
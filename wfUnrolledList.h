@@ -0,0 +1,424 @@
+#ifndef WF_STDLIB_UNROLLEDLIST_HDR
+#define WF_STDLIB_UNROLLEDLIST_HDR
+#include "wfStandard.h"
+#include "wfNullPointer.h"
+#include "wfIterator.h"
+
+/*
+ * File: wfUnrolledList
+ *  A doubly linked list of small arrays of elements.
+ *
+ * >#include "wfUnrolledList.h"
+ *
+ *  Every node of the list holds as many elements as fit in about two cache
+ *  lines instead of a single element, which divides the number of
+ *  allocations and the link overhead by that many and turns traversal
+ *  into mostly sequential reads.  Inserting into a full node splits it in
+ *  two halves, erasing from a node which falls below a quarter full merges
+ *  the following node into it when both fit, so that nodes stay at least
+ *  partially filled without ever moving more than one node of elements.
+ *  Pushing at either end fills the node at that end while it has room and
+ *  only then starts a fresh node, a list built by pushes alone therefor
+ *  has full nodes and never splits one.
+ *
+ *  The interface is the one of <wfSmallList>, with <wfUnrolledList::Insert>
+ *  and <wfUnrolledList::Erase> at iterators in addition.
+ */
+
+namespace wfPrivate {
+	enum {
+		wfUnrolledListNodeBytes   = 128,
+		wfUnrolledListNodeMinimum = 4
+	};
+
+	struct wfUnrolledListLink {
+		wfUnrolledListLink *m_prev;
+		wfUnrolledListLink *m_next;
+	};
+
+	template <typename T>
+	struct wfUnrolledListNode : wfUnrolledListLink {
+		enum {
+			Capacity = sizeof(T) * wfUnrolledListNodeMinimum + 3 * sizeof(void*) > wfUnrolledListNodeBytes
+				? static_cast<size_t>(wfUnrolledListNodeMinimum)
+				: (wfUnrolledListNodeBytes - 3 * sizeof(void*)) / sizeof(T)
+		};
+
+		size_t m_count;
+		union {
+			char        m_bytes[Capacity * sizeof(T)];
+			long double m_align;
+			void       *m_alignPointer;
+		};
+
+		T *Data() { return reinterpret_cast<T*>(m_bytes); }
+	};
+}
+
+/*
+ * Class: wfUnrolledListIterator
+ *  A bidirectional iterator over a <wfUnrolledList>.
+ *
+ * Parameters:
+ *  T - The element data type.
+ *  U - *T* for a mutable iterator, *const T* for a constant one.
+ */
+template <typename T, typename U>
+struct wfUnrolledListIterator {
+	typedef ptrdiff_t                             DifferenceType;
+	typedef T                                     ValueType;
+	typedef U*                                    Pointer;
+	typedef U&                                    Reference;
+	typedef U*                                    PointerType;
+	typedef U&                                    ReferenceType;
+	typedef wfPrivate::wfBidirectionlIteratorTag  IteratorCategory;
+
+	wfUnrolledListIterator() :
+		m_link (wfNullPointer),
+		m_index(0)
+	{ }
+
+	// mutable iterators convert to constant ones
+	wfUnrolledListIterator(const wfUnrolledListIterator<T, T>& other) :
+		m_link (other.m_link),
+		m_index(other.m_index)
+	{ }
+
+	Reference operator *  () const { return  Node()->Data()[m_index]; }
+	Pointer   operator -> () const { return &Node()->Data()[m_index]; }
+
+	wfUnrolledListIterator& operator ++ () {
+		if (++m_index == Node()->m_count) {
+			m_link  = m_link->m_next;
+			m_index = 0;
+		}
+		return *this;
+	}
+
+	wfUnrolledListIterator& operator -- () {
+		if (m_index == 0) {
+			m_link  = m_link->m_prev;
+			m_index = Node()->m_count;
+		}
+		m_index --;
+		return *this;
+	}
+
+	wfUnrolledListIterator operator ++ (int) { wfUnrolledListIterator it(*this); ++*this; return it; }
+	wfUnrolledListIterator operator -- (int) { wfUnrolledListIterator it(*this); --*this; return it; }
+
+	bool operator == (const wfUnrolledListIterator& other) const { return m_link == other.m_link && m_index == other.m_index; }
+	bool operator != (const wfUnrolledListIterator& other) const { return m_link != other.m_link || m_index != other.m_index; }
+
+private:
+	template <typename> friend struct wfUnrolledList;
+	template <typename, typename> friend struct wfUnrolledListIterator;
+
+	wfUnrolledListIterator(wfPrivate::wfUnrolledListLink *link, size_t index) :
+		m_link (link),
+		m_index(index)
+	{ }
+
+	wfPrivate::wfUnrolledListNode<T> *Node() const {
+		return static_cast<wfPrivate::wfUnrolledListNode<T>*>(m_link);
+	}
+
+	wfPrivate::wfUnrolledListLink *m_link;
+	size_t                         m_index;
+};
+
+/*
+ * Class: wfUnrolledList
+ *  A double-ended list with O(1) insertion and erasure at iterators that
+ *  stores its elements a few dozen to a node.
+ *
+ * Parameters:
+ *  T - The element data type to be stored in the <wfUnrolledList>.
+ *
+ * Remarks:
+ *  Unlike <wfSmallList> elements move within and between nodes: inserting
+ *  or erasing invalidates the iterators to, and addresses of, the elements
+ *  in the node involved and in the node it splits or merges with.  The
+ *  cost of either is bounded by the number of elements in a node, not by
+ *  the length of the list.
+ */
+template <typename T>
+struct wfUnrolledList {
+	/*
+	 * Type: Iterator
+	 *  A type that provides a bidirectional iterator that can read or
+	 *  modify any element in a <wfUnrolledList>.
+	 */
+	typedef wfUnrolledListIterator<T, T>       Iterator;
+
+	/*
+	 * Type: ConstIterator
+	 *  A type that provides a bidirectional iterator that can read a
+	 *  *const* element in a <wfUnrolledList>.
+	 */
+	typedef wfUnrolledListIterator<T, const T> ConstIterator;
+
+	explicit wfUnrolledList(wfHeap *heap = &g_miscHeap) :
+		m_heap  (heap),
+		m_length(0)
+	{
+		m_end.m_prev = &m_end;
+		m_end.m_next = &m_end;
+	}
+
+	~wfUnrolledList() {
+		Clear();
+	}
+
+	/*
+	 * Function: Begin
+	 *  Returns an iterator to the first element, or <End> if the list is
+	 *  empty.  There exists a const cv-qualified version of this function
+	 *  as well.
+	 */
+	Iterator      Begin()       { return Iterator     (m_end.m_next, 0); }
+	ConstIterator Begin() const { return ConstIterator(m_end.m_next, 0); }
+
+	/*
+	 * Function: End
+	 *  Returns an iterator to the location succeeding the last element.
+	 *  There exists a const cv-qualified version of this function as well.
+	 */
+	Iterator      End()       { return Iterator     (const_cast<wfPrivate::wfUnrolledListLink*>(&m_end), 0); }
+	ConstIterator End() const { return ConstIterator(const_cast<wfPrivate::wfUnrolledListLink*>(&m_end), 0); }
+
+	/*
+	 * Function: Length
+	 *  Returns the number of elements in the list.
+	 */
+	size_t Length() const { return m_length;      }
+
+	/*
+	 * Function: Empty
+	 *  Tests if the list is empty.
+	 */
+	bool   Empty () const { return m_length == 0; }
+
+	/*
+	 * Function: Front
+	 *  Returns the first element.  There exists a const cv-qualified version
+	 *  of this function as well.
+	 */
+	T&       Front()       { return *Begin(); }
+	const T& Front() const { return *Begin(); }
+
+	/*
+	 * Function: Back
+	 *  Returns the last element.  There exists a const cv-qualified version
+	 *  of this function as well.
+	 */
+	T&       Back()       { return *--End(); }
+	const T& Back() const { return *--End(); }
+
+	/*
+	 * Function: PushBack
+	 *  Adds an element to the end of the list.
+	 *
+	 * Returns:
+	 *  A reference to the element added.
+	 */
+	T& PushBack(const T& data) { return *Insert(End(), data); }
+
+	/*
+	 * Function: PushFront
+	 *  Adds an element to the beginning of the list.
+	 *
+	 * Returns:
+	 *  A reference to the element added.
+	 */
+	T& PushFront(const T& data) { return *Insert(Begin(), data); }
+
+	/*
+	 * Function: PopBack
+	 *  Erases the last element, which must exist.
+	 */
+	void PopBack() { Erase(--End()); }
+
+	/*
+	 * Function: PopFront
+	 *  Erases the first element, which must exist.
+	 */
+	void PopFront() { Erase(Begin()); }
+
+	/*
+	 * Function: Insert
+	 *  Inserts a copy of an element before the element at an iterator.
+	 *
+	 * Parameters:
+	 *  position - Where to insert, <End> to append.
+	 *  data     - The element to insert.
+	 *
+	 * Returns:
+	 *  An iterator to the element inserted.
+	 *
+	 * Remarks:
+	 *  The element may be one of the list, even one of the node the
+	 *  insertion shifts or splits.
+	 */
+	Iterator Insert(Iterator position, const T& data) {
+		if (position.m_link != &m_end && Holds(position.Node(), &data)) {
+			// the element would be shifted or moved away underneath
+			const T copy(data);
+			return Insert(position, copy);
+		}
+
+		wfPrivate::wfUnrolledListLink *link  = position.m_link;
+		size_t                         index = position.m_index;
+
+		// append to the last node rather than starting a node at the end
+		if (link == &m_end && m_end.m_prev != &m_end) {
+			link  = m_end.m_prev;
+			index = static_cast<Node*>(link)->m_count;
+		}
+
+		if (link == &m_end) {
+			link  = Link(Allocate(), &m_end);
+			index = 0;
+		} else if (static_cast<Node*>(link)->m_count == Node::Capacity) {
+			Node *node = static_cast<Node*>(link);
+			if (index == Node::Capacity) {
+				// at the end of a full node: the element starts the next node
+				link  = Link(Allocate(), node->m_next);
+				index = 0;
+			} else if (index == 0 && node->m_prev == &m_end) {
+				// at the front of the list: the element starts a new first node
+				link = Link(Allocate(), node);
+			} else {
+				// split the full node and insert into the half it belongs to
+				Node        *upper = static_cast<Node*>(Link(Allocate(), node->m_next));
+				const size_t half  = Node::Capacity / 2;
+				Move(upper->Data(), node->Data() + half, Node::Capacity - half);
+				upper->m_count = Node::Capacity - half;
+				node->m_count  = half;
+				if (index > half) {
+					link   = upper;
+					index -= half;
+				}
+			}
+		}
+
+		Node *node   = static_cast<Node*>(link);
+		T    *values = node->Data();
+		if (index == node->m_count) {
+			new (&values[index]) T(data);
+		} else {
+			new (&values[node->m_count]) T(values[node->m_count - 1]);
+			for (size_t i = node->m_count - 1; i > index; i--)
+				values[i] = values[i - 1];
+			values[index] = data;
+		}
+		node->m_count ++;
+		m_length ++;
+
+		return Iterator(link, index);
+	}
+
+	/*
+	 * Function: Erase
+	 *  Erases the element at an iterator.
+	 *
+	 * Returns:
+	 *  An iterator to the element which followed the one erased.
+	 */
+	Iterator Erase(Iterator position) {
+		Node        *node  = position.Node();
+		const size_t index = position.m_index;
+		T           *data  = node->Data();
+
+		for (size_t i = index + 1; i < node->m_count; i++)
+			data[i - 1] = data[i];
+		data[--node->m_count].~T();
+		m_length --;
+
+		if (node->m_count == 0) {
+			wfPrivate::wfUnrolledListLink *next = node->m_next;
+			Unlink(node);
+			return Iterator(next, 0);
+		}
+
+		// merge the next node into a node that has become sparse, when the
+		// result leaves room to insert without splitting again right away
+		if (node->m_count < Node::Capacity / 4 && node->m_next != &m_end) {
+			Node *next = static_cast<Node*>(node->m_next);
+			if (node->m_count + next->m_count <= Node::Capacity * 3 / 4) {
+				Move(data + node->m_count, next->Data(), next->m_count);
+				node->m_count += next->m_count;
+				next->m_count  = 0;
+				Unlink(next);
+			}
+		}
+
+		if (index < node->m_count)
+			return Iterator(node, index);
+		return Iterator(node->m_next, 0);
+	}
+
+	/*
+	 * Function: Clear
+	 *  Erases all the elements and frees every node.
+	 */
+	void Clear() {
+		while (m_end.m_next != &m_end) {
+			Node *node = static_cast<Node*>(m_end.m_next);
+			for (size_t i = 0; i < node->m_count; i++)
+				node->Data()[i].~T();
+			node->m_count = 0;
+			Unlink(node);
+		}
+		m_length = 0;
+	}
+
+private:
+	typedef wfPrivate::wfUnrolledListNode<T> Node;
+
+	Node *Allocate() {
+		Node *node = static_cast<Node*>(m_heap->Alloc(sizeof(Node)));
+		node->m_count = 0;
+		return node;
+	}
+
+	// links a node in before another, returns it
+	wfPrivate::wfUnrolledListLink *Link(Node *node, wfPrivate::wfUnrolledListLink *before) {
+		node->m_prev           = before->m_prev;
+		node->m_next           = before;
+		before->m_prev->m_next = node;
+		before->m_prev         = node;
+		return node;
+	}
+
+	// unlinks and frees an emptied node
+	void Unlink(Node *node) {
+		node->m_prev->m_next = node->m_next;
+		node->m_next->m_prev = node->m_prev;
+		m_heap->Free(node);
+	}
+
+	// if an element lies in the storage of a node
+	static bool Holds(const Node *node, const T *data) {
+		const size_t begin = reinterpret_cast<size_t>(node->m_bytes);
+		const size_t at    = reinterpret_cast<size_t>(data);
+		return at >= begin && at < begin + sizeof(node->m_bytes);
+	}
+
+	// copy constructs count elements into raw storage, destroying the sources
+	static void Move(T *to, T *from, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			new (&to[i]) T(from[i]);
+			from[i].~T();
+		}
+	}
+
+	wfHeap                        *m_heap;
+	wfPrivate::wfUnrolledListLink  m_end;
+	size_t                         m_length;
+
+	wfUnrolledList(const wfUnrolledList&);
+	wfUnrolledList& operator=(const wfUnrolledList&);
+};
+
+#endif